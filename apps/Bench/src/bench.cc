@@ -1,23 +1,62 @@
 #include <benchmark/benchmark.h>
+#include <fmt/format.h>
+#include <gfx/draw_queue.h>
+#include <gfx/functions.h>
+#include <gfx/instancing.h>
+#include <gfx/reflection.h>
+#include <gfx/shader_source.h>
+#include <gfx/state_cache.h>
 
 #include <array>
+#include <cmath>
 #include <cstdlib>
-
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <math/batch.h>
+#include <math/cpu.h>
 #include <math/euler.h>
+#include <math/expr.h>
+#include <math/geo/aabb.h>
+#include <math/geo/plane.h>
 #include <math/geo/tri.h>
 #include <math/literals.h>
 #include <math/matrix.h>
 #include <math/matrix/rotation.h>
+#include <math/matrix/transform.h>
 #include <math/quat.h>
 #include <math/spaces.h>
+#include <math/spatial_hash.h>
 #include <math/vector.h>
+#include <mesh/binary.h>
+#include <mesh/mesh_data.h>
+#include <mesh/meshlet.h>
+#include <mesh/obj.h>
+#include <mesh/optimize.h>
+#include <mesh/quantize.h>
+#include <mesh/simplify.h>
+#include <mesh/tangent_space.h>
+#include <raster/framebuffer.h>
+#include <raster/occlusion.h>
+#include <raster/rasterizer.h>
 #include <sized.h>
 
+#include "perf_counters.h"
+
 // NOLINTBEGIN
 
 using namespace sized;
 using benchmark::State;
 using benchmark::DoNotOptimize;
+using bench::PerfScope;
 
 using math::Mat2x2;
 using math::Mat3x3;
@@ -33,12 +72,19 @@ using math::Vec2;
 using math::Vec3;
 using math::Vec4;
 
+using math::geo::AABBox;
+using math::geo::Plane;
+using math::geo::Ray;
+using math::geo::Sphere;
 using math::geo::Tri;
 
+using math::Isa;
+
 
 // Constructor (sanity check)
 static void BM_Ctor(State& state)
 {
+	auto perf = PerfScope(state);
 	for (auto _ : state)
 		DoNotOptimize(Vec3{ 1, 2, 3 });
 }
@@ -51,6 +97,7 @@ static void BM_CrossProduct(State& state)
 	auto a = Vec3{ 1.0, 3.0, 4.0 };
 	auto b = Vec3{ 2.0, -5.0, 8.0 };
 
+	auto perf = PerfScope(state);
 	for (auto _ : state)
 		DoNotOptimize(a.cross(b));
 }
@@ -61,6 +108,7 @@ BENCHMARK(BM_CrossProduct);
 static void BM_Length(State& state)
 {
 	auto vec = Vec3{ 1.0, 2.0, 3.0 };
+	auto perf = PerfScope(state);
 	for (auto _ : state)
 		DoNotOptimize(vec.length());
 }
@@ -71,6 +119,7 @@ BENCHMARK(BM_Length);
 static void BM_Normal(State& state)
 {
 	auto vec = Vec3{ 1.0, 2.0, 3.0 };
+	auto perf = PerfScope(state);
 	for (auto _ : state)
 		DoNotOptimize(vec.normal());
 }
@@ -81,6 +130,7 @@ BENCHMARK(BM_Normal);
 static void BM_LengthAndDirection(State& state)
 {
 	auto vec = Vec3{ 1.0, 2.0, 3.0 };
+	auto perf = PerfScope(state);
 	for (auto _ : state)
 		DoNotOptimize(vec.length_and_direction());
 }
@@ -93,6 +143,7 @@ static void BM_Distance(State& state)
 	auto a = Vec3{ 1.0, 3.0, 4.0 };
 	auto b = Vec3{ 2.0, -5.0, 8.0 };
 
+	auto perf = PerfScope(state);
 	for (auto _ : state)
 		DoNotOptimize(Vec3::dist(a, b));
 }
@@ -105,6 +156,7 @@ static void BM_DotProduct(State& state)
 	auto a = Vec3{ 1.0, 3.0, 4.0 };
 	auto b = Vec3{ 2.0, -5.0, 8.0 };
 
+	auto perf = PerfScope(state);
 	for (auto _ : state)
 		DoNotOptimize(a.dot(b));
 }
@@ -114,6 +166,7 @@ BENCHMARK(BM_DotProduct);
 // Matrix Constructors
 static void BM_Mat2x2_Ctor(State& state)
 {
+	auto perf = PerfScope(state);
 	for (auto _ : state) {
 		auto mat = Mat2x2{
 			{ -3.0, 4.0 },
@@ -124,6 +177,7 @@ static void BM_Mat2x2_Ctor(State& state)
 }
 static void BM_Mat3x3_Ctor(State& state)
 {
+	auto perf = PerfScope(state);
 	for (auto _ : state) {
 		auto mat = Mat3x3{
 			{ -4.0, -3.0,  3.0 },
@@ -135,6 +189,7 @@ static void BM_Mat3x3_Ctor(State& state)
 }
 static void BM_Mat4x4_Ctor(State& state)
 {
+	auto perf = PerfScope(state);
 	for (auto _ : state) {
 		auto mat = Mat4x4{
 			{ -4.0, -3.0,  3.0,  1.0 },
@@ -157,6 +212,7 @@ static void BM_Mat2x2_Transpose(State& state)
 		{ -3.0, 4.0 },
 		{  2.0, 5.0 },
 	};
+	auto perf = PerfScope(state);
 	for (auto _ : state)
 		DoNotOptimize(mat.transpose());
 }
@@ -167,6 +223,7 @@ static void BM_Mat3x3_Transpose(State& state)
 		{  0.0,  2.0, -2.0 },
 		{  1.0,  4.0, -1.0 },
 	};
+	auto perf = PerfScope(state);
 	for (auto _ : state)
 		DoNotOptimize(mat.transpose());
 }
@@ -178,6 +235,7 @@ static void BM_Mat4x4_Transpose(State& state)
 		{  1.0,  4.0, -1.0,  1.0 },
 		{  0.0,  2.0, -2.0,  1.0 },
 	};
+	auto perf = PerfScope(state);
 	for (auto _ : state)
 		DoNotOptimize(mat.transpose());
 }
@@ -186,6 +244,71 @@ BENCHMARK(BM_Mat3x3_Transpose);
 BENCHMARK(BM_Mat4x4_Transpose);
 
 
+// Matrix Multiplication
+static void BM_Mat4x4_Multiply(State& state)
+{
+	auto a = Mat4x4{
+		{  1.0,  2.0,  3.0,  4.0 },
+		{  5.0,  6.0,  7.0,  8.0 },
+		{  9.0, 10.0, 11.0, 12.0 },
+		{ 13.0, 14.0, 15.0, 16.0 },
+	};
+	auto b = a.transpose();
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		DoNotOptimize(a);
+		DoNotOptimize(b);
+		DoNotOptimize(a * b);
+	}
+}
+
+static void BM_Vec4_Mat4x4_Multiply(State& state)
+{
+	auto v = Vec4{ 1.0, 2.0, 3.0, 1.0 };
+	auto m = Mat4x4{
+		{  1.0,  2.0,  3.0,  4.0 },
+		{  5.0,  6.0,  7.0,  8.0 },
+		{  9.0, 10.0, 11.0, 12.0 },
+		{ 13.0, 14.0, 15.0, 16.0 },
+	};
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		DoNotOptimize(v);
+		DoNotOptimize(m);
+		DoNotOptimize(v * m);
+	}
+}
+
+static void BM_Mat4x4_IsIdentity(State& state)
+{
+	auto m = Mat4x4::identity();
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		DoNotOptimize(m);
+		DoNotOptimize(m.is_identity());
+	}
+}
+
+static void BM_Quat_Subscript(State& state)
+{
+	auto q = Quat{ 1.0, 2.0, 3.0, 4.0 };
+	usize idx = 3;
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		DoNotOptimize(idx);
+		DoNotOptimize(q[idx]);
+	}
+}
+BENCHMARK(BM_Mat4x4_Multiply);
+BENCHMARK(BM_Vec4_Mat4x4_Multiply);
+BENCHMARK(BM_Mat4x4_IsIdentity);
+BENCHMARK(BM_Quat_Subscript);
+
+
 // Matrix Determinants
 static void BM_Mat2x2_Determinant(State& state)
 {
@@ -193,6 +316,7 @@ static void BM_Mat2x2_Determinant(State& state)
 		{ -3.0, 4.0 },
 		{  2.0, 5.0 },
 	};
+	auto perf = PerfScope(state);
 	for (auto _ : state)
 		DoNotOptimize(mat.determinant());
 }
@@ -203,6 +327,7 @@ static void BM_Mat3x3_Determinant(State& state)
 		{  0.0,  2.0, -2.0 },
 		{  1.0,  4.0, -1.0 },
 	};
+	auto perf = PerfScope(state);
 	for (auto _ : state)
 		DoNotOptimize(mat.determinant());
 }
@@ -214,6 +339,7 @@ static void BM_Mat4x4_Determinant(State& state)
 		{  1.0,  4.0, -1.0,  1.0 },
 		{  0.0,  2.0, -2.0,  1.0 },
 	};
+	auto perf = PerfScope(state);
 	for (auto _ : state)
 		DoNotOptimize(mat.determinant());
 }
@@ -228,6 +354,7 @@ static void BM_Mat2x2_Inverse(State& state)
 		{ -3.0, 4.0 },
 		{  2.0, 5.0 },
 	};
+	auto perf = PerfScope(state);
 	for (auto _ : state)
 		DoNotOptimize(mat.inverse());
 }
@@ -238,6 +365,7 @@ static void BM_Mat3x3_Inverse(State& state)
 		{  0.0,  2.0, -2.0 },
 		{  1.0,  4.0, -1.0 },
 	};
+	auto perf = PerfScope(state);
 	for (auto _ : state)
 		DoNotOptimize(mat.inverse());
 }
@@ -249,6 +377,7 @@ static void BM_Mat4x4_Inverse(State& state)
 		{  1.0,  4.0, -1.0,  1.0 },
 		{  0.0,  2.0, -2.0,  1.0 },
 	};
+	auto perf = PerfScope(state);
 	for (auto _ : state)
 		DoNotOptimize(mat.inverse());
 }
@@ -258,6 +387,7 @@ static void BM_RotationMatrix_Inverse(State& state)
 	auto axis = Vec3{ -0.25, 0.5, 0.33 }.unit();
 	auto rotation_mat = RotationMatrix(angle, axis);
 
+	auto perf = PerfScope(state);
 	for (auto _ : state)
 		DoNotOptimize(rotation_mat.inverse());
 }
@@ -265,6 +395,7 @@ static void BM_Identity4x4_Inverse(State& state)
 {
 	auto mat = Mat4x4::identity();
 
+	auto perf = PerfScope(state);
 	for (auto _ : state)
 		DoNotOptimize(mat.inverse());
 }
@@ -281,6 +412,7 @@ static void BM_Mat3x3_Orthogonalize(State& state)
 	auto axis = Vec3{ -0.25, 0.5, 0.33 }.unit();
 	const auto initial = RotationMatrix(angle, axis);
 
+	auto perf = PerfScope(state);
 	for (auto _ : state) {
 		auto mat = initial;
 		mat.orthogonalize();
@@ -295,6 +427,7 @@ static void BM_EulerToMatrix_Expanded(State& state)
 	using namespace math::literals;
 	auto euler = Euler{ 31.9_deg, -22.8_deg, 17.2_deg };
 
+	auto perf = PerfScope(state);
 	for (auto _ : state)
 		DoNotOptimize(euler.matrix(Space::Local2Parent));
 }
@@ -303,6 +436,7 @@ static void BM_EulerToMatrix_Composed(State& state)
 	using namespace math::literals;
 	auto euler = Euler{ 31.9_deg, -22.8_deg, 17.2_deg };
 
+	auto perf = PerfScope(state);
 	for (auto _ : state) {
 		auto mat
 			= RotationMatrix(euler.roll, Axis::Forward)
@@ -325,6 +459,7 @@ static void BM_Max_Recursive(State& state)
 	flt y = m.m22 - m.m11 - m.m33;
 	flt z = m.m33 - m.m11 - m.m22;
 
+	auto perf = PerfScope(state);
 	for (auto _ : state) {
 		flt largest = std::max(w, std::max(x, std::max(y, z)));
 		DoNotOptimize(largest);
@@ -339,6 +474,7 @@ static void BM_Max_InitList(State& state)
 	flt y = m.m22 - m.m11 - m.m33;
 	flt z = m.m33 - m.m11 - m.m22;
 
+	auto perf = PerfScope(state);
 	for (auto _ : state) {
 		flt largest = std::max({ w, x, y, z });
 		DoNotOptimize(largest);
@@ -354,6 +490,7 @@ static void BM_Slerp(State& state)
 	auto three60 = Quat::angle_axis(360_deg, Vec3::up());
 	auto seven20 = Quat::angle_axis(720_deg, Vec3::up());
 
+	auto perf = PerfScope(state);
 	for (auto _ : state)
 		DoNotOptimize(Quat::slerp(three60, seven20, 0.5));
 }
@@ -365,6 +502,7 @@ static void BM_Euler2Quat_Composed1(State& state)
 	using namespace math::literals;
 	auto euler = Euler{ 45_deg, -15_deg, 3.3_deg };
 
+	auto perf = PerfScope(state);
 	for (auto _ : state) {
 		auto yq = Quat{
 			std::cos(euler.yaw * 0.5),
@@ -387,6 +525,7 @@ static void BM_Euler2Quat_Composed2(State& state)
 	using namespace math::literals;
 	auto euler = Euler{ 45_deg, -15_deg, 3.3_deg };
 
+	auto perf = PerfScope(state);
 	for (auto _ : state) {
 		auto yq = Quat::angle_axis(euler.yaw, Vec3::up());
 		auto pq = Quat::angle_axis(euler.pitch, Vec3::right());
@@ -400,6 +539,7 @@ static void BM_Euler2Quat_Expanded(State& state)
 	using namespace math::literals;
 	auto euler = Euler{ 45_deg, -15_deg, 3.3_deg };
 
+	auto perf = PerfScope(state);
 	for (auto _ : state) {
 		flt cos_y2 = std::cos(euler.yaw * 0.5);
 		flt cos_p2 = std::cos(euler.pitch * 0.5);
@@ -434,6 +574,7 @@ static void BM_Cart2Bary_eq1(State& state)
 
 	Vec3 result;
 
+	auto perf = PerfScope(state);
 	for (auto _ : state) {
 		Vec3 d1 = t.edge<3>();
 		Vec3 d2 = t.edge<1>();
@@ -504,6 +645,7 @@ static void BM_Cart2Bary_eq2(State& state)
 
 	Vec3 result;
 
+	auto perf = PerfScope(state);
 	for (auto _ : state) {
 		Vec3 e1 = t.edge<1>();
 		Vec3 e2 = t.edge<2>();
@@ -536,6 +678,1316 @@ BENCHMARK(BM_Cart2Bary_eq1);
 BENCHMARK(BM_Cart2Bary_eq2);
 
 
-BENCHMARK_MAIN();
+// Expression templates
+// Each `_Eager` variant spells out the expression with the regular `Vector`
+// operators; the `_Lazy` variant calls the library function, which fuses it.
+static void BM_Bary2Cart_Eager(State& state)
+{
+	auto tri = Tri{
+		Vec3{ 0.0, 0.0, 0.0 },
+		Vec3{ 1.0, 0.5, 0.0 },
+		Vec3{ 0.5, 1.0, 0.2 },
+	};
+	flt x = 0.2, y = 0.3, z = 0.5;
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		DoNotOptimize(tri);
+		DoNotOptimize(x * tri.v1 + y * tri.v2 + z * tri.v3);
+	}
+}
+
+static void BM_Bary2Cart_Lazy(State& state)
+{
+	auto tri = Tri{
+		Vec3{ 0.0, 0.0, 0.0 },
+		Vec3{ 1.0, 0.5, 0.0 },
+		Vec3{ 0.5, 1.0, 0.2 },
+	};
+	flt x = 0.2, y = 0.3, z = 0.5;
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		DoNotOptimize(tri);
+		DoNotOptimize(tri.bary2cart(x, y, z));
+	}
+}
+BENCHMARK(BM_Bary2Cart_Eager);
+BENCHMARK(BM_Bary2Cart_Lazy);
+
+static void BM_AABBox_Center_Eager(State& state)
+{
+	auto box = AABBox{ Vec3{ -1.0, -2.0, -3.0 }, Vec3{ 4.0, 5.0, 6.0 } };
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		DoNotOptimize(box);
+		DoNotOptimize(0.5 * (box.min + box.max));
+	}
+}
+
+static void BM_AABBox_Center_Lazy(State& state)
+{
+	auto box = AABBox{ Vec3{ -1.0, -2.0, -3.0 }, Vec3{ 4.0, 5.0, 6.0 } };
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		DoNotOptimize(box);
+		DoNotOptimize(box.center());
+	}
+}
+BENCHMARK(BM_AABBox_Center_Eager);
+BENCHMARK(BM_AABBox_Center_Lazy);
+
+// The pre-expression-template `Plane::best_fit`, kept for comparison
+template <typename Iter>
+static auto best_fit_eager(const Iter& points) -> Plane
+{
+	usize count = 1;
+	Vec3 normal = Vec3::Zero;
+	Vec3 prev, sum;
+
+	for (const Vec3& current : points) {
+		if (count == 1) {
+			prev = sum = current;
+			++count;
+			continue;
+		}
+
+		normal.x += (prev.z + current.z) * (prev.y - current.y);
+		normal.y += (prev.x + current.x) * (prev.z - current.z);
+		normal.z += (prev.y + current.y) * (prev.x - current.x);
+
+		prev = current;
+		sum += current;
+		++count;
+	}
+
+	normal.normalize();
+	flt distance = ((1 / static_cast<flt>(count)) * sum) | normal;
+
+	return Plane{ normal, distance };
+}
+
+static auto best_fit_points() -> std::array<Vec3, 8>
+{
+	return {
+		Vec3{ 1.0, 0.1, 0.0 },
+		Vec3{ 0.7, 0.0, 0.7 },
+		Vec3{ 0.0, -0.1, 1.0 },
+		Vec3{ -0.7, 0.0, 0.7 },
+		Vec3{ -1.0, 0.1, 0.0 },
+		Vec3{ -0.7, 0.0, -0.7 },
+		Vec3{ 0.0, -0.1, -1.0 },
+		Vec3{ 0.7, 0.0, -0.7 },
+	};
+}
+
+static void BM_Plane_BestFit_Eager(State& state)
+{
+	auto points = best_fit_points();
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		DoNotOptimize(points);
+		DoNotOptimize(best_fit_eager(points));
+	}
+}
+
+static void BM_Plane_BestFit_Lazy(State& state)
+{
+	auto points = best_fit_points();
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		DoNotOptimize(points);
+		DoNotOptimize(Plane::best_fit(points));
+	}
+}
+BENCHMARK(BM_Plane_BestFit_Eager);
+BENCHMARK(BM_Plane_BestFit_Lazy);
+
+
+// Batch kernels
+// Each benchmark is registered once per instruction set, and skipped if the
+// CPU running it doesn't support that variant.
+static constexpr usize k_batch_size = 4096;
+
+static auto use_isa(State& state, Isa isa) -> bool
+{
+	if (math::batch::force_isa(isa))
+		return true;
+
+	state.SkipWithError("instruction set not supported by this CPU");
+	return false;
+}
+
+static auto batch_sample(usize i, flt scale) -> Vec3
+{
+	auto n = static_cast<flt>(i);
+	return Vec3{ std::sin(n * 1.3f), std::cos(n * 0.7f), std::sin(n * 2.9f + 1) } * scale;
+}
+
+static void BM_Batch_TransformPoints(State& state, Isa isa)
+{
+	if (!use_isa(state, isa))
+		return;
+
+	auto m = Mat4x4{
+		{ 0.8, 0.1, -0.5, 0 },
+		{ -0.2, 0.9, 0.1, 0 },
+		{ 0.5, 0.3, 0.8, 0 },
+		{ 4.0, -5.0, 6.0, 1 },
+	};
+	auto points = std::vector<Vec3>(k_batch_size);
+	auto result = std::vector<Vec3>(k_batch_size);
+	for (usize i = 0; i < k_batch_size; ++i)
+		points[i] = batch_sample(i, 10);
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		math::batch::transform_points(m, points.data(), result.data(), k_batch_size);
+		DoNotOptimize(result.data());
+	}
+	state.SetItemsProcessed(state.iterations() * k_batch_size);
+	math::batch::reset_isa();
+}
+
+static void BM_Batch_Normalize(State& state)
+{
+	auto vectors = std::vector<Vec3>(k_batch_size);
+	for (usize i = 0; i < k_batch_size; ++i)
+		vectors[i] = batch_sample(i, 10);
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		// Normalizing is idempotent, so every iteration after the first
+		// measures the already-unit case
+		state.PauseTiming();
+		for (usize i = 0; i < k_batch_size; ++i)
+			vectors[i] = batch_sample(i, 10);
+		state.ResumeTiming();
+
+		math::batch::normalize(vectors.data(), k_batch_size);
+		DoNotOptimize(vectors.data());
+	}
+	state.SetItemsProcessed(state.iterations() * k_batch_size);
+}
+
+static void BM_Batch_CullSpheres(State& state, Isa isa)
+{
+	if (!use_isa(state, isa))
+		return;
+
+	auto planes = std::array<Plane, 6>{
+		Plane{ Vec3::right(), -5 },
+		Plane{ -Vec3::right(), -5 },
+		Plane{ Vec3::up(), -5 },
+		Plane{ -Vec3::up(), -5 },
+		Plane{ Vec3::forward(), -1 },
+		Plane{ -Vec3::forward(), -8 },
+	};
+	auto spheres = std::vector<Sphere>(k_batch_size);
+	auto visible = std::vector<u8>(k_batch_size);
+	for (usize i = 0; i < k_batch_size; ++i)
+		spheres[i] = Sphere{ batch_sample(i, 8), static_cast<flt>(i % 4) * 0.5f };
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		math::batch::cull_spheres(
+			planes.data(), planes.size(),
+			spheres.data(), k_batch_size,
+			visible.data());
+
+		DoNotOptimize(visible.data());
+	}
+	state.SetItemsProcessed(state.iterations() * k_batch_size);
+	math::batch::reset_isa();
+}
+
+static void BM_Batch_IntersectRayTris(State& state, Isa isa)
+{
+	if (!use_isa(state, isa))
+		return;
+
+	auto ray = Ray{ Vec3{ 0, 0, -10 }, Vec3{ 0, 0, 20 } };
+	auto tris = std::vector<Tri>(k_batch_size);
+	auto t = std::vector<flt>(k_batch_size);
+	for (usize i = 0; i < k_batch_size; ++i) {
+		auto center = batch_sample(i, 2);
+		tris[i] = Tri{
+			center + Vec3{ -1, -1, 0 },
+			center + Vec3{ 0, 1, 0.5 },
+			center + Vec3{ 1, -1, 0 },
+		};
+	}
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		math::batch::intersect_ray_tris(ray, tris.data(), k_batch_size, t.data());
+		DoNotOptimize(t.data());
+	}
+	state.SetItemsProcessed(state.iterations() * k_batch_size);
+	math::batch::reset_isa();
+}
+
+static void BM_Batch_Slerp(State& state)
+{
+	auto src = std::vector<Quat>(k_batch_size);
+	auto dest = std::vector<Quat>(k_batch_size);
+	auto result = std::vector<Quat>(k_batch_size);
+	for (usize i = 0; i < k_batch_size; ++i) {
+		src[i] = Quat::angle_axis(static_cast<flt>(i % 360), batch_sample(i, 1).normal());
+		dest[i] = Quat::angle_axis(static_cast<flt>(i % 90), batch_sample(i + 1, 1).normal());
+	}
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		math::batch::slerp(src.data(), dest.data(), 0.3f, result.data(), k_batch_size);
+		DoNotOptimize(result.data());
+	}
+	state.SetItemsProcessed(state.iterations() * k_batch_size);
+}
+
+static void BM_Batch_CullCones(State& state, Isa isa)
+{
+	if (!use_isa(state, isa))
+		return;
+
+	auto spheres = std::vector<Sphere>(k_batch_size);
+	auto axes = std::vector<Vec3>(k_batch_size);
+	auto cutoffs = std::vector<flt>(k_batch_size);
+	auto visible = std::vector<u8>(k_batch_size);
+	for (usize i = 0; i < k_batch_size; ++i) {
+		spheres[i] = Sphere{ batch_sample(i, 8), static_cast<flt>(i % 4) * 0.5f };
+		axes[i] = batch_sample(i + 1, 1).normal();
+		cutoffs[i] = static_cast<flt>(i % 8) * 0.125f;
+	}
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		math::batch::cull_cones(
+			Vec3{ 0, 0, -20 },
+			spheres.data(), axes.data(), cutoffs.data(), k_batch_size,
+			visible.data());
+
+		DoNotOptimize(visible.data());
+	}
+	state.SetItemsProcessed(state.iterations() * k_batch_size);
+	math::batch::reset_isa();
+}
+
+#define BATCH_BENCHMARK(func) \
+	BENCHMARK_CAPTURE(func, baseline, Isa::Baseline); \
+	BENCHMARK_CAPTURE(func, avx2, Isa::AVX2); \
+	BENCHMARK_CAPTURE(func, avx512, Isa::AVX512)
+
+BATCH_BENCHMARK(BM_Batch_TransformPoints);
+BATCH_BENCHMARK(BM_Batch_CullSpheres);
+BATCH_BENCHMARK(BM_Batch_CullCones);
+BATCH_BENCHMARK(BM_Batch_IntersectRayTris);
+
+// Not dispatched, see `math/batch.h`
+BENCHMARK(BM_Batch_Normalize);
+BENCHMARK(BM_Batch_Slerp);
+
+#undef BATCH_BENCHMARK
+
+
+// Spatial hashing
+// A million random points in a 100-unit cube, in cells 2 units across (about
+// 8 points per cell). `_Rebuild` re-indexes them with 1, 2, 4 and 8 threads,
+// as for a particle system every frame; the queries each search around 4096
+// random positions, within the cell size or for the 8 nearest points. Items
+// are points for rebuilds and searches for queries.
+
+static constexpr usize k_spatial_points = 1 << 20;
+static constexpr flt k_spatial_cell = 2;
+
+static auto spatial_points(usize count, u32 seed) -> std::vector<Vec3>
+{
+	auto rng = std::mt19937(seed);
+	auto dist = std::uniform_real_distribution<flt>(0, 100);
+	auto result = std::vector<Vec3>(count);
+	for (auto& p : result)
+		p = Vec3{ dist(rng), dist(rng), dist(rng) };
+
+	return result;
+}
+
+static void BM_SpatialHash_Rebuild(State& state)
+{
+	auto points = spatial_points(k_spatial_points, 1);
+	auto grid = math::SpatialHash(k_spatial_cell, static_cast<usize>(state.range(0)));
+	grid.build(points.data(), points.size());
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		grid.build(points.data(), points.size());
+		DoNotOptimize(grid);
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<i64>(k_spatial_points));
+}
+BENCHMARK(BM_SpatialHash_Rebuild)->ArgName("threads")->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_SpatialHash_QueryRadius(State& state)
+{
+	auto points = spatial_points(k_spatial_points, 1);
+	auto centers = spatial_points(4096, 2);
+	auto grid = math::SpatialHash(k_spatial_cell);
+	grid.build(points.data(), points.size());
+
+	auto found = std::vector<u32>();
+	usize total = 0;
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		total = 0;
+		for (const auto& center : centers) {
+			grid.query_radius(center, k_spatial_cell, found);
+			total += found.size();
+		}
+		DoNotOptimize(total);
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<i64>(centers.size()));
+	state.counters["found"] = static_cast<f64>(total) / static_cast<f64>(centers.size());
+}
+BENCHMARK(BM_SpatialHash_QueryRadius)->Unit(benchmark::kMillisecond);
+
+static void BM_SpatialHash_QueryNearest(State& state)
+{
+	auto points = spatial_points(k_spatial_points, 1);
+	auto centers = spatial_points(4096, 2);
+	auto grid = math::SpatialHash(k_spatial_cell);
+	grid.build(points.data(), points.size());
+
+	auto found = std::vector<u32>();
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		for (const auto& center : centers) {
+			grid.query_nearest(center, 8, found);
+			DoNotOptimize(found.data());
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<i64>(centers.size()));
+}
+BENCHMARK(BM_SpatialHash_QueryNearest)->Unit(benchmark::kMillisecond);
+
+
+// Formatting
+// `_ToString` builds a new string per value; `_FormatTo` writes into a reused
+// buffer, so after the first iteration it shouldn't touch the heap at all.
+
+static void BM_Mat4x4_ToString(State& state)
+{
+	auto m = math::TransformMatrix(Quat::identity(), Vec3{ 1, -2, 3 });
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		DoNotOptimize(m);
+		auto result = m.to_string();
+		DoNotOptimize(result.data());
+	}
+}
+
+static void BM_Mat4x4_FormatTo(State& state)
+{
+	auto m = math::TransformMatrix(Quat::identity(), Vec3{ 1, -2, 3 });
+	auto buffer = fmt::memory_buffer();
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		DoNotOptimize(m);
+		buffer.clear();
+		m.format_to(std::back_inserter(buffer));
+		DoNotOptimize(buffer.data());
+	}
+}
+
+static void BM_Vec3_Range_ToString(State& state)
+{
+	auto points = std::vector<Vec3>(256, Vec3{ 1.5, -2.25, 300 });
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		auto result = std::string();
+		for (const auto& p : points) {
+			result += p.to_string();
+			result += "\n";
+		}
+		DoNotOptimize(result.data());
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<i64>(points.size()));
+}
+
+static void BM_Vec3_Range_FormatTo(State& state)
+{
+	auto points = std::vector<Vec3>(256, Vec3{ 1.5, -2.25, 300 });
+	auto buffer = fmt::memory_buffer();
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		buffer.clear();
+		fmt::format_to(std::back_inserter(buffer), "{}", math::fmt::values(points));
+		DoNotOptimize(buffer.data());
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<i64>(points.size()));
+}
+BENCHMARK(BM_Mat4x4_ToString);
+BENCHMARK(BM_Mat4x4_FormatTo);
+BENCHMARK(BM_Vec3_Range_ToString);
+BENCHMARK(BM_Vec3_Range_FormatTo);
+
+
+// Mesh loading
+// The same grid mesh stored as a binary `.mesh` file and as a simple text
+// format (one `v`/`f` line per vertex/triangle). Each iteration loads the file
+// and copies the vertex and index data into a staging buffer, as uploading it
+// to the GPU would.
+
+namespace {
+
+constexpr u32 k_grid_size = 256;
+
+auto make_grid_mesh() -> mesh::MeshData
+{
+	auto result = mesh::MeshData();
+	result.push_attribute(mesh::Scalar::f32, 3); // position
+	result.push_attribute(mesh::Scalar::f32, 3); // normal
+	result.push_attribute(mesh::Scalar::f32, 2); // uv
+
+	for (u32 y = 0; y < k_grid_size; ++y) {
+		for (u32 x = 0; x < k_grid_size; ++x) {
+			f32 u = f32(x) / (k_grid_size - 1);
+			f32 v = f32(y) / (k_grid_size - 1);
+			f32 vertex[8] { u, std::sin(u * 6.f) * std::cos(v * 6.f), v, 0, 1, 0, u, v };
+
+			auto offset = result.vertices.size();
+			result.vertices.resize(offset + sizeof(vertex));
+			std::memcpy(&result.vertices[offset], vertex, sizeof(vertex));
+		}
+	}
+
+	for (u32 y = 0; y + 1 < k_grid_size; ++y) {
+		for (u32 x = 0; x + 1 < k_grid_size; ++x) {
+			u32 i = y * k_grid_size + x;
+			result.indices.insert(result.indices.end(), {
+				i, i + k_grid_size, i + 1,
+				i + 1, i + k_grid_size, i + k_grid_size + 1,
+			});
+		}
+	}
+
+	result.submeshes.push_back({ 0, static_cast<u32>(result.indices.size()) });
+	result.compute_bounds();
+
+	return result;
+}
+
+void write_text_mesh(const std::string& path, const mesh::MeshData& data)
+{
+	auto file = std::ofstream(path);
+	for (usize i = 0; i < data.vertex_count(); ++i) {
+		f32 vertex[8];
+		std::memcpy(vertex, &data.vertices[i * data.stride], sizeof(vertex));
+
+		file << fmt::format("v {} {} {} {} {} {} {} {}\n",
+			vertex[0], vertex[1], vertex[2], vertex[3],
+			vertex[4], vertex[5], vertex[6], vertex[7]);
+	}
+	for (usize i = 0; i < data.indices.size(); i += 3)
+		file << fmt::format("f {} {} {}\n", data.indices[i], data.indices[i + 1], data.indices[i + 2]);
+}
+
+auto read_text_mesh(const std::string& path) -> mesh::MeshData
+{
+	auto result = mesh::MeshData();
+	result.push_attribute(mesh::Scalar::f32, 3);
+	result.push_attribute(mesh::Scalar::f32, 3);
+	result.push_attribute(mesh::Scalar::f32, 2);
+
+	auto file = std::ifstream(path);
+	std::string tag;
+	while (file >> tag) {
+		if (tag == "v") {
+			f32 vertex[8];
+			for (auto& component : vertex)
+				file >> component;
+
+			auto offset = result.vertices.size();
+			result.vertices.resize(offset + sizeof(vertex));
+			std::memcpy(&result.vertices[offset], vertex, sizeof(vertex));
+		}
+		else if (tag == "f") {
+			u32 a, b, c;
+			file >> a >> b >> c;
+			result.indices.insert(result.indices.end(), { a, b, c });
+		}
+	}
+
+	result.submeshes.push_back({ 0, static_cast<u32>(result.indices.size()) });
+	result.compute_bounds();
+
+	return result;
+}
+
+/** The paths of the benchmark mesh files, written on first use. */
+auto grid_mesh_paths() -> const std::pair<std::string, std::string>&
+{
+	static const auto result = [] {
+		auto dir = std::filesystem::temp_directory_path();
+		auto paths = std::pair{
+			(dir / "bench_grid.mesh").string(),
+			(dir / "bench_grid.txt").string(),
+		};
+
+		auto data = make_grid_mesh();
+		mesh::binary::write(paths.first, data);
+		write_text_mesh(paths.second, data);
+
+		return paths;
+	}();
+
+	return result;
+}
+
+} // namespace
+
+static void BM_MeshLoad_Binary(State& state)
+{
+	const auto& path = grid_mesh_paths().first;
+	auto staging = std::vector<u8>();
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		auto loaded = mesh::binary::Mesh::load(path);
+
+		auto index_bytes = loaded.index_count() * sizeof(u32);
+		staging.resize(loaded.vertex_data_size() + index_bytes);
+		std::memcpy(staging.data(), loaded.vertex_data(), loaded.vertex_data_size());
+		std::memcpy(staging.data() + loaded.vertex_data_size(), loaded.index_data(), index_bytes);
+		DoNotOptimize(staging.data());
+	}
+	state.SetBytesProcessed(state.iterations() * static_cast<i64>(std::filesystem::file_size(path)));
+}
+
+static void BM_MeshLoad_Text(State& state)
+{
+	const auto& path = grid_mesh_paths().second;
+	auto staging = std::vector<u8>();
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		auto loaded = read_text_mesh(path);
+
+		auto index_bytes = loaded.indices.size() * sizeof(u32);
+		staging.resize(loaded.vertices.size() + index_bytes);
+		std::memcpy(staging.data(), loaded.vertices.data(), loaded.vertices.size());
+		std::memcpy(staging.data() + loaded.vertices.size(), loaded.indices.data(), index_bytes);
+		DoNotOptimize(staging.data());
+	}
+	state.SetBytesProcessed(state.iterations() * static_cast<i64>(std::filesystem::file_size(path)));
+}
+BENCHMARK(BM_MeshLoad_Binary)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MeshLoad_Text)->Unit(benchmark::kMillisecond);
+
+
+// OBJ import
+// Throughput of `mesh::obj::import` on a generated grid with positions, uvs
+// and normals, parsed with a varying number of threads.
+
+namespace {
+
+auto grid_obj_path() -> const std::string&
+{
+	static const auto result = [] {
+		auto path = (std::filesystem::temp_directory_path() / "bench_grid.obj").string();
+		auto data = make_grid_mesh();
+		auto buffer = fmt::memory_buffer();
+
+		for (usize i = 0; i < data.vertex_count(); ++i) {
+			f32 vertex[8];
+			std::memcpy(vertex, &data.vertices[i * data.stride], sizeof(vertex));
+
+			fmt::format_to(std::back_inserter(buffer), "v {:.6f} {:.6f} {:.6f}\n", vertex[0], vertex[1], vertex[2]);
+			fmt::format_to(std::back_inserter(buffer), "vn {:.6f} {:.6f} {:.6f}\n", vertex[3], vertex[4], vertex[5]);
+			fmt::format_to(std::back_inserter(buffer), "vt {:.6f} {:.6f}\n", vertex[6], vertex[7]);
+		}
+		for (usize i = 0; i < data.indices.size(); i += 3) {
+			u32 a = data.indices[i] + 1, b = data.indices[i + 1] + 1, c = data.indices[i + 2] + 1;
+			fmt::format_to(std::back_inserter(buffer), "f {0}/{0}/{0} {1}/{1}/{1} {2}/{2}/{2}\n", a, b, c);
+		}
+
+		auto file = std::ofstream(path, std::ios::binary);
+		file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+
+		return path;
+	}();
+
+	return result;
+}
+
+} // namespace
+
+static void BM_ObjImport(State& state)
+{
+	const auto& path = grid_obj_path();
+	auto options = mesh::obj::ImportOptions{ static_cast<usize>(state.range(0)), 1 << 16 };
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		auto result = mesh::obj::import(path, options);
+		DoNotOptimize(result.indices.data());
+	}
+	state.SetBytesProcessed(state.iterations() * static_cast<i64>(std::filesystem::file_size(path)));
+}
+BENCHMARK(BM_ObjImport)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+
+// Mesh optimization
+// The grid mesh with its triangles shuffled, which is close to the worst case
+// for the vertex cache. The ACMR/ATVR counters report the simulated FIFO cache
+// before and after optimizing.
+
+namespace {
+
+auto shuffled_grid_mesh() -> mesh::SoaMesh
+{
+	auto data = make_grid_mesh();
+	auto result = mesh::SoaMesh();
+
+	for (usize i = 0; i < data.vertex_count(); ++i)
+		result.positions.push_back(data.position(i));
+
+	usize triangle_count = data.indices.size() / 3;
+	auto order = std::vector<usize>(triangle_count);
+	for (usize i = 0; i < triangle_count; ++i)
+		order[i] = (i * 7919) % triangle_count; // 7919 is prime, so this is a permutation
+
+	for (usize t : order)
+		for (usize k = 0; k < 3; ++k)
+			result.indices.push_back(data.indices[t * 3 + k]);
+
+	result.submeshes.push_back({ 0, static_cast<u32>(result.indices.size()) });
+	result.compute_bounds();
+
+	return result;
+}
+
+} // namespace
+
+static void BM_MeshOptimize(State& state)
+{
+	const auto source = shuffled_grid_mesh();
+	auto options = mesh::optimize::Options{};
+	options.overdraw = state.range(0) != 0;
+
+	auto report = mesh::optimize::Report{};
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		state.PauseTiming();
+		auto m = source;
+		state.ResumeTiming();
+
+		report = mesh::optimize::optimize(m, options);
+		DoNotOptimize(m.indices.data());
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<i64>(source.indices.size() / 3));
+	state.counters["acmr_before"] = report.before.acmr;
+	state.counters["acmr_after"] = report.after.acmr;
+	state.counters["atvr_before"] = report.before.atvr;
+	state.counters["atvr_after"] = report.after.atvr;
+}
+BENCHMARK(BM_MeshOptimize)->ArgName("overdraw")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+
+// Vertex quantization
+// Interleaving the grid mesh as f32s (0) versus the compact encodings (1). The
+// counters report the resulting vertex size, and the largest position error
+// and normal angle error (in degrees) of the quantized vertices.
+
+namespace {
+
+auto wavy_grid_mesh() -> mesh::SoaMesh
+{
+	auto data = make_grid_mesh();
+	auto result = mesh::SoaMesh();
+
+	for (u32 y = 0; y < k_grid_size; ++y) {
+		for (u32 x = 0; x < k_grid_size; ++x) {
+			flt u = flt(x) / (k_grid_size - 1);
+			flt v = flt(y) / (k_grid_size - 1);
+
+			// The gradient of the height field gives the normal
+			flt du = 6 * std::cos(u * 6) * std::cos(v * 6);
+			flt dv = -6 * std::sin(u * 6) * std::sin(v * 6);
+
+			result.positions.push_back(data.position(y * k_grid_size + x));
+			result.normals.push_back(Vec3{ -du, 1, -dv }.normal());
+			result.uvs.push_back(Vec2{ u, v });
+		}
+	}
+
+	result.indices = data.indices;
+	result.submeshes.push_back({ 0, static_cast<u32>(result.indices.size()) });
+
+	return result;
+}
+
+} // namespace
+
+static void BM_MeshInterleave(State& state)
+{
+	const auto source = wavy_grid_mesh();
+	bool quantized = state.range(0) != 0;
+
+	auto data = mesh::MeshData();
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		data = quantized ? mesh::quantize::interleave(source) : source.interleave();
+		DoNotOptimize(data.vertices.data());
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<i64>(source.vertex_count()));
+	state.counters["bytes_per_vertex"] = data.stride;
+
+	if (quantized) {
+		auto bounds = mesh::quantize::mesh_bounds(source);
+		flt max_position_error = 0;
+		flt min_normal_dot = 1;
+
+		for (usize i = 0; i < source.vertex_count(); ++i) {
+			auto p = std::array<u16, 4>{};
+			auto n = std::array<i16, 2>{};
+			std::memcpy(p.data(), &data.vertices[i * data.stride + data.layout[0].offset], sizeof(p));
+			std::memcpy(n.data(), &data.vertices[i * data.stride + data.layout[1].offset], sizeof(n));
+
+			auto position = mesh::quantize::decode_position(p, bounds);
+			max_position_error = std::max(max_position_error, (position - source.positions[i]).length());
+
+			auto normal = mesh::quantize::decode_octahedral16(n);
+			min_normal_dot = std::min(min_normal_dot, normal | source.normals[i]);
+		}
+
+		state.counters["max_position_error"] = max_position_error;
+		state.counters["max_normal_error_deg"] = math::rad2deg(std::acos(std::min<flt>(min_normal_dot, 1)));
+	}
+}
+BENCHMARK(BM_MeshInterleave)->ArgName("quantized")->Arg(0)->Arg(1);
+
+
+// Draw queue
+// A frame of draws in scene order, each with its own transform, recorded and
+// replayed against a null GL backend. Replaying in recording order (0) is what
+// immediate drawing would do; sorting (1) groups draws by state first. The
+// counters are the program and vertex array switches issued per frame.
+
+namespace {
+
+auto null_gl() -> gfx::Functions
+{
+	auto result = gfx::Functions();
+	result.bind_buffer = [](u32, u32) {};
+	result.bind_vertex_array = [](u32) {};
+	result.use_program = [](u32) {};
+	result.uniform_matrix_4fv = [](i32, i32, bool, const f32*) {};
+	result.uniform_matrix_4x3fv = [](i32, i32, bool, const f32*) {};
+	result.draw_elements = [](u32, i32, u32, const void*) {};
+	result.draw_elements_instanced = [](u32, i32, u32, const void*, i32, u32) {};
+
+	return result;
+}
+
+} // namespace
+
+static void BM_DrawQueue(State& state)
+{
+	constexpr usize draw_count = 10'000;
+	bool sorted = state.range(0) != 0;
+
+	auto items = std::vector<gfx::DrawItem>(draw_count);
+	auto transforms = std::vector<std::array<f32, 16>>(draw_count);
+	for (usize i = 0; i < draw_count; ++i) {
+		auto& item = items[i];
+		item.program = 1 + static_cast<u32>((i * 7) % 16);
+		item.vertex_array = 1 + static_cast<u32>((i * 13) % 256);
+		item.count = 36;
+		item.depth = static_cast<f32>((i * 7919) % draw_count) / draw_count;
+		transforms[i].fill(static_cast<f32>(i));
+	}
+
+	auto gl = gfx::StateCache(null_gl());
+	auto queue = gfx::DrawQueue();
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		queue.clear();
+		for (usize i = 0; i < draw_count; ++i) {
+			queue.push(items[i]);
+			queue.uniform(0, gfx::UniformType::Mat4, transforms[i].data());
+		}
+
+		if (sorted)
+			queue.sort();
+
+		queue.submit(gl);
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<i64>(draw_count));
+
+	auto frames = static_cast<f64>(state.iterations());
+	state.counters["program_switches"] = static_cast<f64>(gl.stats().programs.issued) / frames;
+	state.counters["vao_switches"] = static_cast<f64>(gl.stats().vertex_arrays.issued) / frames;
+}
+BENCHMARK(BM_DrawQueue)->ArgName("sorted")->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+
+// Instancing
+// 10k copies of 8 meshes, each with its own Mat4x3 transform, drawn as one
+// draw per copy with a uniform (0) or batched into instanced draws (1). The
+// counter is the draw calls issued per frame.
+static void BM_InstanceBatching(State& state)
+{
+	constexpr usize copy_count = 10'000;
+	constexpr usize mesh_count = 8;
+	bool batched = state.range(0) != 0;
+
+	auto items = std::vector<gfx::DrawItem>(copy_count);
+	auto transforms = std::vector<std::array<f32, 12>>(copy_count);
+	for (usize i = 0; i < copy_count; ++i) {
+		items[i].program = 1;
+		items[i].vertex_array = 1 + static_cast<u32>(i % mesh_count);
+		items[i].count = 36;
+		transforms[i].fill(static_cast<f32>(i));
+	}
+
+	auto gl = gfx::StateCache(null_gl());
+	auto queue = gfx::DrawQueue();
+	auto batcher = gfx::InstanceBatcher(12);
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		queue.clear();
+
+		if (batched) {
+			batcher.clear();
+			for (usize i = 0; i < copy_count; ++i)
+				batcher.add(items[i], transforms[i].data());
+
+			batcher.build(queue);
+			DoNotOptimize(batcher.instance_data().data());
+		}
+		else {
+			for (usize i = 0; i < copy_count; ++i) {
+				queue.push(items[i]);
+				queue.uniform(0, gfx::UniformType::Mat4x3, transforms[i].data());
+			}
+		}
+
+		queue.sort();
+		queue.submit(gl);
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<i64>(copy_count));
+	state.counters["draws"] = static_cast<f64>(gl.stats().draws) / static_cast<f64>(state.iterations());
+}
+BENCHMARK(BM_InstanceBatching)->ArgName("batched")->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+
+auto main(int argc, char** argv) -> int
+{
+	bench::init_perf_counters(argc, argv);
+
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv))
+		return 1;
+
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+
+	return 0;
+}
 
 // NOLINTEND
+
+
+// Uniform lookup
+// Resolving 32 uniform locations by name each frame: from a map keyed by
+// strings (0), the best a cache of `glGetUniformLocation` results can do, or
+// by compile-time hashed name from a program's reflection (1).
+static void BM_UniformLookup(State& state)
+{
+	constexpr usize uniform_count = 32;
+	bool hashed = state.range(0) != 0;
+
+	auto names = std::vector<std::string>();
+	auto variables = std::vector<gfx::ShaderVariable>();
+	auto by_string = std::unordered_map<std::string, i32>();
+	for (usize i = 0; i < uniform_count; ++i) {
+		names.push_back(fmt::format("u_material.layer{}", i));
+		variables.push_back({ names.back(), static_cast<i32>(i), 0, 1 });
+		by_string.emplace(names.back(), static_cast<i32>(i));
+	}
+
+	auto ids = std::vector<gfx::NameId>();
+	for (const auto& name : names)
+		ids.emplace_back(name);
+
+	auto reflection = gfx::ProgramReflection(variables, {});
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		i32 sum = 0;
+		if (hashed) {
+			for (auto id : ids)
+				sum += reflection.uniform_location(id);
+		}
+		else {
+			for (const auto& name : names)
+				sum += by_string.find(name.c_str())->second;
+		}
+		DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<i64>(uniform_count));
+}
+BENCHMARK(BM_UniformLookup)->ArgName("hashed")->Arg(0)->Arg(1);
+
+
+// Shader parsing
+// A library of 64 shader files of two ~300-line stages each, every stage
+// including a shared file, parsed by the previous line-by-line `std::regex`
+// parser (0), which copied each stage into its own string, and by
+// `gfx::ShaderSource` (1).
+
+namespace {
+
+/** The renderer's original `gl::parse_shaders`, minus the GL types. */
+auto regex_parse_shaders(const std::filesystem::path& file_path) -> std::unordered_map<std::string, std::string>
+{
+	std::unordered_map<std::string, std::string> result;
+	const auto shader_block_pattern = std::regex(R"(#shader (\S+))");
+	auto file = std::ifstream(file_path);
+
+	std::string line;
+	std::smatch matches;
+
+	std::string current_type;
+	std::string current_src;
+
+	while (std::getline(file, line)) {
+		if (std::regex_match(line, matches, shader_block_pattern)) {
+			if (!current_src.empty() && !current_type.empty())
+				result.emplace(current_type, current_src);
+
+			current_type = matches.str(1);
+			current_src.clear();
+		}
+		else if (!current_type.empty()) {
+			current_src.append(line);
+			current_src.push_back('\n');
+		}
+	}
+
+	if (!current_src.empty() && !current_type.empty())
+		result.emplace(current_type, current_src);
+
+	return result;
+}
+
+/** The paths of the benchmark shader library, written on first use. */
+auto shader_library_paths() -> const std::vector<std::filesystem::path>&
+{
+	static const auto result = [] {
+		auto dir = std::filesystem::temp_directory_path() / "bench_shaders";
+		std::filesystem::create_directories(dir);
+
+		auto common = std::ofstream(dir / "common.glsl");
+		for (usize i = 0; i < 100; ++i)
+			common << fmt::format("vec4 helper{0}(vec4 v) {{ return v * {0}.0 + vec4(0.5); }}\n", i);
+
+		auto paths = std::vector<std::filesystem::path>();
+		for (usize file_index = 0; file_index < 64; ++file_index) {
+			paths.push_back(dir / fmt::format("shader{}.shader", file_index));
+			auto file = std::ofstream(paths.back());
+
+			for (const char* stage : { "vertex", "fragment" }) {
+				file << fmt::format("#shader {}\n#version 330 core\n#include \"common.glsl\"\n\n", stage);
+				for (usize i = 0; i < 300; ++i)
+					file << fmt::format("\tvec4 value{0} = helper{1}(vec4({0}.0, 1.0, 2.0, 3.0)); // line {0}\n", i, i % 100);
+				file << "\n";
+			}
+		}
+
+		return paths;
+	}();
+
+	return result;
+}
+
+} // namespace
+
+static void BM_ShaderParse(State& state)
+{
+	const auto& paths = shader_library_paths();
+	bool single_pass = state.range(0) != 0;
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		for (const auto& path : paths) {
+			if (single_pass) {
+				auto source = gfx::ShaderSource(path);
+				DoNotOptimize(source.stages().data());
+			}
+			else {
+				auto sources = regex_parse_shaders(path);
+				DoNotOptimize(sources.size());
+			}
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<i64>(paths.size()));
+}
+BENCHMARK(BM_ShaderParse)->ArgName("single_pass")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+
+// Software rasterization
+// A 1280x720 target covered by a 64x36 grid of quads, four layers deep, each
+// layer nearer than the last, with interpolated colors, drawn by
+// `raster::Rasterizer` with 1, 2, 4 and 8 threads.
+
+namespace {
+
+struct RasterVertex {
+	f32 x, y, z;
+	f32 r, g, b;
+};
+
+auto raster_vertex(const void* /*uniforms*/, const u8* data, u32 /*instance*/, f32* varyings) -> raster::Position
+{
+	auto vertex = RasterVertex();
+	std::memcpy(&vertex, data, sizeof(vertex));
+	varyings[0] = vertex.r;
+	varyings[1] = vertex.g;
+	varyings[2] = vertex.b;
+
+	return { vertex.x, vertex.y, vertex.z, 1 };
+}
+
+auto raster_fragment(const void* /*uniforms*/, const f32* varyings) -> raster::Color
+{
+	return { varyings[0], varyings[1], varyings[2], 1 };
+}
+
+} // namespace
+
+static void BM_Rasterize(State& state)
+{
+	constexpr u32 columns = 64;
+	constexpr u32 rows = 36;
+	constexpr u32 layers = 4;
+
+	auto vertices = std::vector<RasterVertex>();
+	auto indices = std::vector<u32>();
+	for (u32 layer = 0; layer < layers; ++layer) {
+		f32 z = 0.5f - static_cast<f32>(layer) * 0.2f;
+		auto base = static_cast<u32>(vertices.size());
+
+		for (u32 y = 0; y <= rows; ++y)
+			for (u32 x = 0; x <= columns; ++x) {
+				f32 u = static_cast<f32>(x) / columns;
+				f32 v = static_cast<f32>(y) / rows;
+				vertices.push_back({ u * 2 - 1, v * 2 - 1, z, u, v, static_cast<f32>(layer) / layers });
+			}
+
+		for (u32 y = 0; y < rows; ++y)
+			for (u32 x = 0; x < columns; ++x) {
+				u32 i = base + y * (columns + 1) + x;
+				u32 j = i + columns + 1;
+				indices.insert(indices.end(), { i, i + 1, j, j, i + 1, j + 1 });
+			}
+	}
+
+	auto program = raster::Program{ raster_vertex, raster_fragment, 3 };
+	auto item = raster::DrawItem();
+	item.program = &program;
+	item.vertices = { vertices.data(), sizeof(RasterVertex), vertices.size() };
+	item.indices = { indices.data(), indices.size() };
+	item.count = indices.size();
+
+	auto rasterizer = raster::Rasterizer(static_cast<usize>(state.range(0)));
+	auto target = raster::Framebuffer(1280, 720);
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		target.clear({ 0, 0, 0, 1 });
+		rasterizer.draw(target, item);
+		DoNotOptimize(target.colors());
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<i64>(indices.size() / 3));
+}
+BENCHMARK(BM_Rasterize)->ArgName("threads")->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+
+// Occlusion culling
+// A 256x128 `raster::OcclusionBuffer` with a row of 16 walls of 2 triangles
+// each, then 16k boxes scattered behind and in front of them, tested with 1,
+// 2, 4 and 8 threads. Each iteration is a whole frame: clearing, drawing the
+// occluders, building the hierarchical depth and testing the boxes.
+
+static void BM_OcclusionCull(State& state)
+{
+	flt near = 1, far = 200;
+	auto projection = Mat4x4{
+		{ 1, 0, 0, 0 },
+		{ 0, 2, 0, 0 },
+		{ 0, 0, (far + near) / (near - far), -1 },
+		{ 0, 0, 2 * far * near / (near - far), 0 },
+	};
+
+	auto walls = std::vector<Tri>();
+	for (usize i = 0; i < 16; ++i) {
+		flt x = static_cast<flt>(i) * 4 - 32;
+		walls.push_back({ Vec3{ x, -3, -20 }, Vec3{ x + 3, -3, -20 }, Vec3{ x + 3, 3, -20 } });
+		walls.push_back({ Vec3{ x, -3, -20 }, Vec3{ x + 3, 3, -20 }, Vec3{ x, 3, -20 } });
+	}
+
+	auto rng = std::mt19937(0x0cc1);
+	auto random = std::uniform_real_distribution<flt>(-1, 1);
+	auto boxes = std::vector<AABBox>();
+	for (usize i = 0; i < 16384; ++i) {
+		auto center = Vec3{ random(rng) * 40, random(rng) * 8, random(rng) * 30 - 40 };
+		boxes.emplace_back(center - Vec3::all(0.5), center + Vec3::all(0.5));
+	}
+	auto visible = std::vector<u8>(boxes.size());
+
+	auto buffer = raster::OcclusionBuffer(256, 128, static_cast<usize>(state.range(0)));
+	auto model = Mat4x4::identity();
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		buffer.begin(projection);
+		buffer.add_occluders(walls.data(), walls.size(), model);
+		buffer.finish();
+		buffer.test(boxes.data(), boxes.size(), visible.data());
+		DoNotOptimize(visible.data());
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<i64>(boxes.size()));
+	state.counters["occluded"] = static_cast<f64>(buffer.stats().occluded) / static_cast<f64>(buffer.stats().tested);
+}
+BENCHMARK(BM_OcclusionCull)->ArgName("threads")->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+
+// Normals and tangents
+// Generating the wavy grid mesh's normals (angle-weighted) and tangents with
+// 1, 2, 4 and 8 threads.
+
+static void BM_TangentSpace(State& state)
+{
+	auto source = wavy_grid_mesh();
+	source.normals.clear();
+
+	auto options = mesh::tangent_space::Options();
+	options.threads = static_cast<usize>(state.range(0));
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		auto mesh = source;
+		mesh::tangent_space::generate(mesh, options);
+		DoNotOptimize(mesh.tangents.data());
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<i64>(source.indices.size() / 3));
+}
+BENCHMARK(BM_TangentSpace)->ArgName("threads")->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+
+// Mesh simplification
+// Simplifying the wavy grid mesh to 1/2, 1/8 and 1/32 of its triangles, with
+// its normals and uvs. Items are the source triangles, and the counter reports
+// the error of the last collapse relative to the mesh's size.
+
+static void BM_Simplify(State& state)
+{
+	const auto source = wavy_grid_mesh();
+	usize triangles = source.indices.size() / 3;
+
+	auto options = mesh::simplify::Options();
+	options.target_triangles = triangles / static_cast<usize>(state.range(0));
+
+	auto result = mesh::simplify::Result();
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		result = mesh::simplify::simplify(
+			source.indices.data(), source.indices.size(),
+			source.positions.data(), source.vertex_count(),
+			options, source.normals.data(), source.uvs.data());
+		DoNotOptimize(result.indices.data());
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<i64>(triangles));
+	state.counters["error"] = result.error;
+}
+BENCHMARK(BM_Simplify)->ArgName("ratio")->Arg(2)->Arg(8)->Arg(32)->Unit(benchmark::kMillisecond);
+
+// Building 4 levels of detail of the wavy grid mesh split into 1 to 64
+// submeshes of consecutive triangles, which shouldn't cost more the more there
+// are. Items are the source triangles.
+
+static void BM_BuildLods(State& state)
+{
+	auto source = wavy_grid_mesh();
+	auto triangles = static_cast<u32>(source.indices.size() / 3);
+	auto count = static_cast<u32>(state.range(0));
+
+	source.submeshes.clear();
+	for (u32 i = 0; i < count; ++i) {
+		u32 first = triangles * i / count;
+		u32 last = triangles * (i + 1) / count;
+		source.submeshes.push_back({ first * 3, (last - first) * 3 });
+	}
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		auto lods = mesh::simplify::build_lods(source, 4);
+		DoNotOptimize(lods.data());
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<i64>(triangles));
+}
+BENCHMARK(BM_BuildLods)->ArgName("submeshes")->Arg(1)->Arg(8)->Arg(64)->Unit(benchmark::kMillisecond);
+
+
+// Meshlet culling
+// Culling the (optimized) wavy grid mesh's meshlets against a frustum around
+// its middle, seen from above (0) or below (1), and gathering the survivors'
+// triangles into an index buffer. Items are meshlets.
+
+static void BM_MeshletCull(State& state)
+{
+	auto source = wavy_grid_mesh();
+	mesh::optimize::optimize(source);
+	auto meshlets = mesh::meshlet::build(
+		source.indices.data(), source.indices.size(),
+		source.positions.data(), source.vertex_count());
+
+	// The grid spans about 0 to 1 on x and z, with y up
+	auto bounds = math::geo::AABBox::empty();
+	bounds.add(source.positions);
+	auto center = bounds.center();
+	auto planes = std::array<Plane, 4>{
+		Plane{ Vec3::right(), center.x - bounds.size().x * 0.3 },
+		Plane{ -Vec3::right(), -(center.x + bounds.size().x * 0.3) },
+		Plane{ Vec3{ 0, 0, 1 }, center.z - bounds.size().z * 0.3 },
+		Plane{ Vec3{ 0, 0, -1 }, -(center.z + bounds.size().z * 0.3) },
+	};
+	flt height = bounds.size().x * (state.range(0) == 0 ? 2 : -2);
+	auto eye = center + Vec3{ 0, height, 0 };
+
+	auto culler = mesh::meshlet::Culler();
+	auto indices = std::vector<u32>();
+	usize visible = 0;
+
+	auto perf = PerfScope(state);
+	for (auto _ : state) {
+		visible = culler.cull(meshlets, planes.data(), planes.size(), eye, indices);
+		DoNotOptimize(indices.data());
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<i64>(meshlets.size()));
+	state.counters["meshlets"] = static_cast<f64>(meshlets.size());
+	state.counters["visible"] = static_cast<f64>(visible) / static_cast<f64>(meshlets.size());
+}
+BENCHMARK(BM_MeshletCull)->ArgName("below")->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
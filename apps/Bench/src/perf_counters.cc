@@ -0,0 +1,226 @@
+#include "perf_counters.h"
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+#include <fmt/format.h>
+
+#ifdef __linux__
+	#include <linux/perf_event.h>
+	#include <sys/ioctl.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+#endif
+
+namespace bench {
+
+namespace {
+
+std::unique_ptr<PerfCounters> s_counters; // NOLINT(*-avoid-non-const-global-variables)
+
+
+#ifdef __linux__
+
+struct EventConfig {
+	u32 type;
+	u64 config;
+};
+
+constexpr auto cache_event(u64 cache, u64 op, u64 result) -> u64
+{
+	return cache | (op << 8) | (result << 16);
+}
+
+constexpr std::array<EventConfig, PerfCounters::EventCount> k_configs {{
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+	{ PERF_TYPE_HW_CACHE, cache_event(
+		PERF_COUNT_HW_CACHE_L1D,
+		PERF_COUNT_HW_CACHE_OP_READ,
+		PERF_COUNT_HW_CACHE_RESULT_MISS) },
+	{ PERF_TYPE_HW_CACHE, cache_event(
+		PERF_COUNT_HW_CACHE_LL,
+		PERF_COUNT_HW_CACHE_OP_READ,
+		PERF_COUNT_HW_CACHE_RESULT_MISS) },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+}};
+
+/** Layout of a `read()` from a counter opened with `k_read_format`. */
+struct ReadFormat {
+	u64 value;
+	u64 time_enabled;
+	u64 time_running;
+};
+
+constexpr u64 k_read_format
+	= PERF_FORMAT_TOTAL_TIME_ENABLED
+	| PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+auto open_event(const EventConfig& event) -> i32
+{
+	perf_event_attr attr {};
+	attr.size = sizeof(perf_event_attr);
+	attr.type = event.type;
+	attr.config = event.config;
+	attr.read_format = k_read_format;
+	attr.disabled = 1;
+	// User-space only, so that we work under the default `perf_event_paranoid`
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	// pid = 0, cpu = -1: the calling thread, on any CPU
+	auto fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+
+	return static_cast<i32>(fd);
+}
+
+#endif
+
+} // namespace
+
+
+// PerfCounters ----------------------------------------------------------------
+
+PerfCounters::PerfCounters()
+{
+	m_fds.fill(-1);
+
+#ifdef __linux__
+	for (usize i = 0; i < EventCount; ++i)
+		m_fds[i] = open_event(k_configs[i]);
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+	for (i32 fd : m_fds)
+		if (fd >= 0) close(fd);
+#endif
+}
+
+auto PerfCounters::available() const -> bool
+{
+	for (i32 fd : m_fds)
+		if (fd >= 0) return true;
+
+	return false;
+}
+
+void PerfCounters::start()
+{
+#ifdef __linux__
+	for (i32 fd : m_fds) {
+		if (fd < 0) continue;
+
+		ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+		ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+	}
+#endif
+}
+
+auto PerfCounters::stop() -> Sample
+{
+	Sample result;
+
+#ifdef __linux__
+	for (i32 fd : m_fds)
+		if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+	for (usize i = 0; i < EventCount; ++i) {
+		if (m_fds[i] < 0) continue;
+
+		ReadFormat data {};
+		if (read(m_fds[i], &data, sizeof(data)) != sizeof(data) || data.time_running == 0)
+			continue;
+
+		// If the kernel had to multiplex the PMU between more events than it has
+		// hardware counters, extrapolate from the fraction of time we were live
+		auto scale = static_cast<f64>(data.time_enabled) / static_cast<f64>(data.time_running);
+
+		result.values[i] = static_cast<f64>(data.value) * scale;
+		result.valid[i] = true;
+	}
+#endif
+
+	return result;
+}
+
+
+// Initialization --------------------------------------------------------------
+
+void init_perf_counters(int& argc, char** argv)
+{
+	constexpr std::string_view flag = "--perf_counters";
+
+	bool requested = false;
+	int out = 1;
+	for (int in = 1; in < argc; ++in) {
+		if (flag == argv[in]) // NOLINT(*-pointer-arithmetic)
+			requested = true;
+		else
+			argv[out++] = argv[in]; // NOLINT(*-pointer-arithmetic)
+	}
+	argc = out;
+
+	if (!requested)
+		return;
+
+	auto counters = std::make_unique<PerfCounters>();
+	if (!counters->available()) {
+		int error = errno;
+		fmt::print(stderr,
+			"Warning: hardware performance counters are unavailable ({}){}. "
+			"Continuing with wall-time only.\n",
+			std::strerror(error), // NOLINT(concurrency-mt-unsafe)
+			(error == EACCES || error == EPERM)
+				? "; check /proc/sys/kernel/perf_event_paranoid"
+				: "");
+		return;
+	}
+
+	s_counters = std::move(counters);
+}
+
+auto perf_counters() -> PerfCounters*
+{
+	return s_counters.get();
+}
+
+
+// PerfScope -------------------------------------------------------------------
+
+PerfScope::PerfScope(benchmark::State& state)
+	: m_state(state)
+	, m_counters(perf_counters())
+{
+	if (m_counters)
+		m_counters->start();
+}
+
+PerfScope::~PerfScope()
+{
+	if (!m_counters)
+		return;
+
+	using benchmark::Counter;
+
+	auto sample = m_counters->stop();
+
+	for (usize i = 0; i < PerfCounters::EventCount; ++i)
+		if (sample.valid[i])
+			m_state.counters[PerfCounters::k_names[i]]
+				= Counter(sample.values[i], Counter::kAvgIterations);
+
+	if (sample.valid[PerfCounters::Cycles]
+		&& sample.valid[PerfCounters::Instructions]
+		&& sample.values[PerfCounters::Cycles] > 0)
+	{
+		m_state.counters["IPC"] = sample.values[PerfCounters::Instructions]
+			/ sample.values[PerfCounters::Cycles];
+	}
+}
+
+} // namespace bench
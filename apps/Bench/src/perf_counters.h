@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+
+#include <benchmark/benchmark.h>
+#include <sized.h>
+
+namespace bench {
+using namespace sized;
+
+/**
+ * A handful of hardware performance counters, opened for the calling thread
+ * directly via `perf_event_open`.
+ *
+ * Each counter is opened independently, so a counter that the kernel refuses
+ * (e.g. due to `perf_event_paranoid`, a virtualized PMU, or a CPU that doesn't
+ * expose the event) is simply skipped. On non-Linux platforms, no counters are
+ * ever available.
+ */
+class PerfCounters {
+public:
+	enum Event : usize {
+		Cycles,
+		Instructions,
+		L1DMisses,
+		LLCMisses,
+		BranchMisses,
+		EventCount,
+	};
+
+	/** The counter name reported for each `Event`. */
+	static constexpr std::array<const char*, EventCount> k_names {
+		"cycles",
+		"instructions",
+		"L1D-misses",
+		"LLC-misses",
+		"branch-misses",
+	};
+
+	struct Sample {
+		/** Counter values, scaled to compensate for kernel multiplexing. */
+		std::array<f64, EventCount> values {};
+		/** Whether the corresponding entry in `values` was actually measured. */
+		std::array<bool, EventCount> valid {};
+	};
+
+	PerfCounters();
+	~PerfCounters();
+
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+
+	PerfCounters(PerfCounters&&) = delete;
+	PerfCounters& operator=(PerfCounters&&) = delete;
+
+	/** Whether at least one counter could be opened. */
+	auto available() const -> bool;
+
+	/** Reset and enable all open counters. */
+	void start();
+	/** Disable all open counters and read their values. */
+	auto stop() -> Sample;
+
+private:
+	std::array<i32, EventCount> m_fds {};
+};
+
+/**
+ * Consume the `--perf_counters` flag (if present) from the command-line
+ * arguments and, if it was found, open the process-wide counters. Must be
+ * called before `benchmark::Initialize`, which rejects unrecognized flags.
+ */
+void init_perf_counters(int& argc, char** argv);
+
+/**
+ * The process-wide counters, or `nullptr` if they weren't requested or none of
+ * them could be opened.
+ */
+auto perf_counters() -> PerfCounters*;
+
+/**
+ * Measures the hardware counters from construction until destruction and
+ * reports them as per-iteration user counters on the benchmark state. Construct
+ * one immediately before the benchmark loop. Does nothing unless counters were
+ * enabled with `init_perf_counters`.
+ */
+class PerfScope {
+public:
+	explicit PerfScope(benchmark::State& state);
+	~PerfScope();
+
+	PerfScope(const PerfScope&) = delete;
+	PerfScope& operator=(const PerfScope&) = delete;
+
+	PerfScope(PerfScope&&) = delete;
+	PerfScope& operator=(PerfScope&&) = delete;
+
+private:
+	benchmark::State& m_state;
+	PerfCounters* m_counters = nullptr;
+};
+
+} // namespace bench
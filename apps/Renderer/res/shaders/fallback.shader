@@ -0,0 +1,26 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 position;
+layout(location = 4) in mat4x3 a_transform;
+
+#include "frame.glsl"
+
+void main()
+{
+	gl_Position = u_view * vec4(a_transform * vec4(position.xyz, 1.0), 1.0);
+}
+
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+#include "frame.glsl"
+
+// Drawn while the real program compiles: just the base color, untinted
+void main()
+{
+	color = u_color;
+}
@@ -0,0 +1,5 @@
+// Set once a frame: see `FrameBlock` in frame.h
+layout(std140) uniform Frame {
+	mat4 u_view;
+	vec4 u_color;
+};
@@ -0,0 +1,30 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 position;
+// One row of a row-vector `Mat4x3` transform per column
+layout(location = 4) in mat4x3 a_transform;
+
+#include "frame.glsl"
+
+void main()
+{
+	gl_Position = u_view * vec4(a_transform * vec4(position.xyz, 1.0), 1.0);
+}
+
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+#include "frame.glsl"
+
+layout(std140) uniform Object {
+	vec4 u_tint;
+};
+
+void main()
+{
+	color = u_color * u_tint;
+}
@@ -294,6 +294,23 @@ inline void enable_vertex_attrib_array(u32 index)
 	glEnableVertexAttribArray(index);
 }
 
+/**
+ * @brief modify the rate at which generic vertex attributes advance during
+ * instanced rendering
+ *
+ * @param index Specifies the index of the generic vertex attribute.
+ *
+ * @param divisor
+ * Specifies the number of instances that will pass between updates of the
+ * generic attribute at slot `index`, or 0 to advance once per vertex.
+ *
+ * @see https://docs.gl/gl4/glVertexAttribDivisor
+ */
+inline void vertex_attrib_divisor(u32 index, u32 divisor)
+{
+	glVertexAttribDivisor(index, divisor);
+}
+
 /**
  * @brief Disable a generic vertex attribute array
  * @param index Specifies the index of the generic vertex attribute.
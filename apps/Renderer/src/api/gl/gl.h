@@ -9,6 +9,7 @@
 
 #include "api/gl/attributes.h"
 #include "api/gl/shader.h"
+#include "api/gl/state.h"
 #include "api/gl/types.h"
 #include "api/gl/uniforms.h"
 
@@ -33,19 +34,23 @@ inline void gen_vertex_arrays(i32 n, u32 out_buffers[])
 	glGenVertexArrays(n, out_buffers);
 }
 
+/** Skipped if `vertex_array` is already bound. @see `gl::state` */
 inline void bind_vertex_array(u32 vertex_array)
 {
-	glBindVertexArray(vertex_array);
+	state().bind_vertex_array(vertex_array);
 }
 
 inline void delete_vertex_arrays(i32 n, const u32 arrays[])
 {
+	for (i32 i = 0; i < n; ++i)
+		state().forget_vertex_array(arrays[i]);
+
 	glDeleteVertexArrays(n, arrays);
 }
 
 inline void delete_vertex_array(u32 array)
 {
-	glDeleteVertexArrays(1, &array);
+	gl::delete_vertex_arrays(1, &array);
 }
 
 /** @see `gen_buffers` */
@@ -78,11 +83,40 @@ inline void gen_buffers(i32 n, u32 out_buffers[])
  * @param target Specifies the target to which the buffer object is bound.
  * @param buffer Specifies the name of a buffer object.
  *
+ * Skipped if `buffer` is already bound to `target`. @see `gl::state`
+ *
  * @see https://docs.gl/gl4/glBindBuffer
  */
 inline void bind_buffer(Target target, u32 buffer)
 {
-	glBindBuffer(static_cast<GLenum>(target), buffer);
+	state().bind_buffer(static_cast<GLenum>(target), buffer);
+}
+
+/**
+ * @brief bind a buffer object to an indexed buffer target
+ *
+ * Also binds `buffer` to the generic `target`. Skipped if `buffer` is already
+ * bound to the binding point. @see `gl::state`
+ *
+ * @see https://docs.gl/gl4/glBindBufferBase
+ */
+inline void bind_buffer_base(Target target, u32 index, u32 buffer)
+{
+	state().bind_buffer_base(static_cast<GLenum>(target), index, buffer);
+}
+
+/**
+ * @brief bind a range within a buffer object to an indexed buffer target
+ *
+ * `offset` must be a multiple of the target's offset alignment, e.g.
+ * `Limit::UniformBufferOffsetAlignment`. Skipped if the range is already bound
+ * to the binding point. @see `gl::state`
+ *
+ * @see https://docs.gl/gl4/glBindBufferRange
+ */
+inline void bind_buffer_range(Target target, u32 index, u32 buffer, usize offset, usize size)
+{
+	state().bind_buffer_range(static_cast<GLenum>(target), index, buffer, offset, size);
 }
 
 /**
@@ -106,6 +140,24 @@ inline void buffer_data(Target target, i32 size, const void* data, Usage usage)
 	glBufferData(static_cast<GLenum>(target), size, data, static_cast<GLenum>(usage));
 }
 
+/**
+ * @brief updates a subset of a buffer object's data store
+ *
+ * @param offset
+ * Specifies the offset into the buffer object's data store where data
+ * replacement will begin, measured in bytes.
+ *
+ * @see https://docs.gl/gl4/glBufferSubData
+ */
+inline void buffer_sub_data(Target target, usize offset, usize size, const void* data)
+{
+	glBufferSubData(
+		static_cast<GLenum>(target),
+		static_cast<GLintptr>(offset),
+		static_cast<GLsizeiptr>(size),
+		data);
+}
+
 /**
  * @brief clear buffers to preset values
  *
@@ -165,7 +217,7 @@ inline void draw_elements(DrawMode mode, i32 count, const Unsigned indices[]);
 template <>
 inline void draw_elements(DrawMode mode, i32 count, const u8 indices[])
 {
-	glDrawElements(static_cast<GLenum>(mode), count, GL_UNSIGNED_BYTE, indices);
+	state().draw_elements(static_cast<GLenum>(mode), count, GL_UNSIGNED_BYTE, indices);
 }
 /**
  * @brief render primitives from array data
@@ -182,7 +234,7 @@ inline void draw_elements(DrawMode mode, i32 count, const u8 indices[])
 template <>
 inline void draw_elements(DrawMode mode, i32 count, const u16 indices[])
 {
-	glDrawElements(static_cast<GLenum>(mode), count, GL_UNSIGNED_SHORT, indices);
+	state().draw_elements(static_cast<GLenum>(mode), count, GL_UNSIGNED_SHORT, indices);
 }
 /**
  * @brief render primitives from array data
@@ -199,7 +251,123 @@ inline void draw_elements(DrawMode mode, i32 count, const u16 indices[])
 template <>
 inline void draw_elements(DrawMode mode, i32 count, const u32 indices[])
 {
-	glDrawElements(static_cast<GLenum>(mode), count, GL_UNSIGNED_INT, indices);
+	state().draw_elements(static_cast<GLenum>(mode), count, GL_UNSIGNED_INT, indices);
+}
+
+/**
+ * @brief draw multiple instances of a set of elements
+ *
+ * @param mode Specifies what kind of primitives to render.
+ * @param count Specifies the number of elements to be rendered.
+ *
+ * @param indices
+ * Specifies an offset of the first index in the array in the data store of the
+ * buffer currently bound to the `gl::BufferTarget::ElementArray` target.
+ *
+ * @param instance_count
+ * Specifies the number of instances of the specified range of indices to be
+ * rendered.
+ *
+ * @param base_instance
+ * Specifies the base instance for use in fetching instanced vertex attributes.
+ * Non-zero values require OpenGL 4.2 or `ARB_base_instance`.
+ *
+ * @see https://docs.gl/gl4/glDrawElementsInstanced
+ * @see https://docs.gl/gl4/glDrawElementsInstancedBaseInstance
+ */
+template <typename Unsigned>
+inline void draw_elements_instanced(
+	DrawMode mode, i32 count, const Unsigned indices[],
+	i32 instance_count, u32 base_instance = 0);
+/**
+ * @brief draw multiple instances of a set of elements
+ *
+ * @param mode Specifies what kind of primitives to render.
+ * @param count Specifies the number of elements to be rendered.
+ *
+ * @param indices
+ * Specifies an offset of the first index in the array in the data store of the
+ * buffer currently bound to the `gl::BufferTarget::ElementArray` target.
+ *
+ * @param instance_count
+ * Specifies the number of instances of the specified range of indices to be
+ * rendered.
+ *
+ * @param base_instance
+ * Specifies the base instance for use in fetching instanced vertex attributes.
+ * Non-zero values require OpenGL 4.2 or `ARB_base_instance`.
+ *
+ * @see https://docs.gl/gl4/glDrawElementsInstanced
+ * @see https://docs.gl/gl4/glDrawElementsInstancedBaseInstance
+ */
+template <>
+inline void draw_elements_instanced(
+	DrawMode mode, i32 count, const u8 indices[],
+	i32 instance_count, u32 base_instance)
+{
+	state().draw_elements_instanced(
+		static_cast<GLenum>(mode), count, GL_UNSIGNED_BYTE, indices,
+		instance_count, base_instance);
+}
+/**
+ * @brief draw multiple instances of a set of elements
+ *
+ * @param mode Specifies what kind of primitives to render.
+ * @param count Specifies the number of elements to be rendered.
+ *
+ * @param indices
+ * Specifies an offset of the first index in the array in the data store of the
+ * buffer currently bound to the `gl::BufferTarget::ElementArray` target.
+ *
+ * @param instance_count
+ * Specifies the number of instances of the specified range of indices to be
+ * rendered.
+ *
+ * @param base_instance
+ * Specifies the base instance for use in fetching instanced vertex attributes.
+ * Non-zero values require OpenGL 4.2 or `ARB_base_instance`.
+ *
+ * @see https://docs.gl/gl4/glDrawElementsInstanced
+ * @see https://docs.gl/gl4/glDrawElementsInstancedBaseInstance
+ */
+template <>
+inline void draw_elements_instanced(
+	DrawMode mode, i32 count, const u16 indices[],
+	i32 instance_count, u32 base_instance)
+{
+	state().draw_elements_instanced(
+		static_cast<GLenum>(mode), count, GL_UNSIGNED_SHORT, indices,
+		instance_count, base_instance);
+}
+/**
+ * @brief draw multiple instances of a set of elements
+ *
+ * @param mode Specifies what kind of primitives to render.
+ * @param count Specifies the number of elements to be rendered.
+ *
+ * @param indices
+ * Specifies an offset of the first index in the array in the data store of the
+ * buffer currently bound to the `gl::BufferTarget::ElementArray` target.
+ *
+ * @param instance_count
+ * Specifies the number of instances of the specified range of indices to be
+ * rendered.
+ *
+ * @param base_instance
+ * Specifies the base instance for use in fetching instanced vertex attributes.
+ * Non-zero values require OpenGL 4.2 or `ARB_base_instance`.
+ *
+ * @see https://docs.gl/gl4/glDrawElementsInstanced
+ * @see https://docs.gl/gl4/glDrawElementsInstancedBaseInstance
+ */
+template <>
+inline void draw_elements_instanced(
+	DrawMode mode, i32 count, const u32 indices[],
+	i32 instance_count, u32 base_instance)
+{
+	state().draw_elements_instanced(
+		static_cast<GLenum>(mode), count, GL_UNSIGNED_INT, indices,
+		instance_count, base_instance);
 }
 
 /**
@@ -221,14 +389,28 @@ inline auto get_string(Info name, u32 index) -> char const*
 	return reinterpret_cast<const char*>(glGetStringi(static_cast<GLenum>(name), index));
 }
 
+/**
+ * @brief return the value of an implementation-dependent limit
+ * @see https://docs.gl/gl4/glGet
+ */
+inline auto get_integer(Limit name) -> i32
+{
+	i32 result = 0;
+	glGetIntegerv(static_cast<GLenum>(name), &result);
+	return result;
+}
+
 inline void delete_buffers(i32 n, const u32 buffers[])
 {
+	for (i32 i = 0; i < n; ++i)
+		state().forget_buffer(buffers[i]);
+
 	glDeleteBuffers(n, buffers);
 }
 
 inline void delete_buffer(u32 buffer)
 {
-	glDeleteBuffers(1, &buffer);
+	gl::delete_buffers(1, &buffer);
 }
 
 /**
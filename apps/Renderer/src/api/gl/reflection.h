@@ -0,0 +1,49 @@
+#pragma once
+
+#include <unordered_map>
+
+#include <gfx/reflection.h>
+#include <sized.h>
+
+#include "api/gl/state.h"
+
+
+namespace gl {
+using namespace sized;
+using gfx::NameId;
+using namespace gfx::literals; // NOLINT(*-using-namespace)
+
+/** The reflection of every linked program, by name. */
+inline auto reflections() -> std::unordered_map<u32, gfx::ProgramReflection>&
+{
+	static auto result = std::unordered_map<u32, gfx::ProgramReflection>();
+	return result;
+}
+
+/**
+ * The active uniforms and attributes of a program. They're queried when it's
+ * linked through `gl::link_program`, or else on the first call.
+ */
+inline auto reflect(u32 program) -> const gfx::ProgramReflection&
+{
+	auto& cache = reflections();
+	auto it = cache.find(program);
+	if (it == cache.end())
+		it = cache.emplace(program, gfx::reflect(functions(), program)).first;
+
+	return it->second;
+}
+
+/** Resolve a uniform's location without any string work, e.g. `"u_color"_id`. */
+inline auto get_uniform_location(u32 program, NameId name) -> i32
+{
+	return reflect(program).uniform_location(name);
+}
+
+/** Resolve an attribute's location without any string work. */
+inline auto get_attrib_location(u32 program, NameId name) -> i32
+{
+	return reflect(program).attribute_location(name);
+}
+
+} // namespace gl
@@ -1,15 +1,19 @@
 #pragma once
 
 #include <filesystem>
-#include <fstream>
-#include <regex>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include <GL/glew.h>
 #include <fmt/format.h>
+#include <gfx/program_cache.h>
+#include <gfx/shader_source.h>
 #include <sized.h>
 
+#include "api/gl/reflection.h"
+#include "api/gl/state.h"
 #include "api/gl/types.h"
 
 namespace gl {
@@ -49,7 +53,56 @@ inline void delete_shader(u32 shader)
 
 inline void link_program(u32 program)
 {
+	// Linking resets the program's uniforms, and may change their locations
+	state().forget_program(program);
 	glLinkProgram(program);
+
+	reflections().insert_or_assign(program, gfx::reflect(functions(), program));
+}
+
+inline auto get_program_link_status(u32 program) -> bool
+{
+	i32 result;
+	glGetProgramiv(program, GL_LINK_STATUS, &result);
+
+	return result == GL_TRUE;
+}
+
+/**
+ * @brief Loads a program object with a program binary
+ *
+ * Like `link_program`, this resets the program's uniforms. Check
+ * `get_program_link_status` afterwards, since the driver may reject it.
+ *
+ * @see https://docs.gl/gl4/glProgramBinary
+ */
+inline void program_binary(u32 program, const gfx::ProgramBinary& binary)
+{
+	state().forget_program(program);
+	glProgramBinary(program, binary.format, binary.data.data(), static_cast<GLsizei>(binary.data.size()));
+
+	if (gl::get_program_link_status(program))
+		reflections().insert_or_assign(program, gfx::reflect(functions(), program));
+}
+
+/**
+ * @brief Returns a binary representation of a linked program object
+ *
+ * Best linked after setting `GL_PROGRAM_BINARY_RETRIEVABLE_HINT`.
+ *
+ * @see https://docs.gl/gl4/glGetProgramBinary
+ */
+inline auto get_program_binary(u32 program) -> gfx::ProgramBinary
+{
+	i32 length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+	auto result = gfx::ProgramBinary();
+	result.data.resize(static_cast<usize>(length));
+	glGetProgramBinary(program, length, &length, &result.format, result.data.data());
+	result.data.resize(static_cast<usize>(length));
+
+	return result;
 }
 
 /**
@@ -152,13 +205,16 @@ inline auto is_shader(u32 name) -> bool
 	return glIsShader(name);
 }
 
+/** Skipped if `program` is already in use. @see `gl::state` */
 inline void use_program(u32 program)
 {
-	glUseProgram(program);
+	state().use_program(program);
 }
 
 inline void delete_program(u32 program)
 {
+	state().forget_program(program);
+	reflections().erase(program);
 	glDeleteProgram(program);
 }
 
@@ -175,47 +231,20 @@ inline auto shader_type_name(Shader type) -> std::string
 	}
 }
 
-static auto shader_type(const std::string& keyword) -> Shader
-{
-	if (keyword == "vertex") return Shader::Vertex;
-	if (keyword == "fragment") return Shader::Fragment;
-	if (keyword == "compute") return Shader::Compute;
-	if (keyword == "tessc") return Shader::TessControl;
-	if (keyword == "tesse") return Shader::TessEval;
-	if (keyword == "geometry") return Shader::Geometry;
-	return Shader::_none;
-}
+static_assert(static_cast<GLenum>(gfx::ShaderStage::Vertex) == GL_VERTEX_SHADER);
+static_assert(static_cast<GLenum>(gfx::ShaderStage::Fragment) == GL_FRAGMENT_SHADER);
+static_assert(static_cast<GLenum>(gfx::ShaderStage::Geometry) == GL_GEOMETRY_SHADER);
+static_assert(static_cast<GLenum>(gfx::ShaderStage::TessControl) == GL_TESS_CONTROL_SHADER);
+static_assert(static_cast<GLenum>(gfx::ShaderStage::TessEval) == GL_TESS_EVALUATION_SHADER);
+static_assert(static_cast<GLenum>(gfx::ShaderStage::Compute) == GL_COMPUTE_SHADER);
 
-inline auto parse_shaders(const fs::path& file_path) -> std::unordered_map<Shader, std::string>
+/**
+ * Split a `.shader` file into its stages, expanding `#include`s. Throws
+ * `gfx::ShaderError` if it or an include can't be read.
+ */
+inline auto parse_shaders(const fs::path& file_path) -> gfx::ShaderSource
 {
-	std::unordered_map<Shader, std::string> result;
-	const auto shader_block_pattern = std::regex(R"(#shader (\S+))");
-	auto file = std::ifstream(file_path);
-
-	std::string line;
-	std::smatch matches;
-
-	auto current_type = Shader::_none;
-	std::string current_src;
-
-	while (std::getline(file, line)) {
-		if (std::regex_match(line, matches, shader_block_pattern)) {
-			if (!current_src.empty() && current_type != Shader::_none)
-				result.emplace(current_type, current_src);
-
-			current_type = gl::shader_type(matches.str(1));
-			current_src.clear();
-		}
-		else if (current_type != Shader::_none) {
-			current_src.append(line);
-			current_src.push_back('\n');
-		}
-	}
-
-	if (!current_src.empty() && current_type != Shader::_none)
-		result.emplace(current_type, current_src);
-
-	return result;
+	return gfx::ShaderSource(file_path);
 }
 
 inline auto compile_shader(Shader type, const char* source) -> u32
@@ -245,16 +274,49 @@ inline auto compile_shader(Shader type, const std::string& source) -> u32
 	return compile_shader(type, source.c_str());
 }
 
-inline auto make_program(const fs::path& shader_path) -> u32
+/**
+ * Compile a stage of a parsed shader file, passing its pieces to GL as they
+ * are. Errors are printed with file names in place of source string numbers.
+ */
+inline auto compile_shader(const gfx::ShaderSource& source, const gfx::ShaderSource::Stage& stage) -> u32
+{
+	auto type = static_cast<Shader>(stage.type);
+	u32 shader = gl::create_shader(type);
+
+	auto strings = std::vector<const char*>();
+	auto lengths = std::vector<i32>();
+	for (auto piece : stage.pieces) {
+		strings.push_back(piece.data());
+		lengths.push_back(static_cast<i32>(piece.size()));
+	}
+
+	gl::shader_source(shader, static_cast<i32>(strings.size()), strings.data(), lengths.data());
+	gl::compile_shader(shader);
+
+	if (!gl::get_shader_compile_status(shader)) {
+		auto message = std::string(static_cast<usize>(gl::get_shader_info_log_length(shader)), '\0');
+		gl::get_shader_info_log(shader, static_cast<i32>(message.size()), nullptr, message.data());
+
+		fmt::print("\nError compiling {}:\n{}\n{}\n",
+			gl::shader_type_name(type),
+			std::string(40, '-'),
+			source.annotate_log(message.c_str()));
+	}
+
+	return shader;
+}
+
+inline auto make_program(const gfx::ShaderSource& source, bool retrievable = false) -> u32
 {
 	u32 program = gl::create_program();
-	auto sources = gl::parse_shaders(shader_path);
+	if (retrievable)
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 
 	std::vector<u32> shaders;
-	shaders.reserve(sources.size());
+	shaders.reserve(source.stages().size());
 
-	for (auto [type, source] : sources) {
-		u32 shader = gl::compile_shader(type, source);
+	for (const auto& stage : source.stages()) {
+		u32 shader = gl::compile_shader(source, stage);
 		gl::attach_shader(program, shader);
 		shaders.push_back(shader);
 	}
@@ -270,6 +332,46 @@ inline auto make_program(const fs::path& shader_path) -> u32
 	return program;
 }
 
+inline auto make_program(const fs::path& shader_path) -> u32
+{
+	return gl::make_program(gl::parse_shaders(shader_path));
+}
+
+/**
+ * Load the program from `cache` if it was built from the same sources with
+ * this driver before, or else build it and store it there.
+ */
+inline auto make_program(const fs::path& shader_path, gfx::ProgramCache& cache) -> u32
+{
+	auto source = gl::parse_shaders(shader_path);
+
+	auto texts = std::vector<std::string>();
+	auto stages = std::vector<std::pair<u32, std::string_view>>();
+	for (const auto& stage : source.stages())
+		texts.push_back(stage.text());
+	for (usize i = 0; i < texts.size(); ++i)
+		stages.emplace_back(static_cast<u32>(source.stages()[i].type), texts[i]);
+
+	u64 key = gfx::ProgramCache::key(std::move(stages));
+
+	if (auto binary = cache.load(key)) {
+		u32 program = gl::create_program();
+		gl::program_binary(program, *binary);
+		if (gl::get_program_link_status(program))
+			return program;
+
+		// The driver rejected it, so rebuild and replace it
+		gl::delete_program(program);
+		cache.remove(key);
+	}
+
+	u32 program = gl::make_program(source, true);
+	if (gl::get_program_link_status(program))
+		cache.store(key, gl::get_program_binary(program));
+
+	return program;
+}
+
 template <typename... Args>
 inline auto link_program(Args... shaders) -> u32
 {
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <gfx/functions.h>
+#include <gfx/state_cache.h>
+#include <sized.h>
+
+
+namespace gl {
+using namespace sized;
+
+/** The real OpenGL entry points, for the `gfx` layer. */
+inline auto functions() -> const gfx::Functions&
+{
+	static const auto result = gfx::Functions{
+		.gen_buffer = []() -> u32 {
+			u32 result;
+			glGenBuffers(1, &result);
+			return result;
+		},
+		.delete_buffer = [](u32 buffer) { glDeleteBuffers(1, &buffer); },
+		.bind_buffer = [](u32 target, u32 buffer) { glBindBuffer(target, buffer); },
+		.bind_buffer_base = [](u32 target, u32 index, u32 buffer) { glBindBufferBase(target, index, buffer); },
+		.bind_buffer_range = [](u32 target, u32 index, u32 buffer, usize offset, usize size) {
+			glBindBufferRange(target, index, buffer, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size));
+		},
+		.buffer_storage = [](u32 target, usize size, const void* data, u32 flags) {
+			glBufferStorage(target, static_cast<GLsizeiptr>(size), data, flags);
+		},
+		.map_buffer_range = [](u32 target, usize offset, usize length, u32 access) -> void* {
+			return glMapBufferRange(target, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(length), access);
+		},
+		.unmap_buffer = [](u32 target) -> bool { return glUnmapBuffer(target) == GL_TRUE; },
+		.bind_vertex_array = [](u32 array) { glBindVertexArray(array); },
+		.use_program = [](u32 program) { glUseProgram(program); },
+
+		.create_shader = [](u32 type) -> u32 { return glCreateShader(type); },
+		.shader_source = [](u32 shader, i32 count, const char* const* strings, const i32* lengths) {
+			glShaderSource(shader, count, strings, lengths);
+		},
+		.compile_shader = [](u32 shader) { glCompileShader(shader); },
+		.get_shader_iv = [](u32 shader, u32 pname) -> i32 {
+			i32 result = 0;
+			glGetShaderiv(shader, pname, &result);
+			return result;
+		},
+		.get_shader_info_log = [](u32 shader, i32 buffer_size, i32* length, char* log) {
+			glGetShaderInfoLog(shader, buffer_size, length, log);
+		},
+		.delete_shader = [](u32 shader) { glDeleteShader(shader); },
+
+		.create_program = []() -> u32 { return glCreateProgram(); },
+		.attach_shader = [](u32 program, u32 shader) { glAttachShader(program, shader); },
+		.link_program = [](u32 program) { glLinkProgram(program); },
+		.get_program_info_log = [](u32 program, i32 buffer_size, i32* length, char* log) {
+			glGetProgramInfoLog(program, buffer_size, length, log);
+		},
+		.delete_program = [](u32 program) { glDeleteProgram(program); },
+		.program_parameter_i = [](u32 program, u32 pname, i32 value) { glProgramParameteri(program, pname, value); },
+		.program_binary = [](u32 program, u32 format, const void* binary, i32 length) {
+			glProgramBinary(program, format, binary, length);
+		},
+		.get_program_binary = [](u32 program, i32 buffer_size, i32* length, u32* format, void* binary) {
+			glGetProgramBinary(program, buffer_size, length, format, binary);
+		},
+		.max_shader_compiler_threads = [](u32 count) {
+			if (GLEW_KHR_parallel_shader_compile)
+				glMaxShaderCompilerThreadsKHR(count);
+			else if (GLEW_ARB_parallel_shader_compile)
+				glMaxShaderCompilerThreadsARB(count);
+		},
+
+		.get_program_iv = [](u32 program, u32 pname) -> i32 {
+			i32 result = 0;
+			glGetProgramiv(program, pname, &result);
+			return result;
+		},
+		.get_active_uniform = [](
+			u32 program, u32 index, i32 buffer_size,
+			i32* length, i32* size, u32* type, char* name)
+		{
+			glGetActiveUniform(program, index, buffer_size, length, size, type, name);
+		},
+		.get_active_attrib = [](
+			u32 program, u32 index, i32 buffer_size,
+			i32* length, i32* size, u32* type, char* name)
+		{
+			glGetActiveAttrib(program, index, buffer_size, length, size, type, name);
+		},
+		.get_uniform_location = [](u32 program, const char* name) -> i32 {
+			return glGetUniformLocation(program, name);
+		},
+		.get_attrib_location = [](u32 program, const char* name) -> i32 {
+			return glGetAttribLocation(program, name);
+		},
+
+		.uniform_1f = [](i32 location, f32 v0) { glUniform1f(location, v0); },
+		.uniform_2f = [](i32 location, f32 v0, f32 v1) { glUniform2f(location, v0, v1); },
+		.uniform_3f = [](i32 location, f32 v0, f32 v1, f32 v2) { glUniform3f(location, v0, v1, v2); },
+		.uniform_4f = [](i32 location, f32 v0, f32 v1, f32 v2, f32 v3) { glUniform4f(location, v0, v1, v2, v3); },
+
+		.uniform_matrix_2fv = [](i32 location, i32 count, bool transpose, const f32* values) {
+			glUniformMatrix2fv(location, count, transpose, values);
+		},
+		.uniform_matrix_3fv = [](i32 location, i32 count, bool transpose, const f32* values) {
+			glUniformMatrix3fv(location, count, transpose, values);
+		},
+		.uniform_matrix_4fv = [](i32 location, i32 count, bool transpose, const f32* values) {
+			glUniformMatrix4fv(location, count, transpose, values);
+		},
+		.uniform_matrix_4x3fv = [](i32 location, i32 count, bool transpose, const f32* values) {
+			glUniformMatrix4x3fv(location, count, transpose, values);
+		},
+		.uniform_matrix_3x4fv = [](i32 location, i32 count, bool transpose, const f32* values) {
+			glUniformMatrix3x4fv(location, count, transpose, values);
+		},
+
+		.draw_elements = [](u32 mode, i32 count, u32 type, const void* indices) {
+			glDrawElements(mode, count, type, indices);
+		},
+		.draw_elements_instanced = [](
+			u32 mode, i32 count, u32 type, const void* indices,
+			i32 instance_count, u32 base_instance)
+		{
+			if (base_instance == 0)
+				glDrawElementsInstanced(mode, count, type, indices, instance_count);
+			else
+				glDrawElementsInstancedBaseInstance(mode, count, type, indices, instance_count, base_instance);
+		},
+
+		.fence_sync = []() -> void* { return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0); },
+		.client_wait_sync = [](void* sync, u32 flags, u64 timeout) -> u32 {
+			return glClientWaitSync(static_cast<GLsync>(sync), flags, timeout);
+		},
+		.delete_sync = [](void* sync) { glDeleteSync(static_cast<GLsync>(sync)); },
+	};
+
+	return result;
+}
+
+/**
+ * The binding and uniform state of the current context, through which the
+ * `gl::` wrappers skip redundant calls. Call `state().invalidate()` after
+ * changing any of that state with raw `gl*` calls.
+ */
+inline auto state() -> gfx::StateCache&
+{
+	static auto result = gfx::StateCache(functions());
+	return result;
+}
+
+} // namespace gl
@@ -130,6 +130,13 @@ enum class Info : GLenum {
 	Extensions = GL_EXTENSIONS,
 };
 
+enum class Limit : GLenum {
+	MaxUniformBlockSize = GL_MAX_UNIFORM_BLOCK_SIZE,
+	MaxUniformBufferBindings = GL_MAX_UNIFORM_BUFFER_BINDINGS,
+	NumProgramBinaryFormats = GL_NUM_PROGRAM_BINARY_FORMATS,
+	UniformBufferOffsetAlignment = GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT,
+};
+
 enum class Scalar : GLenum {
 	Byte = GL_BYTE,   UnsignedByte = GL_UNSIGNED_BYTE,
 	Short = GL_SHORT, UnsignedShort = GL_UNSIGNED_SHORT,
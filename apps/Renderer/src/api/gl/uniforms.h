@@ -1,10 +1,15 @@
 #pragma once
 
+#include <type_traits>
+#include <vector>
+
 #include <math/matrix.h>
 #include <math/sfinae.h>
 #include <math/vector.h>
 #include <sized.h>
 
+#include "api/gl/reflection.h"
+#include "api/gl/state.h"
 #include "api/gl/types.h"
 
 
@@ -25,35 +30,83 @@ inline auto get_uniform_location(u32 program, const char* name) -> i32
 	return glGetUniformLocation(program, name);
 }
 
+/** Returns `GL_INVALID_INDEX` if the program has no active block of that name. */
+inline auto get_uniform_block_index(u32 program, const char* name) -> u32
+{
+	return glGetUniformBlockIndex(program, name);
+}
+
+/**
+ * Assign a uniform block of a program to a uniform buffer binding point.
+ * @see https://docs.gl/gl4/glUniformBlockBinding
+ */
+inline void uniform_block_binding(u32 program, u32 block_index, u32 binding)
+{
+	glUniformBlockBinding(program, block_index, binding);
+}
+
+/**
+ * Set a uniform of the current program. Skipped if it already has that value.
+ * @see `gl::state`
+ */
 template <typename T>
 void uniform(i32 location, const T& data);
 
 template <>
 inline void uniform<f32>(i32 location, const f32& data)
 {
-	glUniform1f(location, data);
+	state().uniform_1f(location, data);
 }
 template <>
 inline void uniform<Vec2>(i32 location, const Vec2& data)
 {
-	glUniform2f(location, data.x, data.y);
+	state().uniform_2f(location, data.x, data.y);
 }
 template <>
 inline void uniform<Vec3>(i32 location, const Vec3& data)
 {
-	glUniform3f(location, data.x, data.y, data.z);
+	state().uniform_3f(location, data.x, data.y, data.z);
 }
 template <>
 inline void uniform<Vec4>(i32 location, const Vec4& data)
 {
-	glUniform4f(location, data.x, data.y, data.z, data.w);
+	state().uniform_4f(location, data.x, data.y, data.z, data.w);
 }
 
 
+
 struct UniformMatrixParams {
 	bool transpose = false;
 };
 
+namespace detail {
+
+/**
+ * The components of `count` matrices as the `f32`s GL takes, converted into a
+ * scratch buffer unless `flt` is already `f32`.
+ */
+template <usize R, usize C>
+auto matrix_data(i32 count, const math::Matrix<R,C> data[]) -> const f32*
+{
+	if constexpr (std::is_same_v<flt, f32>) {
+		return &data->m11;
+	}
+	else {
+		static thread_local auto scratch = std::vector<f32>();
+		scratch.resize(static_cast<usize>(count) * R * C);
+
+		usize i = 0;
+		for (i32 m = 0; m < count; ++m)
+			for (usize r = 0; r < R; ++r)
+				for (usize c = 0; c < C; ++c)
+					scratch[i++] = static_cast<f32>(data[m][r][c]);
+
+		return scratch.data();
+	}
+}
+
+} // namespace detail
+
 template <usize R, usize C>
 void uniform(
 	i32 location,
@@ -75,7 +128,7 @@ inline void uniform<2,2>(
 	i32 count, const Mat2x2 data[],
 	const UniformMatrixParams& params)
 {
-	glUniformMatrix2fv(location, count, params.transpose, &data->m11);
+	state().uniform_matrix_2fv(location, count, params.transpose, detail::matrix_data(count, data));
 }
 template <>
 inline void uniform<3,3>(
@@ -83,7 +136,7 @@ inline void uniform<3,3>(
 	i32 count, const Mat3x3 data[],
 	const UniformMatrixParams& params)
 {
-	glUniformMatrix3fv(location, count, params.transpose, &data->m11);
+	state().uniform_matrix_3fv(location, count, params.transpose, detail::matrix_data(count, data));
 }
 template <>
 inline void uniform<4,4>(
@@ -91,7 +144,7 @@ inline void uniform<4,4>(
 	i32 count, const Mat4x4 data[],
 	const UniformMatrixParams& params)
 {
-	glUniformMatrix4fv(location, count, params.transpose, &data->m11);
+	state().uniform_matrix_4fv(location, count, params.transpose, detail::matrix_data(count, data));
 }
 template <>
 inline void uniform<4,3>(
@@ -99,7 +152,7 @@ inline void uniform<4,3>(
 	i32 count, const Mat4x3 data[],
 	const UniformMatrixParams& params)
 {
-	glUniformMatrix4x3fv(location, count, params.transpose, &data->m11);
+	state().uniform_matrix_4x3fv(location, count, params.transpose, detail::matrix_data(count, data));
 }
 template <>
 inline void uniform<3,4>(
@@ -107,7 +160,17 @@ inline void uniform<3,4>(
 	i32 count, const Mat3x4 data[],
 	const UniformMatrixParams& params)
 {
-	glUniformMatrix3x4fv(location, count, params.transpose, &data->m11);
+	state().uniform_matrix_3x4fv(location, count, params.transpose, detail::matrix_data(count, data));
+}
+
+/**
+ * Set a uniform of the current program, `program`, by its hashed name. Ignored
+ * if it isn't an active uniform.
+ */
+template <typename T>
+inline void uniform(u32 program, NameId name, const T& data)
+{
+	gl::uniform(gl::get_uniform_location(program, name), data);
 }
 
 } // namespace gl
@@ -0,0 +1,68 @@
+#include "frame.h"
+
+#include <cmath>
+
+
+auto make_grid() -> std::vector<Instance>
+{
+	auto result = std::vector<Instance>();
+	for (u32 y = 0; y < k_grid_size; ++y) {
+		for (u32 x = 0; x < k_grid_size; ++x) {
+			f32 scale = 0.8f / k_grid_size;
+			f32 cell = 2.f / k_grid_size;
+			auto transform = math::Mat4x3{
+				{ scale, 0, 0 },
+				{ 0, scale, 0 },
+				{ 0, 0, scale },
+				{ -1 + cell * (x + 0.5f), -1 + cell * (y + 0.5f), 0 },
+			};
+
+			auto& instance = result.emplace_back();
+			for (usize r = 0; r < 4; ++r)
+				for (usize c = 0; c < 3; ++c)
+					instance[r * 3 + c] = static_cast<f32>(transform[r][c]);
+		}
+	}
+
+	return result;
+}
+
+auto pack_frame(flt aspect, const math::Vec4& color) -> std::array<u8, FrameBlock::size>
+{
+	auto view = math::Mat4x4::identity();
+	if (aspect > 1)
+		view.m11 = 1 / aspect;
+	else
+		view.m22 = aspect;
+
+	return FrameBlock::pack(view, color);
+}
+
+void write_objects(u8* dest, usize count, usize stride, flt time)
+{
+	for (usize i = 0; i < count; ++i) {
+		flt pulse = 0.75 + 0.25 * std::sin(time * 2 + static_cast<flt>(i));
+		ObjectBlock::write(dest + i * stride, math::Vec4{ pulse, pulse, pulse, 1 });
+	}
+}
+
+void record_frame(gfx::InstanceBatcher& batcher, const mesh::binary::Mesh& geometry,
+	const std::vector<Instance>& instances, const FrameObjects& objects)
+{
+	const auto& submeshes = geometry.submeshes();
+	for (const auto& instance : instances) {
+		for (usize i = 0; i < submeshes.size(); ++i) {
+			batcher.add({
+				.program = objects.program,
+				.vertex_array = objects.vertex_array,
+				.index_buffer = objects.index_buffer,
+				.count = static_cast<i32>(submeshes[i].index_count),
+				.offset = static_cast<usize>(submeshes[i].first_index) * sizeof(u32),
+				.block_buffer = objects.object_buffer,
+				.block_binding = k_object_binding,
+				.block_offset = static_cast<u32>(i * objects.object_stride),
+				.block_size = static_cast<u32>(ObjectBlock::size),
+			}, instance.data());
+		}
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include <gfx/instancing.h>
+#include <gfx/uniform_block.h>
+#include <math/matrix.h>
+#include <math/vector.h>
+#include <mesh/binary.h>
+#include <sized.h>
+
+using namespace sized;
+
+
+// The frame drawn by both the window and `render_headless`: a copy of the mesh
+// in each cell of a grid, each submesh tinted by its own pulsing block. Both
+// record it with these functions into a `gfx::DrawQueue`, and only differ in
+// the backend they submit it to.
+
+/** The number of copies of the mesh drawn along each side of the target. */
+constexpr u32 k_grid_size = 32;
+
+/** A transform as the instance buffer holds it: the rows of a `Mat4x3`, as `f32`s. */
+using Instance = std::array<f32, 12>;
+
+/** `Frame` in the shader: the view transform and base color, set once a frame. */
+using FrameBlock = gfx::Std140<math::Mat4x4, math::Vec4>;
+/** `Object` in the shader: a tint for each submesh. */
+using ObjectBlock = gfx::Std140<math::Vec4>;
+
+/** The uniform buffer binding points of the blocks. */
+constexpr u32 k_frame_binding = 0;
+constexpr u32 k_object_binding = 1;
+
+/**
+ * The objects a frame is drawn with: GL names, or the names they're
+ * registered under with a `raster::Backend`.
+ */
+struct FrameObjects {
+	u32 program = 0;
+	u32 vertex_array = 0;
+	u32 index_buffer = 0;
+	/** Every submesh's `ObjectBlock`, `object_stride` bytes apart. */
+	u32 object_buffer = 0;
+	u32 object_stride = 0;
+};
+
+/** The transform of each cell of the grid, whatever the precision of `flt`. */
+auto make_grid() -> std::vector<Instance>;
+
+/** The `Frame` block, with a view that keeps the grid's cells square whatever the target's shape. */
+auto pack_frame(flt aspect, const math::Vec4& color) -> std::array<u8, FrameBlock::size>;
+
+/** Write the `Object` block of `count` submeshes, `stride` bytes apart, at `time` seconds. */
+void write_objects(u8* dest, usize count, usize stride, flt time);
+
+/** Add a draw of each submesh in each grid cell to `batcher`, to be built into a queue. */
+void record_frame(gfx::InstanceBatcher& batcher, const mesh::binary::Mesh& geometry,
+	const std::vector<Instance>& instances, const FrameObjects& objects);
@@ -0,0 +1,131 @@
+#include "headless.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <tuple>
+
+#include <fmt/format.h>
+#include <gfx/draw_queue.h>
+#include <raster/backend.h>
+#include <raster/framebuffer.h>
+#include <raster/rasterizer.h>
+
+
+namespace {
+
+// The names the objects are registered under with the backend
+constexpr u32 k_program = 1;
+constexpr u32 k_vertex_array = 1;
+constexpr u32 k_index_buffer = 1;
+constexpr u32 k_frame_buffer = 2;
+constexpr u32 k_object_buffer = 3;
+
+/** Where the vertex shader finds the mesh's positions, as the vertex array's layout would say. */
+struct Attributes {
+	u32 position_offset = 0;
+	u32 position_count = 0;
+};
+
+/** `instanced.shader`'s vertex stage: `u_view * vec4(a_transform * vec4(position.xyz, 1), 1)`. */
+auto instanced_vertex(const void* uniforms, const u8* vertex, u32 instance, f32* /*varyings*/) -> raster::Position
+{
+	const auto& bindings = *static_cast<const raster::Bindings*>(uniforms);
+	const auto& attributes = *static_cast<const Attributes*>(bindings.program_data);
+
+	f32 position[4] { 0, 0, 0, 1 };
+	std::memcpy(position, vertex + attributes.position_offset, attributes.position_count * sizeof(f32));
+
+	// Each row of the transform and view is a column of the GLSL matrix
+	f32 transform[12];
+	std::memcpy(transform, bindings.instance(instance), sizeof(transform));
+	f32 view[16];
+	std::memcpy(view, bindings.blocks[k_frame_binding] + FrameBlock::offsets[0], sizeof(view));
+
+	f32 world[4] { 0, 0, 0, 1 };
+	for (usize c = 0; c < 3; ++c)
+		for (usize r = 0; r < 4; ++r)
+			world[c] += position[r] * transform[r * 3 + c];
+
+	f32 clip[4] {};
+	for (usize c = 0; c < 4; ++c)
+		for (usize r = 0; r < 4; ++r)
+			clip[c] += world[r] * view[r * 4 + c];
+
+	return { clip[0], clip[1], clip[2], clip[3] };
+}
+
+/** `instanced.shader`'s fragment stage: `u_color * u_tint`. */
+auto instanced_fragment(const void* uniforms, const f32* /*varyings*/) -> raster::Color
+{
+	const auto& bindings = *static_cast<const raster::Bindings*>(uniforms);
+
+	f32 color[4];
+	f32 tint[4];
+	std::memcpy(color, bindings.blocks[k_frame_binding] + FrameBlock::offsets[1], sizeof(color));
+	std::memcpy(tint, bindings.blocks[k_object_binding] + ObjectBlock::offsets[0], sizeof(tint));
+
+	return { color[0] * tint[0], color[1] * tint[1], color[2] * tint[2], color[3] * tint[3] };
+}
+
+} // namespace
+
+
+auto render_headless(const mesh::binary::Mesh& geometry, const std::vector<Instance>& instances,
+	const math::Vec4& color, u32 width, u32 height, const std::filesystem::path& output) -> bool
+{
+	const auto& layout = geometry.layout();
+	if (layout.empty() || layout[0].type != mesh::Scalar::f32 || layout[0].count > 3) {
+		std::cerr << "Error: headless rendering needs 2D or 3D f32 positions\n";
+		return false;
+	}
+
+	// The same blocks and draws as the window's first frame
+	flt aspect = height > 0 ? static_cast<flt>(width) / static_cast<flt>(height) : 1;
+	auto frame = pack_frame(aspect, color);
+
+	usize object_count = geometry.submeshes().size();
+	auto objects = std::vector<u8>(object_count * ObjectBlock::size);
+	write_objects(objects.data(), object_count, ObjectBlock::size, 0);
+
+	auto queue = gfx::DrawQueue();
+	auto batcher = gfx::InstanceBatcher(std::tuple_size_v<Instance>);
+	record_frame(batcher, geometry, instances, {
+		k_program, k_vertex_array, k_index_buffer, k_object_buffer, static_cast<u32>(ObjectBlock::size),
+	});
+	batcher.build(queue);
+	queue.sort();
+
+	// Register what the draws refer to
+	auto rasterizer = raster::Rasterizer();
+	auto target = raster::Framebuffer(width, height);
+	target.clear({ 0, 0, 0, 1 });
+
+	auto attributes = Attributes{ layout[0].offset, layout[0].count };
+	auto backend = raster::Backend(rasterizer, target);
+	backend.set_program(k_program, { instanced_vertex, instanced_fragment, 0 }, &attributes);
+	backend.set_vertex_array(k_vertex_array,
+		{ geometry.vertex_data(), geometry.vertex_stride(), geometry.vertex_count() },
+		{ batcher.instance_data().data(), sizeof(Instance), batcher.instance_count() });
+	backend.set_buffer(k_index_buffer, geometry.index_data(), geometry.index_count() * sizeof(u32));
+	backend.set_buffer(k_frame_buffer, frame.data(), frame.size());
+	backend.set_buffer(k_object_buffer, objects.data(), objects.size());
+	backend.bind_block(k_frame_binding, k_frame_buffer);
+
+	auto start = std::chrono::steady_clock::now();
+	queue.submit(backend);
+	auto elapsed = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start);
+
+	const auto& stats = rasterizer.stats();
+	fmt::print("Rasterized {} draws, {} triangles ({} culled, {} clipped), {} fragments in {:.2f} ms on {} threads\n",
+		queue.size(), stats.triangles, stats.culled, stats.clipped, stats.fragments, elapsed.count(),
+		rasterizer.threads());
+
+	if (!target.write_tga(output)) {
+		std::cerr << fmt::format("Error: can't write '{}'\n", output.string());
+		return false;
+	}
+
+	fmt::print("Wrote {}\n", output.string());
+	return true;
+}
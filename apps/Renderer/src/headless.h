@@ -0,0 +1,25 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include <math/vector.h>
+#include <mesh/binary.h>
+#include <sized.h>
+
+#include "frame.h"
+
+using namespace sized;
+
+
+/**
+ * Draw the window's first frame with `raster::Rasterizer` instead of OpenGL,
+ * and write it to a TGA file, for rendering without a GPU or a display.
+ *
+ * The frame is recorded, batched and sorted into a `gfx::DrawQueue` as the
+ * window does (see `frame.h`), and submitted to a `raster::Backend`, with the
+ * instanced program's shaders written in C++. The mesh's first attribute is
+ * its position, which has to be floating point.
+ */
+auto render_headless(const mesh::binary::Mesh& geometry, const std::vector<Instance>& instances,
+	const math::Vec4& color, u32 width, u32 height, const std::filesystem::path& output) -> bool;
@@ -18,6 +18,8 @@ public:
 
 	auto count() const -> u32 { return m_count; }
 
+	auto id() const -> u32 { return m_renderer_id; }
+
 	void bind() const;
 	void unbind() const;
 
@@ -1,16 +1,69 @@
+#include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include <fmt/format.h>
+#include <gfx/draw_queue.h>
+#include <gfx/instancing.h>
+#include <gfx/program_builder.h>
+#include <gfx/program_cache.h>
+#include <gfx/shader_reloader.h>
+#include <gfx/shader_source.h>
+#include <gfx/streaming_buffer.h>
+#include <math/matrix.h>
 #include <math/vector.h>
+#include <mesh/binary.h>
+#include <mesh/error.h>
+#include <mesh/mesh_data.h>
+#include <mesh/obj.h>
+#include <mesh/optimize.h>
 #include <sized.h>
 
 #include "api/gl/gl.h"
+#include "frame.h"
+#include "headless.h"
 #include "index_buffer.h"
+#include "uniform_buffer.h"
 #include "vertex_array.h"
 #include "vertex_buffer.h"
 
 
-auto main() -> int
+namespace {
+
+/** The first attribute index of the per-instance transforms, after the mesh's. */
+constexpr sized::u32 k_transform_attribute = 4;
+
+/** The mesh drawn when no mesh file is given: a full-screen quad. */
+auto make_quad() -> mesh::MeshData
+{
+	using namespace sized;
+
+	f32 positions[] {
+		-1.f,  1.f,
+		 1.f,  1.f,
+		 1.f, -1.f,
+		-1.f, -1.f,
+	};
+
+	auto result = mesh::MeshData();
+	result.push_attribute(mesh::Scalar::f32, 2);
+	result.vertices.resize(sizeof(positions));
+	std::memcpy(result.vertices.data(), positions, sizeof(positions));
+	result.indices = { 0, 1, 2, 0, 2, 3 };
+	result.submeshes.push_back({ 0, 6 });
+	result.compute_bounds();
+
+	return result;
+}
+
+} // namespace
+
+
+auto main(int argc, char** argv) -> int
 {
 	using namespace sized;
 	using gl::DrawMode;
@@ -23,13 +76,64 @@ auto main() -> int
 	using math::Vec4;
 
 
+	// Load the mesh given on the command line (`Renderer [mesh] [--headless
+	// out.tga]`), or fall back to the built-in quad. OBJ files are imported,
+	// optimized and encoded in memory; either way the vertex and index data are
+	// then used in place.
+	auto path = std::string_view();
+	auto headless_path = std::optional<std::filesystem::path>();
+	for (int i = 1; i < argc; ++i) {
+		auto arg = std::string_view(argv[i]);
+		if (arg == "--headless" && i + 1 < argc)
+			headless_path = argv[++i];
+		else
+			path = arg;
+	}
+
+	auto encoded = std::vector<u8>();
+	auto geometry = std::optional<mesh::binary::Mesh>();
+	try {
+		if (path.empty()) {
+			encoded = mesh::binary::encode(make_quad());
+			geometry.emplace(encoded.data(), encoded.size());
+		}
+		else if (path.size() > 4 && path.substr(path.size() - 4) == ".obj") {
+			auto imported = mesh::obj::import(std::string(path));
+			auto report = mesh::optimize::optimize(imported);
+			fmt::print("Optimized {}: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}\n",
+				path, report.before.acmr, report.after.acmr, report.before.atvr, report.after.atvr);
+
+			encoded = mesh::binary::encode(imported.interleave());
+			geometry.emplace(encoded.data(), encoded.size());
+		}
+		else {
+			geometry = mesh::binary::Mesh::load(std::string(path));
+		}
+	}
+	catch (const mesh::FileError& error) {
+		std::cerr << fmt::format("Error: {}\n", error.what());
+		return 1;
+	}
+
+	// Setup our color-shifting base color, and a copy of the mesh in each cell
+	// of a grid
+	Vec4 color = { 0.2, 0.3, 0.8, 1.0 };
+	auto instances = make_grid();
+
+	// Without a window, draw the first frame on the CPU
+	if (headless_path)
+		return render_headless(*geometry, instances, color, 1280, 960, *headless_path) ? 0 : 1;
+
+
 	// Initialize the window and OpenGL context
 
 	if (!glfwInit())
 		return 1;
 
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	// 4.2 for base instances, so that each instanced draw can select its own
+	// range of the instance buffer
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
 	auto* window = glfwCreateWindow(1280, 960, "Hello Triangle", nullptr, nullptr);
@@ -47,32 +151,68 @@ auto main() -> int
 
 	fmt::print("OpenGL {}\n", gl::get_string(Info::Version));
 
-	f32 positions[] {
-		-1.f,  1.f,
-		 1.f,  1.f,
-		 1.f, -1.f,
-		-1.f, -1.f,
-	};
-
-	constexpr u32 index_count = 6;
-	u32 indices[index_count] { 0, 1, 2, 0, 2, 3 };
-
 	{
 		// Setup vertex array
 		auto vertex_array = VertexArray();
-		auto vertex_buffer = VertexBuffer(&positions, sizeof(positions));
-		auto layout = VertexBufferLayout{{
-			.type = Scalar::f32,
-			.count = 2,
-		}};
+		auto vertex_buffer = VertexBuffer(
+			geometry->vertex_data(),
+			static_cast<u32>(geometry->vertex_data_size()));
+		auto layout = VertexBufferLayout(geometry->layout(), geometry->vertex_stride());
 		vertex_array.add_buffer(vertex_buffer, layout);
 
+		// Setup the per-instance transforms, refilled every frame. They're
+		// written straight into persistently mapped memory where supported,
+		// and re-uploaded otherwise.
+		usize instance_count = k_grid_size * k_grid_size * geometry->submeshes().size();
+		auto instance_buffer = VertexBuffer(nullptr, 0, Usage::StreamDraw);
+		auto instance_stream = std::optional<gfx::StreamingBuffer>();
+		if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage)
+			instance_stream.emplace(gl::state(), GL_ARRAY_BUFFER, instance_count * sizeof(Instance));
+
+		vertex_array.add_buffer(
+			instance_stream ? instance_stream->id() : instance_buffer.id(),
+			VertexBufferLayout::instance_matrices<4,3>(),
+			k_transform_attribute);
+
 		// Setup index buffer
-		auto index_buffer = IndexBuffer(indices, index_count);
+		auto index_buffer = IndexBuffer(
+			geometry->index_data(),
+			static_cast<u32>(geometry->index_count()));
+
+		// Programs built before on this driver are loaded from the cache
+		auto program_cache = std::optional<gfx::ProgramCache>();
+		if ((GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)
+			&& gl::get_integer(gl::Limit::NumProgramBinaryFormats) > 0)
+		{
+			auto driver = fmt::format("{}\n{}\n{}",
+				gl::get_string(Info::Vendor), gl::get_string(Info::Renderer), gl::get_string(Info::Version));
+			program_cache.emplace(std::filesystem::temp_directory_path() / "renderer-programs", driver);
+		}
 
-		// Compile and link the program
-		u32 program = gl::make_program(PROJECT_SOURCE_DIR"/res/shaders/hello.shader");
-		gl::use_program(program);
+		// Start building the program in the background, loading it from the
+		// cache instead where possible, and draw with a trivial fallback program
+		// until it's ready. The fallback is built up front, as the first frame
+		// needs it. The program is rebuilt whenever its files are saved.
+		bool parallel = GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile;
+		if (parallel)
+			gl::functions().max_shader_compiler_threads(0xffff'ffff);
+
+		auto builder = gfx::ProgramBuilder(gl::state(), parallel, program_cache ? &*program_cache : nullptr);
+		auto shaders = gfx::ShaderReloader(builder);
+		if (!shaders.watch(PROJECT_SOURCE_DIR"/res/shaders"))
+			fmt::print("Can't watch the shaders for changes\n");
+
+		gfx::ShaderReloader::Handle instanced;
+		u32 fallback;
+		try {
+			fallback = gl::make_program(PROJECT_SOURCE_DIR"/res/shaders/fallback.shader");
+			instanced = shaders.add(PROJECT_SOURCE_DIR"/res/shaders/instanced.shader");
+		}
+		catch (const gfx::ShaderError& error) {
+			std::cerr << fmt::format("Error: {}\n", error.what());
+			return 1;
+		}
+		gl::uniform_block_binding(fallback, gl::get_uniform_block_index(fallback, "Frame"), k_frame_binding);
 
 		// Unbind buffers
 		gl::use_program(0);
@@ -80,40 +220,108 @@ auto main() -> int
 		gl::bind_buffer(Target::Array, 0);
 		gl::bind_buffer(Target::ElementArray, 0);
 
-		// Setup our color-shifting uniform
-		Vec4 u_color = { 0.2, 0.3, 0.8, 1.0 };
-		i32 location = gl::get_uniform_location(program, "u_color");
+		// Setup the uniform buffers: the frame's block, bound once, and every
+		// submesh's block in one buffer, each bound by range for its draws
+		auto frame_buffer = UniformBuffer(FrameBlock::size);
+		frame_buffer.bind(k_frame_binding);
+
+		usize object_count = geometry->submeshes().size();
+		u32 object_stride = UniformBuffer::aligned_stride(ObjectBlock::size);
+		auto object_buffer = UniformBuffer(static_cast<u32>(object_count * object_stride));
+		auto objects = std::vector<u8>(object_count * object_stride);
+
 		f32 increment = 0.01;
 
+		auto queue = gfx::DrawQueue();
+		auto batcher = gfx::InstanceBatcher(std::tuple_size_v<Instance>);
+
 		// Run render loop
 		while (!glfwWindowShouldClose(window)) {
 			gl::clear(Mask::ColorBuffer);
 
-			// Bind the shader program
-			gl::use_program(program);
-			gl::uniform(location, u_color);
+			// Switch to rebuilt programs, assigning their blocks' binding points
+			// first. Deleting the old ones drops their cached uniforms.
+			for (const auto& update : shaders.update()) {
+				if (update.program == 0) {
+					fmt::print("\nError building program:\n{}\n{}\n", std::string(40, '-'), update.log);
+					continue;
+				}
 
-			// Bind vertex array
-			vertex_array.bind();
+				u32 ready = update.program;
+				gl::uniform_block_binding(ready, gl::get_uniform_block_index(ready, "Frame"), k_frame_binding);
+				gl::uniform_block_binding(ready, gl::get_uniform_block_index(ready, "Object"), k_object_binding);
+				if (update.replaced != 0)
+					gl::delete_program(update.replaced);
 
-			// Bind and draw index buffer
-			index_buffer.bind();
-			gl::draw_elements<u32>(DrawMode::Triangles, index_count, nullptr);
+				fmt::print("Program {} at {:.3f}s\n", update.replaced ? "reloaded" : "built", glfwGetTime());
+			}
+			u32 program = shaders.program(instanced, fallback);
 
-			// Cycle the uniform color
-			if (u_color.x > 1)
+			// Write this frame's blocks, each buffer in a single upload
+			i32 width, height;
+			glfwGetFramebufferSize(window, &width, &height);
+			flt aspect = height > 0 ? static_cast<flt>(width) / height : 1;
+			auto frame = pack_frame(aspect, color);
+			frame_buffer.set_data(frame.data(), FrameBlock::size);
+
+			write_objects(objects.data(), object_count, object_stride, static_cast<flt>(glfwGetTime()));
+			object_buffer.set_data(objects.data(), object_buffer.size());
+
+			// Record the frame's draws, then batch, sort and submit them
+			queue.clear();
+			batcher.clear();
+			record_frame(batcher, *geometry, instances, {
+				program, vertex_array.id(), index_buffer.id(), object_buffer.id(), object_stride,
+			});
+			usize instance_size = batcher.instance_count() * sizeof(Instance);
+			if (instance_stream) {
+				// Point the draws at this frame's region via their base instance
+				instance_stream->begin_frame();
+				auto region = instance_stream->allocate(instance_size, sizeof(Instance));
+				batcher.build(queue, static_cast<u32>(region.offset / sizeof(Instance)));
+				std::memcpy(region.data, batcher.instance_data().data(), instance_size);
+			}
+			else {
+				batcher.build(queue);
+				instance_buffer.set_data(batcher.instance_data().data(), static_cast<u32>(instance_size));
+			}
+
+			queue.sort();
+			queue.submit(gl::state());
+
+			if (instance_stream)
+				instance_stream->end_frame();
+
+			// Cycle the base color
+			if (color.x > 1)
 				increment = -0.01;
-			else if (u_color.x < 0)
+			else if (color.x < 0)
 				increment = 0.01;
 
-			u_color.x += increment;
+			color.x += increment;
 
 			glfwSwapBuffers(window);
 			glfwPollEvents();
 		}
 
+		const auto& stats = gl::state().stats();
+		fmt::print("GL state changes: {} issued, {} skipped\n", stats.total().issued, stats.total().skipped);
+		fmt::print("GL draws: {} for {} instances\n", stats.draws, stats.instances);
+		if (program_cache)
+			fmt::print("Program cache: {} hits, {} misses\n",
+				program_cache->stats().hits, program_cache->stats().misses);
+		if (instance_stream)
+			fmt::print("Streaming buffer stalls: {} in {} frames\n",
+				instance_stream->stats().stalls, instance_stream->stats().frames);
+
 		// Cleanup
-		gl::delete_program(program);
+		builder.finish();
+		for (const auto& update : shaders.update())
+			if (update.replaced != 0)
+				gl::delete_program(update.replaced);
+		if (u32 program = shaders.program(instanced))
+			gl::delete_program(program);
+		gl::delete_program(fallback);
 	}
 	glfwTerminate();
 
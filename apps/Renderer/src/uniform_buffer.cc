@@ -0,0 +1,53 @@
+#include "uniform_buffer.h"
+
+#include <gfx/uniform_block.h>
+
+#include "api/gl/gl.h"
+
+
+UniformBuffer::UniformBuffer(u32 size)
+	: m_renderer_id(gl::gen_buffer())
+	, m_size(size)
+{
+	gl::bind_buffer(gl::Target::Uniform, m_renderer_id);
+	gl::buffer_data(gl::Target::Uniform, static_cast<i32>(size), nullptr, gl::Usage::DynamicDraw);
+}
+
+UniformBuffer::~UniformBuffer()
+{
+	gl::delete_buffer(m_renderer_id);
+}
+
+void UniformBuffer::set_data(const void* data, u32 size)
+{
+	m_size = size;
+	gl::bind_buffer(gl::Target::Uniform, m_renderer_id);
+	gl::buffer_data(gl::Target::Uniform, static_cast<i32>(size), data, gl::Usage::DynamicDraw);
+}
+
+void UniformBuffer::update(u32 offset, const void* data, u32 size)
+{
+	gl::bind_buffer(gl::Target::Uniform, m_renderer_id);
+	gl::buffer_sub_data(gl::Target::Uniform, offset, size, data);
+}
+
+void UniformBuffer::bind(u32 binding) const
+{
+	gl::bind_buffer_base(gl::Target::Uniform, binding, m_renderer_id);
+}
+
+void UniformBuffer::bind_range(u32 binding, u32 offset, u32 size) const
+{
+	gl::bind_buffer_range(gl::Target::Uniform, binding, m_renderer_id, offset, size);
+}
+
+auto UniformBuffer::offset_alignment() -> u32
+{
+	static const auto result = static_cast<u32>(gl::get_integer(gl::Limit::UniformBufferOffsetAlignment));
+	return result;
+}
+
+auto UniformBuffer::aligned_stride(usize block_size) -> u32
+{
+	return static_cast<u32>(gfx::align_up(block_size, offset_alignment()));
+}
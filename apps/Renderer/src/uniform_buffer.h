@@ -0,0 +1,49 @@
+#pragma once
+
+#include <sized.h>
+
+using namespace sized;
+
+
+/**
+ * A buffer of uniform blocks, filled from a `gfx::BlockLayout` and bound to the
+ * binding points that programs' blocks are assigned to with
+ * `gl::uniform_block_binding`.
+ *
+ * Blocks that change every frame should be written with a single `set_data`
+ * of the whole buffer, e.g. every object's block packed at a stride of
+ * `aligned_stride`, and then bound by range.
+ */
+class UniformBuffer {
+public:
+	explicit UniformBuffer(u32 size);
+	~UniformBuffer();
+
+	UniformBuffer(const UniformBuffer&) = delete;
+	UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+	UniformBuffer(UniformBuffer&&) noexcept = default;
+	UniformBuffer& operator=(UniformBuffer&&) noexcept = default;
+
+	auto id() const -> u32 { return m_renderer_id; }
+	auto size() const -> u32 { return m_size; }
+
+	/** Replace the buffer's contents, orphaning the old storage. */
+	void set_data(const void* data, u32 size);
+	/** Overwrite `size` bytes from `offset`, which may wait for draws still reading them. */
+	void update(u32 offset, const void* data, u32 size);
+
+	/** Bind the whole buffer to a uniform buffer binding point. */
+	void bind(u32 binding) const;
+	/** Bind one block to a binding point. `offset` must be a multiple of `offset_alignment`. */
+	void bind_range(u32 binding, u32 offset, u32 size) const;
+
+	/** The alignment of the offsets passed to `bind_range`. */
+	static auto offset_alignment() -> u32;
+	/** The distance between consecutive blocks of `block_size` bytes in one buffer. */
+	static auto aligned_stride(usize block_size) -> u32;
+
+private:
+	u32 m_renderer_id = 0;
+	u32 m_size = 0;
+};
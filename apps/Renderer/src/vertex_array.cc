@@ -13,13 +13,17 @@ VertexArray::~VertexArray()
 	gl::delete_vertex_array(m_renderer_id);
 }
 
-void VertexArray::add_buffer(const VertexBuffer &buffer, const VertexBufferLayout &layout) const
+void VertexArray::add_buffer(const VertexBuffer &buffer, const VertexBufferLayout &layout, u32 first_index) const
+{
+	add_buffer(buffer.id(), layout, first_index);
+}
+
+void VertexArray::add_buffer(u32 buffer, const VertexBufferLayout &layout, u32 first_index) const
 {
 	bind();
-	buffer.bind();
+	gl::bind_buffer(gl::Target::Array, buffer);
 
-	usize idx = 0;
-	usize offset = 0;
+	u32 idx = first_index;
 	for (const auto& element : layout.elements()) {
 		gl::enable_vertex_attrib_array(idx);
 		gl::vertex_attrib_pointer(idx, {
@@ -27,11 +31,12 @@ void VertexArray::add_buffer(const VertexBuffer &buffer, const VertexBufferLayou
 			.size = static_cast<i32>(element.count),
 			.normalized = element.normalized,
 			.stride = static_cast<i32>(layout.stride()),
-			.offset = reinterpret_cast<const void*>(offset), // NOLINT
+			.offset = reinterpret_cast<const void*>(element.offset), // NOLINT
 		});
+		if (element.divisor != 0)
+			gl::vertex_attrib_divisor(idx, element.divisor);
 
 		++idx;
-		offset += element.count * gl::size_of(element.type);
 	}
 }
 
@@ -19,7 +19,15 @@ public:
 	VertexArray(VertexArray&&) noexcept = default;
 	VertexArray& operator=(VertexArray&&) noexcept = default;
 
-	void add_buffer(const VertexBuffer& buffer, const VertexBufferLayout& layout) const;
+	/**
+	 * Add the attributes of `layout`, read from `buffer`, at consecutive
+	 * attribute indices starting from `first_index`.
+	 */
+	void add_buffer(const VertexBuffer& buffer, const VertexBufferLayout& layout, u32 first_index = 0) const;
+	/** @see `add_buffer`, for a buffer that isn't a `VertexBuffer` (e.g. a `gfx::StreamingBuffer`). */
+	void add_buffer(u32 buffer, const VertexBufferLayout& layout, u32 first_index = 0) const;
+
+	auto id() const -> u32 { return m_renderer_id; }
 
 	void bind() const;
 	void unbind() const;
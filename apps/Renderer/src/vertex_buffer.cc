@@ -1,13 +1,16 @@
 #include "vertex_buffer.h"
 
+#include <mesh/layout.h>
+
 #include "api/gl/gl.h"
 
 
-VertexBuffer::VertexBuffer(const void* data, u32 size)
+VertexBuffer::VertexBuffer(const void* data, u32 size, gl::Usage usage)
 	: m_renderer_id(gl::gen_buffer())
+	, m_usage(usage)
 {
 	gl::bind_buffer(gl::Target::Array, m_renderer_id);
-	gl::buffer_data(gl::Target::Array, static_cast<i32>(size), data, gl::Usage::StaticDraw);
+	gl::buffer_data(gl::Target::Array, static_cast<i32>(size), data, usage);
 }
 
 VertexBuffer::~VertexBuffer()
@@ -15,6 +18,12 @@ VertexBuffer::~VertexBuffer()
 	gl::delete_buffer(m_renderer_id);
 }
 
+void VertexBuffer::set_data(const void* data, u32 size)
+{
+	gl::bind_buffer(gl::Target::Array, m_renderer_id);
+	gl::buffer_data(gl::Target::Array, static_cast<i32>(size), data, m_usage);
+}
+
 void VertexBuffer::bind() const
 {
 	gl::bind_buffer(gl::Target::Array, m_renderer_id);
@@ -30,6 +39,24 @@ VertexBufferLayout::VertexBufferLayout(std::initializer_list<VertexBufferElement
 {
 	for (const auto& element : elements) {
 		m_elements.push_back(element);
+		m_elements.back().offset = m_stride;
 		m_stride += element.count * gl::size_of(element.type);
 	}
 }
+
+VertexBufferLayout::VertexBufferLayout(const std::vector<mesh::Attribute>& attributes, usize stride)
+	: m_stride(stride)
+{
+	static_assert(static_cast<GLenum>(mesh::Scalar::f32) == GL_FLOAT);
+	static_assert(static_cast<GLenum>(mesh::Scalar::f16) == GL_HALF_FLOAT);
+	static_assert(static_cast<GLenum>(mesh::Scalar::u32_2_10_10_10_rev) == GL_UNSIGNED_INT_2_10_10_10_REV);
+
+	for (const auto& attribute : attributes) {
+		m_elements.push_back({
+			.type = static_cast<gl::Scalar>(attribute.type),
+			.count = attribute.count,
+			.normalized = attribute.normalized,
+			.offset = attribute.offset,
+		});
+	}
+}
@@ -7,12 +7,16 @@
 
 #include "api/gl/types.h"
 
+namespace mesh {
+struct Attribute;
+}
+
 using namespace sized;
 
 
 class VertexBuffer {
 public:
-	VertexBuffer(const void* data, u32 size);
+	VertexBuffer(const void* data, u32 size, gl::Usage usage = gl::Usage::StaticDraw);
 	~VertexBuffer();
 
 	VertexBuffer(const VertexBuffer&) = delete;
@@ -21,11 +25,17 @@ public:
 	VertexBuffer(VertexBuffer&&) noexcept = default;
 	VertexBuffer& operator=(VertexBuffer&&) noexcept = default;
 
+	auto id() const -> u32 { return m_renderer_id; }
+
+	/** Replace the buffer's contents, orphaning the old storage. */
+	void set_data(const void* data, u32 size);
+
 	void bind() const;
 	void unbind() const;
 
 private:
 	u32 m_renderer_id = 0;
+	gl::Usage m_usage = gl::Usage::StaticDraw;
 };
 
 
@@ -46,12 +56,34 @@ struct VertexBufferElement {
 	 * accessed.
 	 */
 	bool normalized = false;
+	/**
+	 * Specifies the byte offset of the attribute from the start of the vertex.
+	 * Assigned automatically when elements are tightly packed.
+	 */
+	usize offset = 0;
+	/**
+	 * Specifies the number of instances drawn before the attribute advances, or
+	 * 0 to advance once per vertex.
+	 */
+	u32 divisor = 0;
 };
 
 class VertexBufferLayout {
 public:
 	VertexBufferLayout() = default;
+	/** Create a layout of tightly-packed elements. */
 	VertexBufferLayout(std::initializer_list<VertexBufferElement> elements);
+	/** Create a layout matching a mesh file's vertex layout. */
+	VertexBufferLayout(const std::vector<mesh::Attribute>& attributes, usize stride);
+
+	/**
+	 * Create a layout for a stream of per-instance `R`x`C` matrices of `f32`,
+	 * row by row, as one attribute per row (`R` consecutive attribute indices)
+	 * that advances once per instance. A shader reads it as a `matCxR`, e.g. an
+	 * `in mat4x3` for a stream of `Mat4x3`s converted to `f32`.
+	 */
+	template <usize R, usize C>
+	static auto instance_matrices() -> VertexBufferLayout;
 
 	auto stride() const -> usize { return m_stride; }
 	auto elements() const -> const std::vector<VertexBufferElement>& { return m_elements; }
@@ -72,7 +104,20 @@ inline void VertexBufferLayout::push(usize count, bool normalized)
 		.type = gl::type<T>(),
 		.count = count,
 		.normalized = normalized,
+		.offset = m_stride,
 	});
 
 	m_stride += count * sizeof(T);
 }
+
+template <usize R, usize C>
+inline auto VertexBufferLayout::instance_matrices() -> VertexBufferLayout
+{
+	auto result = VertexBufferLayout();
+	for (usize row = 0; row < R; ++row) {
+		result.push<f32>(C);
+		result.m_elements.back().divisor = 1;
+	}
+
+	return result;
+}
@@ -1,21 +1,69 @@
+#include <algorithm>
 #include <array>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
 #include <limits>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
 
 #include <catch2/catch_all.hpp>
 #include <fmt/format.h>
-
+#include <gfx/arena.h>
+#include <gfx/draw_queue.h>
+#include <gfx/file_watcher.h>
+#include <gfx/functions.h>
+#include <gfx/instancing.h>
+#include <gfx/program_builder.h>
+#include <gfx/program_cache.h>
+#include <gfx/reflection.h>
+#include <gfx/shader_reloader.h>
+#include <gfx/shader_source.h>
+#include <gfx/state_cache.h>
+#include <gfx/streaming_buffer.h>
+#include <gfx/uniform_block.h>
+
+#include <math/batch.h>
+#include <math/check.h>
+#include <math/cpu.h>
 #include <math/euler.h>
+#include <math/expr.h>
+#include <math/geo/aabb.h>
 #include <math/geo/circle.h>
 #include <math/geo/plane.h>
 #include <math/geo/tri.h>
 #include <math/literals.h>
 #include <math/matrix.h>
 #include <math/matrix/rotation.h>
+#include <math/matrix/transform.h>
 #include <math/quat.h>
 #include <math/spaces.h>
+#include <math/spatial_hash.h>
 #include <math/utility.h>
 #include <math/vector.h>
+#include <mesh/binary.h>
+#include <mesh/error.h>
+#include <mesh/mesh_data.h>
+#include <mesh/meshlet.h>
+#include <mesh/obj.h>
+#include <mesh/optimize.h>
+#include <mesh/parse.h>
+#include <mesh/quantize.h>
+#include <mesh/simplify.h>
+#include <mesh/tangent_space.h>
+#include <raster/backend.h>
+#include <raster/framebuffer.h>
+#include <raster/occlusion.h>
+#include <raster/rasterizer.h>
 #include <sized.h>
 
 using Catch::Matchers::WithinAbs;
@@ -413,6 +461,147 @@ TEST_CASE("math::Vector", "[vector]") {
 	}
 }
 
+TEST_CASE("math::expr", "[vector][expr]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+	using math::expr::lazy;
+	using math::Vec2;
+
+	// Results must be bit-identical to the eager operators, so compare exactly
+	auto require_identical = [](const auto& lhs, const auto& rhs) {
+		for (usize i = 0; i < std::tuple_size_v<std::decay_t<decltype(lhs)>>; ++i)
+			REQUIRE(lhs[i] == rhs[i]);
+	};
+
+	auto a = Vec3{ 0.1, -2.7, 3.3 };
+	auto b = Vec3{ 1.0 / 3.0, 5.5, -0.7 };
+	auto c = Vec3{ -8.25, 0.01, 1e5 };
+	flt x = 0.3, y = 1.7, z = -0.45;
+
+	SECTION("matches the eager operators") {
+		require_identical(Vec3(lazy(a) + b), a + b);
+		require_identical(Vec3(a + lazy(b)), a + b);
+		require_identical(Vec3(lazy(a) - b), a - b);
+		require_identical(Vec3(-lazy(a)), -a);
+		require_identical(Vec3(lazy(a) * x), a * x);
+		require_identical(Vec3(x * lazy(a)), x * a);
+		require_identical(Vec3(lazy(a) / y), a / y);
+	}
+	SECTION("matches the eager operators for compound expressions") {
+		require_identical(
+			Vec3(lazy(a) * x + lazy(b) * y + lazy(c) * z),
+			x * a + y * b + z * c);
+
+		require_identical(
+			Vec3((lazy(a) - b) / z + -lazy(c) * y),
+			(a - b) / z + -c * y);
+
+		CHECK((lazy(a) * x + b | c) == ((a * x + b) | c));
+		CHECK(math::expr::dot(lazy(a) - b, lazy(c) * y) == ((a - b) | (c * y)));
+	}
+	SECTION("matches division by ~zero") {
+		require_identical(Vec3(lazy(a) / 0), a / 0);
+		require_identical(Vec3(lazy(a) / 0), Vec3::Zero);
+	}
+	SECTION("works for other dimensions") {
+		auto u = Vec2{ 1.5, -2.5 };
+		auto v = Vec4{ 1, 2, 3, 4 };
+		require_identical(Vec2(lazy(u) * x - u), u * x - u);
+		require_identical(Vec4(lazy(v) + v * y), v + v * y);
+	}
+	SECTION("geo helpers are unchanged") {
+		auto tri = math::geo::Tri{ a, b, c };
+		require_identical(tri.bary2cart(x, y, z), x * a + y * b + z * c);
+
+		auto box = math::geo::AABBox{ a, c };
+		require_identical(box.center(), 0.5 * (a + c));
+		require_identical(box.radius(), 0.5 * (c - a));
+	}
+}
+
+TEST_CASE("Index checks", "[vector][matrix][quat]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+
+	auto v = Vec3{ 1, 2, 3 };
+	auto m = Mat3x3::identity();
+	auto q = math::Quat{ 1, 2, 3, 4 };
+	const auto& cq = q;
+
+	SECTION("at() is always checked") {
+		CHECK(v.at(2) == 3);
+		CHECK_THROWS_AS(v.at(3), std::out_of_range);
+
+		CHECK(m.at(1) == Vec3{ 0, 1, 0 });
+		CHECK_THROWS_AS(m.at(3), std::out_of_range);
+
+		CHECK(q.at(0) == 1);
+		CHECK_THROWS_AS(q.at(4), std::out_of_range);
+	}
+	SECTION("operator[] is checked according to the policy") {
+		if constexpr (math::detail::k_check_indices) {
+			CHECK_THROWS_AS(v[3], std::out_of_range);
+			CHECK_THROWS_AS(m[3], std::out_of_range);
+			CHECK_THROWS_AS(q[4], std::out_of_range);
+		}
+		else {
+			CHECK_NOTHROW(v[2]);
+		}
+	}
+	SECTION("Quat subscripts map to w, x, y, z") {
+		CHECK(cq[0] == q.w);
+		CHECK(cq[1] == q.x);
+		CHECK(cq[2] == q.y);
+		CHECK(cq[3] == q.z);
+
+		q[3] = 5;
+		CHECK(q.z == 5);
+	}
+}
+
+TEST_CASE("Formatting", "[vector][matrix][quat][fmt]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+
+	auto v = Vec3{ 1, -2.5, 30 };
+	auto m = Mat2x2{
+		{ 1, 0 },
+		{ 0, -1 },
+	};
+	auto q = math::Quat{ 1, 0, 0, 0 };
+	auto buffer = fmt::memory_buffer();
+
+	SECTION("format_to matches to_string") {
+		v.format_to(std::back_inserter(buffer));
+		CHECK(fmt::to_string(buffer) == v.to_string());
+		buffer.clear();
+
+		m.format_to(std::back_inserter(buffer), 1);
+		CHECK(fmt::to_string(buffer) == m.to_string(1));
+		buffer.clear();
+
+		q.format_to(std::back_inserter(buffer));
+		CHECK(fmt::to_string(buffer) == q.to_string());
+	}
+	SECTION("supports fmt format specs") {
+		CHECK(fmt::format("{}", v) == v.to_string());
+		CHECK(fmt::format("{:.1}", v) == v.to_string(1));
+		CHECK(fmt::format("{:.0}", m) == "|  1   0 |\n|  0  -1 |\n");
+		CHECK(fmt::format("{:.2}", q) == q.to_string(2));
+		CHECK(fmt::format("{}", math::RotationMatrix(0, math::Axis::Z)) == Mat3x3::identity().to_string());
+	}
+	SECTION("can format into a fixed-size buffer") {
+		auto chars = std::array<char, 8>{};
+		auto result = fmt::format_to_n(chars.data(), chars.size(), "{:.1}", v);
+
+		CHECK(result.size == v.to_string(1).size());
+		CHECK(std::string(chars.data(), chars.size()) == v.to_string(1).substr(0, chars.size()));
+	}
+	SECTION("can format a range of values") {
+		auto points = std::array<math::Vec2, 2>{ math::Vec2{ 1, 2.5 }, math::Vec2{ 3, 4 } };
+
+		CHECK(fmt::format("{:.1}", math::fmt::values(points, ", ")) == "[ 1.0  2.5 ], [ 3  4 ]");
+		CHECK(fmt::format("{}", math::fmt::values(points.data(), 1)) == points[0].to_string());
+	}
+}
+
 TEST_CASE("math::Matrix<R,C,T>", "[matrix]") {
 	using namespace sized; // NOLINT
 
@@ -1048,3 +1237,2552 @@ TEST_CASE("Geometric Primitives", "[geoprim]") {
 		}
 	}
 }
+
+TEST_CASE("math::batch", "[batch]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+	using namespace math::literals; // NOLINT(*-using-namespace)
+
+	using math::Isa;
+	using math::Quat;
+	using math::TransformMatrix;
+	using math::geo::Plane;
+	using math::geo::Ray;
+	using math::geo::Sphere;
+	using math::geo::Tri;
+
+	constexpr flt epsilon = 1e-5;
+	constexpr usize count = 67; // Deliberately not a multiple of any vector width
+
+	// Deterministic, irregular inputs
+	auto sample = [](usize i, flt scale) -> Vec3 {
+		auto n = static_cast<flt>(i);
+		return Vec3{ std::sin(n * 1.3_flt), std::cos(n * 0.7_flt), std::sin(n * 2.9_flt + 1) } * scale;
+	};
+
+	for (auto isa : { Isa::Baseline, Isa::AVX2, Isa::AVX512 }) {
+		if (!math::batch::force_isa(isa))
+			continue;
+
+		INFO("isa = " << math::isa_name(isa));
+		CHECK(math::batch::isa() == isa);
+
+		DYNAMIC_SECTION("transform_points matches TransformMatrix::transform_point (" << math::isa_name(isa) << ")") {
+			auto rotation = Quat::angle_axis(33_deg, Vec3{ 1, 2, 3 }.normal());
+			auto m = TransformMatrix(rotation, Vec3{ 4, -5, 6 });
+
+			std::array<Vec3, count> points;
+			for (usize i = 0; i < count; ++i)
+				points[i] = sample(i, 10);
+
+			std::array<Vec3, count> result;
+			math::batch::transform_points(m, points.data(), result.data(), count);
+
+			for (usize i = 0; i < count; ++i) {
+				auto expected = m.transform_point(points[i]);
+				CHECK_THAT(result[i].x, WithinAbs(expected.x, epsilon));
+				CHECK_THAT(result[i].y, WithinAbs(expected.y, epsilon));
+				CHECK_THAT(result[i].z, WithinAbs(expected.z, epsilon));
+			}
+		}
+		DYNAMIC_SECTION("cull_spheres matches Plane::dist (" << math::isa_name(isa) << ")") {
+			std::array<Plane, 4> planes {
+				Plane{ Vec3::right(), -5 },
+				Plane{ -Vec3::right(), -5 },
+				Plane{ Vec3::up(), -5 },
+				Plane{ Vec3{ 0, -1, 1 }.normal(), -3 },
+			};
+
+			// More than the kernel does at a time
+			constexpr usize many = count * 9;
+			std::array<Sphere, many> spheres;
+			for (usize i = 0; i < many; ++i)
+				spheres[i] = Sphere{ sample(i, 8), static_cast<flt>(i % 3) };
+
+			std::array<u8, many> visible;
+			math::batch::cull_spheres(planes.data(), planes.size(), spheres.data(), many, visible.data());
+
+			for (usize i = 0; i < many; ++i) {
+				bool expected = true;
+				for (const auto& plane : planes)
+					expected = expected && plane.dist(spheres[i].center) >= -spheres[i].radius;
+
+				CHECK(static_cast<bool>(visible[i]) == expected);
+			}
+		}
+		DYNAMIC_SECTION("cull_cones keeps clusters facing the eye (" << math::isa_name(isa) << ")") {
+			// Clusters of triangles facing +z, or spread over a hemisphere
+			std::array<Sphere, 4> spheres {
+				Sphere{ Vec3{ 0, 0, 0 }, 1 },
+				Sphere{ Vec3{ 0, 0, 20 }, 1 },
+				Sphere{ Vec3{ 20, 0, 10 }, 1 },
+				Sphere{ Vec3{ 0, 0, 20 }, 1 },
+			};
+			std::array<Vec3, 4> axes;
+			axes.fill(Vec3{ 0, 0, 1 });
+			std::array<flt, 4> cutoffs { 0, 0, 0, 1 };
+
+			std::array<u8, 4> visible;
+			math::batch::cull_cones(Vec3{ 0, 0, 10 }, spheres.data(), axes.data(), cutoffs.data(), 4, visible.data());
+
+			// In front, behind, edge-on, and unbounded normals
+			CHECK(visible[0] == 1);
+			CHECK(visible[1] == 0);
+			CHECK(visible[2] == 1);
+			CHECK(visible[3] == 1);
+
+			// Enough clusters to fill the vector lanes, against the scalar test
+			auto eye = Vec3{ 1, -2, 3 };
+			std::array<Sphere, count> many_spheres;
+			std::array<Vec3, count> many_axes;
+			std::array<flt, count> many_cutoffs;
+			for (usize i = 0; i < count; ++i) {
+				many_spheres[i] = Sphere{ sample(i, 8), static_cast<flt>(i % 3) * 0.5_flt };
+				many_axes[i] = sample(i + count, 1).normal();
+				many_cutoffs[i] = static_cast<flt>(i % 5) * 0.25_flt;
+			}
+
+			std::array<u8, count> many_visible;
+			math::batch::cull_cones(
+				eye, many_spheres.data(), many_axes.data(), many_cutoffs.data(), count, many_visible.data());
+
+			usize culled = 0;
+			for (usize i = 0; i < count; ++i) {
+				auto to_center = many_spheres[i].center - eye;
+				bool expected = (to_center | many_axes[i])
+					< many_cutoffs[i] * to_center.length() + many_spheres[i].radius;
+
+				CHECK(static_cast<bool>(many_visible[i]) == expected);
+				culled += !expected;
+			}
+			CHECK(culled > 0);
+			CHECK(culled < count);
+		}
+		DYNAMIC_SECTION("intersect_ray_tris (" << math::isa_name(isa) << ")") {
+			auto ray = Ray{ Vec3{ 0.25, 1, 0.25 }, Vec3{ 0, -2, 0 } };
+			std::array<Tri, 4> tris {
+				// Hit, halfway along the ray
+				Tri{ { -1, 0, -1 }, { 0, 0, 1 }, { 1, 0, -1 } },
+				// Hit from the other side (reversed winding)
+				Tri{ { 1, -0.5, -1 }, { 0, -0.5, 1 }, { -1, -0.5, -1 } },
+				// Miss, off to the side
+				Tri{ { 5, 0, 5 }, { 6, 0, 7 }, { 7, 0, 5 } },
+				// Miss, beyond the end of the ray
+				Tri{ { -1, -3, -1 }, { 0, -3, 1 }, { 1, -3, -1 } },
+			};
+
+			std::array<flt, 4> t;
+			math::batch::intersect_ray_tris(ray, tris.data(), tris.size(), t.data());
+
+			CHECK_THAT(t[0], WithinAbs(0.5, epsilon));
+			CHECK_THAT(t[1], WithinAbs(0.75, epsilon));
+			CHECK(std::isinf(t[2]));
+			CHECK(std::isinf(t[3]));
+		}
+	}
+
+	// Not dispatched
+	SECTION("normalize matches Vec3::normal") {
+		std::array<Vec3, count> vectors;
+		for (usize i = 0; i < count; ++i)
+			vectors[i] = sample(i, static_cast<flt>(i));
+
+		vectors[0] = Vec3::Zero;
+		vectors[1] = Vec3::up();
+
+		auto expected = vectors;
+		math::batch::normalize(vectors.data(), count);
+
+		for (usize i = 0; i < count; ++i) {
+			auto n = expected[i].normal();
+			CHECK_THAT(vectors[i].x, WithinAbs(n.x, epsilon));
+			CHECK_THAT(vectors[i].y, WithinAbs(n.y, epsilon));
+			CHECK_THAT(vectors[i].z, WithinAbs(n.z, epsilon));
+		}
+	}
+	SECTION("slerp") {
+		std::array<Quat, 3> src {
+			Quat::angle_axis(30_deg, Vec3::up()),
+			Quat::angle_axis(-40_deg, Vec3::right()),
+			Quat::angle_axis(10_deg, Vec3{ 1, 1, 0 }.normal()),
+		};
+		std::array<Quat, 3> dest {
+			Quat::angle_axis(90_deg, Vec3::up()),
+			Quat::angle_axis(40_deg, Vec3::right()),
+			// Same rotation, but on the far hemisphere
+			-Quat::angle_axis(10.001_deg, Vec3{ 1, 1, 0 }.normal()),
+		};
+		std::array<Quat, 3> halfway {
+			Quat::angle_axis(60_deg, Vec3::up()),
+			Quat::identity(),
+			Quat::angle_axis(10.0005_deg, Vec3{ 1, 1, 0 }.normal()),
+		};
+
+		std::array<Quat, 3> result;
+		math::batch::slerp(src.data(), dest.data(), 0.5, result.data(), src.size());
+
+		for (usize i = 0; i < src.size(); ++i) {
+			CHECK_THAT(result[i].w, WithinAbs(halfway[i].w, epsilon));
+			CHECK_THAT(result[i].x, WithinAbs(halfway[i].x, epsilon));
+			CHECK_THAT(result[i].y, WithinAbs(halfway[i].y, epsilon));
+			CHECK_THAT(result[i].z, WithinAbs(halfway[i].z, epsilon));
+		}
+
+		math::batch::slerp(src.data(), dest.data(), 0, result.data(), 1);
+		CHECK_THAT(result[0].w, WithinAbs(src[0].w, epsilon));
+		CHECK_THAT(result[0].y, WithinAbs(src[0].y, epsilon));
+
+		math::batch::slerp(src.data(), dest.data(), 1, result.data(), 1);
+		CHECK_THAT(result[0].w, WithinAbs(dest[0].w, epsilon));
+		CHECK_THAT(result[0].y, WithinAbs(dest[0].y, epsilon));
+	}
+	SECTION("rejects instruction sets the CPU doesn't support") {
+		for (auto isa : { Isa::AVX2, Isa::AVX512 })
+			if (static_cast<u8>(isa) > static_cast<u8>(math::cpu_isa()))
+				CHECK(!math::batch::force_isa(isa));
+	}
+
+	math::batch::reset_isa();
+}
+
+TEST_CASE("math::SpatialHash", "[spatial]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+	using math::SpatialHash;
+
+	// Random points around the origin, denser towards it
+	auto make_points = [](usize count) {
+		auto rng = std::mt19937(7);
+		auto dist = std::uniform_real_distribution<flt>(-1, 1);
+		auto result = std::vector<Vec3>();
+		for (usize i = 0; i < count; ++i) {
+			auto p = Vec3{ dist(rng), dist(rng), dist(rng) };
+			result.push_back(p * (20 * std::abs(dist(rng))));
+		}
+		return result;
+	};
+	auto sq_dist = [](const Vec3& a, const Vec3& b) { return (a - b).sq_length(); };
+
+	auto points = make_points(3000);
+	auto grid = SpatialHash(1.5, 1);
+	grid.build(points.data(), points.size());
+	REQUIRE(grid.size() == points.size());
+
+	auto centers = std::vector<Vec3>{ Vec3{ 0, 0, 0 }, Vec3{ 3.7, -2.2, 9.1 }, Vec3{ -15, 4, 0.5 }, Vec3{ 60, 60, 60 } };
+	auto out = std::vector<u32>();
+
+	SECTION("finds the points within a radius") {
+		bool matches = true;
+		for (const auto& center : centers) {
+			for (flt radius : { 0.0, 1.0, 2.5, 8.0 }) {
+				grid.query_radius(center, radius, out);
+				std::sort(out.begin(), out.end());
+
+				auto expected = std::vector<u32>();
+				for (u32 i = 0; i < points.size(); ++i)
+					if (sq_dist(points[i], center) <= radius * radius)
+						expected.push_back(i);
+
+				matches &= out == expected;
+			}
+		}
+		CHECK(matches);
+
+		grid.query_radius(Vec3{ 0, 0, 0 }, 100, out);
+		CHECK(out.size() == points.size());
+	}
+	SECTION("finds the nearest points, nearest first") {
+		bool matches = true;
+		for (const auto& center : centers) {
+			for (usize k : { 1, 7, 40 }) {
+				grid.query_nearest(center, k, out);
+
+				auto expected = std::vector<u32>(points.size());
+				std::iota(expected.begin(), expected.end(), 0);
+				std::sort(expected.begin(), expected.end(), [&](u32 a, u32 b) {
+					return std::pair(sq_dist(points[a], center), a) < std::pair(sq_dist(points[b], center), b);
+				});
+				expected.resize(k);
+
+				matches &= out == expected;
+			}
+		}
+		CHECK(matches);
+
+		grid.query_nearest(Vec3{ 1, 1, 1 }, points.size() + 5, out);
+		CHECK(out.size() == points.size());
+	}
+	SECTION("builds the same grid with any number of threads") {
+		auto many = make_points(100000);
+		grid.build(many.data(), many.size());
+		auto threaded = SpatialHash(1.5, 4);
+		threaded.build(many.data(), many.size());
+
+		bool same = true;
+		auto other = std::vector<u32>();
+		for (const auto& center : centers) {
+			grid.query_radius(center, 2, out);
+			threaded.query_radius(center, 2, other);
+			same &= out == other && !out.empty() == (center.x < 50);
+
+			grid.query_nearest(center, 16, out);
+			threaded.query_nearest(center, 16, other);
+			same &= out == other;
+		}
+		CHECK(same);
+
+		// Rebuilding over fewer points forgets the rest
+		grid.build(points.data(), 10);
+		grid.query_radius(Vec3{ 0, 0, 0 }, 100, out);
+		CHECK(out.size() == 10);
+	}
+	SECTION("handles points beyond the range of the cells") {
+		// Further out than 2^31 cells, where the cells at the end of the range
+		// hold everything beyond
+		auto far = std::vector<Vec3>{
+			Vec3{ 0, 0, 0 }, Vec3{ 1e15, 0, 0 }, Vec3{ 1.5e15, 0, 0 }, Vec3{ 1e15, 3, 0 }, Vec3{ -1e15, -1e15, 1 },
+		};
+		grid.build(far.data(), far.size());
+
+		grid.query_radius(far[1], 4, out);
+		std::sort(out.begin(), out.end());
+		CHECK(out == std::vector<u32>{ 1, 3 });
+		grid.query_radius(far[4], 1, out);
+		CHECK(out == std::vector<u32>{ 4 });
+
+		// The point in the same cell is further than the one two cells up
+		grid.query_nearest(far[1], 2, out);
+		CHECK(out == std::vector<u32>{ 1, 3 });
+		grid.query_nearest(Vec3{ 0, 0, 0 }, 1, out);
+		CHECK(out == std::vector<u32>{ 0 });
+	}
+}
+
+TEST_CASE("mesh::binary", "[mesh]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+
+	// Two quads as separate submeshes, with an f32x3 position and u8x4 color
+	auto data = mesh::MeshData();
+	data.push_attribute(mesh::Scalar::f32, 3);
+	data.push_attribute(mesh::Scalar::u8, 4, true);
+
+	for (u32 i = 0; i < 8; ++i) {
+		f32 position[3] { f32(i % 2), f32(i / 2 % 2), f32(i / 4) * 5 };
+		u8 color[4] { u8(i), 0, 0, 255 };
+
+		auto offset = data.vertices.size();
+		data.vertices.resize(offset + data.stride);
+		std::memcpy(&data.vertices[offset], position, sizeof(position));
+		std::memcpy(&data.vertices[offset + sizeof(position)], color, sizeof(color));
+	}
+	data.indices = { 0, 1, 3, 0, 3, 2, 4, 5, 7, 4, 7, 6 };
+	data.submeshes = { { 0, 6 }, { 6, 6 } };
+	data.compute_bounds();
+
+	SECTION("computes submesh bounds from the positions") {
+		CHECK(data.submeshes[0].bounds.min == Vec3{ 0, 0, 0 });
+		CHECK(data.submeshes[0].bounds.max == Vec3{ 1, 1, 0 });
+		CHECK(data.submeshes[1].bounds.min == Vec3{ 0, 0, 5 });
+		CHECK(data.submeshes[1].bounds.max == Vec3{ 1, 1, 5 });
+	}
+	SECTION("round-trips through the encoded format without copying") {
+		auto bytes = mesh::binary::encode(data);
+		auto loaded = mesh::binary::Mesh(bytes.data(), bytes.size());
+
+		REQUIRE(loaded.layout().size() == 2);
+		CHECK(loaded.layout()[1].type == mesh::Scalar::u8);
+		CHECK(loaded.layout()[1].count == 4);
+		CHECK(loaded.layout()[1].normalized);
+		CHECK(loaded.layout()[1].offset == 12);
+
+		CHECK(loaded.vertex_stride() == 16);
+		CHECK(loaded.vertex_count() == 8);
+		CHECK(loaded.index_count() == 12);
+		CHECK(std::memcmp(loaded.vertex_data(), data.vertices.data(), data.vertices.size()) == 0);
+		CHECK(std::memcmp(loaded.index_data(), data.indices.data(), data.indices.size() * sizeof(u32)) == 0);
+
+		// The blobs are views into the encoded bytes, aligned for direct upload
+		CHECK(static_cast<const u8*>(loaded.vertex_data()) >= bytes.data());
+		CHECK(reinterpret_cast<std::uintptr_t>(loaded.index_data()) % mesh::binary::k_alignment == 0);
+
+		REQUIRE(loaded.submeshes().size() == 2);
+		CHECK(loaded.submeshes()[1].first_index == 6);
+		CHECK(loaded.submeshes()[1].bounds.max == Vec3{ 1, 1, 5 });
+		CHECK(loaded.bounds().min == Vec3{ 0, 0, 0 });
+		CHECK(loaded.bounds().max == Vec3{ 1, 1, 5 });
+	}
+	SECTION("can be written to and memory-mapped from a file") {
+		auto path = (std::filesystem::temp_directory_path() / "mesh_binary_test.mesh").string();
+		mesh::binary::write(path, data);
+
+		{
+			auto loaded = mesh::binary::Mesh::load(path);
+			CHECK(loaded.vertex_count() == 8);
+			CHECK(loaded.index_data()[11] == 6);
+		}
+		std::filesystem::remove(path);
+
+		CHECK_THROWS_AS(mesh::binary::Mesh::load(path), mesh::FileError);
+	}
+	SECTION("rejects malformed files") {
+		auto bytes = mesh::binary::encode(data);
+		auto header = mesh::binary::Header{};
+		std::memcpy(&header, bytes.data(), sizeof(header));
+
+		auto corrupt = [&](auto&& modify) {
+			auto copy = bytes;
+			auto h = header;
+			modify(h);
+			std::memcpy(copy.data(), &h, sizeof(h));
+			return copy;
+		};
+
+		auto bad_magic = corrupt([](auto& h) { h.magic[0] = 'X'; });
+		auto bad_version = corrupt([](auto& h) { h.version_major += 1; });
+		auto truncated = corrupt([](auto& h) { h.index_count += 1; });
+		auto overflow = corrupt([](auto& h) { h.vertex_count = ~u64(0); });
+		auto newer_minor = corrupt([](auto& h) { h.version_minor += 1; });
+
+		CHECK_THROWS_AS(mesh::binary::Mesh(bytes.data(), 16), mesh::FileError);
+		CHECK_THROWS_AS(mesh::binary::Mesh(bad_magic.data(), bad_magic.size()), mesh::FileError);
+		CHECK_THROWS_AS(mesh::binary::Mesh(bad_version.data(), bad_version.size()), mesh::FileError);
+		CHECK_THROWS_AS(mesh::binary::Mesh(truncated.data(), truncated.size()), mesh::FileError);
+		CHECK_THROWS_AS(mesh::binary::Mesh(overflow.data(), overflow.size()), mesh::FileError);
+		CHECK_NOTHROW(mesh::binary::Mesh(newer_minor.data(), newer_minor.size()));
+	}
+}
+
+TEST_CASE("mesh::parse", "[mesh]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+
+	auto parse = [](std::string_view text, f64& out) {
+		const char* it = text.data();
+		bool ok = mesh::parse::parse_float(it, text.data() + text.size(), out);
+		return ok ? static_cast<usize>(it - text.data()) : 0;
+	};
+
+	SECTION("parses floats exactly like strtod") {
+		for (auto text : { "0", "-0.5", "+3.25", "1e3", "1.5E-3", ".125", "7.", "0.000123",
+			"3.14159265358979", "123456789012345678901234", "1e-300", "2.2250738585072014e-308" })
+		{
+			f64 value = 0;
+			CHECK(parse(text, value) == std::string_view(text).size());
+			CHECK(value == std::strtod(text, nullptr));
+		}
+	}
+	SECTION("stops at the end of the number") {
+		f64 value = 0;
+		CHECK(parse("1.5/2", value) == 3);
+		CHECK(value == 1.5);
+		CHECK(parse("4e", value) == 1);
+	}
+	SECTION("rejects non-numbers") {
+		f64 value = 0;
+		CHECK(parse("", value) == 0);
+		CHECK(parse("-", value) == 0);
+		CHECK(parse(".", value) == 0);
+		CHECK(parse("x1", value) == 0);
+	}
+}
+
+TEST_CASE("mesh::obj", "[mesh]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+	using math::Vec2;
+
+	auto import = [](std::string_view source, usize threads = 1) {
+		auto options = mesh::obj::ImportOptions{ threads, 1 };
+		return mesh::obj::import(source.data(), source.size(), options);
+	};
+
+	SECTION("deduplicates shared vertices") {
+		auto result = import(
+			"# A quad made of two triangles\n"
+			"v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+			"f 1 2 3\n"
+			"f 1 3 4\n");
+
+		CHECK(result.vertex_count() == 4);
+		CHECK(result.indices == std::vector<u32>{ 0, 1, 2, 0, 2, 3 });
+		CHECK(result.normals.empty());
+		CHECK(result.uvs.empty());
+		REQUIRE(result.submeshes.size() == 1);
+		CHECK(result.submeshes[0].bounds.max == Vec3{ 1, 1, 0 });
+	}
+	SECTION("splits vertices with different attributes, and triangulates polygons") {
+		auto result = import(
+			"v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\r\n"
+			"vt 0 0\nvt 1 1\n"
+			"vn 0 0 1\n"
+			"f 1/1/1 2/1/1 3/2/1 4/2/1\n"
+			"f -4//-1 -3//-1 -2//-1 # relative\n");
+
+		CHECK(result.indices.size() == 9);
+		CHECK(result.vertex_count() == 7);
+		CHECK(result.uvs[2] == Vec2{ 1, 1 });
+		CHECK(result.uvs[4] == Vec2{ 0, 0 });
+		CHECK(result.normals[6] == Vec3{ 0, 0, 1 });
+	}
+	SECTION("starts submeshes at objects, groups and materials") {
+		auto result = import(
+			"v 0 0 0\nv 1 0 0\nv 0 1 0\nv 0 0 5\n"
+			"o first\nf 1 2 3\n"
+			"usemtl red\nf 1 2 4\nf 2 3 4\n"
+			"g empty\n");
+
+		REQUIRE(result.submeshes.size() == 2);
+		CHECK(result.submeshes[1].first_index == 3);
+		CHECK(result.submeshes[1].index_count == 6);
+		CHECK(result.submeshes[1].bounds.max.z == 5);
+	}
+	SECTION("gives the same result with any number of threads") {
+		auto source = std::string();
+		for (u32 i = 0; i < 500; ++i)
+			source += fmt::format("v {} {} 0\nv {} {} 1\nvn 0 0 1\nf -1//-1 -2//-1 {}//-1\n", i, i * 0.5, i, -0.25 * i, i + 1);
+
+		auto serial = import(source, 1);
+		auto parallel = import(source, 7);
+
+		CHECK(serial.indices == parallel.indices);
+		CHECK(serial.positions == parallel.positions);
+		CHECK(serial.normals == parallel.normals);
+	}
+	SECTION("reports errors with their line number") {
+		CHECK_THROWS_WITH(import("v 0 0 0\nv 1 0\n"), Catch::Matchers::ContainsSubstring("line 2"));
+		CHECK_THROWS_AS(import("v 0 0 0\nf 1 2 3\n"), mesh::FileError);
+		CHECK_THROWS_AS(import("v 0 0 0\nf 1 1\n"), mesh::FileError);
+	}
+}
+
+TEST_CASE("mesh::optimize", "[mesh]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+	namespace opt = mesh::optimize;
+
+	// A grid of quads, with its triangles emitted in a cache-hostile order:
+	// alternating between the two halves of each row
+	constexpr u32 size = 32;
+	auto grid = mesh::SoaMesh();
+	for (u32 y = 0; y < size; ++y)
+		for (u32 x = 0; x < size; ++x)
+			grid.positions.push_back(Vec3{ flt(x), flt(y), 0 });
+
+	for (u32 y = 0; y + 1 < size; ++y) {
+		for (u32 i = 0; i + 1 < size; ++i) {
+			u32 x = (i % 2 == 0) ? i / 2 : size / 2 + i / 2;
+			u32 v = y * size + x;
+			grid.indices.insert(grid.indices.end(), { v, v + size, v + 1, v + 1, v + size, v + size + 1 });
+		}
+	}
+	grid.submeshes.push_back({ 0, static_cast<u32>(grid.indices.size()) });
+
+	// Triangles as sorted position triples, to compare meshes independent of
+	// triangle order, vertex order and winding rotation
+	auto triangles = [](const mesh::SoaMesh& m) {
+		auto result = std::vector<std::array<flt, 9>>();
+		for (usize i = 0; i < m.indices.size(); i += 3) {
+			auto tri = std::array<flt, 9>{};
+			auto corners = std::array<Vec3, 3>{
+				m.positions[m.indices[i]], m.positions[m.indices[i + 1]], m.positions[m.indices[i + 2]] };
+			auto first = std::min_element(corners.begin(), corners.end(), [](const auto& a, const auto& b) {
+				return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+			});
+			std::rotate(corners.begin(), first, corners.end());
+			for (usize k = 0; k < 9; ++k)
+				tri[k] = corners[k / 3][k % 3];
+			result.push_back(tri);
+		}
+		std::sort(result.begin(), result.end());
+		return result;
+	};
+
+	SECTION("simulates the vertex cache") {
+		u32 tri[] { 0, 1, 2 };
+		auto stats = opt::analyze_vertex_cache(tri, 3, 3);
+
+		CHECK(stats.transformed == 3);
+		CHECK(stats.acmr == 3);
+		CHECK(stats.atvr == 1);
+	}
+	SECTION("improves ACMR without changing the triangles") {
+		auto optimized = grid;
+		auto report = opt::optimize(optimized, { opt::k_cache_size, false });
+
+		CHECK(report.before.acmr == opt::analyze_vertex_cache(
+			grid.indices.data(), grid.indices.size(), grid.vertex_count()).acmr);
+		CHECK(report.after.acmr < report.before.acmr);
+		CHECK(report.after.acmr < 0.8f);
+		CHECK(report.after.atvr < report.before.atvr);
+		CHECK(triangles(optimized) == triangles(grid));
+	}
+	SECTION("keeps the triangles when reordering for overdraw") {
+		auto optimized = grid;
+		auto report = opt::optimize(optimized);
+
+		CHECK(report.after.acmr < report.before.acmr);
+		CHECK(triangles(optimized) == triangles(grid));
+	}
+	SECTION("orders vertices by first use and drops unused ones") {
+		auto m = mesh::SoaMesh();
+		m.positions = { Vec3{ 0, 0, 0 }, Vec3{ 1, 0, 0 }, Vec3{ 2, 0, 0 }, Vec3{ 3, 0, 0 } };
+		m.indices = { 3, 1, 0 };
+
+		auto remap = opt::optimize_vertex_fetch(m.indices.data(), m.indices.size(), m.vertex_count());
+		opt::remap_vertices(m.positions, remap);
+
+		CHECK(m.indices == std::vector<u32>{ 0, 1, 2 });
+		CHECK(remap[2] == opt::k_unused);
+		CHECK(m.positions == std::vector<Vec3>{ Vec3{ 3, 0, 0 }, Vec3{ 1, 0, 0 }, Vec3{ 0, 0, 0 } });
+	}
+}
+
+TEST_CASE("mesh::quantize", "[mesh]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+	namespace q = mesh::quantize;
+
+	auto rng = std::mt19937(0x5eed);
+	auto range = [&](flt min, flt max) {
+		return std::uniform_real_distribution<flt>(min, max)(rng);
+	};
+	auto random_unit = [&] {
+		return Vec3{ range(-1, 1), range(-1, 1), range(-1, 1) }.normal();
+	};
+
+	SECTION("converts half floats, rounding to nearest even") {
+		CHECK(q::half(0.f) == 0x0000);
+		CHECK(q::half(-0.f) == 0x8000);
+		CHECK(q::half(1.f) == 0x3c00);
+		CHECK(q::half(-2.f) == 0xc000);
+		CHECK(q::half(65504.f) == 0x7bff);
+		CHECK(q::half(1e6f) == 0x7c00);
+		CHECK(q::half(std::numeric_limits<f32>::quiet_NaN()) == 0x7e00);
+		CHECK(q::half(std::ldexp(1.f, -24)) == 0x0001);
+		CHECK(q::half(1.f + std::ldexp(1.f, -11)) == 0x3c00);
+		CHECK(q::half(1.f + 3 * std::ldexp(1.f, -11)) == 0x3c02);
+
+		usize mismatches = 0;
+		for (u32 h = 0; h < 0x7c00; ++h) {
+			mismatches += q::half(q::decode_half(static_cast<u16>(h))) != h;
+			mismatches += q::half(q::decode_half(static_cast<u16>(h | 0x8000))) != (h | 0x8000);
+		}
+		CHECK(mismatches == 0);
+	}
+	SECTION("positions stay within half a step of the original") {
+		auto bounds = math::geo::AABBox{ Vec3{ -3, 0, 10 }, Vec3{ 5, 2, 10 } };
+		auto tolerance = (bounds.max - bounds.min) / 65535 / 2 + Vec3::all(1e-9);
+
+		for (usize i = 0; i < 100; ++i) {
+			auto p = Vec3{ range(-3, 5), range(0, 2), 10 };
+			auto decoded = q::decode_position(q::position(p, bounds), bounds);
+
+			for (usize c = 0; c < 3; ++c)
+				CHECK(std::abs(decoded[c] - p[c]) <= tolerance[c]);
+		}
+
+		auto matrix = q::dequantize_matrix(bounds);
+		auto corner = Vec4{ 1, 1, 0, 1 } * matrix;
+		CHECK(corner == Vec4{ 5, 2, 10, 1 });
+	}
+	SECTION("octahedral normals are accurate to a fraction of a degree") {
+		flt min_dot16 = 1;
+		flt min_dot8 = 1;
+
+		for (usize i = 0; i < 1000; ++i) {
+			auto n = random_unit();
+			min_dot16 = std::min(min_dot16, q::decode_octahedral16(q::octahedral16(n)) | n);
+			min_dot8 = std::min(min_dot8, q::decode_octahedral8(q::octahedral8(n)) | n);
+		}
+		for (auto n : { Vec3{ 0, 0, 1 }, Vec3{ 0, 0, -1 }, Vec3{ 1, 0, 0 }, Vec3{ 0, -1, 0 } })
+			CHECK(q::decode_octahedral16(q::octahedral16(n)) == n);
+
+		CHECK(std::acos(min_dot16) < math::deg2rad(0.01));
+		CHECK(std::acos(min_dot8) < math::deg2rad(1.0));
+	}
+	SECTION("tangent frames round-trip with their handedness") {
+		for (usize i = 0; i < 100; ++i) {
+			auto n = random_unit();
+			auto t = (random_unit() ^ n).normal();
+			auto frame = q::tangent_frame(n, t);
+
+			CHECK_THAT(frame.rotate_point(Vec3{ 1, 0, 0 }) | t, WithinAbs(1, 1e-9));
+			CHECK_THAT(frame.rotate_point(Vec3{ 0, 0, 1 }) | n, WithinAbs(1, 1e-9));
+
+			for (flt handedness : { 1.0, -1.0 }) {
+				auto [decoded, decoded_handedness] = q::decode_tangent_frame8(q::tangent_frame8(frame, handedness));
+
+				CHECK(decoded_handedness == handedness);
+				CHECK((decoded.rotate_point(Vec3{ 0, 0, 1 }) | n) > 0.999);
+				CHECK((decoded.rotate_point(Vec3{ 1, 0, 0 }) | t) > 0.999);
+			}
+		}
+	}
+	SECTION("interleaves meshes with normalized packed attributes") {
+		auto m = mesh::SoaMesh();
+		m.positions = { Vec3{ 0, 0, 0 }, Vec3{ 4, 0, 0 }, Vec3{ 0, 2, 1 } };
+		m.normals = { Vec3{ 0, 0, 1 }, Vec3{ 0, 0, 1 }, Vec3{ 0, 1, 0 } };
+		m.uvs = { math::Vec2{ 0, 0 }, math::Vec2{ 1, 0 }, math::Vec2{ 0.5, 1 } };
+		m.indices = { 0, 1, 2 };
+		m.submeshes.push_back({ 0, 3 });
+
+		auto data = q::interleave(m);
+
+		REQUIRE(data.layout.size() == 3);
+		CHECK(data.stride == 16);
+		CHECK(data.vertices.size() == 3 * 16);
+		CHECK(m.interleave().stride == 32);
+
+		CHECK(data.layout[0].type == mesh::Scalar::u16);
+		CHECK(data.layout[0].normalized);
+		CHECK(data.layout[1].type == mesh::Scalar::i16);
+		CHECK(data.layout[1].normalized);
+		CHECK(data.layout[2].type == mesh::Scalar::f16);
+		CHECK_FALSE(data.layout[2].normalized);
+
+		auto p = std::array<u16, 4>{};
+		std::memcpy(p.data(), data.vertices.data() + 2 * data.stride, sizeof(p));
+		CHECK(q::decode_position(p, q::mesh_bounds(m)) == m.positions[2]);
+		CHECK(p[3] == 0);
+
+		CHECK(q::interleave(m, { true }).stride == 16);
+		CHECK(q::interleave(m, { true }).layout[1].type == mesh::Scalar::i8);
+	}
+}
+
+namespace {
+
+/**
+ * A `size` by `size` grid over x and y, facing +z, with uvs along x and y,
+ * bumped along z by up to `bumps`.
+ */
+auto make_grid(sized::u32 size, sized::flt bumps) -> mesh::SoaMesh
+{
+	using namespace sized; // NOLINT(*-using-namespace)
+
+	auto result = mesh::SoaMesh();
+	for (u32 y = 0; y < size; ++y) {
+		for (u32 x = 0; x < size; ++x) {
+			flt z = bumps * std::sin(flt(x) * 0.7) * std::cos(flt(y) * 0.3);
+			result.positions.push_back(Vec3{ flt(x), flt(y), z });
+			result.uvs.push_back(math::Vec2{ flt(x) / size, flt(y) / size });
+		}
+	}
+	for (u32 y = 0; y + 1 < size; ++y) {
+		for (u32 x = 0; x + 1 < size; ++x) {
+			u32 v = y * size + x;
+			result.indices.insert(result.indices.end(), { v, v + 1, v + size, v + size, v + 1, v + size + 1 });
+		}
+	}
+	result.submeshes.push_back({ 0, static_cast<u32>(result.indices.size()) });
+	return result;
+}
+
+} // namespace
+
+TEST_CASE("mesh::tangent_space", "[mesh]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+	namespace ts = mesh::tangent_space;
+	using math::Vec2;
+
+	SECTION("gives a flat surface its plane's normal and uv directions") {
+		auto grid = make_grid(8, 0);
+		ts::generate(grid);
+
+		REQUIRE(grid.normals.size() == grid.vertex_count());
+		REQUIRE(grid.tangents.size() == grid.vertex_count());
+		for (usize i = 0; i < grid.vertex_count(); ++i) {
+			CHECK(grid.normals[i] == Vec3{ 0, 0, 1 });
+			CHECK(grid.tangents[i] == Vec4{ 1, 0, 0, 1 });
+		}
+
+		// Mirroring u flips the tangent and its bitangent sign
+		for (auto& uv : grid.uvs)
+			uv.x = -uv.x;
+		ts::generate(grid);
+		CHECK(grid.tangents[10] == Vec4{ -1, 0, 0, -1 });
+	}
+	SECTION("weights by angle independently of the triangulation") {
+		// A unit cube, each face split along a different diagonal
+		auto cube = std::vector<Vec3>();
+		for (u32 i = 0; i < 8; ++i)
+			cube.push_back(Vec3{ flt(i & 1), flt((i >> 1) & 1), flt((i >> 2) & 1) });
+		auto indices = std::vector<u32>{
+			0, 2, 1, 1, 2, 3,  4, 5, 6, 5, 7, 6,  0, 1, 4, 1, 5, 4,
+			2, 6, 3, 3, 6, 7,  0, 4, 2, 2, 4, 6,  1, 3, 5, 3, 7, 5,
+		};
+
+		auto normals = std::vector<Vec3>(8);
+		ts::compute_normals(normals.data(), indices.data(), indices.size(), cube.data(), cube.size());
+		for (u32 i = 0; i < 8; ++i) {
+			auto expected = (cube[i] - Vec3::all(0.5)).normal();
+			CHECK_THAT(normals[i].x, WithinAbs(expected.x, 1e-12));
+			CHECK_THAT(normals[i].y, WithinAbs(expected.y, 1e-12));
+			CHECK_THAT(normals[i].z, WithinAbs(expected.z, 1e-12));
+		}
+
+		// By area, corners with two triangles of a face lean towards it
+		auto options = ts::Options();
+		options.weighting = ts::Weighting::Area;
+		ts::compute_normals(normals.data(), indices.data(), indices.size(), cube.data(), cube.size(), options);
+		CHECK(std::abs(normals[1].z) > std::abs(normals[1].x));
+	}
+	SECTION("gives the same result with any number of threads") {
+		auto grid = make_grid(200, 0.8);
+		auto options = ts::Options();
+		options.threads = 1;
+		auto single = grid;
+		ts::generate(single, options);
+
+		options.threads = 4;
+		options.min_triangles_per_thread = 64;
+		ts::generate(grid, options);
+
+		auto xyz = [](const Vec4& v) { return Vec3{ v.x, v.y, v.z }; };
+		flt max_difference = 0;
+		flt max_error = 0;
+		bool same_signs = true;
+		for (usize i = 0; i < grid.vertex_count(); ++i) {
+			const auto& n = grid.normals[i];
+			auto t = xyz(grid.tangents[i]);
+			max_difference = std::max({ max_difference,
+				(n - single.normals[i]).length(), (t - xyz(single.tangents[i])).length() });
+			max_error = std::max({ max_error, std::abs(n.length() - 1), std::abs(t | n) });
+			same_signs &= grid.tangents[i].w == single.tangents[i].w && grid.tangents[i].w == 1;
+		}
+		CHECK(max_difference < 1e-12);
+		CHECK(max_error < 1e-12);
+		CHECK(same_signs);
+
+		CHECK(mesh::quantize::interleave(grid).layout.size() == 4);
+		CHECK(grid.interleave().stride == 48);
+	}
+}
+
+TEST_CASE("mesh::simplify", "[mesh]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+	namespace ms = mesh::simplify;
+
+	auto simplify = [](const mesh::SoaMesh& mesh, const ms::Options& options) {
+		return ms::simplify(
+			mesh.indices.data(), mesh.indices.size(),
+			mesh.positions.data(), mesh.vertex_count(),
+			options);
+	};
+	auto area = [](const mesh::SoaMesh& mesh, const std::vector<u32>& indices) {
+		flt result = 0;
+		for (usize i = 0; i < indices.size(); i += 3) {
+			const auto& p0 = mesh.positions[indices[i]];
+			auto normal = (mesh.positions[indices[i + 1]] - p0) ^ (mesh.positions[indices[i + 2]] - p0);
+			result += normal.z / 2;
+		}
+		return result;
+	};
+	auto uses = [](const std::vector<u32>& indices, u32 vertex) {
+		return std::find(indices.begin(), indices.end(), vertex) != indices.end();
+	};
+
+	SECTION("collapses a flat surface without error") {
+		auto grid = make_grid(9, 0);
+		auto options = ms::Options();
+		options.target_error = 1e-9;
+		auto result = simplify(grid, options);
+
+		CHECK(result.indices.size() / 3 <= 8);
+		CHECK(result.error < 1e-9);
+		CHECK_THAT(area(grid, result.indices), WithinAbs(64, 1e-9));
+		for (u32 corner : { 0u, 8u, 72u, 80u })
+			CHECK(uses(result.indices, corner));
+	}
+	SECTION("stops at the target triangle count") {
+		auto grid = make_grid(20, 0.8);
+		auto options = ms::Options();
+		options.target_triangles = 100;
+		auto result = simplify(grid, options);
+
+		usize triangles = result.indices.size() / 3;
+		CHECK(triangles <= 100);
+		CHECK(triangles >= 98);
+		CHECK(result.error > 0);
+
+		// Every triangle still faces the same way
+		bool facing = true;
+		for (usize i = 0; i < result.indices.size(); i += 3) {
+			const auto& p0 = grid.positions[result.indices[i]];
+			auto normal = (grid.positions[result.indices[i + 1]] - p0) ^ (grid.positions[result.indices[i + 2]] - p0);
+			facing &= normal.z > 0;
+		}
+		CHECK(facing);
+	}
+	SECTION("keeps boundaries and seams in place") {
+		auto grid = make_grid(12, 0.8);
+		auto options = ms::Options();
+		options.target_triangles = 10;
+		options.lock_boundary = true;
+		auto result = simplify(grid, options);
+
+		bool kept = true;
+		for (u32 i = 0; i < 12; ++i)
+			kept &= uses(result.indices, i) && uses(result.indices, 132 + i)
+				&& uses(result.indices, i * 12) && uses(result.indices, i * 12 + 11);
+		CHECK(kept);
+
+		// Split the grid's middle column in two, as along a uv seam
+		for (usize i = 0; i < grid.indices.size(); i += 6) {
+			u32 v = grid.indices[i];
+			if (v % 12 >= 6) {
+				for (usize k = i; k < i + 6; ++k)
+					if (grid.indices[k] % 12 == 6)
+						grid.indices[k] = static_cast<u32>(grid.positions.size() + grid.indices[k] / 12);
+			}
+		}
+		for (u32 y = 0; y < 12; ++y)
+			grid.positions.push_back(grid.positions[y * 12 + 6]);
+
+		result = simplify(grid, ms::Options());
+		bool seam = true;
+		for (u32 y = 0; y < 12; ++y)
+			seam &= uses(result.indices, y * 12 + 6) && uses(result.indices, 144 + y);
+		CHECK(seam);
+	}
+	SECTION("builds levels of detail sharing the vertices") {
+		auto grid = make_grid(32, 0.8);
+		auto lods = ms::build_lods(grid, 4);
+
+		REQUIRE(lods.size() == 4);
+		CHECK(lods[0].indices == grid.indices);
+		CHECK(lods[0].error == 0);
+		for (usize i = 1; i < lods.size(); ++i) {
+			usize triangles = lods[i].indices.size() / 3;
+			usize previous = lods[i - 1].indices.size() / 3;
+			CHECK(triangles <= previous / 2);
+			CHECK(triangles + 2 >= previous / 2);
+			CHECK(lods[i].error >= lods[i - 1].error);
+			REQUIRE(lods[i].submeshes.size() == 1);
+			CHECK(lods[i].submeshes[0].index_count == lods[i].indices.size());
+		}
+	}
+	SECTION("keeps the seams between submeshes closed") {
+		// The left and right halves of the grid, the right with its own copy
+		// of the middle column
+		auto grid = make_grid(24, 0.8);
+		auto left = std::vector<u32>();
+		auto right = std::vector<u32>();
+		for (usize i = 0; i < grid.indices.size(); i += 6) {
+			bool is_left = grid.indices[i] % 24 < 12;
+			for (usize k = i; k < i + 6; ++k) {
+				u32 v = grid.indices[k];
+				if (is_left)
+					left.push_back(v);
+				else
+					right.push_back(v % 24 == 12 ? static_cast<u32>(576 + v / 24) : v);
+			}
+		}
+		for (u32 y = 0; y < 24; ++y) {
+			grid.positions.push_back(grid.positions[y * 24 + 12]);
+			grid.uvs.push_back(grid.uvs[y * 24 + 12]);
+		}
+		grid.indices = left;
+		grid.indices.insert(grid.indices.end(), right.begin(), right.end());
+		grid.submeshes = {
+			{ 0, static_cast<u32>(left.size()) },
+			{ static_cast<u32>(left.size()), static_cast<u32>(right.size()) },
+		};
+
+		auto lods = ms::build_lods(grid, 3);
+		REQUIRE(lods.size() == 3);
+		for (const auto& lod : lods) {
+			REQUIRE(lod.submeshes.size() == 2);
+			auto first = std::vector<u32>(lod.indices.begin(), lod.indices.begin() + lod.submeshes[0].index_count);
+			auto second = std::vector<u32>(lod.indices.begin() + lod.submeshes[1].first_index, lod.indices.end());
+
+			bool seam = true;
+			for (u32 y = 0; y < 24; ++y)
+				seam &= uses(first, y * 24 + 12) && uses(second, 576 + y);
+			CHECK(seam);
+
+			bool own = true;
+			for (u32 v : first)
+				own &= v < 576 && v % 24 <= 12;
+			for (u32 v : second)
+				own &= v >= 576 || v % 24 > 12;
+			CHECK(own);
+		}
+		CHECK(lods[2].indices.size() < lods[0].indices.size() / 3);
+	}
+}
+
+TEST_CASE("mesh::meshlet", "[mesh]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+	namespace mm = mesh::meshlet;
+	using math::geo::Plane;
+
+	auto grid = make_grid(40, 0.3);
+	const auto& positions = grid.positions;
+	const auto& indices = grid.indices;
+
+	auto meshlets = mm::build(indices.data(), indices.size(), positions.data(), positions.size());
+	auto culler = mm::Culler();
+	auto out = std::vector<u32>();
+
+	SECTION("splits the triangles within the limits and bounds them") {
+		REQUIRE(meshlets.size() > 1);
+		REQUIRE(meshlets.spheres.size() == meshlets.size());
+		REQUIRE(meshlets.cone_cutoffs.size() == meshlets.size());
+
+		bool within = true;
+		bool bounded = true;
+		usize triangles = 0;
+		for (usize i = 0; i < meshlets.size(); ++i) {
+			const auto& m = meshlets.meshlets[i];
+			within &= m.vertex_count <= mm::k_max_vertices && m.triangle_count <= mm::k_max_triangles;
+			triangles += m.triangle_count;
+
+			const auto& sphere = meshlets.spheres[i];
+			for (u32 k = 0; k < m.vertex_count; ++k) {
+				const auto& p = positions[meshlets.vertices[m.first_vertex + k]];
+				bounded &= meshlets.boxes[i].contains(p) && (p - sphere.center).length() <= sphere.radius + 1e-9;
+			}
+			bounded &= meshlets.cone_cutoffs[i] < 0.5;
+		}
+		CHECK(within);
+		CHECK(bounded);
+		CHECK(triangles == indices.size() / 3);
+		CHECK(meshlets.triangles.size() == indices.size());
+	}
+	SECTION("keeps everything in view and facing the eye") {
+		auto visible = culler.cull(meshlets, nullptr, 0, Vec3{ 20, 20, 100 }, out);
+		CHECK(visible == meshlets.size());
+		CHECK(out == indices);
+	}
+	SECTION("culls meshlets facing away") {
+		auto visible = culler.cull(meshlets, nullptr, 0, Vec3{ 20, 20, -100 }, out);
+		CHECK(visible == 0);
+		CHECK(out.empty());
+	}
+	SECTION("culls meshlets outside the frustum") {
+		// The meshlets are strips along the rows of the grid, about 40 long
+		auto plane = Plane{ Vec3{ 0, 1, 0 }, 30 };
+		auto visible = culler.cull(meshlets, &plane, 1, Vec3{ 20, 20, 100 }, out);
+		CHECK(visible > 0);
+		CHECK(visible < meshlets.size());
+
+		// Every triangle inside is drawn, and nothing a strip's length outside
+		usize inside = 0;
+		for (usize i = 0; i < indices.size(); i += 3)
+			inside += positions[indices[i]].y >= 30 && positions[indices[i + 1]].y >= 30 && positions[indices[i + 2]].y >= 30;
+		usize far = 0;
+		for (u32 v : out)
+			far += positions[v].y < 5;
+		CHECK(out.size() / 3 >= inside);
+		CHECK(far == 0);
+	}
+}
+
+TEST_CASE("gfx::StateCache", "[gfx]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+
+	// A mock GL that records the calls it receives
+	static auto calls = std::vector<std::string>();
+	calls.clear();
+
+	auto gl = gfx::Functions();
+	gl.bind_buffer = [](u32 target, u32 buffer) { calls.push_back(fmt::format("buffer {:#x} {}", target, buffer)); };
+	gl.bind_vertex_array = [](u32 array) { calls.push_back(fmt::format("vertex_array {}", array)); };
+	gl.bind_buffer_base = [](u32 /*target*/, u32 index, u32 buffer) {
+		calls.push_back(fmt::format("base {} {}", index, buffer));
+	};
+	gl.bind_buffer_range = [](u32 /*target*/, u32 index, u32 buffer, usize offset, usize size) {
+		calls.push_back(fmt::format("range {} {} {} {}", index, buffer, offset, size));
+	};
+	gl.use_program = [](u32 program) { calls.push_back(fmt::format("program {}", program)); };
+	gl.uniform_1f = [](i32 location, f32 v0) { calls.push_back(fmt::format("uniform {} {}", location, v0)); };
+	gl.uniform_matrix_2fv = [](i32 location, i32 count, bool transpose, const f32* values) {
+		calls.push_back(fmt::format("matrix {} {} {} {}", location, count, transpose, values[0]));
+	};
+
+	constexpr u32 array_buffer = 0x8892;
+	auto state = gfx::StateCache(gl);
+
+	SECTION("skips redundant binds and counts them") {
+		for (usize frame = 0; frame < 3; ++frame) {
+			state.use_program(1);
+			state.bind_vertex_array(2);
+			state.bind_buffer(gfx::k_element_array_buffer, 3);
+			state.bind_buffer(array_buffer, 4);
+		}
+
+		CHECK(calls == std::vector<std::string>{ "program 1", "vertex_array 2", "buffer 0x8893 3", "buffer 0x8892 4" });
+		CHECK(state.stats().programs.issued == 1);
+		CHECK(state.stats().programs.skipped == 2);
+		CHECK(state.stats().total().issued == 4);
+		CHECK(state.stats().total().skipped == 8);
+
+		state.reset_stats();
+		CHECK(state.stats().total().issued == 0);
+		CHECK(state.stats().total().skipped == 0);
+	}
+	SECTION("tracks the element array binding per vertex array") {
+		state.bind_vertex_array(1);
+		state.bind_buffer(gfx::k_element_array_buffer, 10);
+		state.bind_vertex_array(2);
+		state.bind_buffer(gfx::k_element_array_buffer, 20);
+		state.bind_buffer(array_buffer, 30);
+
+		calls.clear();
+		state.bind_vertex_array(1);
+		state.bind_buffer(gfx::k_element_array_buffer, 10);
+		state.bind_buffer(array_buffer, 30);
+
+		CHECK(calls == std::vector<std::string>{ "vertex_array 1" });
+	}
+	SECTION("tracks indexed bindings, which also bind the generic target") {
+		state.bind_buffer_base(gfx::k_uniform_buffer, 0, 5);
+		state.bind_buffer_range(gfx::k_uniform_buffer, 1, 6, 0, 16);
+		state.bind_buffer_range(gfx::k_uniform_buffer, 1, 6, 0, 16);
+		state.bind_buffer_range(gfx::k_uniform_buffer, 1, 6, 256, 16);
+		state.bind_buffer_base(gfx::k_uniform_buffer, 0, 5);
+		state.bind_buffer(gfx::k_uniform_buffer, 6);
+
+		CHECK(calls == std::vector<std::string>{ "base 0 5", "range 1 6 0 16", "range 1 6 256 16" });
+
+		state.forget_buffer(6);
+		state.bind_buffer_range(gfx::k_uniform_buffer, 1, 6, 256, 16);
+		CHECK(calls.back() == "range 1 6 256 16");
+		CHECK(calls.size() == 4);
+	}
+	SECTION("skips uniforms that already have the value, per program") {
+		f32 matrix[] { 1, 2, 3, 4 };
+
+		state.use_program(1);
+		state.uniform_1f(0, 0.5f);
+		state.uniform_1f(0, 0.5f);
+		state.uniform_matrix_2fv(1, 1, false, matrix);
+		state.uniform_matrix_2fv(1, 1, false, matrix);
+		state.uniform_matrix_2fv(1, 1, true, matrix);
+
+		state.use_program(2);
+		state.uniform_1f(0, 0.5f);
+		state.use_program(1);
+		state.uniform_1f(0, 0.5f);
+		state.uniform_1f(-1, 0.5f);
+
+		CHECK(calls == std::vector<std::string>{
+			"program 1", "uniform 0 0.5", "matrix 1 1 false 1", "matrix 1 1 true 1",
+			"program 2", "uniform 0 0.5", "program 1", "uniform -1 0.5" });
+		CHECK(state.stats().uniforms.issued == 5);
+		CHECK(state.stats().uniforms.skipped == 3);
+	}
+	SECTION("forgets deleted objects and relinked programs") {
+		state.use_program(1);
+		state.uniform_1f(0, 1.f);
+		state.bind_vertex_array(2);
+		state.bind_buffer(array_buffer, 3);
+
+		state.forget_program(1);
+		state.forget_vertex_array(2);
+		state.forget_buffer(3);
+		calls.clear();
+
+		state.use_program(1);
+		state.uniform_1f(0, 1.f);
+		state.bind_vertex_array(0);
+		state.bind_buffer(array_buffer, 0);
+		state.bind_vertex_array(2);
+		state.bind_buffer(array_buffer, 3);
+
+		CHECK(calls == std::vector<std::string>{ "program 1", "uniform 0 1", "vertex_array 2", "buffer 0x8892 3" });
+	}
+	SECTION("issues everything again after being invalidated") {
+		state.use_program(1);
+		state.bind_buffer(array_buffer, 3);
+		state.invalidate();
+		state.use_program(1);
+		state.bind_buffer(array_buffer, 3);
+
+		CHECK(calls.size() == 4);
+	}
+}
+
+TEST_CASE("gfx::DrawQueue", "[gfx]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+
+	static auto calls = std::vector<std::string>();
+	calls.clear();
+
+	auto gl = gfx::Functions();
+	gl.bind_buffer = [](u32 /*target*/, u32 buffer) { calls.push_back(fmt::format("ib {}", buffer)); };
+	gl.bind_vertex_array = [](u32 array) { calls.push_back(fmt::format("vao {}", array)); };
+	gl.use_program = [](u32 program) { calls.push_back(fmt::format("program {}", program)); };
+	gl.uniform_1f = [](i32 location, f32 v0) { calls.push_back(fmt::format("uniform {} {}", location, v0)); };
+	gl.draw_elements = [](u32 /*mode*/, i32 count, u32 /*type*/, const void* /*indices*/) {
+		calls.push_back(fmt::format("draw {}", count));
+	};
+
+	auto state = gfx::StateCache(gl);
+	auto queue = gfx::DrawQueue(256);
+
+	auto draw = [](u32 program, u32 vertex_array, i32 count, u8 layer, f32 depth) {
+		auto result = gfx::DrawItem();
+		result.program = program;
+		result.vertex_array = vertex_array;
+		result.count = count;
+		result.layer = layer;
+		result.depth = depth;
+		result.back_to_front = layer == 1;
+		return result;
+	};
+	auto record = [&] {
+		f32 one = 1;
+		f32 two = 2;
+
+		queue.push(draw(2, 1, 1, 0, 0.5f));
+		queue.uniform(0, gfx::UniformType::F1, &one);
+		queue.push(draw(1, 2, 2, 0, 0.9f));
+		queue.push(draw(1, 1, 3, 1, 0.2f));
+		queue.push(draw(2, 1, 4, 1, 0.8f));
+		queue.push(draw(1, 2, 5, 0, 0.1f));
+		queue.push(draw(2, 1, 6, 0, 0.5f));
+		queue.uniform(0, gfx::UniformType::F1, &two);
+	};
+
+	SECTION("replays in recording order until sorted") {
+		record();
+		queue.submit(state);
+
+		CHECK(state.stats().draws == 6);
+		CHECK(calls.back() == "draw 6");
+		CHECK(state.stats().programs.issued == 5);
+	}
+	SECTION("sorts by layer and state, then depth, keeping ties in order") {
+		record();
+		queue.sort();
+		queue.submit(state);
+
+		CHECK(calls == std::vector<std::string>{
+			// Opaque: by program, then near to far
+			"program 1", "vao 2", "draw 5", "draw 2",
+			"program 2", "vao 1", "uniform 0 1", "draw 1", "uniform 0 2", "draw 6",
+			// Translucent: far to near
+			"draw 4", "program 1", "draw 3",
+		});
+		CHECK(state.stats().programs.issued == 3);
+		CHECK(state.stats().vertex_arrays.issued == 2);
+	}
+	SECTION("keys sort by layer before anything else") {
+		CHECK(gfx::DrawQueue::sort_key(draw(0, 0, 0, 1, 0), 0) > gfx::DrawQueue::sort_key(draw(0xfff, 0xfff, 0, 0, 1), 5));
+		CHECK(gfx::DrawQueue::sort_key(draw(1, 0, 0, 0, 0), 0) > gfx::DrawQueue::sort_key(draw(0, 0xfff, 0, 0, 1), 5));
+	}
+	SECTION("the arena reuses its memory after a reset") {
+		auto arena = gfx::Arena(64);
+		for (usize frame = 0; frame < 3; ++frame) {
+			arena.reset();
+			for (usize i = 0; i < 100; ++i) {
+				auto* value = arena.make<u64>(i);
+				CHECK(reinterpret_cast<uintptr_t>(value) % alignof(u64) == 0);
+			}
+			*arena.make_array<u8>(100) = 0;
+		}
+
+		CHECK(arena.used() >= 900);
+		CHECK(arena.capacity() < 1200);
+	}
+}
+
+TEST_CASE("gfx::InstanceBatcher", "[gfx]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+
+	static auto calls = std::vector<std::string>();
+	calls.clear();
+
+	auto gl = gfx::Functions();
+	gl.use_program = [](u32 /*program*/) {};
+	gl.bind_vertex_array = [](u32 /*array*/) {};
+	gl.draw_elements = [](u32 /*mode*/, i32 count, u32 /*type*/, const void* /*indices*/) {
+		calls.push_back(fmt::format("draw {}", count));
+	};
+	gl.draw_elements_instanced = [](u32 /*mode*/, i32 count, u32 /*type*/, const void* /*indices*/,
+		i32 instance_count, u32 base_instance)
+	{
+		calls.push_back(fmt::format("draw {} x{} from {}", count, instance_count, base_instance));
+	};
+
+	auto mesh = [](i32 count) {
+		auto result = gfx::DrawItem();
+		result.program = 1;
+		result.vertex_array = 1;
+		result.count = count;
+		return result;
+	};
+
+	auto state = gfx::StateCache(gl);
+	auto queue = gfx::DrawQueue();
+	auto batcher = gfx::InstanceBatcher(2);
+
+	SECTION("groups identical meshes into one draw each") {
+		for (usize i = 0; i < 1000; ++i) {
+			f32 instance[] { f32(i), f32(i % 2) };
+			batcher.add(mesh(3 + 3 * static_cast<i32>(i % 2)), instance);
+		}
+		batcher.build(queue, 10);
+		queue.sort();
+		queue.submit(state);
+
+		CHECK(batcher.batch_count() == 2);
+		CHECK(batcher.instance_count() == 1000);
+		CHECK(calls == std::vector<std::string>{ "draw 3 x500 from 10", "draw 6 x500 from 510" });
+		CHECK(state.stats().draws == 2);
+		CHECK(state.stats().instances == 1000);
+
+		// Each group's instances are contiguous, in the order they were added
+		const auto& data = batcher.instance_data();
+		REQUIRE(data.size() == 2000);
+		CHECK(data[0] == 0);
+		CHECK(data[2] == 2);
+		CHECK(data[1000] == 1);
+		CHECK(data[1001] == 1);
+		CHECK(data[1998] == 999);
+	}
+	SECTION("keeps draws with different state apart") {
+		f32 instance[] { 0, 0 };
+		auto other = mesh(3);
+		other.offset = 12;
+
+		batcher.add(mesh(3), instance);
+		batcher.add(other, instance);
+		batcher.add(mesh(3), instance);
+		batcher.build(queue);
+
+		CHECK(batcher.batch_count() == 2);
+		CHECK(queue.size() == 2);
+
+		batcher.clear();
+		CHECK(batcher.instance_count() == 0);
+		CHECK(batcher.batch_count() == 0);
+	}
+	SECTION("draws blended instances one by one, far to near") {
+		auto blended = [&](f32 depth) {
+			auto result = mesh(3);
+			result.back_to_front = true;
+			result.depth = depth;
+			return result;
+		};
+
+		f32 instance[] { 0, 0 };
+		batcher.add(blended(0.2f), instance);
+		batcher.add(mesh(6), instance);
+		batcher.add(blended(0.8f), instance);
+		batcher.add(mesh(6), instance);
+		batcher.add(blended(0.5f), instance);
+		batcher.build(queue);
+		queue.sort();
+		queue.submit(state);
+
+		CHECK(batcher.batch_count() == 4);
+		CHECK(batcher.instance_count() == 5);
+		CHECK(calls == std::vector<std::string>{
+			"draw 6 x2 from 1", "draw 3 x1 from 3", "draw 3 x1 from 4", "draw 3" });
+	}
+	SECTION("single draws aren't instanced") {
+		queue.push(mesh(9));
+		queue.submit(state);
+
+		CHECK(calls == std::vector<std::string>{ "draw 9" });
+	}
+}
+
+TEST_CASE("gfx::BlockLayout", "[gfx]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+	using math::Vec2;
+
+	SECTION("lays out std140 blocks") {
+		using Block = gfx::Std140<f32, Vec3, Mat3x3, Vec2, std::array<f32,3>, Mat4x4>;
+
+		// Matrix columns and array elements are padded to a vec4
+		CHECK(Block::offsets == std::array<usize,6>{ 0, 16, 32, 80, 96, 144 });
+		STATIC_REQUIRE(Block::size == 208);
+		STATIC_REQUIRE(Block::alignment == 16);
+
+		// A scalar fills the end of a vec3, but not of an array
+		STATIC_REQUIRE(gfx::Std140<Vec3, f32>::offsets[1] == 12);
+		STATIC_REQUIRE(gfx::Std140<Vec3, f32>::size == 16);
+		STATIC_REQUIRE(gfx::Std140<std::array<f32,2>, f32>::offsets[1] == 32);
+		STATIC_REQUIRE(gfx::Std140<Mat2x2>::size == 32);
+		STATIC_REQUIRE(gfx::Std140<f32>::size == 16);
+	}
+	SECTION("lays out std430 blocks") {
+		using Block = gfx::Std430<f32, Vec3, Mat3x3, Vec2, std::array<f32,3>, Mat4x4>;
+
+		CHECK(Block::offsets == std::array<usize,6>{ 0, 16, 32, 80, 88, 112 });
+		STATIC_REQUIRE(Block::size == 176);
+		STATIC_REQUIRE(gfx::Std430<Mat2x2>::size == 16);
+		STATIC_REQUIRE(gfx::Std430<std::array<Vec3,2>>::size == 32);
+		STATIC_REQUIRE(gfx::Std430<f32>::size == 4);
+	}
+	SECTION("writes f32 components, with a matrix row per column") {
+		using Block = gfx::Std140<f32, Mat3x3, std::array<f32,2>, i32>;
+
+		auto matrix = Mat3x3{
+			{ 1, 2, 3 },
+			{ 4, 5, 6 },
+			{ 7, 8, 9 },
+		};
+		auto bytes = Block::pack(0.5, matrix, { 10, 11 }, -1);
+		auto read = [&](usize offset) {
+			f32 result;
+			std::memcpy(&result, &bytes[offset], sizeof(result));
+			return result;
+		};
+
+		CHECK(bytes.size() == 112);
+		CHECK(read(0) == 0.5f);
+		CHECK(read(16) == 1);
+		CHECK(read(24) == 3);
+		CHECK(read(28) == 0);
+		CHECK(read(32) == 4);
+		CHECK(read(56) == 9);
+		CHECK(read(64) == 10);
+		CHECK(read(80) == 11);
+
+		i32 last;
+		std::memcpy(&last, &bytes[Block::offsets[3]], sizeof(last));
+		CHECK(last == -1);
+
+		Block::write_member<0>(bytes.data(), 2);
+		CHECK(read(0) == 2);
+	}
+}
+
+TEST_CASE("gfx::ProgramReflection", "[gfx]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+	using namespace gfx::literals; // NOLINT(*-using-namespace)
+
+	// A mock program's active variables, as GL reports them
+	struct Active {
+		std::string name;
+		i32 size;
+		i32 location;
+	};
+	static auto uniforms = std::vector<Active>();
+	static auto attributes = std::vector<Active>();
+	uniforms = {
+		{ "u_color", 1, 3 },
+		{ "u_lights[0]", 4, 5 },
+		{ "Frame.u_view", 1, -1 },
+	};
+	attributes = {
+		{ "position", 1, 0 },
+		{ "gl_VertexID", 1, -1 },
+		{ "a_transform", 1, 4 },
+	};
+
+	auto gl = gfx::Functions();
+	gl.get_program_iv = [](u32 /*program*/, u32 pname) -> i32 {
+		switch (pname) {
+			case gfx::k_active_uniforms: return static_cast<i32>(uniforms.size());
+			case gfx::k_active_attributes: return static_cast<i32>(attributes.size());
+			default: return 32;
+		}
+	};
+	gl.get_active_uniform = [](u32 /*program*/, u32 index, i32 /*buffer_size*/,
+		i32* length, i32* size, u32* type, char* name)
+	{
+		const auto& active = uniforms[index];
+		*length = static_cast<i32>(active.name.size());
+		*size = active.size;
+		*type = 0x8b52;
+		std::memcpy(name, active.name.c_str(), active.name.size() + 1);
+	};
+	gl.get_active_attrib = [](u32 /*program*/, u32 index, i32 /*buffer_size*/,
+		i32* length, i32* size, u32* type, char* name)
+	{
+		const auto& active = attributes[index];
+		*length = static_cast<i32>(active.name.size());
+		*size = active.size;
+		*type = 0x8b52;
+		std::memcpy(name, active.name.c_str(), active.name.size() + 1);
+	};
+	gl.get_uniform_location = [](u32 /*program*/, const char* name) -> i32 {
+		for (const auto& active : uniforms)
+			if (active.name == name)
+				return active.location;
+		return -1;
+	};
+	gl.get_attrib_location = [](u32 /*program*/, const char* name) -> i32 {
+		for (const auto& active : attributes)
+			if (active.name == name)
+				return active.location;
+		return -1;
+	};
+
+	SECTION("hashes names at compile time") {
+		STATIC_REQUIRE("u_color"_id == gfx::NameId("u_color"));
+		STATIC_REQUIRE("u_color"_id != "u_colour"_id);
+		STATIC_REQUIRE(gfx::hash_name("") == 0x811c9dc5);
+		STATIC_REQUIRE(gfx::hash_name("a") == 0xe40c292c);
+	}
+	SECTION("resolves locations by hashed name") {
+		auto reflection = gfx::reflect(gl, 1);
+
+		CHECK(reflection.uniform_location("u_color"_id) == 3);
+		CHECK(reflection.uniform_location("u_lights"_id) == 5);
+		CHECK(reflection.find_uniform("u_lights"_id)->count == 4);
+		CHECK(reflection.attribute_location("a_transform"_id) == 4);
+		CHECK(reflection.attribute_location("position"_id) == 0);
+
+		// Block members and built-ins have no location
+		CHECK(reflection.uniforms().size() == 2);
+		CHECK(reflection.attributes().size() == 2);
+		CHECK(reflection.uniform_location("Frame.u_view"_id) == -1);
+		CHECK(reflection.uniform_location("u_missing"_id) == -1);
+		CHECK(reflection.attribute_location("u_color"_id) == -1);
+	}
+	SECTION("finds every variable of a large program") {
+		auto variables = std::vector<gfx::ShaderVariable>();
+		for (i32 i = 0; i < 100; ++i)
+			variables.push_back({ fmt::format("u_value{}", i), i, 0, 1 });
+
+		auto reflection = gfx::ProgramReflection(variables, {});
+		usize found = 0;
+		for (i32 i = 0; i < 100; ++i)
+			found += reflection.uniform_location(gfx::NameId(fmt::format("u_value{}", i))) == i;
+
+		CHECK(found == 100);
+		CHECK(gfx::ProgramReflection().uniform_location("u_value0"_id) == -1);
+	}
+	SECTION("rejects names with colliding hashes") {
+		auto variables = std::vector<gfx::ShaderVariable>{ { "u_a", 0, 0, 1 }, { "u_a", 1, 0, 1 } };
+		CHECK_THROWS_AS(gfx::ProgramReflection(variables, {}), std::logic_error);
+	}
+}
+
+namespace {
+
+/**
+ * A mock driver that compiles in the background until `done` is set. Sources
+ * containing "error" don't compile, and the only binary it accepts is { 42 }.
+ */
+struct MockCompiler {
+	struct Object {
+		std::string source;
+		std::vector<sized::u32> shaders;
+		bool linked = false;
+	};
+
+	static inline auto objects = std::map<sized::u32, Object>();
+	static inline auto deleted = std::vector<sized::u32>();
+	static inline auto compiles = 0;
+	static inline auto links = 0;
+	static inline auto done = false;
+
+	static auto functions() -> gfx::Functions;
+};
+
+auto MockCompiler::functions() -> gfx::Functions
+{
+	using namespace sized; // NOLINT(*-using-namespace)
+
+	objects.clear();
+	deleted.clear();
+	compiles = 0;
+	links = 0;
+	done = false;
+
+	static auto create = []() -> u32 {
+		auto name = static_cast<u32>(objects.size() + deleted.size() + 1);
+		objects[name] = {};
+		return name;
+	};
+	static auto destroy = [](u32 name) {
+		objects.erase(name);
+		deleted.push_back(name);
+	};
+	static auto compiled = [](u32 shader) {
+		return objects[shader].source.find("error") == std::string::npos;
+	};
+
+	auto gl = gfx::Functions();
+	gl.create_shader = [](u32 /*type*/) -> u32 { return create(); };
+	gl.shader_source = [](u32 shader, i32 count, const char* const* strings, const i32* lengths) {
+		for (i32 i = 0; i < count; ++i)
+			objects[shader].source.append(strings[i], static_cast<usize>(lengths[i]));
+	};
+	gl.compile_shader = [](u32 /*shader*/) { ++compiles; };
+	gl.get_shader_iv = [](u32 shader, u32 pname) -> i32 {
+		if (pname == gfx::k_compile_status)
+			return compiled(shader);
+		return 16;
+	};
+	gl.get_shader_info_log = [](u32 /*shader*/, i32 /*buffer_size*/, i32* length, char* log) {
+		std::memcpy(log, "0(1) : error\n", 13);
+		*length = 13;
+	};
+	gl.delete_shader = [](u32 shader) { destroy(shader); };
+	gl.create_program = []() -> u32 { return create(); };
+	gl.attach_shader = [](u32 program, u32 shader) { objects[program].shaders.push_back(shader); };
+	gl.link_program = [](u32 program) {
+		++links;
+		auto& object = objects[program];
+		object.linked = std::all_of(object.shaders.begin(), object.shaders.end(), compiled);
+	};
+	gl.get_program_iv = [](u32 program, u32 pname) -> i32 {
+		switch (pname) {
+			case gfx::k_completion_status: return done;
+			case gfx::k_link_status: return objects[program].linked;
+			case gfx::k_program_binary_length: return 1;
+			default: return 0;
+		}
+	};
+	gl.get_program_info_log = [](u32 /*program*/, i32 /*buffer_size*/, i32* length, char* /*log*/) { *length = 0; };
+	gl.delete_program = [](u32 program) { destroy(program); };
+	gl.program_parameter_i = [](u32 /*program*/, u32 /*pname*/, i32 /*value*/) {};
+	gl.program_binary = [](u32 program, u32 /*format*/, const void* binary, i32 length) {
+		objects[program].linked = length == 1 && *static_cast<const u8*>(binary) == 42;
+	};
+	gl.get_program_binary = [](u32 /*program*/, i32 /*buffer_size*/, i32* length, u32* format, void* binary) {
+		*static_cast<u8*>(binary) = 42;
+		*length = 1;
+		*format = 7;
+	};
+
+	return gl;
+}
+
+} // namespace
+
+TEST_CASE("gfx::ProgramBuilder", "[gfx]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+	namespace fs = std::filesystem;
+	using gfx::BuildStatus;
+
+	auto gl = MockCompiler::functions();
+	auto& objects = MockCompiler::objects;
+	auto& links = MockCompiler::links;
+	auto& done = MockCompiler::done;
+
+	auto state = gfx::StateCache(gl);
+	auto read = [](const fs::path& path) -> std::optional<std::string> {
+		if (path.filename() == "broken.shader")
+			return "#shader vertex\nvoid main() {}\n#shader fragment\nerror\n";
+		return "#shader vertex\nvoid main() {}\n#shader fragment\nvoid main() {}\n";
+	};
+	auto source = gfx::ShaderSource("lit.shader", read);
+
+	SECTION("polls without waiting in parallel") {
+		auto builder = gfx::ProgramBuilder(state, true);
+		auto pending = builder.submit(source);
+		CHECK(pending.status() == BuildStatus::Pending);
+		CHECK(pending.get_or(99) == 99);
+		CHECK(links == 1);
+
+		CHECK(builder.poll() == 0);
+		CHECK(pending.program() == 0);
+
+		done = true;
+		CHECK(builder.poll() == 1);
+		CHECK(builder.pending() == 0);
+		REQUIRE(pending.ready());
+		CHECK(pending.get_or(99) == pending.program());
+
+		// Only the program is left
+		CHECK(objects.size() == 1);
+		CHECK(objects.count(pending.program()) == 1);
+	}
+	SECTION("finishes one build per poll without parallel compilation") {
+		auto builder = gfx::ProgramBuilder(state, false);
+		auto first = builder.submit(source);
+		auto second = builder.submit(source);
+
+		CHECK(builder.poll() == 1);
+		CHECK(first.ready());
+		CHECK_FALSE(second.ready());
+		CHECK(builder.poll() == 1);
+		CHECK(second.ready());
+		CHECK(builder.poll() == 0);
+	}
+	SECTION("reports failures with their logs") {
+		auto broken = gfx::ShaderSource("broken.shader", read);
+		auto builder = gfx::ProgramBuilder(state, true);
+		auto pending = builder.submit(broken);
+
+		builder.finish();
+		CHECK(pending.failed());
+		CHECK(pending.program() == 0);
+		CHECK(pending.get_or(99) == 99);
+		CHECK(pending.log() == "0(1) : error\n");
+		CHECK(objects.empty());
+	}
+	SECTION("deletes abandoned programs") {
+		auto builder = gfx::ProgramBuilder(state, true);
+		builder.submit(source);
+		builder.submit(source);
+		CHECK(builder.pending() == 2);
+
+		done = true;
+		CHECK(builder.poll() == 2);
+		CHECK(objects.empty());
+	}
+	SECTION("rebuilds only the stages that changed") {
+		auto changed = gfx::ShaderSource("broken.shader", read);
+		auto builder = gfx::ProgramBuilder(state, false);
+		auto first = builder.submit(source, true);
+		builder.finish();
+		CHECK(MockCompiler::compiles == 2);
+
+		auto same = builder.rebuild(source, first);
+		builder.finish();
+		CHECK(same.ready());
+		CHECK(MockCompiler::compiles == 2);
+		CHECK(links == 2);
+
+		// Only the fragment stage differs, and fails
+		auto broken = builder.rebuild(changed, same);
+		builder.finish();
+		CHECK(broken.failed());
+		CHECK(MockCompiler::compiles == 3);
+
+		// The stages live until the last program using them is dropped
+		usize live = objects.size();
+		first = {};
+		CHECK(objects.size() == live);
+		same = {};
+		CHECK(objects.size() == live - 2);
+	}
+	SECTION("loads and stores binaries in the cache") {
+		auto directory = fs::temp_directory_path() / "gfx_program_builder_test";
+		fs::remove_all(directory);
+		auto cache = gfx::ProgramCache(directory, "driver");
+		done = true;
+
+		{
+			auto builder = gfx::ProgramBuilder(state, true, &cache);
+			auto built = builder.submit(source);
+			builder.finish();
+			CHECK(built.ready());
+			CHECK(cache.stats().stores == 1);
+		}
+		{
+			auto builder = gfx::ProgramBuilder(state, true, &cache);
+			auto loaded = builder.submit(source);
+			CHECK(links == 1);
+			CHECK(builder.poll() == 1);
+			CHECK(loaded.ready());
+			CHECK(cache.stats().hits == 1);
+		}
+
+		// A binary the driver rejects is replaced
+		u64 key = gfx::ProgramCache::key({
+			{ static_cast<u32>(source.stages()[0].type), source.stages()[0].text() },
+			{ static_cast<u32>(source.stages()[1].type), source.stages()[1].text() },
+		});
+		cache.store(key, { 7, { 13 } });
+		{
+			auto builder = gfx::ProgramBuilder(state, true, &cache);
+			auto rebuilt = builder.submit(source);
+			CHECK(builder.poll() == 0);
+			CHECK(links == 2);
+			CHECK(builder.poll() == 1);
+			CHECK(rebuilt.ready());
+			CHECK(cache.load(key)->data == std::vector<u8>{ 42 });
+		}
+
+		// Without parallel compilation, recompiling a rejected binary is the
+		// one wait of its poll
+		cache.store(key, { 7, { 13 } });
+		{
+			auto broken = gfx::ShaderSource("broken.shader", read);
+			auto builder = gfx::ProgramBuilder(state, false, &cache);
+			auto rebuilt = builder.submit(source);
+			auto failed = builder.submit(broken);
+			CHECK(builder.poll() == 0);
+			CHECK_FALSE(failed.failed());
+			CHECK(builder.poll() == 1);
+			CHECK(rebuilt.ready());
+			CHECK(builder.poll() == 1);
+			CHECK(failed.failed());
+		}
+
+		fs::remove_all(directory);
+	}
+}
+
+TEST_CASE("gfx::FileWatcher", "[gfx]") {
+	namespace fs = std::filesystem;
+
+	auto directory = fs::temp_directory_path() / "gfx_file_watcher_test";
+	fs::remove_all(directory);
+	fs::create_directories(directory / "lib");
+
+	auto watcher = gfx::FileWatcher();
+	if (!watcher.supported()) {
+		WARN("File watching isn't supported here");
+		return;
+	}
+
+	REQUIRE(watcher.watch(directory));
+	CHECK(watcher.poll().empty());
+
+	std::ofstream(directory / "a.glsl") << "a";
+	std::ofstream(directory / "lib" / "b.glsl") << "b";
+	std::ofstream(directory / "a.glsl") << "a";
+
+	auto changed = watcher.poll();
+	std::sort(changed.begin(), changed.end());
+	CHECK(changed == std::vector<fs::path>{ directory / "a.glsl", directory / "lib" / "b.glsl" });
+	CHECK(watcher.poll().empty());
+
+	// Saved by moving over the original, and in a new directory
+	auto temp = fs::temp_directory_path() / "gfx_file_watcher_test.tmp";
+	std::ofstream(temp) << "a";
+	fs::rename(temp, directory / "a.glsl");
+	CHECK(watcher.poll() == std::vector<fs::path>{ directory / "a.glsl" });
+
+	fs::create_directory(directory / "new");
+	CHECK(watcher.poll().empty());
+	std::ofstream(directory / "new" / "c.glsl") << "c";
+	CHECK(watcher.poll() == std::vector<fs::path>{ directory / "new" / "c.glsl" });
+
+	// Written before the new directory's first poll
+	fs::create_directories(directory / "newer" / "deeper");
+	std::ofstream(directory / "newer" / "deeper" / "d.glsl") << "d";
+	CHECK(watcher.poll() == std::vector<fs::path>{ directory / "newer" / "deeper" / "d.glsl" });
+	CHECK(watcher.poll().empty());
+
+	fs::remove_all(directory);
+}
+
+TEST_CASE("gfx::ShaderReloader", "[gfx]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+	namespace fs = std::filesystem;
+
+	auto gl = MockCompiler::functions();
+	auto state = gfx::StateCache(gl);
+	auto builder = gfx::ProgramBuilder(state, true);
+	MockCompiler::done = true;
+
+	static auto files = std::map<std::string, std::string>();
+	static auto reads = 0;
+	files = {
+		{ "a.shader", "#shader vertex\n#include \"common.glsl\"\n#shader fragment\nvoid main() {}\n" },
+		{ "b.shader", "#shader vertex\nvoid main() {}\n#shader fragment\nvoid main() {}\n" },
+		{ "common.glsl", "void main() {}\n" },
+	};
+	reads = 0;
+	auto read = [](const fs::path& path) -> std::optional<std::string> {
+		++reads;
+		auto it = files.find(path.generic_string());
+		if (it == files.end())
+			return std::nullopt;
+		return it->second;
+	};
+
+	auto shaders = gfx::ShaderReloader(builder, read);
+	auto a = shaders.add("a.shader");
+	auto b = shaders.add("b.shader");
+	CHECK(shaders.program(a, 99) == 99);
+	CHECK(reads == 3);
+
+	REQUIRE(shaders.update().size() == 2);
+	u32 a_program = shaders.program(a);
+	u32 b_program = shaders.program(b);
+	CHECK(a_program != 0);
+	CHECK(shaders.update().empty());
+
+	SECTION("rebuilds the programs that use a changed file") {
+		files["common.glsl"] = "void main() { }\n";
+		shaders.changed("common.glsl");
+		CHECK(MockCompiler::compiles == 4);
+
+		const auto& updates = shaders.update();
+		REQUIRE(updates.size() == 1);
+		CHECK(updates[0].handle == a);
+		CHECK(updates[0].replaced == a_program);
+		CHECK(updates[0].program == shaders.program(a));
+		CHECK(shaders.program(b) == b_program);
+
+		// Only the changed file was read, and the changed stage compiled
+		CHECK(reads == 4);
+		CHECK(MockCompiler::compiles == 5);
+	}
+	SECTION("keeps the previous program when a change fails") {
+		files["b.shader"] = "#shader vertex\nvoid main() {}\n#shader fragment\nerror\n";
+		shaders.changed("b.shader");
+
+		const auto& updates = shaders.update();
+		REQUIRE(updates.size() == 1);
+		CHECK(updates[0].program == 0);
+		CHECK(updates[0].log == "b.shader(1) : error\n");
+		CHECK(shaders.program(b) == b_program);
+	}
+	SECTION("recovers from files that can't be parsed") {
+		files["b.shader"] = "#shader vertex\n#include \"new.glsl\"\n";
+		shaders.changed("b.shader");
+		REQUIRE(shaders.update().size() == 1);
+		CHECK(shaders.program(b) == b_program);
+
+		files["new.glsl"] = "void main() {}\n";
+		shaders.changed("new.glsl");
+		const auto& updates = shaders.update();
+		REQUIRE(updates.size() == 1);
+		CHECK(updates[0].replaced == b_program);
+	}
+	SECTION("ignores unrelated files") {
+		shaders.changed("other.glsl");
+		CHECK(shaders.update().empty());
+		CHECK(shaders.building() == 0);
+	}
+}
+
+TEST_CASE("gfx::ProgramCache", "[gfx]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+	namespace fs = std::filesystem;
+
+	auto directory = fs::temp_directory_path() / "gfx_program_cache_test";
+	fs::remove_all(directory);
+
+	auto binary = gfx::ProgramBinary{ 0x8e21, { 1, 2, 3, 4, 5 } };
+	u64 key = gfx::ProgramCache::key({ { 0x8b31, "void main() {}" }, { 0x8b30, "out vec4 c;" } });
+
+	SECTION("keys depend on every stage, but not their order") {
+		CHECK(key == gfx::ProgramCache::key({ { 0x8b30, "out vec4 c;" }, { 0x8b31, "void main() {}" } }));
+		CHECK(key != gfx::ProgramCache::key({ { 0x8b31, "void main() {}" }, { 0x8b30, "out vec4 d;" } }));
+		CHECK(key != gfx::ProgramCache::key({ { 0x8b30, "void main() {}" }, { 0x8b31, "out vec4 c;" } }));
+		CHECK(gfx::ProgramCache::key({ { 0x8b31, "ab" }, { 0x8b31, "c" } })
+			!= gfx::ProgramCache::key({ { 0x8b31, "a" }, { 0x8b31, "bc" } }));
+	}
+	SECTION("stores and reloads binaries") {
+		auto cache = gfx::ProgramCache(directory, "Vendor\nRenderer\n4.6");
+		CHECK_FALSE(cache.load(key).has_value());
+		CHECK(cache.store(key, binary));
+
+		auto reopened = gfx::ProgramCache(directory, "Vendor\nRenderer\n4.6");
+		auto loaded = reopened.load(key);
+		REQUIRE(loaded.has_value());
+		CHECK(loaded->format == binary.format);
+		CHECK(loaded->data == binary.data);
+		CHECK(reopened.stats().hits == 1);
+		CHECK(cache.stats().misses == 1);
+		CHECK(cache.stats().stores == 1);
+	}
+	SECTION("drops other drivers' entries when opened") {
+		auto cache = gfx::ProgramCache(directory, "Vendor\nRenderer\n4.6");
+		cache.store(key, binary);
+		auto old_path = cache.path(key);
+
+		auto updated = gfx::ProgramCache(directory, "Vendor\nRenderer\n4.6.1");
+		CHECK_FALSE(fs::exists(old_path));
+		CHECK_FALSE(updated.load(key).has_value());
+	}
+	SECTION("removes damaged and rejected entries") {
+		auto cache = gfx::ProgramCache(directory, "driver");
+		cache.store(key, binary);
+
+		// Flip a byte of the binary
+		{
+			auto file = std::fstream(cache.path(key), std::ios::in | std::ios::out | std::ios::binary);
+			file.seekp(-1, std::ios::end);
+			file.put('\x7f');
+		}
+		CHECK_FALSE(cache.load(key).has_value());
+		CHECK_FALSE(fs::exists(cache.path(key)));
+
+		// Truncated
+		cache.store(key, binary);
+		fs::resize_file(cache.path(key), 20);
+		CHECK_FALSE(cache.load(key).has_value());
+
+		// A size far beyond the file, which mustn't be allocated
+		cache.store(key, binary);
+		{
+			auto file = std::fstream(cache.path(key), std::ios::in | std::ios::out | std::ios::binary);
+			file.seekp(32);
+			u64 size = ~u64(0) >> 1;
+			file.write(reinterpret_cast<const char*>(&size), sizeof(size)); // NOLINT
+		}
+		CHECK_FALSE(cache.load(key).has_value());
+		CHECK_FALSE(fs::exists(cache.path(key)));
+
+		cache.store(key, binary);
+		cache.remove(key);
+		CHECK_FALSE(cache.load(key).has_value());
+		CHECK(cache.stats().removed == 4);
+	}
+
+	fs::remove_all(directory);
+}
+
+TEST_CASE("gfx::ShaderSource", "[gfx]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+	namespace fs = std::filesystem;
+	using gfx::ShaderStage;
+
+	static auto files = std::map<std::string, std::string>();
+	files = {
+		{ "shaders/lit.shader",
+			"// A comment before any stage\n"
+			"#shader vertex\n"
+			"#version 330 core\n"
+			"#include \"common.glsl\"\n"
+			"void main() {}\n"
+			"\n"
+			"#shader fragment\n"
+			"#version 330 core\n"
+			"#include \"common.glsl\"\n"
+			"#include \"lib/light.glsl\"\n"
+			"void main() {}" },
+		{ "shaders/common.glsl", "uniform vec4 u_color;\n" },
+		{ "shaders/lib/light.glsl", "  #include \"../common.glsl\"\nvec3 light();\n" },
+		{ "shaders/broken.shader", "#shader vertex\n#include \"missing.glsl\"\n" },
+		{ "shaders/unknown.shader", "#shader pixel\n" },
+	};
+	auto read = [](const fs::path& path) -> std::optional<std::string> {
+		auto it = files.find(path.generic_string());
+		if (it == files.end())
+			return std::nullopt;
+		return it->second;
+	};
+
+	SECTION("splits stages and expands includes once per stage") {
+		auto source = gfx::ShaderSource("shaders/lit.shader", read);
+
+		REQUIRE(source.stages().size() == 2);
+		CHECK(source.find(ShaderStage::Vertex)->text() ==
+			"#version 330 core\n"
+			"#line 4 0\n"
+			"#line 1 1\n"
+			"uniform vec4 u_color;\n"
+			"#line 5 0\n"
+			"void main() {}\n"
+			"\n");
+		CHECK(source.find(ShaderStage::Fragment)->text() ==
+			"#version 330 core\n"
+			"#line 9 0\n"
+			"#line 1 1\n"
+			"uniform vec4 u_color;\n"
+			"#line 10 0\n"
+			"#line 1 2\n"
+			"\n"
+			"vec3 light();\n"
+			"#line 11 0\n"
+			"void main() {}\n");
+		CHECK(source.find(ShaderStage::Compute) == nullptr);
+
+		// The pieces are slices of the files, which survive a move
+		auto moved = std::move(source);
+		CHECK(moved.stages()[0].pieces.size() == 6);
+		CHECK(moved.stages()[0].pieces[0] == "#version 330 core\n");
+		CHECK(moved.files() == std::vector<fs::path>{
+			"shaders/lit.shader", "shaders/common.glsl", "shaders/lib/light.glsl" });
+	}
+	SECTION("reports errors with the file and line") {
+		CHECK_THROWS_WITH(gfx::ShaderSource("shaders/broken.shader", read),
+			"shaders/broken.shader:2: can't open include 'missing.glsl'");
+		CHECK_THROWS_WITH(gfx::ShaderSource("shaders/unknown.shader", read),
+			"shaders/unknown.shader:1: unknown shader stage 'pixel'");
+		CHECK_THROWS_AS(gfx::ShaderSource("shaders/none.shader", read), gfx::ShaderError);
+	}
+	SECTION("names files in compiler logs") {
+		auto source = gfx::ShaderSource("shaders/lit.shader", read);
+
+		CHECK(source.annotate_log("1(12) : error C0000: syntax error\n") == "common.glsl(12) : error C0000: syntax error\n");
+		CHECK(source.annotate_log("0:3(5): error: `x' undeclared") == "lit.shader:3(5): error: `x' undeclared");
+		CHECK(source.annotate_log("ERROR: 2:1: 'light' : no matching overload\nERROR: 1 compilation errors")
+			== "ERROR: light.glsl:1: 'light' : no matching overload\nERROR: 1 compilation errors");
+		CHECK(source.annotate_log("7(1) : unknown file") == "7(1) : unknown file");
+	}
+}
+
+TEST_CASE("gfx::StreamingBuffer", "[gfx]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+
+	// A mock GL whose fences signal once the "GPU" has finished their frame
+	struct MockGpu {
+		std::vector<u8> memory;
+		std::vector<std::string> calls;
+		u64 fences_created = 0;
+		u64 fences_completed = 0;
+		u64 live_fences = 0;
+		/** The number of unsuccessful waits before the GPU catches up. */
+		usize busy_waits = 0;
+	};
+	static auto gpu = MockGpu();
+	gpu = MockGpu();
+
+	auto gl = gfx::Functions();
+	gl.gen_buffer = []() -> u32 { return 7; };
+	gl.delete_buffer = [](u32 buffer) { gpu.calls.push_back(fmt::format("delete {}", buffer)); };
+	gl.bind_buffer = [](u32 /*target*/, u32 /*buffer*/) {};
+	gl.buffer_storage = [](u32 /*target*/, usize size, const void* /*data*/, u32 flags) {
+		gpu.memory.resize(size);
+		gpu.calls.push_back(fmt::format("storage {} {:#x}", size, flags));
+	};
+	gl.map_buffer_range = [](u32 /*target*/, usize offset, usize /*length*/, u32 /*access*/) -> void* {
+		return gpu.memory.data() + offset;
+	};
+	gl.unmap_buffer = [](u32 /*target*/) { gpu.calls.push_back("unmap"); return true; };
+	gl.fence_sync = []() -> void* {
+		++gpu.live_fences;
+		return reinterpret_cast<void*>(++gpu.fences_created); // NOLINT
+	};
+	gl.client_wait_sync = [](void* sync, u32 /*flags*/, u64 /*timeout*/) -> u32 {
+		auto fence = reinterpret_cast<u64>(sync); // NOLINT
+		if (fence > gpu.fences_completed) {
+			if (gpu.busy_waits == 0)
+				gpu.fences_completed = fence;
+			else
+				--gpu.busy_waits;
+
+			return gfx::k_timeout_expired;
+		}
+		return gfx::k_already_signaled;
+	};
+	gl.delete_sync = [](void* /*sync*/) { --gpu.live_fences; };
+
+	auto state = gfx::StateCache(gl);
+
+	SECTION("maps persistent, coherent storage for every frame") {
+		auto buffer = gfx::StreamingBuffer(state, 0x8892, 1024);
+
+		CHECK(buffer.id() == 7);
+		CHECK(gpu.memory.size() == 1024 * gfx::StreamingBuffer::k_frame_count);
+		CHECK(gpu.calls == std::vector<std::string>{ "storage 3072 0xc2" });
+	}
+	SECTION("cycles through the regions, writing into mapped memory") {
+		auto buffer = gfx::StreamingBuffer(state, 0x8892, 1024);
+		auto offsets = std::vector<usize>();
+
+		for (usize frame = 0; frame < 4; ++frame) {
+			buffer.begin_frame();
+			auto a = buffer.allocate(100);
+			auto b = buffer.allocate(48, 48);
+			std::memset(a.data, static_cast<int>(frame + 1), 100);
+
+			offsets.push_back(a.offset);
+			CHECK(b.offset % 48 == 0);
+			CHECK(b.offset >= a.offset + 100);
+			buffer.end_frame();
+		}
+
+		CHECK(offsets == std::vector<usize>{ 0, 1024, 2048, 0 });
+		CHECK(gpu.memory[0] == 4);
+		CHECK(gpu.memory[1024] == 2);
+	}
+	SECTION("only stalls when the GPU is still reading the region") {
+		auto buffer = gfx::StreamingBuffer(state, 0x8892, 256);
+
+		// The first cycle has nothing to wait for
+		for (usize frame = 0; frame < 3; ++frame) {
+			buffer.begin_frame();
+			buffer.end_frame();
+		}
+		CHECK(buffer.stats().stalls == 0);
+
+		// The GPU finished frame 1 already
+		gpu.fences_completed = 1;
+		buffer.begin_frame();
+		buffer.end_frame();
+		CHECK(buffer.stats().stalls == 0);
+
+		// It's still busy with frame 2, for a few more waits
+		gpu.busy_waits = 3;
+		buffer.begin_frame();
+		buffer.end_frame();
+		CHECK(buffer.stats().stalls == 1);
+		CHECK(gpu.fences_completed == 2);
+		CHECK(buffer.stats().frames == 5);
+		CHECK(gpu.live_fences == 3);
+	}
+	SECTION("rejects allocations that overflow the frame") {
+		auto buffer = gfx::StreamingBuffer(state, 0x8892, 256);
+		buffer.begin_frame();
+		buffer.allocate(200);
+
+		CHECK_THROWS_AS(buffer.allocate(100), std::length_error);
+		CHECK(buffer.used() == 200);
+	}
+	SECTION("releases the fences, mapping and buffer") {
+		{
+			auto buffer = gfx::StreamingBuffer(state, 0x8892, 256);
+			buffer.begin_frame();
+			buffer.end_frame();
+
+			auto moved = std::move(buffer);
+			moved.begin_frame();
+			moved.end_frame();
+		}
+
+		CHECK(gpu.live_fences == 0);
+		CHECK(gpu.calls == std::vector<std::string>{ "storage 768 0xc2", "unmap", "delete 7" });
+	}
+}
+
+TEST_CASE("raster::Rasterizer", "[raster]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+	namespace fs = std::filesystem;
+
+	// Vertices in clip space, with a color passed straight through
+	struct Vertex {
+		f32 x, y, z, w;
+		f32 r, g, b;
+	};
+	auto program = raster::Program();
+	program.vertex = [](const void* /*uniforms*/, const u8* data, u32 /*instance*/, f32* varyings) {
+		auto vertex = Vertex();
+		std::memcpy(&vertex, data, sizeof(vertex));
+		varyings[0] = vertex.r;
+		varyings[1] = vertex.g;
+		varyings[2] = vertex.b;
+		return raster::Position{ vertex.x, vertex.y, vertex.z, vertex.w };
+	};
+	program.fragment = [](const void* /*uniforms*/, const f32* varyings) {
+		return raster::Color{ varyings[0], varyings[1], varyings[2], 1 };
+	};
+	program.varying_count = 3;
+
+	auto draw = [&](raster::Rasterizer& rasterizer, raster::Framebuffer& target,
+		const std::vector<Vertex>& vertices, raster::Cull cull = raster::Cull::Back)
+	{
+		auto indices = std::vector<u32>(vertices.size());
+		std::iota(indices.begin(), indices.end(), 0);
+
+		auto item = raster::DrawItem();
+		item.program = &program;
+		item.vertices = { vertices.data(), sizeof(Vertex), vertices.size() };
+		item.indices = { indices.data(), indices.size() };
+		item.count = indices.size();
+		item.cull = cull;
+		rasterizer.draw(target, item);
+	};
+
+	auto rasterizer = raster::Rasterizer(4);
+	auto target = raster::Framebuffer(100, 75);
+	target.clear({ 0, 0, 0, 0 });
+
+	SECTION("covers every pixel of a fan exactly once") {
+		// Each triangle in front of the previous one, so any pixel drawn twice
+		// would count twice
+		auto boundary = std::vector<std::pair<f32, f32>>{
+			{ -1, -1 }, { -0.3f, -1 }, { 0.77f, -1 }, { 1, -1 }, { 1, -0.1f }, { 1, 1 },
+			{ 0.123f, 1 }, { -1, 1 }, { -1, 0.31f }, { -1, -1 },
+		};
+		auto vertices = std::vector<Vertex>();
+		for (usize i = 0; i + 1 < boundary.size(); ++i) {
+			f32 z = 0.5f - static_cast<f32>(i) * 0.05f;
+			vertices.push_back({ 0.1f, -0.2f, z, 1, 1, 1, 1 });
+			vertices.push_back({ boundary[i].first, boundary[i].second, z, 1, 1, 1, 1 });
+			vertices.push_back({ boundary[i + 1].first, boundary[i + 1].second, z, 1, 1, 1, 1 });
+		}
+		draw(rasterizer, target, vertices);
+
+		CHECK(rasterizer.stats().fragments == 100 * 75);
+		CHECK(rasterizer.stats().culled == 0);
+		usize white = 0;
+		for (u32 y = 0; y < 75; ++y)
+			for (u32 x = 0; x < 100; ++x)
+				white += target.color(x, y) == 0xffff'ffff;
+		CHECK(white == 100 * 75);
+	}
+	SECTION("keeps the nearest fragments") {
+		draw(rasterizer, target, {
+			{ -1, -1, 0.2f, 1, 1, 0, 0 }, { 1, -1, 0.2f, 1, 1, 0, 0 }, { -1, 1, 0.2f, 1, 1, 0, 0 },
+			{ -1, -1, 0.4f, 1, 0, 1, 0 }, { 1, -1, 0.4f, 1, 0, 1, 0 }, { 1, 1, 0.4f, 1, 0, 1, 0 },
+		});
+
+		CHECK(target.color(10, 70) == raster::pack({ 1, 0, 0, 1 }));
+		CHECK(target.color(95, 40) == raster::pack({ 0, 1, 0, 1 }));
+		CHECK(target.color(90, 5) == 0);
+		CHECK_THAT(target.depth(10, 70), WithinAbs(0.6, 1e-6));
+	}
+	SECTION("culls by winding") {
+		auto clockwise = std::vector<Vertex>{
+			{ -1, -1, 0, 1, 1, 1, 1 }, { -1, 1, 0, 1, 1, 1, 1 }, { 1, -1, 0, 1, 1, 1, 1 },
+		};
+		draw(rasterizer, target, clockwise);
+		CHECK(rasterizer.stats().culled == 1);
+		CHECK(rasterizer.stats().fragments == 0);
+
+		draw(rasterizer, target, clockwise, raster::Cull::Front);
+		CHECK(rasterizer.stats().fragments > 0);
+	}
+	SECTION("clips triangles that cross the near plane") {
+		draw(rasterizer, target, {
+			{ -1, -1, 0, 1, 1, 1, 1 }, { 1, -1, 0, 1, 1, 1, 1 }, { 0, 1, -3, 1, 1, 1, 1 },
+			{ -1, -1, -2, 1, 1, 1, 1 }, { 1, -1, -2, 1, 1, 1, 1 }, { 0, 1, -2, 1, 1, 1, 1 },
+		});
+
+		CHECK(rasterizer.stats().clipped == 1);
+		CHECK(rasterizer.stats().culled == 1);
+		CHECK(target.color(50, 74) == 0xffff'ffff);
+		CHECK(target.color(50, 1) == 0);
+	}
+	SECTION("interpolates varyings with perspective") {
+		// The same triangle on screen, but with w = 1, 4 and 2 at its vertices
+		draw(rasterizer, target, {
+			{ -1, -1, 0, 1, 0, 0, 0 }, { 4, -4, 0, 4, 1, 0, 0 }, { -2, 2, 0, 2, 0, 0, 0 },
+		});
+
+		for (auto [px, py] : { std::pair{ 20, 40 }, std::pair{ 10, 70 }, std::pair{ 30, 50 } }) {
+			f64 x = (px + 0.5) / 50 - 1;
+			f64 y = 1 - (py + 0.5) / 37.5;
+			f64 l1 = (x + 1) / 2;
+			f64 l2 = (y + 1) / 2;
+			f64 l0 = 1 - l1 - l2;
+			f64 expected = (l1 / 4) / (l0 + l1 / 4 + l2 / 2);
+
+			CHECK_THAT(raster::unpack(target.color(static_cast<u32>(px), static_cast<u32>(py))).r,
+				WithinAbs(expected, 0.5 / 255 + 1e-4));
+		}
+	}
+	SECTION("draws the same image with any number of threads") {
+		auto rng = std::mt19937(0x5eed);
+		auto random = std::uniform_real_distribution<f32>(-1.2f, 1.2f);
+		auto vertices = std::vector<Vertex>();
+		for (usize i = 0; i < 3000; ++i)
+			vertices.push_back({ random(rng), random(rng), random(rng), 1, random(rng), random(rng), random(rng) });
+
+		auto single = raster::Rasterizer(1);
+		auto other = raster::Framebuffer(100, 75);
+		other.clear({ 0, 0, 0, 0 });
+		draw(single, other, vertices, raster::Cull::None);
+		draw(rasterizer, target, vertices, raster::Cull::None);
+
+		CHECK(rasterizer.stats().fragments == single.stats().fragments);
+		usize size = usize(target.stride()) * target.height();
+		CHECK(std::equal(target.colors(), target.colors() + size, other.colors()));
+		CHECK(std::equal(target.depths(), target.depths() + size, other.depths()));
+	}
+	SECTION("rejects malformed draws") {
+		auto indices = std::vector<u32>{ 0, 1, 5 };
+		auto vertices = std::vector<Vertex>(3);
+		auto item = raster::DrawItem();
+		item.program = &program;
+		item.vertices = { vertices.data(), sizeof(Vertex), vertices.size() };
+		item.indices = { indices.data(), indices.size() };
+		item.count = 3;
+		CHECK_THROWS_AS(rasterizer.draw(target, item), std::out_of_range);
+
+		item.count = 2;
+		CHECK_THROWS_AS(rasterizer.draw(target, item), std::invalid_argument);
+	}
+	SECTION("writes TGA images") {
+		auto path = fs::temp_directory_path() / "raster_test.tga";
+		target.clear({ 1, 0, 0, 1 });
+		REQUIRE(target.write_tga(path));
+
+		auto data = std::vector<u8>(fs::file_size(path));
+		std::ifstream(path, std::ios::binary).read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size())); // NOLINT
+		CHECK(data.size() == 18 + 100 * 75 * 4);
+		CHECK(data[12] == 100);
+		CHECK(data[14] == 75);
+		CHECK(std::vector<u8>(data.begin() + 18, data.begin() + 22) == std::vector<u8>{ 0, 0, 255, 255 });
+
+		fs::remove(path);
+	}
+}
+
+TEST_CASE("raster::OcclusionBuffer", "[raster]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+	using math::geo::AABBox;
+	using math::geo::Tri;
+
+	// A 90 degree perspective looking down -z, with near and far planes at 1
+	// and 100
+	flt near = 1, far = 100;
+	auto projection = Mat4x4{
+		{ 1, 0, 0, 0 },
+		{ 0, 1, 0, 0 },
+		{ 0, 0, (far + near) / (near - far), -1 },
+		{ 0, 0, 2 * far * near / (near - far), 0 },
+	};
+
+	// A wall across the middle of the view, 5 units away
+	auto wall = std::vector<Tri>{
+		{ Vec3{ -2, -2, 0 }, Vec3{ 2, -2, 0 }, Vec3{ 2, 2, 0 } },
+		{ Vec3{ -2, -2, 0 }, Vec3{ 2, 2, 0 }, Vec3{ -2, 2, 0 } },
+	};
+	auto model = Mat4x4{
+		{ 1, 0, 0, 0 },
+		{ 0, 1, 0, 0 },
+		{ 0, 0, 1, 0 },
+		{ 0, 0, -5, 1 },
+	};
+
+	auto buffer = raster::OcclusionBuffer(128, 96, 4);
+	buffer.begin(projection);
+	buffer.add_occluders(wall.data(), wall.size(), model);
+	buffer.finish();
+
+	auto boxes = std::vector<AABBox>{
+		{ Vec3{ -0.5, -0.5, -10.5 }, Vec3{ 0.5, 0.5, -9.5 } },   // behind the wall
+		{ Vec3{ -0.5, -0.5, -3.5 }, Vec3{ 0.5, 0.5, -2.5 } },    // in front of it
+		{ Vec3{ 7.5, -0.5, -10.5 }, Vec3{ 8.5, 0.5, -9.5 } },    // beside it
+		{ Vec3{ 49.5, -0.5, -10.5 }, Vec3{ 50.5, 0.5, -9.5 } },  // off screen
+		{ Vec3{ -6, -0.5, -10.5 }, Vec3{ 6, 0.5, -9.5 } },       // wider than it
+		{ Vec3{ -1, -1, -1 }, Vec3{ 1, 1, 1 } },                 // around the eye
+		{ Vec3{ -1, -1, -5.5 }, Vec3{ 1, 1, -4.5 } },            // through it
+	};
+	auto visible = std::vector<u8>(boxes.size());
+	buffer.test(boxes.data(), boxes.size(), visible.data());
+
+	CHECK(visible == std::vector<u8>{ 0, 1, 1, 0, 1, 1, 1 });
+	CHECK(buffer.stats().triangles == 2);
+	CHECK(buffer.stats().tested == boxes.size());
+	CHECK(buffer.stats().occluded == 2);
+
+	// The wall covers the middle fifth of the view, which the top levels mix
+	// with empty space
+	CHECK(buffer.levels() == 8);
+	CHECK(buffer.depth(0, 64, 48) < 1);
+	CHECK(buffer.depth(0, 10, 10) == 1);
+	CHECK(buffer.depth(buffer.levels() - 1, 0, 0) == 1);
+
+	SECTION("tests a thousand boxes the same with any number of threads") {
+		auto rng = std::mt19937(0x0cc1);
+		auto random = std::uniform_real_distribution<flt>(-8, 8);
+		auto many = std::vector<AABBox>();
+		for (usize i = 0; i < 1000; ++i) {
+			auto center = Vec3{ random(rng), random(rng), random(rng) - 12 };
+			many.emplace_back(center - Vec3::all(0.5), center + Vec3::all(0.5));
+		}
+
+		auto single = raster::OcclusionBuffer(128, 96, 1);
+		single.begin(projection);
+		single.add_occluders(wall.data(), wall.size(), model);
+		single.finish();
+
+		auto expected = std::vector<u8>(many.size());
+		auto actual = std::vector<u8>(many.size());
+		single.test(many.data(), many.size(), expected.data());
+		buffer.test(many.data(), many.size(), actual.data());
+
+		CHECK(actual == expected);
+		CHECK(single.stats().occluded > 0);
+	}
+	SECTION("keeps the farthest depth of odd sizes' last texels") {
+		// A wall past the right and bottom edges, which a pyramid that dropped
+		// the last column or row of a level would lose
+		auto corner = std::vector<Tri>{
+			{ Vec3{ 0, -50, 0 }, Vec3{ 50, -50, 0 }, Vec3{ 50, 0, 0 } },
+			{ Vec3{ 0, -50, 0 }, Vec3{ 50, 0, 0 }, Vec3{ 0, 0, 0 } },
+		};
+		auto odd = raster::OcclusionBuffer(101, 77, 1);
+		odd.begin(projection);
+		odd.add_occluders(corner.data(), corner.size(), model);
+		odd.finish();
+
+		bool matches = true;
+		for (usize level = 1; level < odd.levels(); ++level) {
+			u32 width = (101 + (1u << level) - 1) >> level;
+			u32 height = (77 + (1u << level) - 1) >> level;
+			u32 source_width = (101 + (1u << (level - 1)) - 1) >> (level - 1);
+			u32 source_height = (77 + (1u << (level - 1)) - 1) >> (level - 1);
+			for (u32 y = 0; y < height; ++y) {
+				for (u32 x = 0; x < width; ++x) {
+					u32 x1 = std::min(x * 2 + 1, source_width - 1);
+					u32 y1 = std::min(y * 2 + 1, source_height - 1);
+					f32 farthest = std::max({
+						odd.depth(level - 1, x * 2, y * 2), odd.depth(level - 1, x1, y * 2),
+						odd.depth(level - 1, x * 2, y1), odd.depth(level - 1, x1, y1),
+					});
+					matches &= odd.depth(level, x, y) == farthest;
+				}
+			}
+		}
+		CHECK(matches);
+		CHECK(odd.depth(0, 100, 76) < 1);
+		CHECK(odd.depth(2, 25, 19) < 1);
+	}
+	SECTION("starts each frame empty") {
+		buffer.begin(projection);
+		buffer.finish();
+		buffer.test(boxes.data(), 1, visible.data());
+		CHECK(visible[0] == 1);
+	}
+}
+
+TEST_CASE("raster::Backend", "[raster]") {
+	using namespace sized; // NOLINT(*-using-namespace)
+
+	// Quads offset by their instance's position, in the color of block 0
+	// scaled by the uniform at location 0
+	auto program = raster::Program();
+	program.vertex = [](const void* uniforms, const u8* vertex, u32 instance, f32* /*varyings*/) {
+		const auto& bindings = *static_cast<const raster::Bindings*>(uniforms);
+		f32 position[2];
+		f32 offset[2];
+		std::memcpy(position, vertex, sizeof(position));
+		std::memcpy(offset, bindings.instance(instance), sizeof(offset));
+		return raster::Position{ position[0] + offset[0], position[1] + offset[1], 0.5f, 1 };
+	};
+	program.fragment = [](const void* uniforms, const f32* /*varyings*/) {
+		const auto& bindings = *static_cast<const raster::Bindings*>(uniforms);
+		f32 color[4];
+		std::memcpy(color, bindings.blocks[0], sizeof(color));
+		const f32* scale = bindings.uniform(0);
+		f32 s = scale ? scale[0] : 1;
+		return raster::Color{ color[0] * s, color[1] * s, color[2] * s, color[3] };
+	};
+
+	f32 quad[] { -0.2f, -0.2f, 0.2f, -0.2f, 0.2f, 0.2f, -0.2f, 0.2f };
+	u32 indices[] { 0, 1, 2, 0, 2, 3 };
+	f32 blocks[] { 1, 0, 0, 1, 0, 0, 1, 1 };
+
+	auto rasterizer = raster::Rasterizer(2);
+	auto target = raster::Framebuffer(16, 16);
+	target.clear({ 0, 0, 0, 1 });
+	auto backend = raster::Backend(rasterizer, target);
+	backend.set_program(1, program);
+	backend.set_buffer(2, indices, sizeof(indices));
+	backend.set_buffer(3, blocks, sizeof(blocks));
+
+	auto mesh = gfx::DrawItem();
+	mesh.program = 1;
+	mesh.vertex_array = 1;
+	mesh.index_buffer = 2;
+	mesh.count = 6;
+	mesh.block_buffer = 3;
+	mesh.block_size = 16;
+
+	SECTION("draws a batched and sorted frame") {
+		auto queue = gfx::DrawQueue();
+		auto batcher = gfx::InstanceBatcher(2);
+		f32 left[] { -0.5f, 0 };
+		f32 right[] { 0.5f, 0 };
+		f32 top[] { 0, 0.5f };
+		batcher.add(mesh, left);
+		batcher.add(mesh, right);
+		batcher.build(queue);
+
+		// A blue quad at half brightness, from the other half of the block buffer
+		auto blue = mesh;
+		blue.block_offset = 16;
+		blue.instance_count = 1;
+		blue.base_instance = 2;
+		queue.push(blue);
+		f32 half = 0.5f;
+		queue.uniform(0, gfx::UniformType::F1, &half);
+
+		auto instances = batcher.instance_data();
+		instances.insert(instances.end(), top, top + 2);
+		backend.set_vertex_array(1, { quad, 2 * sizeof(f32), 4 }, { instances.data(), 2 * sizeof(f32), 3 });
+
+		queue.sort();
+		queue.submit(backend);
+
+		CHECK(target.color(4, 8) == raster::pack({ 1, 0, 0, 1 }));
+		CHECK(target.color(12, 8) == raster::pack({ 1, 0, 0, 1 }));
+		CHECK(target.color(8, 4) == raster::pack({ 0, 0, 0.5f, 1 }));
+		CHECK(target.color(8, 8) == raster::pack({ 0, 0, 0, 1 }));
+		CHECK(rasterizer.stats().triangles == 6);
+	}
+	SECTION("rejects draws it can't do") {
+		backend.set_vertex_array(1, { quad, 2 * sizeof(f32), 4 });
+
+		auto unknown = mesh;
+		unknown.program = 9;
+		CHECK_THROWS_AS(backend.draw(unknown, nullptr), std::invalid_argument);
+
+		auto lines = mesh;
+		lines.mode = 0x0001;
+		CHECK_THROWS_AS(backend.draw(lines, nullptr), std::invalid_argument);
+
+		auto instanced = mesh;
+		instanced.instance_count = 2;
+		backend.set_vertex_array(1, { quad, 2 * sizeof(f32), 4 }, { quad, 2 * sizeof(f32), 1 });
+		CHECK_THROWS_AS(backend.draw(instanced, nullptr), std::invalid_argument);
+	}
+}
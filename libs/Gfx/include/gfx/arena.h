@@ -0,0 +1,82 @@
+#pragma once
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <sized.h>
+
+namespace gfx {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/**
+ * A bump allocator for per-frame data. Allocations are never freed
+ * individually; `reset` releases all of them at once but keeps the memory, so
+ * once an arena has grown to a frame's high-water mark it stops allocating.
+ *
+ * Only trivially destructible types may be created in an arena, since their
+ * destructors are never run.
+ */
+class Arena {
+public:
+	static constexpr usize k_default_block_size = 64 * 1024;
+
+	explicit Arena(usize block_size = k_default_block_size);
+
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	Arena(Arena&&) noexcept = default;
+	Arena& operator=(Arena&&) noexcept = default;
+
+	/** Allocate uninitialized memory. `alignment` must be a power of two. */
+	auto allocate(usize size, usize alignment = alignof(std::max_align_t)) -> void*;
+
+	template <typename T, typename... Args>
+	auto make(Args&&... args) -> T*;
+
+	/** Allocate an array of default-initialized elements. */
+	template <typename T>
+	auto make_array(usize count) -> T*;
+
+	/** Release every allocation, keeping the memory for reuse. */
+	void reset();
+
+	/** The number of bytes allocated since the last reset, including padding. */
+	auto used() const -> usize;
+	/** The number of bytes reserved from the system. */
+	auto capacity() const -> usize;
+
+private:
+	struct Block {
+		std::unique_ptr<u8[]> data;
+		usize size;
+	};
+
+	usize m_block_size;
+	std::vector<Block> m_blocks;
+	/** The block being allocated from. */
+	usize m_current = 0;
+	usize m_offset = 0;
+	/** The bytes used by blocks before `m_current`. */
+	usize m_used_before = 0;
+};
+
+
+template <typename T, typename... Args>
+inline auto Arena::make(Args&&... args) -> T*
+{
+	static_assert(std::is_trivially_destructible_v<T>, "Arena-allocated types are never destroyed");
+	return new (allocate(sizeof(T), alignof(T))) T{ std::forward<Args>(args)... };
+}
+
+template <typename T>
+inline auto Arena::make_array(usize count) -> T*
+{
+	static_assert(std::is_trivially_destructible_v<T>, "Arena-allocated types are never destroyed");
+	return new (allocate(sizeof(T) * count, alignof(T))) T[count];
+}
+
+} // namespace gfx
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <vector>
+
+#include <sized.h>
+
+#include "gfx/arena.h"
+#include "gfx/functions.h"
+#include "gfx/state_cache.h"
+
+namespace gfx {
+using namespace sized; // NOLINT(*-using-namespace)
+
+enum class UniformType : u8 {
+	F1, F2, F3, F4,
+	Mat2, Mat3, Mat4, Mat4x3, Mat3x4,
+};
+
+/** The number of `f32`s in one value of a uniform type. */
+constexpr auto component_count(UniformType type) -> usize
+{
+	switch (type) {
+		case UniformType::F1: return 1;
+		case UniformType::F2: return 2;
+		case UniformType::F3: return 3;
+		case UniformType::F4: return 4;
+		case UniformType::Mat2: return 4;
+		case UniformType::Mat3: return 9;
+		case UniformType::Mat4: return 16;
+		case UniformType::Mat4x3: return 12;
+		case UniformType::Mat3x4: return 12;
+	}
+	return 0;
+}
+
+/** An indexed draw call and the state it needs. */
+struct DrawItem {
+	u32 program = 0;
+	u32 vertex_array = 0;
+	/** Bound to the element array target before drawing, unless zero. */
+	u32 index_buffer = 0;
+
+	u32 mode = k_triangles;
+	i32 count = 0;
+	u32 index_type = k_unsigned_int;
+	/** The byte offset of the first index in the index buffer. */
+	usize offset = 0;
+
+	/** Drawn with `draw_elements_instanced` unless this is 1 and `base_instance` is 0. */
+	i32 instance_count = 1;
+	/** The first instance, for attributes with a non-zero divisor. */
+	u32 base_instance = 0;
+
+	/**
+	 * A range of a uniform buffer bound to the `block_binding` point before
+	 * drawing, unless `block_buffer` is zero: typically the draw's per-object
+	 * block, in a buffer shared with the other draws.
+	 */
+	u32 block_buffer = 0;
+	u32 block_binding = 0;
+	u32 block_offset = 0;
+	u32 block_size = 0;
+
+	/** Draws are sorted by layer first, e.g. opaque before translucent. */
+	u8 layer = 0;
+	/** The normalized depth, in [0, 1]. */
+	f32 depth = 0;
+	/**
+	 * Sort by depth, far to near, before state within the layer, as blending
+	 * requires. Otherwise draws are sorted by state and then near to far.
+	 */
+	bool back_to_front = false;
+};
+
+/** A uniform value recorded for a draw, in a list of the draw's uniforms. */
+struct UniformValue {
+	const UniformValue* next;
+	/** `count` values of `type`. */
+	const f32* values;
+	i32 location;
+	i32 count;
+	UniformType type;
+	bool transpose;
+};
+
+/**
+ * Where `DrawQueue::submit` replays its draws: `GlBackend` for OpenGL, or a
+ * software backend such as `raster::Backend`, so the same recorded frame can
+ * be drawn by either.
+ */
+class DrawBackend {
+public:
+	virtual ~DrawBackend() = default;
+
+	/**
+	 * Draw `item`, after setting `uniforms` (a list, possibly null) on its
+	 * program.
+	 */
+	virtual void draw(const DrawItem& item, const UniformValue* uniforms) = 0;
+
+protected:
+	DrawBackend() = default;
+	DrawBackend(const DrawBackend&) = default;
+	DrawBackend& operator=(const DrawBackend&) = default;
+};
+
+/** Draws through a `StateCache`, so that redundant state changes are skipped. */
+class GlBackend final : public DrawBackend {
+public:
+	explicit GlBackend(StateCache& state)
+		: m_state(&state)
+	{}
+
+	void draw(const DrawItem& item, const UniformValue* uniforms) override;
+
+private:
+	StateCache* m_state;
+};
+
+/**
+ * Records draw calls over a frame, then sorts and replays them to minimize
+ * state changes.
+ *
+ * Each draw gets a 64-bit sort key. From the most significant bits down:
+ *
+ *     layer (4) | program (12) | vertex array (12) | depth (16) | index (20)
+ *
+ * and for `back_to_front` draws, depth is moved ahead of the program. Object
+ * names are truncated to 12 bits, so a collision only costs some batching.
+ * The index is the draw's position in the queue, which keeps the sort stable.
+ *
+ * Recording doesn't allocate once the queue has reached a frame's high-water
+ * mark: uniform values go in an arena, and `clear` keeps every buffer's memory.
+ */
+class DrawQueue {
+public:
+	static constexpr u32 k_index_bits = 20;
+	static constexpr usize k_max_draws = usize(1) << k_index_bits;
+
+	explicit DrawQueue(usize arena_block_size = Arena::k_default_block_size);
+
+	/** Record a draw. */
+	void push(const DrawItem& item);
+
+	/**
+	 * Record a uniform value for the most recent draw, set on its program just
+	 * before it. `values` holds `count` values of `type`, and is copied.
+	 */
+	void uniform(i32 location, UniformType type, const f32* values, i32 count = 1, bool transpose = false);
+
+	/** Order the draws by their sort keys. Until then they're in recording order. */
+	void sort();
+
+	/** Replay every draw into `backend`. */
+	void submit(DrawBackend& backend) const;
+	/** Replay every draw with OpenGL, through `state` so that redundant changes are skipped. */
+	void submit(StateCache& state) const;
+
+	/** Remove every draw, keeping the memory for the next frame. */
+	void clear();
+
+	auto size() const -> usize { return m_commands.size(); }
+	auto empty() const -> bool { return m_commands.empty(); }
+
+	static auto sort_key(const DrawItem& item, u32 index) -> u64;
+
+private:
+	struct Command {
+		DrawItem item;
+		const UniformValue* first_uniform = nullptr;
+		UniformValue* last_uniform = nullptr;
+	};
+
+	Arena m_arena;
+	std::vector<Command> m_commands;
+	std::vector<u64> m_keys;
+	std::vector<u64> m_scratch;
+};
+
+} // namespace gfx
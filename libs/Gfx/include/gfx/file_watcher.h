@@ -0,0 +1,58 @@
+#pragma once
+
+#include <filesystem>
+#include <unordered_map>
+#include <vector>
+
+#include <sized.h>
+
+namespace gfx {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/**
+ * Reports files written under a set of directories, with inotify.
+ *
+ * A file counts as changed once it's closed after writing, or moved into
+ * place, as editors that save atomically do. `poll` never blocks, and is a
+ * single `read` that fails with `EAGAIN` when nothing has changed.
+ *
+ * Only implemented on Linux: elsewhere `watch` fails, and nothing is reported.
+ */
+class FileWatcher {
+public:
+	FileWatcher();
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	FileWatcher(FileWatcher&& other) noexcept;
+	FileWatcher& operator=(FileWatcher&& other) noexcept;
+
+	/**
+	 * Watch a directory and its subdirectories, including ones created later,
+	 * whose files are reported as changed when they're found. Returns whether
+	 * it could.
+	 */
+	auto watch(const std::filesystem::path& directory) -> bool;
+
+	/**
+	 * The files changed since the last call, each once, as their directory's
+	 * (normalized) path joined with their name.
+	 */
+	auto poll() -> const std::vector<std::filesystem::path>&;
+
+	/** Whether file changes can be watched at all. */
+	auto supported() const -> bool { return m_fd >= 0; }
+
+private:
+	void release();
+	auto add(const std::filesystem::path& directory) -> bool;
+
+	i32 m_fd = -1;
+	/** The watched directories, by watch descriptor. */
+	std::unordered_map<i32, std::filesystem::path> m_directories;
+	std::vector<std::filesystem::path> m_changed;
+};
+
+} // namespace gfx
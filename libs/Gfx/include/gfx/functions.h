@@ -0,0 +1,111 @@
+#pragma once
+
+#include <sized.h>
+
+namespace gfx {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/** `GL_ELEMENT_ARRAY_BUFFER`, whose binding is part of the vertex array's state. */
+constexpr u32 k_element_array_buffer = 0x8893;
+/** `GL_UNIFORM_BUFFER`, which also has indexed binding points. */
+constexpr u32 k_uniform_buffer = 0x8a11;
+/** `GL_TRIANGLES` */
+constexpr u32 k_triangles = 0x0004;
+/** `GL_UNSIGNED_INT` */
+constexpr u32 k_unsigned_int = 0x1405;
+
+// Buffer storage and mapping flags
+constexpr u32 k_map_write_bit = 0x0002;
+constexpr u32 k_map_persistent_bit = 0x0040;
+constexpr u32 k_map_coherent_bit = 0x0080;
+
+// Shader and program queries
+constexpr u32 k_compile_status = 0x8b81;
+constexpr u32 k_link_status = 0x8b82;
+constexpr u32 k_info_log_length = 0x8b84;
+/** `GL_COMPLETION_STATUS_KHR`, from `KHR_parallel_shader_compile`. */
+constexpr u32 k_completion_status = 0x91b1;
+constexpr u32 k_program_binary_retrievable_hint = 0x8257;
+constexpr u32 k_program_binary_length = 0x8741;
+constexpr u32 k_active_uniforms = 0x8b86;
+constexpr u32 k_active_uniform_max_length = 0x8b87;
+constexpr u32 k_active_attributes = 0x8b89;
+constexpr u32 k_active_attribute_max_length = 0x8b8a;
+
+// Sync objects
+constexpr u32 k_sync_flush_commands_bit = 0x0001;
+constexpr u32 k_already_signaled = 0x911a;
+constexpr u32 k_timeout_expired = 0x911b;
+constexpr u32 k_condition_satisfied = 0x911c;
+constexpr u32 k_wait_failed = 0x911d;
+
+/**
+ * The OpenGL entry points used by the `gfx` layer, with plain types in place of
+ * the `GL*` typedefs. The renderer fills this in with thin wrappers around the
+ * real functions; tests and benchmarks can substitute mocks so that everything
+ * above it runs without a GPU or a context.
+ */
+struct Functions {
+	auto (*gen_buffer)() -> u32 = nullptr;
+	void (*delete_buffer)(u32 buffer) = nullptr;
+	void (*bind_buffer)(u32 target, u32 buffer) = nullptr;
+	void (*bind_buffer_base)(u32 target, u32 index, u32 buffer) = nullptr;
+	void (*bind_buffer_range)(u32 target, u32 index, u32 buffer, usize offset, usize size) = nullptr;
+	void (*buffer_storage)(u32 target, usize size, const void* data, u32 flags) = nullptr;
+	auto (*map_buffer_range)(u32 target, usize offset, usize length, u32 access) -> void* = nullptr;
+	auto (*unmap_buffer)(u32 target) -> bool = nullptr;
+
+	void (*bind_vertex_array)(u32 array) = nullptr;
+	void (*use_program)(u32 program) = nullptr;
+
+	auto (*create_shader)(u32 type) -> u32 = nullptr;
+	void (*shader_source)(u32 shader, i32 count, const char* const* strings, const i32* lengths) = nullptr;
+	void (*compile_shader)(u32 shader) = nullptr;
+	auto (*get_shader_iv)(u32 shader, u32 pname) -> i32 = nullptr;
+	void (*get_shader_info_log)(u32 shader, i32 buffer_size, i32* length, char* log) = nullptr;
+	void (*delete_shader)(u32 shader) = nullptr;
+
+	auto (*create_program)() -> u32 = nullptr;
+	void (*attach_shader)(u32 program, u32 shader) = nullptr;
+	void (*link_program)(u32 program) = nullptr;
+	void (*get_program_info_log)(u32 program, i32 buffer_size, i32* length, char* log) = nullptr;
+	void (*delete_program)(u32 program) = nullptr;
+	void (*program_parameter_i)(u32 program, u32 pname, i32 value) = nullptr;
+	void (*program_binary)(u32 program, u32 format, const void* binary, i32 length) = nullptr;
+	void (*get_program_binary)(u32 program, i32 buffer_size, i32* length, u32* format, void* binary) = nullptr;
+	/** Only with `KHR_parallel_shader_compile` or `ARB_parallel_shader_compile`; may be null. */
+	void (*max_shader_compiler_threads)(u32 count) = nullptr;
+
+	auto (*get_program_iv)(u32 program, u32 pname) -> i32 = nullptr;
+	void (*get_active_uniform)(
+		u32 program, u32 index, i32 buffer_size,
+		i32* length, i32* size, u32* type, char* name) = nullptr;
+	void (*get_active_attrib)(
+		u32 program, u32 index, i32 buffer_size,
+		i32* length, i32* size, u32* type, char* name) = nullptr;
+	auto (*get_uniform_location)(u32 program, const char* name) -> i32 = nullptr;
+	auto (*get_attrib_location)(u32 program, const char* name) -> i32 = nullptr;
+
+	void (*uniform_1f)(i32 location, f32 v0) = nullptr;
+	void (*uniform_2f)(i32 location, f32 v0, f32 v1) = nullptr;
+	void (*uniform_3f)(i32 location, f32 v0, f32 v1, f32 v2) = nullptr;
+	void (*uniform_4f)(i32 location, f32 v0, f32 v1, f32 v2, f32 v3) = nullptr;
+
+	void (*uniform_matrix_2fv)(i32 location, i32 count, bool transpose, const f32* values) = nullptr;
+	void (*uniform_matrix_3fv)(i32 location, i32 count, bool transpose, const f32* values) = nullptr;
+	void (*uniform_matrix_4fv)(i32 location, i32 count, bool transpose, const f32* values) = nullptr;
+	void (*uniform_matrix_4x3fv)(i32 location, i32 count, bool transpose, const f32* values) = nullptr;
+	void (*uniform_matrix_3x4fv)(i32 location, i32 count, bool transpose, const f32* values) = nullptr;
+
+	void (*draw_elements)(u32 mode, i32 count, u32 type, const void* indices) = nullptr;
+	void (*draw_elements_instanced)(
+		u32 mode, i32 count, u32 type, const void* indices,
+		i32 instance_count, u32 base_instance) = nullptr;
+
+	/** Insert a fence for `GL_SYNC_GPU_COMMANDS_COMPLETE`, returning a `GLsync`. */
+	auto (*fence_sync)() -> void* = nullptr;
+	auto (*client_wait_sync)(void* sync, u32 flags, u64 timeout) -> u32 = nullptr;
+	void (*delete_sync)(void* sync) = nullptr;
+};
+
+} // namespace gfx
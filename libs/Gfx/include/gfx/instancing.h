@@ -0,0 +1,75 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include <sized.h>
+
+#include "gfx/draw_queue.h"
+
+namespace gfx {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/**
+ * Groups draws of the same mesh with the same state into instanced draws.
+ *
+ * Each draw comes with its per-instance data, e.g. a transform. `build` emits
+ * one draw per group, gathering every group's instance data into one array,
+ * which is meant to be uploaded to a vertex buffer whose attributes have a
+ * divisor of 1. Each emitted draw's `base_instance` selects its group's range.
+ *
+ * Draws only group if every field but `depth` matches; a group is sorted by
+ * its nearest instance. `back_to_front` draws are never grouped, since their
+ * instances must interleave with other blended draws by depth, so each is
+ * emitted as a draw of its own instance.
+ */
+class InstanceBatcher {
+public:
+	/** `components` is the number of `f32`s per instance, e.g. 12 for a `Mat4x3`. */
+	explicit InstanceBatcher(usize components);
+
+	/** Add a draw of a single instance, copying its `components` values. */
+	void add(const DrawItem& item, const f32* instance);
+
+	/**
+	 * Emit a draw per group into `queue` and gather the instance data, keeping
+	 * the order they were added within each group. `first_instance` is where
+	 * the data will start in the instance buffer.
+	 */
+	void build(DrawQueue& queue, u32 first_instance = 0);
+
+	/** The gathered instance data, valid after `build`. */
+	auto instance_data() const -> const std::vector<f32>& { return m_gathered; }
+	auto instance_count() const -> usize { return m_groups_of_instances.size(); }
+	auto batch_count() const -> usize { return m_batches.size(); }
+	auto components() const -> usize { return m_components; }
+
+	/** Remove every draw, keeping the memory for the next frame. */
+	void clear();
+
+private:
+	struct Batch {
+		DrawItem item;
+		u32 instance_count = 0;
+	};
+
+	struct KeyHash {
+		auto operator()(const DrawItem& item) const -> usize;
+	};
+	struct KeyEqual {
+		auto operator()(const DrawItem& lhs, const DrawItem& rhs) const -> bool;
+	};
+
+	usize m_components;
+	std::unordered_map<DrawItem, u32, KeyHash, KeyEqual> m_lookup;
+	std::vector<Batch> m_batches;
+
+	/** The instance data in the order it was added. */
+	std::vector<f32> m_instances;
+	/** The batch of each added instance. */
+	std::vector<u32> m_groups_of_instances;
+	std::vector<f32> m_gathered;
+	std::vector<u32> m_offsets;
+};
+
+} // namespace gfx
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sized.h>
+
+#include "gfx/program_cache.h"
+#include "gfx/shader_source.h"
+#include "gfx/state_cache.h"
+
+namespace gfx {
+using namespace sized; // NOLINT(*-using-namespace)
+
+enum class BuildStatus : u8 {
+	Pending,
+	Ready,
+	Failed,
+};
+
+namespace detail {
+
+/** A compiled shader, shared by the builds of a program that use it. */
+struct CompiledStage {
+	const Functions* gl;
+	u32 shader;
+	/** `hash64` of the stage's type and source. */
+	u64 hash;
+
+	CompiledStage(const Functions& gl, u32 shader, u64 hash)
+		: gl(&gl), shader(shader), hash(hash)
+	{}
+	~CompiledStage() { gl->delete_shader(shader); }
+
+	CompiledStage(const CompiledStage&) = delete;
+	CompiledStage& operator=(const CompiledStage&) = delete;
+};
+
+struct ProgramBuild {
+	BuildStatus status = BuildStatus::Pending;
+	u32 program = 0;
+	/** The compile and link errors, if it failed. */
+	std::string log;
+	/** The compiled stages, while pending, or afterwards if they're kept. */
+	std::vector<std::shared_ptr<CompiledStage>> shaders;
+
+	// Owned by the builder while pending
+	std::vector<std::pair<ShaderStage, std::string>> stages;
+	/** The stages of the build this one replaces, to use where unchanged. */
+	std::vector<std::shared_ptr<CompiledStage>> previous;
+	u64 key = 0;
+	bool from_cache = false;
+	bool keep_shaders = false;
+};
+
+} // namespace detail
+
+/**
+ * A program being built by a `ProgramBuilder`, like a future. Once it's ready
+ * the program is the caller's, to use and eventually delete. If every handle
+ * to a build is dropped first, the builder deletes the program when it's done.
+ */
+class PendingProgram {
+public:
+	PendingProgram() = default;
+
+	/** Whether this refers to a build at all. */
+	auto valid() const -> bool { return m_build != nullptr; }
+
+	auto status() const -> BuildStatus { return m_build ? m_build->status : BuildStatus::Failed; }
+	auto ready() const -> bool { return status() == BuildStatus::Ready; }
+	auto failed() const -> bool { return status() == BuildStatus::Failed; }
+
+	/** The linked program, or zero until it's ready. */
+	auto program() const -> u32 { return ready() ? m_build->program : 0; }
+	/** The linked program, or `fallback` until it's ready (or if it failed). */
+	auto get_or(u32 fallback) const -> u32 { return ready() ? m_build->program : fallback; }
+
+	/** The compile and link errors of a failed build. */
+	auto log() const -> const std::string&;
+
+private:
+	friend class ProgramBuilder;
+
+	explicit PendingProgram(std::shared_ptr<detail::ProgramBuild> build)
+		: m_build(std::move(build))
+	{}
+
+	std::shared_ptr<const detail::ProgramBuild> m_build;
+};
+
+/**
+ * Builds programs without blocking on the driver.
+ *
+ * `submit` issues every stage's compile and the link straight away, and never
+ * asks for their results, which would wait for them. With
+ * `KHR_parallel_shader_compile` (or the ARB version) the driver compiles on
+ * its own threads, and `poll` checks `GL_COMPLETION_STATUS_KHR` to finish only
+ * the builds that are done, so it never stalls. Without it, `poll` finishes
+ * one build per call, so that a frame waits for at most one.
+ *
+ * With a `ProgramCache`, programs built before are loaded from their binaries
+ * instead, and compiled as usual if the driver rejects them. Freshly built
+ * programs are stored in the cache.
+ *
+ * Programs submitted with `keep_shaders` hold on to their compiled stages, so
+ * that `rebuild` only needs to compile the stages whose source changed.
+ */
+class ProgramBuilder {
+public:
+	/**
+	 * `parallel` says whether the driver supports parallel compilation. The
+	 * cache, if any, must outlive the builder.
+	 */
+	ProgramBuilder(StateCache& state, bool parallel, ProgramCache* cache = nullptr);
+	~ProgramBuilder();
+
+	ProgramBuilder(const ProgramBuilder&) = delete;
+	ProgramBuilder& operator=(const ProgramBuilder&) = delete;
+
+	ProgramBuilder(ProgramBuilder&&) noexcept = default;
+	ProgramBuilder& operator=(ProgramBuilder&&) noexcept = default;
+
+	/**
+	 * Start building a program from every stage of `source`. With
+	 * `keep_shaders`, the compiled stages are kept until every handle to the
+	 * program is dropped.
+	 */
+	auto submit(const ShaderSource& source, bool keep_shaders = false) -> PendingProgram;
+	/**
+	 * Start building a new version of `previous`, compiling only the stages
+	 * that differ from the ones it kept. Its stages are kept in turn.
+	 */
+	auto rebuild(const ShaderSource& source, const PendingProgram& previous) -> PendingProgram;
+
+	/** Finish the builds that are done, returning how many there were. */
+	auto poll() -> usize;
+	/** Finish every build, blocking until they're done. */
+	void finish();
+
+	/** The builds that haven't finished. */
+	auto pending() const -> usize { return m_pending.size(); }
+	auto parallel() const -> bool { return m_parallel; }
+
+private:
+	using Build = detail::ProgramBuild;
+
+	auto start(const ShaderSource& source, std::shared_ptr<Build> build) -> PendingProgram;
+	void compile(Build& build);
+	/** Whether the build was finished, rather than restarted from source. */
+	auto complete(Build& build) -> bool;
+	auto info_log(u32 object, bool is_program) const -> std::string;
+
+	StateCache* m_state;
+	bool m_parallel;
+	ProgramCache* m_cache;
+	std::vector<std::shared_ptr<Build>> m_pending;
+};
+
+} // namespace gfx
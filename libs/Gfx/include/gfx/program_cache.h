@@ -0,0 +1,76 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <sized.h>
+
+namespace gfx {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/** The 64-bit FNV-1a hash of `data`, continuing from `seed`. */
+auto hash64(std::string_view data, u64 seed = 0xcbf2'9ce4'8422'2325) -> u64;
+
+/** The output of `glGetProgramBinary`. */
+struct ProgramBinary {
+	u32 format = 0;
+	std::vector<u8> data;
+};
+
+/**
+ * An on-disk cache of linked program binaries, so that programs only need
+ * compiling the first time they're built with a given driver.
+ *
+ * Entries are keyed by the hash of a program's preprocessed stage sources,
+ * and stored in a file per entry whose name also holds the hash of the driver
+ * identity. Binaries are only valid for the driver that made them, so the
+ * cache deletes other drivers' entries when it's opened. A driver may still
+ * reject a binary (e.g. after a change it doesn't advertise), in which case
+ * the caller should `remove` it, rebuild the program and `store` it again.
+ *
+ * Failures to read or write the cache are never fatal: they just miss.
+ */
+class ProgramCache {
+public:
+	struct Stats {
+		u64 hits = 0;
+		u64 misses = 0;
+		u64 stores = 0;
+		/** Entries that were damaged, or rejected by the driver. */
+		u64 removed = 0;
+	};
+
+	/**
+	 * Open (or create) the cache in `directory`. `driver` identifies the GL
+	 * implementation, e.g. its vendor, renderer and version strings.
+	 */
+	ProgramCache(std::filesystem::path directory, std::string_view driver);
+
+	/**
+	 * The key of a program built from these `(stage type, source)` pairs,
+	 * whatever their order.
+	 */
+	static auto key(std::vector<std::pair<u32, std::string_view>> stages) -> u64;
+
+	/** The binary stored under `key`, or none. Damaged entries are removed. */
+	auto load(u64 key) -> std::optional<ProgramBinary>;
+	/** Store a binary, replacing any under the same key. Returns false if it couldn't be written. */
+	auto store(u64 key, const ProgramBinary& binary) -> bool;
+	/** Remove an entry, e.g. one the driver rejected. */
+	void remove(u64 key);
+
+	auto path(u64 key) const -> std::filesystem::path;
+	auto directory() const -> const std::filesystem::path& { return m_directory; }
+	auto driver() const -> u64 { return m_driver; }
+	auto stats() const -> const Stats& { return m_stats; }
+
+private:
+	std::filesystem::path m_directory;
+	u64 m_driver;
+	Stats m_stats;
+};
+
+} // namespace gfx
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sized.h>
+
+#include "gfx/functions.h"
+
+namespace gfx {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/** The 32-bit FNV-1a hash of a shader variable's name. */
+constexpr auto hash_name(std::string_view name) -> u32
+{
+	u32 result = 0x811c'9dc5;
+	for (char c : name) {
+		result ^= static_cast<u8>(c);
+		result *= 0x0100'0193;
+	}
+
+	return result;
+}
+
+/**
+ * The hashed name of a shader variable, for lookups without any string work.
+ * Make them at compile time with `"u_color"_id`, or once up front from a
+ * runtime string.
+ */
+struct NameId {
+	u32 hash = 0;
+
+	constexpr NameId() = default;
+	constexpr explicit NameId(std::string_view name)
+		: hash(hash_name(name))
+	{}
+
+	constexpr auto operator==(NameId other) const -> bool { return hash == other.hash; }
+	constexpr auto operator!=(NameId other) const -> bool { return hash != other.hash; }
+};
+
+namespace literals {
+	constexpr auto operator""_id(const char* name, usize length) -> NameId
+	{
+		return NameId(std::string_view(name, length));
+	}
+} // namespace literals
+
+
+/** An active uniform or vertex attribute of a linked program. */
+struct ShaderVariable {
+	/** Without the `[0]` suffix GL reports for arrays. */
+	std::string name;
+	i32 location = -1;
+	/** The GLSL type, e.g. `GL_FLOAT_VEC4`. */
+	u32 type = 0;
+	/** The number of array elements, or 1. */
+	i32 count = 1;
+};
+
+/**
+ * The active uniforms and attributes of a linked program, in flat hash tables
+ * keyed by `NameId`, so that locations can be resolved every frame at the cost
+ * of a probe or two.
+ *
+ * Uniforms in uniform blocks have no location, so they're left out.
+ */
+class ProgramReflection {
+public:
+	ProgramReflection() = default;
+	/** Throws `std::logic_error` if two names of the same kind share a hash. */
+	ProgramReflection(std::vector<ShaderVariable> uniforms, std::vector<ShaderVariable> attributes);
+
+	/** The location of an active uniform, or -1, which GL ignores. */
+	auto uniform_location(NameId name) const -> i32;
+	/** The location of an active attribute, or -1. */
+	auto attribute_location(NameId name) const -> i32;
+
+	auto find_uniform(NameId name) const -> const ShaderVariable*;
+	auto find_attribute(NameId name) const -> const ShaderVariable*;
+
+	auto uniforms() const -> const std::vector<ShaderVariable>& { return m_uniforms; }
+	auto attributes() const -> const std::vector<ShaderVariable>& { return m_attributes; }
+
+private:
+	static constexpr u32 k_empty = 0xffff'ffff;
+
+	struct Slot {
+		u32 hash = 0;
+		/** The index of the variable, or `k_empty`. */
+		u32 index = k_empty;
+	};
+
+	/** An open-addressed table with linear probing, at most half full. */
+	static auto build(const std::vector<ShaderVariable>& variables) -> std::vector<Slot>;
+	static auto find(const std::vector<Slot>& table, NameId name) -> u32;
+
+	std::vector<ShaderVariable> m_uniforms;
+	std::vector<ShaderVariable> m_attributes;
+	std::vector<Slot> m_uniform_table;
+	std::vector<Slot> m_attribute_table;
+};
+
+/** Query every active uniform and attribute of a linked program. */
+auto reflect(const Functions& gl, u32 program) -> ProgramReflection;
+
+} // namespace gfx
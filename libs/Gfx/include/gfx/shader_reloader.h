@@ -0,0 +1,103 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sized.h>
+
+#include "gfx/file_watcher.h"
+#include "gfx/program_builder.h"
+#include "gfx/shader_source.h"
+
+namespace gfx {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/**
+ * Programs built from shader files, rebuilt whenever one of their files
+ * changes on disk.
+ *
+ * Changes are reported by a `FileWatcher`. Only the files that changed are
+ * read again: the rest are parsed from memory. Programs are rebuilt through
+ * a `ProgramBuilder`, which only compiles the stages whose preprocessed
+ * source changed, and the new program replaces the old one in `update`,
+ * between frames, once it's ready. A program that fails to build leaves the
+ * previous one in place.
+ *
+ * When no files have changed, `update` costs one non-blocking `read`.
+ */
+class ShaderReloader {
+public:
+	/** Identifies a program for its whole life, across rebuilds. */
+	using Handle = u32;
+
+	/** A program that finished building in an `update`. */
+	struct Update {
+		Handle handle;
+		/** The program it replaces, now the caller's to delete, or zero. */
+		u32 replaced;
+		/** The new program, or zero if it failed. */
+		u32 program;
+		/** The compile and link errors, with file names, if it failed. */
+		std::string log;
+	};
+
+	/** `builder` must outlive the reloader. */
+	explicit ShaderReloader(ProgramBuilder& builder, ShaderSource::Reader read = read_file);
+
+	/** Watch a directory of shaders, returning whether it can. */
+	auto watch(const std::filesystem::path& directory) -> bool;
+
+	/** Start building a program from a shader file. Throws `ShaderError`. */
+	auto add(const std::filesystem::path& path) -> Handle;
+
+	/** The handle's current program, or `fallback` until one is ready. */
+	auto program(Handle handle, u32 fallback = 0) const -> u32;
+
+	/** Treat a file as changed, as if the watcher had reported it. */
+	void changed(const std::filesystem::path& path);
+
+	/**
+	 * Rebuild the programs whose files changed, and switch to the ones that
+	 * are ready. Call it between frames: the programs it returns replace
+	 * their handles' previous ones from then on.
+	 */
+	auto update() -> const std::vector<Update>&;
+
+	/** Programs still building. */
+	auto building() const -> usize { return m_building; }
+	auto watcher() const -> const FileWatcher& { return m_watcher; }
+
+private:
+	struct Entry {
+		std::filesystem::path path;
+		/** The source of `current`, and its build. */
+		std::optional<ShaderSource> source;
+		PendingProgram current;
+		/** The source of `next`, and its build while it's in progress. */
+		std::optional<ShaderSource> next_source;
+		PendingProgram next;
+		bool dirty = false;
+		/** Whether the last change left the file unparsable. */
+		bool unparsed = false;
+	};
+
+	/** Read a file, from memory if it hasn't changed since it was last read. */
+	auto read(const std::filesystem::path& path) -> std::optional<std::string>;
+	auto parse(const std::filesystem::path& path) -> ShaderSource;
+	void rebuild(Handle handle);
+
+	ProgramBuilder* m_builder;
+	ShaderSource::Reader m_read;
+	FileWatcher m_watcher;
+	std::vector<Entry> m_entries;
+	/** The contents of every file read, by normalized path. */
+	std::unordered_map<std::string, std::string> m_files;
+	std::vector<Update> m_updates;
+	usize m_building = 0;
+	bool m_dirty = false;
+};
+
+} // namespace gfx
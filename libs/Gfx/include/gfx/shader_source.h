@@ -0,0 +1,108 @@
+#pragma once
+
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <sized.h>
+
+namespace gfx {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/** The stages of a program, with the values of their GL shader types. */
+enum class ShaderStage : u32 {
+	Vertex = 0x8b31,
+	Fragment = 0x8b30,
+	Geometry = 0x8dd9,
+	TessControl = 0x8e88,
+	TessEval = 0x8e87,
+	Compute = 0x91b9,
+};
+
+/** The stage named by a `#shader` directive: `vertex`, `fragment`, `tessc`, etc. */
+auto shader_stage(std::string_view keyword) -> std::optional<ShaderStage>;
+
+/** Thrown when a shader file or one of its includes can't be read or parsed. */
+class ShaderError : public std::runtime_error {
+public:
+	using std::runtime_error::runtime_error;
+};
+
+/**
+ * A `.shader` file split into its stages, each introduced by a line like
+ * `#shader vertex`, with `#include "file"` directives expanded.
+ *
+ * Each file is read once, and scanned once, line by line, looking only at
+ * lines that start with a directive. Rather than copying the text into a
+ * string per stage, a stage is a list of slices of the files, which can be
+ * passed straight to `glShaderSource` as an array of strings.
+ *
+ * Includes are resolved relative to the including file, and each file is
+ * included at most once per stage. `#line` directives are inserted around
+ * them (after `#version`, which must come first) so that compiler errors refer
+ * to the right line of the right file: a GLSL source string number is the
+ * index of the file in `files`, and `annotate_log` replaces them with names.
+ */
+class ShaderSource {
+public:
+	/** Reads a whole file, or returns none if it can't. */
+	using Reader = std::function<auto (const std::filesystem::path&) -> std::optional<std::string>>;
+
+	struct Stage {
+		ShaderStage type;
+		std::vector<std::string_view> pieces;
+
+		/** The stage's source as one string. */
+		auto text() const -> std::string;
+	};
+
+	/** Parse a file, reading it and its includes from disk. Throws `ShaderError`. */
+	explicit ShaderSource(const std::filesystem::path& path);
+	/** Parse a file, reading it and its includes with `read`. Throws `ShaderError`. */
+	ShaderSource(const std::filesystem::path& path, const Reader& read);
+
+	ShaderSource(const ShaderSource&) = delete;
+	ShaderSource& operator=(const ShaderSource&) = delete;
+
+	// The pieces point into the file contents, which don't move with the object
+	ShaderSource(ShaderSource&&) noexcept = default;
+	ShaderSource& operator=(ShaderSource&&) noexcept = default;
+
+	auto stages() const -> const std::vector<Stage>& { return m_stages; }
+	auto find(ShaderStage type) const -> const Stage*;
+
+	/** Every file read, in the order they were first included. The first is the shader itself. */
+	auto files() const -> const std::vector<std::filesystem::path>& { return m_paths; }
+
+	/**
+	 * Replace the source string numbers in a compiler's info log with file
+	 * names, e.g. `1(12) : error` with `common.glsl(12) : error`.
+	 */
+	auto annotate_log(std::string_view log) const -> std::string;
+
+private:
+	struct Parser;
+
+	/** The file's index, reading it if it's new. */
+	auto file(const std::filesystem::path& path, const Reader& read) -> u32;
+	/** A `#line` directive, kept alive with the pieces that refer to it. */
+	auto line_directive(usize line, u32 file) -> std::string_view;
+
+	std::vector<std::filesystem::path> m_paths;
+	/** The contents of each file. A deque, so that they never move. */
+	std::deque<std::string> m_contents;
+	std::unordered_map<std::string, u32> m_indices;
+	std::deque<std::string> m_directives;
+	std::vector<Stage> m_stages;
+};
+
+/** Read a whole file in one go, or return none if it can't be opened. */
+auto read_file(const std::filesystem::path& path) -> std::optional<std::string>;
+
+} // namespace gfx
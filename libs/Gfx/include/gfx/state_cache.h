@@ -0,0 +1,135 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include <sized.h>
+
+#include "gfx/functions.h"
+
+namespace gfx {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/**
+ * Tracks the OpenGL binding state set through it, and skips any call that
+ * wouldn't change it: re-binding the bound buffer, vertex array or program, or
+ * re-uploading a uniform's current value.
+ *
+ * The cache can only know about state changed through it. After calling GL
+ * directly, making another context current, or anything else that may have
+ * changed bindings behind its back, call `invalidate`. Objects must also be
+ * forgotten when they're deleted (or, for programs, relinked), since GL resets
+ * their bindings and uniforms and may hand their names out again.
+ */
+class StateCache {
+public:
+	struct Counter {
+		/** Calls forwarded to GL. */
+		u64 issued = 0;
+		/** Calls elided because they wouldn't have changed anything. */
+		u64 skipped = 0;
+	};
+
+	struct Stats {
+		Counter buffers;
+		Counter vertex_arrays;
+		Counter programs;
+		Counter uniforms;
+		/** Draw calls, which are always issued. */
+		u64 draws = 0;
+		/** The instances drawn by those calls. */
+		u64 instances = 0;
+
+		/** The binding and uniform calls combined. */
+		auto total() const -> Counter;
+	};
+
+
+	explicit StateCache(const Functions& functions);
+
+	void bind_buffer(u32 target, u32 buffer);
+	/** Bind a whole buffer to an indexed binding point, e.g. of `k_uniform_buffer`. */
+	void bind_buffer_base(u32 target, u32 index, u32 buffer);
+	/** Bind `size` bytes of a buffer from `offset` to an indexed binding point. */
+	void bind_buffer_range(u32 target, u32 index, u32 buffer, usize offset, usize size);
+	void bind_vertex_array(u32 array);
+	void use_program(u32 program);
+
+	// Uniforms of the current program
+	void uniform_1f(i32 location, f32 v0);
+	void uniform_2f(i32 location, f32 v0, f32 v1);
+	void uniform_3f(i32 location, f32 v0, f32 v1, f32 v2);
+	void uniform_4f(i32 location, f32 v0, f32 v1, f32 v2, f32 v3);
+
+	void uniform_matrix_2fv(i32 location, i32 count, bool transpose, const f32* values);
+	void uniform_matrix_3fv(i32 location, i32 count, bool transpose, const f32* values);
+	void uniform_matrix_4fv(i32 location, i32 count, bool transpose, const f32* values);
+	void uniform_matrix_4x3fv(i32 location, i32 count, bool transpose, const f32* values);
+	void uniform_matrix_3x4fv(i32 location, i32 count, bool transpose, const f32* values);
+
+	void draw_elements(u32 mode, i32 count, u32 type, const void* indices);
+	void draw_elements_instanced(
+		u32 mode, i32 count, u32 type, const void* indices,
+		i32 instance_count, u32 base_instance = 0);
+
+	/** Forget a buffer that's being deleted. */
+	void forget_buffer(u32 buffer);
+	/** Forget a vertex array that's being deleted. */
+	void forget_vertex_array(u32 array);
+	/** Forget a program that's being deleted or relinked, with its uniforms. */
+	void forget_program(u32 program);
+
+	/** Forget everything, so that the next call of each kind is issued. */
+	void invalidate();
+
+	/** The underlying GL functions, for calls that don't touch cached state. */
+	auto functions() const -> const Functions& { return m_gl; }
+
+	auto stats() const -> const Stats& { return m_stats; }
+	void reset_stats() { m_stats = {}; }
+
+private:
+	static constexpr u32 k_unknown = 0xffff'ffff;
+
+	struct BufferBinding {
+		u32 target;
+		u32 buffer;
+	};
+
+	struct IndexedBinding {
+		u32 target;
+		u32 index;
+		u32 buffer;
+		usize offset;
+		/** Zero for the whole buffer. */
+		usize size;
+	};
+
+	/** A uniform's last value, prefixed by its transpose flag. Empty if unknown. */
+	using UniformValue = std::vector<u8>;
+
+	auto buffer_binding(u32 target) -> u32&;
+	auto indexed_binding(u32 target, u32 index) -> IndexedBinding&;
+	/** Record a uniform's new value, returning whether it differs from the old. */
+	auto update_uniform(i32 location, const void* data, usize size, bool transpose = false) -> bool;
+	/** Count a call, returning whether to issue it. */
+	static auto count(Counter& counter, bool changed) -> bool;
+
+	Functions m_gl;
+
+	std::vector<BufferBinding> m_buffers;
+	std::vector<IndexedBinding> m_indexed_buffers;
+	u32 m_vertex_array = k_unknown;
+	u32 m_program = k_unknown;
+
+	/** The element array binding of each vertex array it's known for. */
+	std::unordered_map<u32, u32> m_element_buffers;
+
+	std::unordered_map<u32, std::vector<UniformValue>> m_uniforms;
+	/** The uniforms of `m_program`, or `nullptr` if it's unknown or zero. */
+	std::vector<UniformValue>* m_current_uniforms = nullptr;
+
+	Stats m_stats;
+};
+
+} // namespace gfx
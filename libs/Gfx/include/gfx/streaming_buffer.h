@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+
+#include <sized.h>
+
+#include "gfx/state_cache.h"
+
+namespace gfx {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/**
+ * A ring of per-frame regions in one persistently mapped buffer, for data the
+ * CPU generates every frame (particles, skinned vertices, debug lines, uniform
+ * blocks). The data is written straight into mapped memory, with no copies or
+ * driver allocations.
+ *
+ * The buffer is created with `glBufferStorage`, mapped once for coherent
+ * writes, and split into `k_frame_count` regions. Each frame writes to the next
+ * region, and a fence at the end of the frame marks when the GPU is done with
+ * it; `begin_frame` only blocks if the GPU is still reading the region from
+ * `k_frame_count` frames ago.
+ *
+ * Requires OpenGL 4.4 or `ARB_buffer_storage`.
+ */
+class StreamingBuffer {
+public:
+	static constexpr usize k_frame_count = 3;
+
+	struct Allocation {
+		/** Where to write the data. */
+		void* data;
+		/** The data's byte offset from the start of the buffer. */
+		usize offset;
+	};
+
+	struct Stats {
+		/** Fences that had to be waited for. */
+		u64 stalls = 0;
+		/** Frames begun. */
+		u64 frames = 0;
+	};
+
+
+	/** Create a buffer for `target` with `frame_size` bytes per frame. */
+	StreamingBuffer(StateCache& state, u32 target, usize frame_size);
+	~StreamingBuffer();
+
+	StreamingBuffer(const StreamingBuffer&) = delete;
+	StreamingBuffer& operator=(const StreamingBuffer&) = delete;
+
+	StreamingBuffer(StreamingBuffer&& other) noexcept;
+	StreamingBuffer& operator=(StreamingBuffer&& other) noexcept;
+
+	/**
+	 * Move on to the next frame's region, waiting until the GPU has finished
+	 * reading it if necessary. Throws `std::runtime_error` if the wait fails.
+	 */
+	void begin_frame();
+
+	/**
+	 * Reserve `size` bytes of the current frame's region. `alignment` needn't
+	 * be a power of two, so that it can be a vertex stride. Throws
+	 * `std::length_error` if the region is full.
+	 */
+	auto allocate(usize size, usize alignment = 16) -> Allocation;
+
+	/** Fence the current region, after submitting every draw that reads it. */
+	void end_frame();
+
+	auto id() const -> u32 { return m_buffer; }
+	auto frame_size() const -> usize { return m_frame_size; }
+	/** The bytes allocated in the current frame. */
+	auto used() const -> usize { return m_used; }
+	auto stats() const -> const Stats& { return m_stats; }
+
+private:
+	void release();
+
+	StateCache* m_state;
+	u32 m_target;
+	u32 m_buffer = 0;
+	u8* m_mapped = nullptr;
+	usize m_frame_size;
+
+	std::array<void*, k_frame_count> m_fences {};
+	usize m_frame = k_frame_count - 1;
+	usize m_used = 0;
+
+	Stats m_stats;
+};
+
+} // namespace gfx
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <math/matrix.h>
+#include <math/vector.h>
+#include <sized.h>
+
+/**
+ * Compile-time layouts of GLSL interface blocks, for filling uniform (and
+ * shader storage) buffers from math types with a single write.
+ *
+ * A block is described by its member types, in declaration order:
+ *
+ *     // layout(std140) uniform Frame { mat4 view; vec3 light; float time; };
+ *     using FrameBlock = gfx::Std140<Mat4x4, Vec3, f32>;
+ *
+ *     auto bytes = FrameBlock::pack(view, light, time);
+ *     ubo.set_data(bytes.data(), FrameBlock::size);
+ *
+ * Supported members are `f32`/`flt` (written as `float`), `i32`, `u32`,
+ * `Vec2`-`Vec4`, every `Matrix<R,C>` and `std::array`s of any of them.
+ * Components are always written as `f32`, whatever the precision of `flt`.
+ *
+ * Matrices are written a row per GLSL column, the same way `gl::uniform`
+ * passes them untransposed, so `Matrix<R,C>` is a GLSL `matRxC` and a shader
+ * multiplies by it on the left: `view * position` applies `position * view`.
+ */
+namespace gfx {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/** The `layout` qualifier of a block. */
+enum class Packing : u8 {
+	/** Required for uniform blocks; array elements and matrix columns are padded to 16 bytes. */
+	Std140,
+	/** Shader storage blocks only; arrays are padded only to their element's alignment. */
+	Std430,
+};
+
+constexpr auto align_up(usize value, usize alignment) -> usize
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+
+// Member rules ----------------------------------------------------------------
+
+/**
+ * The base alignment and size of a block member of type `T`, and how to write
+ * it. Only specialized for supported types.
+ */
+template <Packing P, typename T, typename = void>
+struct BlockMember;
+
+template <Packing P, typename T>
+struct BlockMember<P, T, std::enable_if_t<std::is_arithmetic_v<T>>> {
+	static_assert(sizeof(T) <= 4 || std::is_floating_point_v<T>, "Expected a 32-bit scalar");
+
+	static constexpr usize alignment = 4;
+	static constexpr usize size = 4;
+
+	static void write(u8* dest, T value)
+	{
+		if constexpr (std::is_floating_point_v<T>) {
+			auto component = static_cast<f32>(value);
+			std::memcpy(dest, &component, sizeof(component));
+		}
+		else if constexpr (std::is_signed_v<T>) {
+			auto component = static_cast<i32>(value);
+			std::memcpy(dest, &component, sizeof(component));
+		}
+		else {
+			auto component = static_cast<u32>(value);
+			std::memcpy(dest, &component, sizeof(component));
+		}
+	}
+};
+
+template <Packing P, usize D>
+struct BlockMember<P, math::Vector<D>> {
+	static_assert(D >= 2 && D <= 4, "Expected a 2-, 3- or 4-component vector");
+
+	/** A `vec3` is aligned like a `vec4`, but a following scalar can fill its last slot. */
+	static constexpr usize alignment = D == 2 ? 8 : 16;
+	static constexpr usize size = D * 4;
+
+	static void write(u8* dest, const math::Vector<D>& value)
+	{
+		for (usize i = 0; i < D; ++i)
+			BlockMember<P, flt>::write(dest + i * 4, value[i]);
+	}
+};
+
+template <Packing P, typename T, usize N>
+struct BlockMember<P, std::array<T,N>> {
+	using Element = BlockMember<P,T>;
+
+	static constexpr usize alignment = P == Packing::Std140
+		? align_up(Element::alignment, 16)
+		: Element::alignment;
+	static constexpr usize stride = align_up(Element::size, alignment);
+	static constexpr usize size = N * stride;
+
+	static void write(u8* dest, const std::array<T,N>& value)
+	{
+		for (usize i = 0; i < N; ++i)
+			Element::write(dest + i * stride, value[i]);
+	}
+};
+
+/** Laid out as an array of its rows, which are the GLSL matrix's columns. */
+template <Packing P, usize R, usize C>
+struct BlockMember<P, math::Matrix<R,C>> {
+	using Column = BlockMember<P, std::array<math::Vector<C>, R>>;
+
+	static constexpr usize alignment = Column::alignment;
+	static constexpr usize stride = Column::stride;
+	static constexpr usize size = Column::size;
+
+	static void write(u8* dest, const math::Matrix<R,C>& value)
+	{
+		for (usize row = 0; row < R; ++row)
+			BlockMember<P, math::Vector<C>>::write(dest + row * stride, value[row]);
+	}
+};
+
+
+// Blocks ----------------------------------------------------------------------
+
+/**
+ * The layout of a block whose members have the types `Members`, in order.
+ * Everything but writing is computed at compile time.
+ */
+template <Packing P, typename... Members>
+class BlockLayout {
+public:
+	static_assert(sizeof...(Members) > 0, "Expected at least one member");
+
+	template <usize I>
+	using Member = std::tuple_element_t<I, std::tuple<Members...>>;
+
+	static constexpr usize count = sizeof...(Members);
+
+	/** The byte offset of each member from the start of the block. */
+	static constexpr std::array<usize, count> offsets = [] {
+		auto result = std::array<usize, count>();
+		usize end = 0;
+		usize i = 0;
+		((end = align_up(end, BlockMember<P,Members>::alignment),
+			result[i++] = end,
+			end += BlockMember<P,Members>::size), ...);
+		return result;
+	}();
+
+	/** The base alignment of the block, as if it were a member of a struct. */
+	static constexpr usize alignment = [] {
+		usize result = P == Packing::Std140 ? 16 : 0;
+		((result = std::max(result, BlockMember<P,Members>::alignment)), ...);
+		return result;
+	}();
+
+	/** The size of the block's buffer storage, including trailing padding. */
+	static constexpr usize size = align_up(
+		offsets[count - 1] + BlockMember<P, Member<count - 1>>::size,
+		alignment);
+
+	/** Write every member to `dest`, which must hold `size` bytes. Padding is left untouched. */
+	static void write(void* dest, const Members&... members)
+	{
+		write_all(static_cast<u8*>(dest), std::index_sequence_for<Members...>{}, members...);
+	}
+
+	/** Write just the member at index `I` to the block at `dest`. */
+	template <usize I>
+	static void write_member(void* dest, const Member<I>& value)
+	{
+		BlockMember<P, Member<I>>::write(static_cast<u8*>(dest) + offsets[I], value);
+	}
+
+	/** Write every member to a new zeroed block. */
+	static auto pack(const Members&... members) -> std::array<u8, size>
+	{
+		auto result = std::array<u8, size>();
+		write(result.data(), members...);
+		return result;
+	}
+
+private:
+	template <usize... I>
+	static void write_all(u8* dest, std::index_sequence<I...> /*indices*/, const Members&... members)
+	{
+		(BlockMember<P,Members>::write(dest + offsets[I], members), ...);
+	}
+};
+
+template <typename... Members>
+using Std140 = BlockLayout<Packing::Std140, Members...>;
+
+template <typename... Members>
+using Std430 = BlockLayout<Packing::Std430, Members...>;
+
+} // namespace gfx
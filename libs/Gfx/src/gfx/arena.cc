@@ -0,0 +1,74 @@
+#include "gfx/arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+
+namespace gfx {
+
+Arena::Arena(usize block_size)
+	: m_block_size(block_size)
+{}
+
+auto Arena::allocate(usize size, usize alignment) -> void*
+{
+	auto try_block = [&](Block& block) -> void* {
+		auto base = reinterpret_cast<uintptr_t>(block.data.get()); // NOLINT
+		auto aligned = (base + m_offset + alignment - 1) & ~(uintptr_t(alignment) - 1);
+		auto end = aligned - base + size;
+
+		if (end > block.size)
+			return nullptr;
+
+		m_offset = end;
+		return reinterpret_cast<void*>(aligned); // NOLINT
+	};
+
+	if (m_current < m_blocks.size())
+		if (void* result = try_block(m_blocks[m_current]))
+			return result;
+
+	// Move on to the next block, reusing it if it's big enough
+	while (!m_blocks.empty() && m_current + 1 < m_blocks.size()) {
+		m_used_before += m_offset;
+		m_offset = 0;
+		++m_current;
+
+		if (void* result = try_block(m_blocks[m_current]))
+			return result;
+	}
+
+	if (!m_blocks.empty()) {
+		m_used_before += m_offset;
+		m_offset = 0;
+		m_current = m_blocks.size();
+	}
+
+	usize block_size = std::max(m_block_size, size + alignment);
+	m_blocks.push_back({ std::make_unique<u8[]>(block_size), block_size });
+
+	return try_block(m_blocks.back());
+}
+
+void Arena::reset()
+{
+	m_current = 0;
+	m_offset = 0;
+	m_used_before = 0;
+}
+
+auto Arena::used() const -> usize
+{
+	return m_used_before + m_offset;
+}
+
+auto Arena::capacity() const -> usize
+{
+	usize result = 0;
+	for (const auto& block : m_blocks)
+		result += block.size;
+
+	return result;
+}
+
+} // namespace gfx
@@ -0,0 +1,179 @@
+#include "gfx/draw_queue.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+
+namespace gfx {
+
+namespace {
+
+constexpr u32 k_radix_bits = 11;
+constexpr u32 k_radix_size = 1u << k_radix_bits;
+
+/**
+ * Stable LSD radix sort of `keys` by their bits from `first_bit` up, in passes
+ * of `k_radix_bits`. Passes where every key has the same digit are skipped.
+ * The result ends up in `keys`.
+ */
+void radix_sort(std::vector<u64>& keys, std::vector<u64>& scratch, u32 first_bit)
+{
+	scratch.resize(keys.size());
+	auto counts = std::array<usize, k_radix_size>();
+
+	for (u32 shift = first_bit; shift < 64; shift += k_radix_bits) {
+		counts.fill(0);
+		for (u64 key : keys)
+			++counts[(key >> shift) & (k_radix_size - 1)];
+
+		if (std::any_of(counts.begin(), counts.end(), [&](usize count) { return count == keys.size(); }))
+			continue;
+
+		usize offset = 0;
+		for (auto& count : counts) {
+			usize n = count;
+			count = offset;
+			offset += n;
+		}
+
+		for (u64 key : keys)
+			scratch[counts[(key >> shift) & (k_radix_size - 1)]++] = key;
+
+		keys.swap(scratch);
+	}
+}
+
+void apply(StateCache& state, i32 location, UniformType type, const f32* v, i32 count, bool transpose)
+{
+	switch (type) {
+		case UniformType::F1: state.uniform_1f(location, v[0]); break;
+		case UniformType::F2: state.uniform_2f(location, v[0], v[1]); break;
+		case UniformType::F3: state.uniform_3f(location, v[0], v[1], v[2]); break;
+		case UniformType::F4: state.uniform_4f(location, v[0], v[1], v[2], v[3]); break;
+		case UniformType::Mat2: state.uniform_matrix_2fv(location, count, transpose, v); break;
+		case UniformType::Mat3: state.uniform_matrix_3fv(location, count, transpose, v); break;
+		case UniformType::Mat4: state.uniform_matrix_4fv(location, count, transpose, v); break;
+		case UniformType::Mat4x3: state.uniform_matrix_4x3fv(location, count, transpose, v); break;
+		case UniformType::Mat3x4: state.uniform_matrix_3x4fv(location, count, transpose, v); break;
+	}
+}
+
+} // namespace
+
+
+DrawQueue::DrawQueue(usize arena_block_size)
+	: m_arena(arena_block_size)
+{}
+
+void DrawQueue::push(const DrawItem& item)
+{
+	if (m_commands.size() == k_max_draws)
+		throw std::length_error("Too many draws in the queue");
+
+	m_keys.push_back(sort_key(item, static_cast<u32>(m_commands.size())));
+	m_commands.push_back({ item });
+}
+
+void DrawQueue::uniform(i32 location, UniformType type, const f32* values, i32 count, bool transpose)
+{
+	if (m_commands.empty())
+		throw std::logic_error("Uniforms must follow the draw they're for");
+
+	// Keep the values right after the uniform, to touch fewer cache lines when
+	// replaying in sorted order
+	usize size = component_count(type) * static_cast<usize>(count) * sizeof(f32);
+	auto* memory = static_cast<u8*>(m_arena.allocate(sizeof(UniformValue) + size, alignof(UniformValue)));
+
+	auto* copy = reinterpret_cast<f32*>(memory + sizeof(UniformValue)); // NOLINT
+	std::memcpy(copy, values, size);
+
+	auto* uniform = new (memory) UniformValue{ nullptr, copy, location, count, type, transpose };
+
+	auto& command = m_commands.back();
+	if (command.last_uniform)
+		command.last_uniform->next = uniform;
+	else
+		command.first_uniform = uniform;
+
+	command.last_uniform = uniform;
+}
+
+void DrawQueue::sort()
+{
+	// The index bits are in recording order already, and the sort is stable
+	radix_sort(m_keys, m_scratch, k_index_bits);
+}
+
+void DrawQueue::submit(DrawBackend& backend) const
+{
+	constexpr u64 index_mask = k_max_draws - 1;
+
+	for (u64 key : m_keys) {
+		const auto& command = m_commands[key & index_mask];
+		backend.draw(command.item, command.first_uniform);
+	}
+}
+
+void DrawQueue::submit(StateCache& state) const
+{
+	auto backend = GlBackend(state);
+	submit(backend);
+}
+
+void DrawQueue::clear()
+{
+	m_commands.clear();
+	m_keys.clear();
+	m_arena.reset();
+}
+
+auto DrawQueue::sort_key(const DrawItem& item, u32 index) -> u64
+{
+	f32 depth = std::clamp(item.depth, 0.f, 1.f);
+	auto depth_bits = static_cast<u64>(depth * 0xffff + 0.5f);
+
+	u64 layer = item.layer & 0xf;
+	u64 program = item.program & 0xfff;
+	u64 vertex_array = item.vertex_array & 0xfff;
+
+	u64 result;
+	if (item.back_to_front)
+		result = layer << 60 | (0xffff - depth_bits) << 44 | program << 32 | vertex_array << 20;
+	else
+		result = layer << 60 | program << 48 | vertex_array << 36 | depth_bits << 20;
+
+	return result | (index & (k_max_draws - 1));
+}
+
+
+// OpenGL ----------------------------------------------------------------------
+
+void GlBackend::draw(const DrawItem& item, const UniformValue* uniforms)
+{
+	auto& state = *m_state;
+
+	state.use_program(item.program);
+	state.bind_vertex_array(item.vertex_array);
+	if (item.index_buffer != 0)
+		state.bind_buffer(k_element_array_buffer, item.index_buffer);
+	if (item.block_buffer != 0)
+		state.bind_buffer_range(
+			k_uniform_buffer, item.block_binding, item.block_buffer,
+			item.block_offset, item.block_size);
+
+	for (const auto* u = uniforms; u; u = u->next)
+		apply(state, u->location, u->type, u->values, u->count, u->transpose);
+
+	const auto* indices = reinterpret_cast<const void*>(item.offset); // NOLINT
+	if (item.instance_count == 1 && item.base_instance == 0)
+		state.draw_elements(item.mode, item.count, item.index_type, indices);
+	else
+		state.draw_elements_instanced(
+			item.mode, item.count, item.index_type, indices,
+			item.instance_count, item.base_instance);
+}
+
+} // namespace gfx
@@ -0,0 +1,157 @@
+#include "gfx/file_watcher.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <system_error>
+#include <utility>
+
+#ifdef __linux__
+	#include <fcntl.h>
+	#include <sys/inotify.h>
+	#include <unistd.h>
+#endif
+
+
+namespace gfx {
+namespace fs = std::filesystem;
+
+#ifdef __linux__
+
+namespace {
+
+constexpr u32 k_file_events = IN_CLOSE_WRITE | IN_MOVED_TO;
+constexpr u32 k_directory_events = IN_CREATE | IN_MOVED_TO;
+
+} // namespace
+
+#endif
+
+
+FileWatcher::FileWatcher()
+{
+#ifdef __linux__
+	m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+	release();
+}
+
+FileWatcher::FileWatcher(FileWatcher&& other) noexcept
+	: m_fd(std::exchange(other.m_fd, -1))
+	, m_directories(std::move(other.m_directories))
+	, m_changed(std::move(other.m_changed))
+{}
+
+auto FileWatcher::operator=(FileWatcher&& other) noexcept -> FileWatcher&
+{
+	if (this != &other) {
+		release();
+		m_fd = std::exchange(other.m_fd, -1);
+		m_directories = std::move(other.m_directories);
+		m_changed = std::move(other.m_changed);
+	}
+
+	return *this;
+}
+
+void FileWatcher::release()
+{
+#ifdef __linux__
+	// Closing the descriptor removes its watches
+	if (m_fd >= 0)
+		close(m_fd);
+#endif
+
+	m_fd = -1;
+	m_directories.clear();
+}
+
+auto FileWatcher::watch(const fs::path& directory) -> bool
+{
+	auto error = std::error_code();
+	if (!add(directory))
+		return false;
+
+	for (const auto& entry : fs::recursive_directory_iterator(directory, error))
+		if (entry.is_directory(error))
+			add(entry.path());
+
+	return true;
+}
+
+auto FileWatcher::add(const fs::path& directory) -> bool
+{
+#ifdef __linux__
+	if (m_fd < 0)
+		return false;
+
+	auto path = directory.lexically_normal();
+	i32 wd = inotify_add_watch(m_fd, path.c_str(), k_file_events | k_directory_events | IN_ONLYDIR);
+	if (wd < 0)
+		return false;
+
+	m_directories.insert_or_assign(wd, std::move(path));
+	return true;
+#else
+	(void)directory;
+	return false;
+#endif
+}
+
+auto FileWatcher::poll() -> const std::vector<fs::path>&
+{
+	m_changed.clear();
+
+#ifdef __linux__
+	if (m_fd < 0)
+		return m_changed;
+
+	auto report = [&](fs::path path) {
+		if (std::find(m_changed.begin(), m_changed.end(), path) == m_changed.end())
+			m_changed.push_back(std::move(path));
+	};
+
+	alignas(inotify_event) std::array<char, 4096> buffer;
+	for (;;) {
+		auto result = read(m_fd, buffer.data(), buffer.size());
+		if (result <= 0)
+			break;
+
+		auto length = static_cast<usize>(result);
+		for (usize offset = 0; offset < length; ) {
+			inotify_event event;
+			std::memcpy(&event, buffer.data() + offset, sizeof(event));
+			const char* name = buffer.data() + offset + sizeof(event);
+			offset += sizeof(event) + event.len;
+
+			auto it = m_directories.find(event.wd);
+			if (it == m_directories.end() || event.len == 0)
+				continue;
+
+			auto path = it->second / name;
+			if (event.mask & IN_ISDIR) {
+				// Files may be written to a new directory before it's watched,
+				// so report every file already in it
+				watch(path);
+
+				auto error = std::error_code();
+				for (const auto& entry : fs::recursive_directory_iterator(path, error))
+					if (entry.is_regular_file(error))
+						report(entry.path());
+				continue;
+			}
+
+			if (event.mask & k_file_events)
+				report(std::move(path));
+		}
+	}
+#endif
+
+	return m_changed;
+}
+
+} // namespace gfx
@@ -0,0 +1,106 @@
+#include "gfx/instancing.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+
+namespace gfx {
+
+InstanceBatcher::InstanceBatcher(usize components)
+	: m_components(components)
+{}
+
+void InstanceBatcher::add(const DrawItem& item, const f32* instance)
+{
+	// Blended draws must stay in depth order with every other blended draw, so
+	// each one is drawn on its own
+	u32 index = static_cast<u32>(m_batches.size());
+	if (item.back_to_front) {
+		m_batches.push_back({ item });
+	}
+	else {
+		auto [it, inserted] = m_lookup.try_emplace(item, index);
+		if (inserted)
+			m_batches.push_back({ item });
+
+		index = it->second;
+		m_batches[index].item.depth = std::min(m_batches[index].item.depth, item.depth);
+	}
+	++m_batches[index].instance_count;
+
+	m_groups_of_instances.push_back(index);
+	m_instances.insert(m_instances.end(), instance, instance + m_components);
+}
+
+void InstanceBatcher::build(DrawQueue& queue, u32 first_instance)
+{
+	// Counting sort of the instances by batch
+	m_offsets.assign(m_batches.size(), 0);
+
+	u32 offset = 0;
+	for (usize i = 0; i < m_batches.size(); ++i) {
+		auto item = m_batches[i].item;
+		item.instance_count = static_cast<i32>(m_batches[i].instance_count);
+		item.base_instance = first_instance + offset;
+		queue.push(item);
+
+		m_offsets[i] = offset;
+		offset += m_batches[i].instance_count;
+	}
+
+	m_gathered.resize(m_instances.size());
+	for (usize i = 0; i < m_groups_of_instances.size(); ++i) {
+		u32 slot = m_offsets[m_groups_of_instances[i]]++;
+		std::memcpy(
+			&m_gathered[slot * m_components],
+			&m_instances[i * m_components],
+			m_components * sizeof(f32));
+	}
+}
+
+void InstanceBatcher::clear()
+{
+	m_lookup.clear();
+	m_batches.clear();
+	m_instances.clear();
+	m_groups_of_instances.clear();
+	m_gathered.clear();
+}
+
+auto InstanceBatcher::KeyHash::operator()(const DrawItem& item) const -> usize
+{
+	usize result = 0;
+	auto combine = [&](u64 value) {
+		result ^= std::hash<u64>{}(value) + 0x9e3779b97f4a7c15 + (result << 6) + (result >> 2);
+	};
+
+	combine(u64(item.program) << 32 | item.vertex_array);
+	combine(u64(item.index_buffer) << 32 | item.mode);
+	combine(u64(static_cast<u32>(item.count)) << 32 | item.index_type);
+	combine(item.offset);
+	combine(u64(item.block_buffer) << 32 | item.block_binding);
+	combine(u64(item.block_offset) << 32 | item.block_size);
+	combine(u64(item.layer) << 1 | u64(item.back_to_front));
+
+	return result;
+}
+
+auto InstanceBatcher::KeyEqual::operator()(const DrawItem& lhs, const DrawItem& rhs) const -> bool
+{
+	return lhs.program == rhs.program
+		&& lhs.vertex_array == rhs.vertex_array
+		&& lhs.index_buffer == rhs.index_buffer
+		&& lhs.mode == rhs.mode
+		&& lhs.count == rhs.count
+		&& lhs.index_type == rhs.index_type
+		&& lhs.offset == rhs.offset
+		&& lhs.block_buffer == rhs.block_buffer
+		&& lhs.block_binding == rhs.block_binding
+		&& lhs.block_offset == rhs.block_offset
+		&& lhs.block_size == rhs.block_size
+		&& lhs.layer == rhs.layer
+		&& lhs.back_to_front == rhs.back_to_front;
+}
+
+} // namespace gfx
@@ -0,0 +1,238 @@
+#include "gfx/program_builder.h"
+
+#include <algorithm>
+#include <utility>
+
+
+namespace gfx {
+
+auto PendingProgram::log() const -> const std::string&
+{
+	static const auto empty = std::string();
+	return m_build ? m_build->log : empty;
+}
+
+
+ProgramBuilder::ProgramBuilder(StateCache& state, bool parallel, ProgramCache* cache)
+	: m_state(&state)
+	, m_parallel(parallel)
+	, m_cache(cache)
+{}
+
+ProgramBuilder::~ProgramBuilder()
+{
+	if (!m_state)
+		return;
+
+	// Abandon whatever is still building
+	const auto& gl = m_state->functions();
+	for (auto& build : m_pending) {
+		build->shaders.clear();
+		build->previous.clear();
+
+		gl.delete_program(build->program);
+		build->program = 0;
+		build->status = BuildStatus::Failed;
+		build->log = "The program builder was destroyed";
+	}
+}
+
+auto ProgramBuilder::submit(const ShaderSource& source, bool keep_shaders) -> PendingProgram
+{
+	auto build = std::make_shared<Build>();
+	build->keep_shaders = keep_shaders;
+
+	return start(source, std::move(build));
+}
+
+auto ProgramBuilder::rebuild(const ShaderSource& source, const PendingProgram& previous) -> PendingProgram
+{
+	auto build = std::make_shared<Build>();
+	build->keep_shaders = true;
+	if (previous.m_build)
+		build->previous = previous.m_build->shaders;
+
+	return start(source, std::move(build));
+}
+
+auto ProgramBuilder::start(const ShaderSource& source, std::shared_ptr<Build> build) -> PendingProgram
+{
+	const auto& gl = m_state->functions();
+
+	for (const auto& stage : source.stages())
+		build->stages.emplace_back(stage.type, stage.text());
+
+	if (m_cache) {
+		auto stages = std::vector<std::pair<u32, std::string_view>>();
+		for (const auto& [type, text] : build->stages)
+			stages.emplace_back(static_cast<u32>(type), text);
+
+		build->key = ProgramCache::key(std::move(stages));
+
+		// Loading a binary may still take the driver a while, so it's polled
+		// like a link
+		if (auto binary = m_cache->load(build->key)) {
+			build->program = gl.create_program();
+			build->from_cache = true;
+			gl.program_binary(
+				build->program, binary->format,
+				binary->data.data(), static_cast<i32>(binary->data.size()));
+		}
+	}
+
+	if (!build->from_cache)
+		compile(*build);
+
+	m_pending.push_back(build);
+	return PendingProgram(std::move(build));
+}
+
+auto ProgramBuilder::poll() -> usize
+{
+	const auto& gl = m_state->functions();
+	usize finished = 0;
+	// Without parallel compilation, asking for the status waits for it, so
+	// only one build may wait per poll, even if it then has to recompile
+	bool waited = false;
+
+	for (usize i = 0; i < m_pending.size(); ) {
+		auto& build = *m_pending[i];
+
+		bool done = m_parallel
+			? gl.get_program_iv(build.program, k_completion_status) != 0
+			: !std::exchange(waited, true);
+
+		if (!done || !complete(build)) {
+			++i;
+			continue;
+		}
+
+		++finished;
+		if (m_pending[i].use_count() == 1 && build.program != 0)
+			gl.delete_program(build.program);
+
+		m_pending.erase(m_pending.begin() + static_cast<std::ptrdiff_t>(i));
+	}
+
+	return finished;
+}
+
+void ProgramBuilder::finish()
+{
+	while (!m_pending.empty()) {
+		auto& build = *m_pending.front();
+		if (!complete(build))
+			continue;
+
+		if (m_pending.front().use_count() == 1 && build.program != 0)
+			m_state->functions().delete_program(build.program);
+
+		m_pending.erase(m_pending.begin());
+	}
+}
+
+void ProgramBuilder::compile(Build& build)
+{
+	const auto& gl = m_state->functions();
+
+	build.program = gl.create_program();
+	for (const auto& [type, text] : build.stages) {
+		u64 hash = hash64(text, static_cast<u64>(type));
+
+		auto reused = std::find_if(build.previous.begin(), build.previous.end(),
+			[&](const auto& stage) { return stage->hash == hash; });
+		if (reused != build.previous.end()) {
+			gl.attach_shader(build.program, (*reused)->shader);
+			build.shaders.push_back(*reused);
+			continue;
+		}
+
+		u32 shader = gl.create_shader(static_cast<u32>(type));
+		const char* string = text.c_str();
+		auto length = static_cast<i32>(text.size());
+
+		gl.shader_source(shader, 1, &string, &length);
+		gl.compile_shader(shader);
+		gl.attach_shader(build.program, shader);
+		build.shaders.push_back(std::make_shared<detail::CompiledStage>(gl, shader, hash));
+	}
+
+	if (m_cache)
+		gl.program_parameter_i(build.program, k_program_binary_retrievable_hint, 1);
+
+	// Linking straight away lets the driver chain it after the compiles,
+	// without waiting for them here
+	gl.link_program(build.program);
+}
+
+auto ProgramBuilder::complete(Build& build) -> bool
+{
+	const auto& gl = m_state->functions();
+	bool linked = gl.get_program_iv(build.program, k_link_status) != 0;
+
+	if (build.from_cache && !linked) {
+		// The driver rejected the binary, so build it from source after all
+		m_cache->remove(build.key);
+		gl.delete_program(build.program);
+		build.from_cache = false;
+		compile(build);
+		return false;
+	}
+
+	if (linked && m_cache && !build.from_cache) {
+		auto binary = ProgramBinary();
+		binary.data.resize(static_cast<usize>(gl.get_program_iv(build.program, k_program_binary_length)));
+
+		i32 length = 0;
+		gl.get_program_binary(
+			build.program, static_cast<i32>(binary.data.size()),
+			&length, &binary.format, binary.data.data());
+		binary.data.resize(static_cast<usize>(length));
+
+		m_cache->store(build.key, binary);
+	}
+
+	if (!linked) {
+		for (const auto& stage : build.shaders)
+			if (gl.get_shader_iv(stage->shader, k_compile_status) == 0)
+				build.log += info_log(stage->shader, false);
+
+		build.log += info_log(build.program, true);
+		gl.delete_program(build.program);
+		build.program = 0;
+	}
+
+	// Attached shaders are only flagged for deletion, and go with the program
+	if (!linked || !build.keep_shaders)
+		build.shaders.clear();
+
+	// The name may be a deleted program's, whose uniforms the cache still holds
+	if (linked)
+		m_state->forget_program(build.program);
+
+	build.stages.clear();
+	build.previous.clear();
+	build.status = linked ? BuildStatus::Ready : BuildStatus::Failed;
+
+	return true;
+}
+
+auto ProgramBuilder::info_log(u32 object, bool is_program) const -> std::string
+{
+	const auto& gl = m_state->functions();
+
+	i32 length = is_program
+		? gl.get_program_iv(object, k_info_log_length)
+		: gl.get_shader_iv(object, k_info_log_length);
+
+	auto result = std::string(static_cast<usize>(std::max(length, 0)), '\0');
+	if (is_program)
+		gl.get_program_info_log(object, length, &length, result.data());
+	else
+		gl.get_shader_info_log(object, length, &length, result.data());
+
+	result.resize(static_cast<usize>(std::max(length, 0)));
+	return result;
+}
+
+} // namespace gfx
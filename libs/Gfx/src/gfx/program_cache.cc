@@ -0,0 +1,179 @@
+#include "gfx/program_cache.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+
+#include <fmt/format.h>
+
+
+namespace gfx {
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr std::array<char,4> k_magic { 'P', 'G', 'M', 'B' };
+constexpr u32 k_version = 1;
+
+/** Every entry file starts with this, followed by `size` bytes of binary. */
+struct Header {
+	std::array<char,4> magic = k_magic;
+	u32 version = k_version;
+	u32 format = 0;
+	u32 reserved = 0;
+	u64 key = 0;
+	u64 driver = 0;
+	u64 size = 0;
+	/** `hash64` of the binary, to catch truncated or damaged files. */
+	u64 checksum = 0;
+};
+
+auto checksum(const std::vector<u8>& data) -> u64
+{
+	return hash64({ reinterpret_cast<const char*>(data.data()), data.size() }); // NOLINT
+}
+
+} // namespace
+
+
+auto hash64(std::string_view data, u64 seed) -> u64
+{
+	u64 result = seed;
+	for (char c : data) {
+		result ^= static_cast<u8>(c);
+		result *= 0x0000'0100'0000'01b3;
+	}
+
+	return result;
+}
+
+
+ProgramCache::ProgramCache(fs::path directory, std::string_view driver)
+	: m_directory(std::move(directory))
+	, m_driver(hash64(driver))
+{
+	auto error = std::error_code();
+	fs::create_directories(m_directory, error);
+
+	// Other drivers' binaries (and unfinished writes) will never load again
+	auto prefix = fmt::format("{:016x}-", m_driver);
+	for (const auto& entry : fs::directory_iterator(m_directory, error)) {
+		auto name = entry.path().filename().string();
+		auto extension = entry.path().extension();
+
+		bool is_entry = extension == ".bin" || extension == ".tmp";
+		bool is_current = name.compare(0, prefix.size(), prefix) == 0 && extension == ".bin";
+		if (is_entry && !is_current)
+			fs::remove(entry.path(), error);
+	}
+}
+
+auto ProgramCache::key(std::vector<std::pair<u32, std::string_view>> stages) -> u64
+{
+	std::sort(stages.begin(), stages.end());
+
+	u64 result = hash64("");
+	for (const auto& [type, source] : stages) {
+		// Hash the lengths too, so that no two different sets of stages can
+		// produce the same stream of bytes
+		auto prefix = fmt::format("{:x}:{:x}:", type, source.size());
+		result = hash64(source, hash64(prefix, result));
+	}
+
+	return result;
+}
+
+auto ProgramCache::load(u64 key) -> std::optional<ProgramBinary>
+{
+	auto file_path = path(key);
+	auto file = std::ifstream(file_path, std::ios::binary);
+	if (!file) {
+		++m_stats.misses;
+		return std::nullopt;
+	}
+
+	auto header = Header();
+	auto result = ProgramBinary();
+
+	file.read(reinterpret_cast<char*>(&header), sizeof(header)); // NOLINT
+	bool valid = file
+		&& header.magic == k_magic
+		&& header.version == k_version
+		&& header.key == key
+		&& header.driver == m_driver;
+
+	// Check the size against the file before trusting it with an allocation
+	if (valid) {
+		auto error = std::error_code();
+		auto file_size = fs::file_size(file_path, error);
+		valid = !error && file_size >= sizeof(header) && header.size == file_size - sizeof(header);
+	}
+
+	if (valid) {
+		result.format = header.format;
+		result.data.resize(static_cast<usize>(header.size));
+		file.read(reinterpret_cast<char*>(result.data.data()), static_cast<std::streamsize>(header.size)); // NOLINT
+		valid = file && checksum(result.data) == header.checksum;
+	}
+
+	if (!valid) {
+		file.close();
+		remove(key);
+		++m_stats.misses;
+		return std::nullopt;
+	}
+
+	++m_stats.hits;
+	return result;
+}
+
+auto ProgramCache::store(u64 key, const ProgramBinary& binary) -> bool
+{
+	auto header = Header();
+	header.format = binary.format;
+	header.key = key;
+	header.driver = m_driver;
+	header.size = binary.data.size();
+	header.checksum = checksum(binary.data);
+
+	// Write to a temporary file first, so that a crash (or another process
+	// reading the cache) never sees half an entry
+	auto final_path = path(key);
+	auto temp_path = fs::path(final_path).replace_extension(".tmp");
+	{
+		auto file = std::ofstream(temp_path, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header)); // NOLINT
+		file.write(reinterpret_cast<const char*>(binary.data.data()), static_cast<std::streamsize>(binary.data.size())); // NOLINT
+		if (!file) {
+			auto error = std::error_code();
+			fs::remove(temp_path, error);
+			return false;
+		}
+	}
+
+	auto error = std::error_code();
+	fs::rename(temp_path, final_path, error);
+	if (error) {
+		fs::remove(temp_path, error);
+		return false;
+	}
+
+	++m_stats.stores;
+	return true;
+}
+
+void ProgramCache::remove(u64 key)
+{
+	auto error = std::error_code();
+	if (fs::remove(path(key), error))
+		++m_stats.removed;
+}
+
+auto ProgramCache::path(u64 key) const -> fs::path
+{
+	return m_directory / fmt::format("{:016x}-{:016x}.bin", m_driver, key);
+}
+
+} // namespace gfx
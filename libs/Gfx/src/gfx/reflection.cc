@@ -0,0 +1,134 @@
+#include "gfx/reflection.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include <fmt/format.h>
+
+
+namespace gfx {
+
+namespace {
+
+using GetActive = void (*)(u32, u32, i32, i32*, i32*, u32*, char*);
+using GetLocation = auto (*)(u32, const char*) -> i32;
+
+auto query(
+	u32 program, u32 count_param, u32 max_length_param,
+	GetActive get_active, GetLocation get_location,
+	const Functions& gl) -> std::vector<ShaderVariable>
+{
+	i32 count = gl.get_program_iv(program, count_param);
+	i32 max_length = gl.get_program_iv(program, max_length_param);
+
+	auto result = std::vector<ShaderVariable>();
+	auto name = std::string(static_cast<usize>(std::max(max_length, 1)), '\0');
+
+	for (i32 i = 0; i < count; ++i) {
+		i32 length = 0;
+		i32 size = 0;
+		u32 type = 0;
+		get_active(program, static_cast<u32>(i), max_length, &length, &size, &type, name.data());
+
+		// Built-ins like `gl_VertexID` and block members have no location
+		auto variable = ShaderVariable{ name.substr(0, static_cast<usize>(length)), -1, type, size };
+		variable.location = get_location(program, variable.name.c_str());
+		if (variable.location < 0)
+			continue;
+
+		auto& var_name = variable.name;
+		if (var_name.size() > 3 && var_name.compare(var_name.size() - 3, 3, "[0]") == 0)
+			var_name.resize(var_name.size() - 3);
+
+		result.push_back(std::move(variable));
+	}
+
+	return result;
+}
+
+} // namespace
+
+
+ProgramReflection::ProgramReflection(std::vector<ShaderVariable> uniforms, std::vector<ShaderVariable> attributes)
+	: m_uniforms(std::move(uniforms))
+	, m_attributes(std::move(attributes))
+	, m_uniform_table(build(m_uniforms))
+	, m_attribute_table(build(m_attributes))
+{}
+
+auto ProgramReflection::uniform_location(NameId name) const -> i32
+{
+	const auto* variable = find_uniform(name);
+	return variable ? variable->location : -1;
+}
+
+auto ProgramReflection::attribute_location(NameId name) const -> i32
+{
+	const auto* variable = find_attribute(name);
+	return variable ? variable->location : -1;
+}
+
+auto ProgramReflection::find_uniform(NameId name) const -> const ShaderVariable*
+{
+	u32 index = find(m_uniform_table, name);
+	return index == k_empty ? nullptr : &m_uniforms[index];
+}
+
+auto ProgramReflection::find_attribute(NameId name) const -> const ShaderVariable*
+{
+	u32 index = find(m_attribute_table, name);
+	return index == k_empty ? nullptr : &m_attributes[index];
+}
+
+auto ProgramReflection::build(const std::vector<ShaderVariable>& variables) -> std::vector<Slot>
+{
+	usize capacity = 4;
+	while (capacity < variables.size() * 2)
+		capacity *= 2;
+
+	auto result = std::vector<Slot>(capacity);
+	for (usize i = 0; i < variables.size(); ++i) {
+		u32 hash = hash_name(variables[i].name);
+		usize slot = hash & (capacity - 1);
+
+		while (result[slot].index != k_empty) {
+			if (result[slot].hash == hash)
+				throw std::logic_error(fmt::format(
+					"Shader variables '{}' and '{}' have the same name hash",
+					variables[result[slot].index].name, variables[i].name));
+
+			slot = (slot + 1) & (capacity - 1);
+		}
+
+		result[slot] = { hash, static_cast<u32>(i) };
+	}
+
+	return result;
+}
+
+auto ProgramReflection::find(const std::vector<Slot>& table, NameId name) -> u32
+{
+	if (table.empty())
+		return k_empty;
+
+	usize mask = table.size() - 1;
+	for (usize slot = name.hash & mask; ; slot = (slot + 1) & mask) {
+		const auto& entry = table[slot];
+		if (entry.index == k_empty || entry.hash == name.hash)
+			return entry.index;
+	}
+}
+
+
+auto reflect(const Functions& gl, u32 program) -> ProgramReflection
+{
+	return {
+		query(program, k_active_uniforms, k_active_uniform_max_length,
+			gl.get_active_uniform, gl.get_uniform_location, gl),
+		query(program, k_active_attributes, k_active_attribute_max_length,
+			gl.get_active_attrib, gl.get_attrib_location, gl),
+	};
+}
+
+} // namespace gfx
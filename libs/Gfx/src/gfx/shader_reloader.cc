@@ -0,0 +1,163 @@
+#include "gfx/shader_reloader.h"
+
+#include <algorithm>
+#include <utility>
+
+
+namespace gfx {
+namespace fs = std::filesystem;
+
+namespace {
+
+auto key(const fs::path& path) -> std::string
+{
+	return path.lexically_normal().generic_string();
+}
+
+auto uses(const ShaderSource& source, const std::string& file) -> bool
+{
+	return std::any_of(source.files().begin(), source.files().end(),
+		[&](const fs::path& path) { return key(path) == file; });
+}
+
+} // namespace
+
+
+ShaderReloader::ShaderReloader(ProgramBuilder& builder, ShaderSource::Reader read)
+	: m_builder(&builder)
+	, m_read(std::move(read))
+{}
+
+auto ShaderReloader::watch(const fs::path& directory) -> bool
+{
+	return m_watcher.watch(directory);
+}
+
+auto ShaderReloader::add(const fs::path& path) -> Handle
+{
+	auto entry = Entry();
+	entry.path = path;
+	entry.next_source = parse(path);
+	entry.next = m_builder->submit(*entry.next_source, true);
+	++m_building;
+
+	m_entries.push_back(std::move(entry));
+	return static_cast<Handle>(m_entries.size() - 1);
+}
+
+auto ShaderReloader::program(Handle handle, u32 fallback) const -> u32
+{
+	return m_entries[handle].current.get_or(fallback);
+}
+
+void ShaderReloader::changed(const fs::path& path)
+{
+	// Files that were never read can only matter to shaders that failed to
+	// parse, e.g. by including a file that didn't exist yet
+	auto file = key(path);
+	bool known = m_files.erase(file) > 0;
+
+	// Rebuild anything that uses it, including builds that are already on
+	// their way, which will be out of date
+	for (auto& entry : m_entries) {
+		bool used = entry.unparsed || (known
+			&& ((entry.source && uses(*entry.source, file))
+				|| (entry.next_source && uses(*entry.next_source, file))));
+		if (used) {
+			entry.dirty = true;
+			m_dirty = true;
+		}
+	}
+}
+
+auto ShaderReloader::update() -> const std::vector<Update>&
+{
+	m_updates.clear();
+
+	for (const auto& path : m_watcher.poll())
+		changed(path);
+
+	if (m_dirty) {
+		m_dirty = false;
+		for (Handle handle = 0; handle < m_entries.size(); ++handle)
+			if (m_entries[handle].dirty)
+				rebuild(handle);
+	}
+
+	if (m_building == 0)
+		return m_updates;
+
+	m_builder->poll();
+	for (Handle handle = 0; handle < m_entries.size(); ++handle) {
+		auto& entry = m_entries[handle];
+		if (!entry.next.valid() || entry.next.status() == BuildStatus::Pending)
+			continue;
+
+		--m_building;
+		if (entry.next.ready()) {
+			m_updates.push_back({ handle, entry.current.program(), entry.next.program(), {} });
+			entry.current = std::move(entry.next);
+			entry.source = std::move(entry.next_source);
+		}
+		else {
+			m_updates.push_back({ handle, 0, 0, entry.next_source->annotate_log(entry.next.log()) });
+		}
+
+		entry.next = {};
+		entry.next_source.reset();
+	}
+
+	return m_updates;
+}
+
+auto ShaderReloader::read(const fs::path& path) -> std::optional<std::string>
+{
+	auto file = key(path);
+	auto it = m_files.find(file);
+	if (it != m_files.end())
+		return it->second;
+
+	auto contents = m_read(path);
+	if (contents)
+		m_files.emplace(std::move(file), *contents);
+
+	return contents;
+}
+
+auto ShaderReloader::parse(const fs::path& path) -> ShaderSource
+{
+	return ShaderSource(path, [this](const fs::path& file) { return read(file); });
+}
+
+void ShaderReloader::rebuild(Handle handle)
+{
+	auto& entry = m_entries[handle];
+	entry.dirty = false;
+
+	auto source = std::optional<ShaderSource>();
+	try {
+		source = parse(entry.path);
+		entry.unparsed = false;
+	}
+	catch (const ShaderError& error) {
+		m_updates.push_back({ handle, 0, 0, error.what() });
+		entry.unparsed = true;
+
+		// Whatever was building is out of date
+		if (entry.next.valid()) {
+			entry.next = {};
+			entry.next_source.reset();
+			--m_building;
+		}
+		return;
+	}
+
+	// Replacing a build in progress abandons it
+	if (!entry.next.valid())
+		++m_building;
+
+	entry.next = m_builder->rebuild(*source, entry.current);
+	entry.next_source = std::move(source);
+}
+
+} // namespace gfx
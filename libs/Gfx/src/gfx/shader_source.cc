@@ -0,0 +1,340 @@
+#include "gfx/shader_source.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <fstream>
+#include <utility>
+
+#include <fmt/format.h>
+
+
+namespace gfx {
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr u32 k_no_file = 0xffff'ffff;
+constexpr std::string_view k_newline = "\n";
+
+auto is_space(char c) -> bool
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+auto trim(std::string_view text) -> std::string_view
+{
+	while (!text.empty() && is_space(text.front()))
+		text.remove_prefix(1);
+	while (!text.empty() && is_space(text.back()))
+		text.remove_suffix(1);
+
+	return text;
+}
+
+struct Directive {
+	/** Empty unless the line is a preprocessor directive. */
+	std::string_view keyword;
+	std::string_view argument;
+};
+
+auto parse_directive(std::string_view line) -> Directive
+{
+	line = trim(line);
+	if (line.empty() || line.front() != '#')
+		return {};
+
+	line = trim(line.substr(1));
+	usize length = 0;
+	while (length < line.size() && std::isalpha(static_cast<unsigned char>(line[length])))
+		++length;
+
+	return { line.substr(0, length), trim(line.substr(length)) };
+}
+
+/** One line of `text` from `begin`, and where the next one starts. */
+struct Line {
+	std::string_view text;
+	usize next;
+};
+
+auto next_line(std::string_view text, usize begin) -> Line
+{
+	usize end = text.find('\n', begin);
+	if (end == std::string_view::npos)
+		return { text.substr(begin), text.size() };
+
+	return { text.substr(begin, end - begin), end + 1 };
+}
+
+} // namespace
+
+
+auto shader_stage(std::string_view keyword) -> std::optional<ShaderStage>
+{
+	if (keyword == "vertex") return ShaderStage::Vertex;
+	if (keyword == "fragment") return ShaderStage::Fragment;
+	if (keyword == "compute") return ShaderStage::Compute;
+	if (keyword == "tessc") return ShaderStage::TessControl;
+	if (keyword == "tesse") return ShaderStage::TessEval;
+	if (keyword == "geometry") return ShaderStage::Geometry;
+	return std::nullopt;
+}
+
+auto read_file(const fs::path& path) -> std::optional<std::string>
+{
+	auto file = std::ifstream(path, std::ios::binary | std::ios::ate);
+	if (!file)
+		return std::nullopt;
+
+	auto result = std::string(static_cast<usize>(file.tellg()), '\0');
+	file.seekg(0);
+	file.read(result.data(), static_cast<std::streamsize>(result.size()));
+	if (!file)
+		return std::nullopt;
+
+	return result;
+}
+
+
+// Parsing ---------------------------------------------------------------------
+
+struct ShaderSource::Parser {
+	ShaderSource& self;
+	const Reader& read;
+	/** The files included in the current stage so far. */
+	std::vector<u32> included;
+
+	auto stage() -> Stage& { return self.m_stages.back(); }
+
+	/** Add the text from `begin` to `end` to the stage, ending with a newline. */
+	void flush(std::string_view text, usize begin, usize end)
+	{
+		if (end > begin)
+			stage().pieces.push_back(text.substr(begin, end - begin));
+		if (end == text.size() && end > begin && text.back() != '\n')
+			stage().pieces.push_back(k_newline);
+	}
+
+	auto error(u32 file, usize line, std::string_view message) const -> ShaderError
+	{
+		return ShaderError(fmt::format("{}:{}: {}", self.m_paths[file].string(), line, message));
+	}
+
+	void parse_shader()
+	{
+		std::string_view text = self.m_contents[0];
+		usize piece = 0;
+		usize line_number = 0;
+		bool expect_version = false;
+
+		for (usize begin = 0; begin < text.size(); ) {
+			auto [line, next] = next_line(text, begin);
+			auto directive = parse_directive(line);
+			++line_number;
+
+			if (directive.keyword == "shader") {
+				if (!self.m_stages.empty())
+					flush(text, piece, begin);
+
+				auto type = shader_stage(directive.argument);
+				if (!type)
+					throw error(0, line_number, fmt::format("unknown shader stage '{}'", directive.argument));
+
+				self.m_stages.push_back({ *type, {} });
+				included.assign(1, 0);
+				expect_version = true;
+				piece = next;
+			}
+			else if (self.m_stages.empty()) {
+				// Text before the first stage is ignored
+			}
+			else if (expect_version && !trim(line).empty()) {
+				// `#version` has to come first, so number the lines after it
+				expect_version = false;
+				if (directive.keyword == "version") {
+					flush(text, piece, next);
+					stage().pieces.push_back(self.line_directive(line_number + 1, 0));
+					piece = next;
+				}
+				else {
+					flush(text, piece, begin);
+					stage().pieces.push_back(self.line_directive(line_number, 0));
+					piece = begin;
+					if (directive.keyword == "include") {
+						include(0, line_number, directive.argument);
+						piece = next;
+					}
+				}
+			}
+			else if (directive.keyword == "include") {
+				flush(text, piece, begin);
+				include(0, line_number, directive.argument);
+				piece = next;
+			}
+
+			begin = next;
+		}
+
+		if (!self.m_stages.empty())
+			flush(text, piece, text.size());
+	}
+
+	void parse_include(u32 file)
+	{
+		std::string_view text = self.m_contents[file];
+		usize piece = 0;
+		usize line_number = 0;
+
+		for (usize begin = 0; begin < text.size(); ) {
+			auto [line, next] = next_line(text, begin);
+			auto directive = parse_directive(line);
+			++line_number;
+
+			if (directive.keyword == "shader")
+				throw error(file, line_number, "#shader in an included file");
+
+			if (directive.keyword == "include") {
+				flush(text, piece, begin);
+				include(file, line_number, directive.argument);
+				piece = next;
+			}
+
+			begin = next;
+		}
+
+		flush(text, piece, text.size());
+	}
+
+	void include(u32 from, usize line_number, std::string_view argument)
+	{
+		bool quoted = argument.size() >= 2
+			&& ((argument.front() == '"' && argument.back() == '"')
+				|| (argument.front() == '<' && argument.back() == '>'));
+		if (!quoted)
+			throw error(from, line_number, "expected #include \"file\"");
+
+		auto name = argument.substr(1, argument.size() - 2);
+		auto path = (self.m_paths[from].parent_path() / name).lexically_normal();
+
+		u32 file = self.file(path, read);
+		if (file == k_no_file)
+			throw error(from, line_number, fmt::format("can't open include '{}'", name));
+
+		// Keep the line count of an include that's skipped
+		if (std::find(included.begin(), included.end(), file) != included.end()) {
+			stage().pieces.push_back(k_newline);
+			return;
+		}
+
+		included.push_back(file);
+		stage().pieces.push_back(self.line_directive(1, file));
+		parse_include(file);
+		stage().pieces.push_back(self.line_directive(line_number + 1, from));
+	}
+};
+
+
+// ShaderSource ----------------------------------------------------------------
+
+auto ShaderSource::Stage::text() const -> std::string
+{
+	auto result = std::string();
+	for (auto piece : pieces)
+		result.append(piece);
+
+	return result;
+}
+
+ShaderSource::ShaderSource(const fs::path& path)
+	: ShaderSource(path, read_file)
+{}
+
+ShaderSource::ShaderSource(const fs::path& path, const Reader& read)
+{
+	if (file(path.lexically_normal(), read) == k_no_file)
+		throw ShaderError(fmt::format("Can't open shader '{}'", path.string()));
+
+	Parser{ *this, read, {} }.parse_shader();
+}
+
+auto ShaderSource::find(ShaderStage type) const -> const Stage*
+{
+	for (const auto& stage : m_stages)
+		if (stage.type == type)
+			return &stage;
+
+	return nullptr;
+}
+
+auto ShaderSource::annotate_log(std::string_view log) const -> std::string
+{
+	// Compilers prefix messages with e.g. `0(12)`, `0:12(5)` or `ERROR: 0:12:`
+	auto result = std::string();
+	result.reserve(log.size());
+
+	for (usize begin = 0; begin < log.size(); ) {
+		auto [line, next] = next_line(log, begin);
+
+		bool replaced = false;
+		for (usize start = 0; start < line.size() && !replaced; ++start) {
+			bool is_word_start = start == 0 || line[start - 1] == ' ';
+			if (!is_word_start || !std::isdigit(static_cast<unsigned char>(line[start])))
+				continue;
+
+			usize end = start;
+			while (end < line.size() && std::isdigit(static_cast<unsigned char>(line[end])))
+				++end;
+
+			bool is_location = end + 1 < line.size()
+				&& (line[end] == '(' || line[end] == ':')
+				&& std::isdigit(static_cast<unsigned char>(line[end + 1]));
+
+			u32 number = 0;
+			auto [last, error] = std::from_chars(line.data() + start, line.data() + end, number);
+			if (is_location && error == std::errc() && number < m_paths.size()) {
+				result.append(line.substr(0, start));
+				result.append(m_paths[number].filename().string());
+				result.append(line.substr(end));
+				replaced = true;
+			}
+
+			start = end;
+		}
+
+		if (!replaced)
+			result.append(line);
+		if (log[next - 1] == '\n')
+			result.push_back('\n');
+
+		begin = next;
+	}
+
+	return result;
+}
+
+auto ShaderSource::file(const fs::path& path, const Reader& read) -> u32
+{
+	auto key = path.generic_string();
+	auto it = m_indices.find(key);
+	if (it != m_indices.end())
+		return it->second;
+
+	auto contents = read(path);
+	if (!contents)
+		return k_no_file;
+
+	auto index = static_cast<u32>(m_paths.size());
+	m_paths.push_back(path);
+	m_contents.push_back(std::move(*contents));
+	m_indices.emplace(std::move(key), index);
+
+	return index;
+}
+
+auto ShaderSource::line_directive(usize line, u32 file) -> std::string_view
+{
+	return m_directives.emplace_back(fmt::format("#line {} {}\n", line, file));
+}
+
+} // namespace gfx
@@ -0,0 +1,273 @@
+#include "gfx/state_cache.h"
+
+#include <cstring>
+#include <initializer_list>
+
+
+namespace gfx {
+
+auto StateCache::Stats::total() const -> Counter
+{
+	auto result = Counter();
+	for (const auto* counter : { &buffers, &vertex_arrays, &programs, &uniforms }) {
+		result.issued += counter->issued;
+		result.skipped += counter->skipped;
+	}
+
+	return result;
+}
+
+
+StateCache::StateCache(const Functions& functions)
+	: m_gl(functions)
+{}
+
+
+// Bindings --------------------------------------------------------------------
+
+void StateCache::bind_buffer(u32 target, u32 buffer)
+{
+	if (target == k_element_array_buffer) {
+		// The element array binding belongs to the bound vertex array
+		if (m_vertex_array == k_unknown) {
+			count(m_stats.buffers, true);
+			m_gl.bind_buffer(target, buffer);
+			return;
+		}
+
+		auto& bound = m_element_buffers.try_emplace(m_vertex_array, k_unknown).first->second;
+		if (count(m_stats.buffers, bound != buffer)) {
+			bound = buffer;
+			m_gl.bind_buffer(target, buffer);
+		}
+		return;
+	}
+
+	auto& bound = buffer_binding(target);
+	if (count(m_stats.buffers, bound != buffer)) {
+		bound = buffer;
+		m_gl.bind_buffer(target, buffer);
+	}
+}
+
+void StateCache::bind_buffer_base(u32 target, u32 index, u32 buffer)
+{
+	auto& bound = indexed_binding(target, index);
+	if (count(m_stats.buffers, bound.buffer != buffer || bound.offset != 0 || bound.size != 0)) {
+		bound = { target, index, buffer, 0, 0 };
+		// Binding to an indexed point also binds to the generic one
+		buffer_binding(target) = buffer;
+		m_gl.bind_buffer_base(target, index, buffer);
+	}
+}
+
+void StateCache::bind_buffer_range(u32 target, u32 index, u32 buffer, usize offset, usize size)
+{
+	auto& bound = indexed_binding(target, index);
+	if (count(m_stats.buffers, bound.buffer != buffer || bound.offset != offset || bound.size != size)) {
+		bound = { target, index, buffer, offset, size };
+		buffer_binding(target) = buffer;
+		m_gl.bind_buffer_range(target, index, buffer, offset, size);
+	}
+}
+
+void StateCache::bind_vertex_array(u32 array)
+{
+	if (count(m_stats.vertex_arrays, m_vertex_array != array)) {
+		m_vertex_array = array;
+		m_gl.bind_vertex_array(array);
+	}
+}
+
+void StateCache::use_program(u32 program)
+{
+	if (count(m_stats.programs, m_program != program)) {
+		m_program = program;
+		m_current_uniforms = program == 0 ? nullptr : &m_uniforms[program];
+		m_gl.use_program(program);
+	}
+}
+
+auto StateCache::buffer_binding(u32 target) -> u32&
+{
+	for (auto& binding : m_buffers)
+		if (binding.target == target)
+			return binding.buffer;
+
+	m_buffers.push_back({ target, k_unknown });
+	return m_buffers.back().buffer;
+}
+
+auto StateCache::indexed_binding(u32 target, u32 index) -> IndexedBinding&
+{
+	for (auto& binding : m_indexed_buffers)
+		if (binding.target == target && binding.index == index)
+			return binding;
+
+	m_indexed_buffers.push_back({ target, index, k_unknown, 0, 0 });
+	return m_indexed_buffers.back();
+}
+
+
+// Uniforms --------------------------------------------------------------------
+
+void StateCache::uniform_1f(i32 location, f32 v0)
+{
+	f32 values[] { v0 };
+	if (update_uniform(location, values, sizeof(values)))
+		m_gl.uniform_1f(location, v0);
+}
+
+void StateCache::uniform_2f(i32 location, f32 v0, f32 v1)
+{
+	f32 values[] { v0, v1 };
+	if (update_uniform(location, values, sizeof(values)))
+		m_gl.uniform_2f(location, v0, v1);
+}
+
+void StateCache::uniform_3f(i32 location, f32 v0, f32 v1, f32 v2)
+{
+	f32 values[] { v0, v1, v2 };
+	if (update_uniform(location, values, sizeof(values)))
+		m_gl.uniform_3f(location, v0, v1, v2);
+}
+
+void StateCache::uniform_4f(i32 location, f32 v0, f32 v1, f32 v2, f32 v3)
+{
+	f32 values[] { v0, v1, v2, v3 };
+	if (update_uniform(location, values, sizeof(values)))
+		m_gl.uniform_4f(location, v0, v1, v2, v3);
+}
+
+void StateCache::uniform_matrix_2fv(i32 location, i32 count, bool transpose, const f32* values)
+{
+	if (update_uniform(location, values, count * 4 * sizeof(f32), transpose))
+		m_gl.uniform_matrix_2fv(location, count, transpose, values);
+}
+
+void StateCache::uniform_matrix_3fv(i32 location, i32 count, bool transpose, const f32* values)
+{
+	if (update_uniform(location, values, count * 9 * sizeof(f32), transpose))
+		m_gl.uniform_matrix_3fv(location, count, transpose, values);
+}
+
+void StateCache::uniform_matrix_4fv(i32 location, i32 count, bool transpose, const f32* values)
+{
+	if (update_uniform(location, values, count * 16 * sizeof(f32), transpose))
+		m_gl.uniform_matrix_4fv(location, count, transpose, values);
+}
+
+void StateCache::uniform_matrix_4x3fv(i32 location, i32 count, bool transpose, const f32* values)
+{
+	if (update_uniform(location, values, count * 12 * sizeof(f32), transpose))
+		m_gl.uniform_matrix_4x3fv(location, count, transpose, values);
+}
+
+void StateCache::uniform_matrix_3x4fv(i32 location, i32 count, bool transpose, const f32* values)
+{
+	if (update_uniform(location, values, count * 12 * sizeof(f32), transpose))
+		m_gl.uniform_matrix_3x4fv(location, count, transpose, values);
+}
+
+auto StateCache::update_uniform(i32 location, const void* data, usize size, bool transpose) -> bool
+{
+	// Without a known program there's nothing to compare against, and GL
+	// silently ignores location -1, so let it do so
+	if (m_current_uniforms == nullptr || location < 0)
+		return count(m_stats.uniforms, true);
+
+	auto& uniforms = *m_current_uniforms;
+	if (static_cast<usize>(location) >= uniforms.size())
+		uniforms.resize(location + 1);
+
+	auto& value = uniforms[location];
+	bool changed = value.size() != size + 1
+		|| value[0] != static_cast<u8>(transpose)
+		|| std::memcmp(value.data() + 1, data, size) != 0;
+
+	if (changed) {
+		value.resize(size + 1);
+		value[0] = static_cast<u8>(transpose);
+		std::memcpy(value.data() + 1, data, size);
+	}
+
+	return count(m_stats.uniforms, changed);
+}
+
+
+// Draws -----------------------------------------------------------------------
+
+void StateCache::draw_elements(u32 mode, i32 count, u32 type, const void* indices)
+{
+	++m_stats.draws;
+	++m_stats.instances;
+	m_gl.draw_elements(mode, count, type, indices);
+}
+
+void StateCache::draw_elements_instanced(
+	u32 mode, i32 count, u32 type, const void* indices,
+	i32 instance_count, u32 base_instance)
+{
+	++m_stats.draws;
+	m_stats.instances += static_cast<u64>(instance_count);
+	m_gl.draw_elements_instanced(mode, count, type, indices, instance_count, base_instance);
+}
+
+
+// Invalidation ----------------------------------------------------------------
+
+void StateCache::forget_buffer(u32 buffer)
+{
+	// GL resets bindings to a deleted buffer in the current context, including
+	// the bound vertex array's element array. Other vertex arrays keep the old
+	// buffer alive, so if its name is reused they still don't refer to the new
+	// one.
+	for (auto& binding : m_buffers)
+		if (binding.buffer == buffer)
+			binding.buffer = 0;
+
+	for (auto& binding : m_indexed_buffers)
+		if (binding.buffer == buffer)
+			binding = { binding.target, binding.index, 0, 0, 0 };
+
+	for (auto& [array, element_buffer] : m_element_buffers)
+		if (element_buffer == buffer)
+			element_buffer = array == m_vertex_array ? 0 : k_unknown;
+}
+
+void StateCache::forget_vertex_array(u32 array)
+{
+	if (m_vertex_array == array)
+		m_vertex_array = 0;
+
+	m_element_buffers.erase(array);
+}
+
+void StateCache::forget_program(u32 program)
+{
+	if (m_program == program) {
+		m_program = k_unknown;
+		m_current_uniforms = nullptr;
+	}
+
+	m_uniforms.erase(program);
+}
+
+void StateCache::invalidate()
+{
+	m_buffers.clear();
+	m_indexed_buffers.clear();
+	m_vertex_array = k_unknown;
+	m_program = k_unknown;
+	m_element_buffers.clear();
+	m_uniforms.clear();
+	m_current_uniforms = nullptr;
+}
+
+auto StateCache::count(Counter& counter, bool changed) -> bool
+{
+	++(changed ? counter.issued : counter.skipped);
+	return changed;
+}
+
+} // namespace gfx
@@ -0,0 +1,154 @@
+#include "gfx/streaming_buffer.h"
+
+#include <stdexcept>
+#include <utility>
+
+
+namespace gfx {
+
+namespace {
+
+/** How long to block per wait once a fence turns out to be unsignaled (1ms). */
+constexpr u64 k_wait_timeout_ns = 1'000'000;
+
+} // namespace
+
+
+StreamingBuffer::StreamingBuffer(StateCache& state, u32 target, usize frame_size)
+	: m_state(&state)
+	, m_target(target)
+	, m_frame_size(frame_size)
+{
+	const auto& gl = state.functions();
+	constexpr u32 flags = k_map_write_bit | k_map_persistent_bit | k_map_coherent_bit;
+	usize size = frame_size * k_frame_count;
+
+	m_buffer = gl.gen_buffer();
+	state.bind_buffer(target, m_buffer);
+	gl.buffer_storage(target, size, nullptr, flags);
+	m_mapped = static_cast<u8*>(gl.map_buffer_range(target, 0, size, flags));
+
+	if (m_mapped == nullptr) {
+		release();
+		throw std::runtime_error("Failed to map the streaming buffer");
+	}
+}
+
+StreamingBuffer::~StreamingBuffer()
+{
+	release();
+}
+
+StreamingBuffer::StreamingBuffer(StreamingBuffer&& other) noexcept
+	: m_state(other.m_state)
+	, m_target(other.m_target)
+	, m_buffer(std::exchange(other.m_buffer, 0))
+	, m_mapped(std::exchange(other.m_mapped, nullptr))
+	, m_frame_size(other.m_frame_size)
+	, m_fences(std::exchange(other.m_fences, {}))
+	, m_frame(other.m_frame)
+	, m_used(other.m_used)
+	, m_stats(other.m_stats)
+{}
+
+StreamingBuffer& StreamingBuffer::operator=(StreamingBuffer&& other) noexcept
+{
+	if (this != &other) {
+		release();
+
+		m_state = other.m_state;
+		m_target = other.m_target;
+		m_buffer = std::exchange(other.m_buffer, 0);
+		m_mapped = std::exchange(other.m_mapped, nullptr);
+		m_frame_size = other.m_frame_size;
+		m_fences = std::exchange(other.m_fences, {});
+		m_frame = other.m_frame;
+		m_used = other.m_used;
+		m_stats = other.m_stats;
+	}
+
+	return *this;
+}
+
+void StreamingBuffer::begin_frame()
+{
+	const auto& gl = m_state->functions();
+
+	m_frame = (m_frame + 1) % k_frame_count;
+	m_used = 0;
+	++m_stats.frames;
+
+	void*& fence = m_fences[m_frame];
+	if (fence == nullptr)
+		return;
+
+	// Poll first, so that a fence that's already signaled isn't counted
+	u64 timeout = 0;
+	u32 flags = 0;
+	for (;;) {
+		u32 status = gl.client_wait_sync(fence, flags, timeout);
+		if (status == k_already_signaled || status == k_condition_satisfied)
+			break;
+		if (status == k_wait_failed)
+			throw std::runtime_error("Failed to wait for a streaming buffer fence");
+
+		if (timeout == 0)
+			++m_stats.stalls;
+
+		// Make sure the fence has been sent to the GPU, or it may never signal
+		timeout = k_wait_timeout_ns;
+		flags = k_sync_flush_commands_bit;
+	}
+
+	gl.delete_sync(fence);
+	fence = nullptr;
+}
+
+auto StreamingBuffer::allocate(usize size, usize alignment) -> Allocation
+{
+	usize base = m_frame * m_frame_size;
+
+	// Align relative to the start of the buffer, since that's what GL sees
+	usize start = (base + m_used + alignment - 1) / alignment * alignment;
+	if (start + size > base + m_frame_size)
+		throw std::length_error("Streaming buffer frame is full");
+
+	m_used = start + size - base;
+	return { m_mapped + start, start };
+}
+
+void StreamingBuffer::end_frame()
+{
+	const auto& gl = m_state->functions();
+
+	void*& fence = m_fences[m_frame];
+	if (fence != nullptr)
+		gl.delete_sync(fence);
+
+	fence = gl.fence_sync();
+}
+
+void StreamingBuffer::release()
+{
+	if (m_buffer == 0)
+		return;
+
+	const auto& gl = m_state->functions();
+	for (void*& fence : m_fences) {
+		if (fence != nullptr)
+			gl.delete_sync(fence);
+		fence = nullptr;
+	}
+
+	if (m_mapped != nullptr) {
+		m_state->bind_buffer(m_target, m_buffer);
+		gl.unmap_buffer(m_target);
+		m_mapped = nullptr;
+	}
+
+	m_state->forget_buffer(m_buffer);
+	gl.delete_buffer(m_buffer);
+	m_buffer = 0;
+}
+
+} // namespace gfx
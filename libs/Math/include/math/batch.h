@@ -0,0 +1,100 @@
+#pragma once
+
+#include <sized.h>
+
+#include "math/cpu.h"
+#include "math/geo/plane.h"
+#include "math/geo/ray.h"
+#include "math/geo/sphere.h"
+#include "math/geo/tri.h"
+#include "math/matrix.h"
+#include "math/quat.h"
+#include "math/vector.h"
+
+/**
+ * Kernels that apply a single operation to a whole array of values.
+ *
+ * Each kernel is compiled once per `math::Isa`, and calls are forwarded to the
+ * most capable variant the running CPU supports. The choice is made once, on
+ * first use, and can be overridden with `force_isa` or by setting the
+ * `MATH_ISA` environment variable to one of the names returned by
+ * `math::isa_name` before the first call.
+ *
+ * `normalize` and `slerp` are the exceptions: they're bound by square roots
+ * and divisions, and by calls to `sin` and `atan2`, which wider vectors don't
+ * speed up, so there's only the baseline variant.
+ */
+namespace math::batch {
+using namespace sized; // NOLINT(*-using-namespace)
+
+// Dispatch --------------------------------------------------------------------
+
+/** The instruction set of the kernels that calls are currently forwarded to. */
+auto isa() -> Isa;
+
+/**
+ * Whether the kernels for an instruction set were compiled into this build
+ * *and* can run on this CPU.
+ */
+auto supported(Isa isa) -> bool;
+
+/**
+ * Forward all subsequent calls to the kernels for a specific instruction set.
+ * Returns `false` (and changes nothing) if the instruction set isn't
+ * `supported`.
+ */
+auto force_isa(Isa isa) -> bool;
+
+/** Undo `force_isa`, reverting to the most capable supported kernels. */
+void reset_isa();
+
+
+// Kernels ---------------------------------------------------------------------
+
+/**
+ * Transform points by a 4x4 matrix, treating each point as the row-vector
+ * `[ x y z 1 ]` (i.e., equivalent to `TransformMatrix::transform_point`).
+ * `points` and `out` may be the same array.
+ */
+void transform_points(const Mat4x4& m, const Vec3* points, Vec3* out, usize count);
+
+/** Normalize vectors in place (equivalent to `Vec3::normalize`). */
+void normalize(Vec3* vectors, usize count);
+
+/**
+ * Test bounding spheres against a convex volume (e.g., a view frustum) made of
+ * planes whose normals point *into* the volume. Writes `1` to `out_visible` for
+ * each sphere that is at least partially inside every plane, or `0` otherwise.
+ */
+void cull_spheres(
+	const geo::Plane* planes, usize plane_count,
+	const geo::Sphere* spheres, usize count,
+	u8* out_visible);
+
+/**
+ * Test normal cones for backfacing, as seen from `eye`. Each cone bounds the
+ * normals of a cluster of triangles inside `spheres[i]`: its axis is
+ * `axes[i]` and `cutoffs[i]` is the sine of the largest angle between the axis
+ * and a normal (or 1 if it's 90 degrees or more). Writes `0` to `out_visible`
+ * for each cluster whose triangles all face away from `eye`, or `1` otherwise.
+ * The test is conservative, so some backfacing clusters are kept.
+ */
+void cull_cones(
+	const Vec3& eye,
+	const geo::Sphere* spheres, const Vec3* axes, const flt* cutoffs, usize count,
+	u8* out_visible);
+
+/**
+ * Intersect a ray with triangles (double-sided). For each triangle, writes the
+ * parametric distance along `ray.delta` (in the range [0,1]) at which the ray
+ * hits it, or infinity if it misses.
+ */
+void intersect_ray_tris(const geo::Ray& ray, const geo::Tri* tris, usize count, flt* out_t);
+
+/**
+ * Spherically interpolate between corresponding pairs of unit quaternions,
+ * taking the shortest arc.
+ */
+void slerp(const Quat* src, const Quat* dest, flt t, Quat* out, usize count);
+
+} // namespace math::batch
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <sized.h>
+
+/**
+ * Bounds-checking policy for `Vector`, `Matrix` and `Quat` subscripts.
+ *
+ * - `MATH_INDEX_CHECKS_OFF`: `operator[]` is never checked.
+ * - `MATH_INDEX_CHECKS_DEBUG`: `operator[]` is checked unless `NDEBUG` is
+ *   defined. This is the default.
+ * - `MATH_INDEX_CHECKS_ALWAYS`: `operator[]` is always checked.
+ *
+ * `at()` is checked regardless of the policy. Set the policy for the whole
+ * build with the `MATH_INDEX_CHECKS` CMake cache variable.
+ */
+#define MATH_INDEX_CHECKS_OFF 0
+#define MATH_INDEX_CHECKS_DEBUG 1
+#define MATH_INDEX_CHECKS_ALWAYS 2
+
+#ifndef MATH_INDEX_CHECKS
+	#define MATH_INDEX_CHECKS MATH_INDEX_CHECKS_DEBUG
+#endif
+
+
+namespace math::detail {
+using namespace sized; // NOLINT(*-using-namespace)
+
+#if MATH_INDEX_CHECKS == MATH_INDEX_CHECKS_ALWAYS \
+	|| (MATH_INDEX_CHECKS == MATH_INDEX_CHECKS_DEBUG && !defined(NDEBUG))
+	constexpr bool k_check_indices = true;
+#else
+	constexpr bool k_check_indices = false;
+#endif
+
+/** Throw `std::out_of_range` for an invalid subscript. Kept out of line. */
+[[noreturn]] void index_out_of_range(const char* type, usize size, usize idx);
+
+/**
+ * Validate a subscript against a container's size. When the index is a
+ * constant (e.g. in an unrolled loop) the check folds away entirely.
+ */
+inline void check_index(const char* type, usize size, usize idx)
+{
+	if (idx >= size)
+		index_out_of_range(type, size, idx);
+}
+
+} // namespace math::detail
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <sized.h>
+
+namespace math {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/**
+ * Instruction-set levels for which `math::batch` kernels are compiled, in
+ * ascending order of capability.
+ */
+enum class Isa : u8 {
+	/** The target's default instruction set (SSE2 on x86-64). */
+	Baseline,
+	/** AVX2 + FMA */
+	AVX2,
+	/** AVX-512 Foundation + Vector Length extensions */
+	AVX512,
+};
+
+/**
+ * Get the most capable instruction set supported by both the CPU and the OS.
+ * The CPU is only queried on the first call.
+ */
+auto cpu_isa() -> Isa;
+
+/** Get a short, lower-case name for an instruction set (e.g. `"avx2"`). */
+auto isa_name(Isa isa) -> const char*;
+
+} // namespace math
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <sized.h>
+
+namespace math::detail {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/** The threads to use when `requested` of them were asked for, where 0 means every hardware thread. */
+inline auto thread_count(usize requested) -> usize
+{
+	if (requested > 0)
+		return requested;
+
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * Call `fn(i)` for every `i` in `[0, count)`, spread over up to `threads`
+ * threads. Rethrows the first exception thrown by `fn`.
+ */
+template <typename Fn>
+void parallel_for(usize count, usize threads, const Fn& fn)
+{
+	threads = std::min(threads, count);
+	if (threads <= 1) {
+		for (usize i = 0; i < count; ++i)
+			fn(i);
+		return;
+	}
+
+	auto next = std::atomic<usize>(0);
+	auto error = std::exception_ptr();
+	auto error_mutex = std::mutex();
+
+	auto work = [&] {
+		for (usize i = next++; i < count; i = next++) {
+			try {
+				fn(i);
+			}
+			catch (...) {
+				auto lock = std::lock_guard(error_mutex);
+				if (!error)
+					error = std::current_exception();
+			}
+		}
+	};
+
+	auto workers = std::vector<std::thread>();
+	workers.reserve(threads - 1);
+	for (usize i = 1; i < threads; ++i)
+		workers.emplace_back(work);
+
+	work();
+	for (auto& worker : workers)
+		worker.join();
+
+	if (error)
+		std::rethrow_exception(error);
+}
+
+} // namespace math::detail
@@ -0,0 +1,281 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+#include <sized.h>
+
+#include "math/sfinae.h"
+#include "math/utility.h"
+#include "math/vector.h"
+
+/**
+ * Opt-in expression templates for `math::Vector` arithmetic.
+ *
+ * The regular `Vector` operators each return a new vector, so an expression
+ * like `x * v1 + y * v2 + z * v3` builds and walks five intermediate vectors.
+ * Wrapping any operand with `math::expr::lazy` instead builds a lightweight
+ * expression tree, which is evaluated in a single pass when it's converted to
+ * a `Vector` (e.g. on assignment or return):
+ *
+ *     Vec3 p = lazy(v1) * x + lazy(v2) * y + lazy(v3) * z;
+ *
+ * Every node performs exactly the same floating-point operations, in the same
+ * order, as the equivalent eager operator, so the results are bit-identical.
+ *
+ * Expressions hold references to their `Vector` operands, so they must be
+ * evaluated before any of those operands go out of scope. In particular, don't
+ * store an expression in an `auto` variable.
+ */
+namespace math::expr {
+using namespace sized; // NOLINT(*-using-namespace)
+
+namespace detail {
+
+struct ExprTag {};
+
+template <typename T>
+constexpr bool is_expr = std::is_base_of_v<ExprTag, T>;
+
+template <typename T>
+struct VectorTraits {
+	static constexpr bool is_vector = false;
+};
+
+template <usize D>
+struct VectorTraits<Vector<D>> {
+	static constexpr bool is_vector = true;
+};
+
+template <typename T>
+constexpr bool is_operand = is_expr<T> || VectorTraits<T>::is_vector;
+
+/** At least one side must already be an expression, so eager ops are untouched. */
+template <typename L, typename R>
+constexpr bool is_lazy_pair = is_operand<L> && is_operand<R> && (is_expr<L> || is_expr<R>);
+
+} // namespace detail
+
+
+// Expression base -------------------------------------------------------------
+
+/**
+ * CRTP base for every expression node. `Derived` must provide
+ * `constexpr auto get(usize index) const -> flt`.
+ */
+template <typename Derived, usize D>
+struct Expr : detail::ExprTag {
+	static constexpr usize dimensions = D;
+
+	/** Evaluate every component of the expression into a new vector. */
+	constexpr auto eval() const -> Vector<D> {
+		return eval(std::make_index_sequence<D>{});
+	}
+
+	constexpr operator Vector<D>() const { // NOLINT(*-explicit-*)
+		return eval();
+	}
+
+private:
+	template <usize... Index>
+	constexpr auto eval(std::index_sequence<Index...> /*indices*/) const -> Vector<D> {
+		const auto& self = static_cast<const Derived&>(*this);
+		return Vector<D>{ self.get(Index)... };
+	}
+};
+
+
+// Nodes -----------------------------------------------------------------------
+
+/** A reference to a `Vector` operand. */
+template <usize D>
+struct Leaf : Expr<Leaf<D>, D> {
+	const Vector<D>& vector;
+
+	constexpr Leaf(const Vector<D>& vector) // NOLINT(*-explicit-*)
+		: vector(vector)
+	{}
+
+	constexpr auto get(usize index) const -> flt {
+		// Read through the base to skip `Vector::operator[]`'s bounds check
+		return static_cast<const math::detail::Vector<D>&>(vector).components[index];
+	}
+};
+
+namespace detail {
+
+template <typename T>
+struct Operand {
+	using type = T;
+};
+
+template <usize D>
+struct Operand<Vector<D>> {
+	using type = Leaf<D>;
+};
+
+/** The node type used to store an operand: `Leaf` for vectors, else itself. */
+template <typename T>
+using operand_t = typename Operand<T>::type;
+
+} // namespace detail
+
+template <typename L, typename R>
+struct Sum : Expr<Sum<L,R>, L::dimensions> {
+	static_assert(L::dimensions == R::dimensions, "Expected vectors of the same size");
+
+	L lhs;
+	R rhs;
+
+	constexpr Sum(const L& lhs, const R& rhs)
+		: lhs(lhs)
+		, rhs(rhs)
+	{}
+
+	constexpr auto get(usize index) const -> flt {
+		return lhs.get(index) + rhs.get(index);
+	}
+};
+
+template <typename L, typename R>
+struct Difference : Expr<Difference<L,R>, L::dimensions> {
+	static_assert(L::dimensions == R::dimensions, "Expected vectors of the same size");
+
+	L lhs;
+	R rhs;
+
+	constexpr Difference(const L& lhs, const R& rhs)
+		: lhs(lhs)
+		, rhs(rhs)
+	{}
+
+	constexpr auto get(usize index) const -> flt {
+		return lhs.get(index) - rhs.get(index);
+	}
+};
+
+template <typename E>
+struct Scaled : Expr<Scaled<E>, E::dimensions> {
+	E expr;
+	flt magnitude;
+
+	constexpr Scaled(const E& expr, flt magnitude)
+		: expr(expr)
+		, magnitude(magnitude)
+	{}
+
+	constexpr auto get(usize index) const -> flt {
+		return expr.get(index) * magnitude;
+	}
+};
+
+template <typename E>
+struct Quotient : Expr<Quotient<E>, E::dimensions> {
+	E expr;
+	flt magnitude;
+	/** Matches `Vector::operator/`, which yields zero for a ~zero divisor. */
+	bool is_zero;
+
+	constexpr Quotient(const E& expr, flt magnitude)
+		: expr(expr)
+		, magnitude(magnitude)
+		, is_zero(math::nearly_equal(magnitude, 0))
+	{}
+
+	constexpr auto get(usize index) const -> flt {
+		return is_zero ? 0 : expr.get(index) / magnitude;
+	}
+};
+
+template <typename E>
+struct Negated : Expr<Negated<E>, E::dimensions> {
+	E expr;
+
+	constexpr Negated(const E& expr) // NOLINT(*-explicit-*)
+		: expr(expr)
+	{}
+
+	constexpr auto get(usize index) const -> flt {
+		return expr.get(index) * -1;
+	}
+};
+
+
+// Entry point -----------------------------------------------------------------
+
+/** Start a lazily-evaluated expression from a vector. */
+template <usize D>
+constexpr auto lazy(const Vector<D>& vector) -> Leaf<D>
+{
+	return Leaf<D>{ vector };
+}
+
+
+// Operators -------------------------------------------------------------------
+
+template <typename L, typename R>
+constexpr auto operator+(const L& lhs, const R& rhs)
+	-> std::enable_if_t<detail::is_lazy_pair<L,R>, Sum<detail::operand_t<L>, detail::operand_t<R>>>
+{
+	return { detail::operand_t<L>(lhs), detail::operand_t<R>(rhs) };
+}
+
+template <typename L, typename R>
+constexpr auto operator-(const L& lhs, const R& rhs)
+	-> std::enable_if_t<detail::is_lazy_pair<L,R>, Difference<detail::operand_t<L>, detail::operand_t<R>>>
+{
+	return { detail::operand_t<L>(lhs), detail::operand_t<R>(rhs) };
+}
+
+template <typename E>
+constexpr auto operator*(const E& expr, flt magnitude)
+	-> ENABLE_IF(detail::is_expr<E>, Scaled<E>)
+{
+	return { expr, magnitude };
+}
+
+template <typename E>
+constexpr auto operator*(flt magnitude, const E& expr)
+	-> ENABLE_IF(detail::is_expr<E>, Scaled<E>)
+{
+	return { expr, magnitude };
+}
+
+template <typename E>
+constexpr auto operator/(const E& expr, flt magnitude)
+	-> ENABLE_IF(detail::is_expr<E>, Quotient<E>)
+{
+	return { expr, magnitude };
+}
+
+template <typename E>
+constexpr auto operator-(const E& expr)
+	-> ENABLE_IF(detail::is_expr<E>, Negated<E>)
+{
+	return { expr };
+}
+
+/** Calculate the dot-product of two operands without materializing either. */
+template <typename L, typename R>
+constexpr auto dot(const L& lhs, const R& rhs)
+	-> ENABLE_IF((detail::is_lazy_pair<L,R>), flt)
+{
+	auto l = detail::operand_t<L>(lhs);
+	auto r = detail::operand_t<R>(rhs);
+
+	flt result = 0;
+	for (usize i = 0; i < decltype(l)::dimensions; ++i)
+		result += l.get(i) * r.get(i);
+
+	return result;
+}
+
+/** Calculate the dot-product of two operands without materializing either. */
+template <typename L, typename R>
+constexpr auto operator|(const L& lhs, const R& rhs)
+	-> ENABLE_IF((detail::is_lazy_pair<L,R>), flt)
+{
+	return dot(lhs, rhs);
+}
+
+} // namespace math::expr
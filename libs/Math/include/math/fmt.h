@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <iterator>
 #include <limits>
 #include <string>
 #include <utility>
@@ -39,13 +40,20 @@ public:
 	/** Format a value to a `std::string`. */
 	inline auto format(flt value) const -> std::string;
 
+	/**
+	 * Format a value to an output iterator (e.g. into a `fmt::memory_buffer`)
+	 * without allocating.
+	 */
+	template <typename OutputIt>
+	auto format_to(OutputIt out, flt value) const -> OutputIt;
+
 	/** Print a value to `stdout`. */
 	inline void print(flt value) const;
 
 	inline void debug() const
 	{
 		::fmt::print("AlignedValues{{\n");
-		::fmt::print("   .m_fmt_string = \"{}\",\n", m_fmt_string);
+		::fmt::print("   .m_needs_sign = {},\n", m_needs_sign);
 		::fmt::print("   .m_width = {},\n", m_width);
 		::fmt::print("   .m_precision = {},\n", m_precision);
 		::fmt::print("   .m_tolerance = {},\n", m_tolerance);
@@ -53,7 +61,7 @@ public:
 	}
 
 private:
-	std::string m_fmt_string;
+	bool m_needs_sign = false;
 	usize m_width = 0;
 	usize m_precision = 0;
 	f64 m_tolerance = std::numeric_limits<flt>::epsilon();
@@ -64,6 +72,9 @@ template <typename Iter>
 AlignedValues::AlignedValues(Iter begin, Iter end, usize precision)
 	: m_tolerance(std::pow(0.1, precision))
 {
+	// NOTE: Nothing in here may allocate -- this runs for every `format_to`
+	// call on a `Vector`, `Matrix` or `Quat`.
+
 	// Iterate through all values to determine:
 	// - The max number of non-fractional digits
 	// - Whether any values are negative
@@ -76,7 +87,7 @@ AlignedValues::AlignedValues(Iter begin, Iter end, usize precision)
 	std::for_each(begin, end, [&](auto n) {
 		if (n < 0) needs_sign = true;
 
-		largest_abs = std::max(largest_abs, std::abs(n));
+		largest_abs = std::max(largest_abs, static_cast<f64>(std::abs(n)));
 
 		f64 base;
 		f64 remainder = std::modf(std::abs(n), &base);
@@ -95,26 +106,123 @@ AlignedValues::AlignedValues(Iter begin, Iter end, usize precision)
 	if (needs_sign) m_width += 1;
 	if (fixed_point) m_width += m_precision + 1;
 
-	// Build the format string
-	m_fmt_string = needs_sign
-		? "{0:> {1}.{2}f}"
-		: "{0:>{1}.{2}f}";
+	m_needs_sign = needs_sign;
 }
 
 inline auto AlignedValues::format(flt value) const -> std::string
+{
+	::fmt::memory_buffer buffer;
+	format_to(std::back_inserter(buffer), value);
+
+	return ::fmt::to_string(buffer);
+}
+
+template <typename OutputIt>
+auto AlignedValues::format_to(OutputIt out, flt value) const -> OutputIt
 {
 	if (math::nearly_equal(value, 0, m_tolerance))
 		value = 0;
 
-	return ::fmt::format(m_fmt_string, value, m_width, m_precision);
+	return m_needs_sign
+		? ::fmt::format_to(out, "{0:> {1}.{2}f}", value, m_width, m_precision)
+		: ::fmt::format_to(out, "{0:>{1}.{2}f}", value, m_width, m_precision);
 }
 
 inline void AlignedValues::print(flt value) const
 {
-	if (math::nearly_equal(value, 0, m_tolerance))
-		value = 0;
+	::fmt::memory_buffer buffer;
+	format_to(std::back_inserter(buffer), value);
 
-	::fmt::print(m_fmt_string, value, m_width, m_precision);
+	::fmt::print("{}", ::fmt::string_view(buffer.data(), buffer.size()));
 }
 
+
+// Format specs ----------------------------------------------------------------
+
+/**
+ * Parser for the format spec shared by the `fmt::formatter` specializations of
+ * the math types, which accept an optional precision: `{}` or `{:.5}`.
+ */
+struct PrecisionSpec {
+	static constexpr usize default_precision = 3;
+
+	usize precision = default_precision;
+
+	constexpr auto parse(::fmt::format_parse_context& ctx) -> decltype(ctx.begin())
+	{
+		const auto* it = ctx.begin();
+		const auto* end = ctx.end();
+
+		if (it != end && *it == '.') {
+			++it;
+			if (it == end || *it < '0' || *it > '9')
+				throw ::fmt::format_error("expected a precision after '.'");
+
+			precision = 0;
+			for (; it != end && *it >= '0' && *it <= '9'; ++it)
+				precision = precision * 10 + static_cast<usize>(*it - '0');
+		}
+
+		if (it != end && *it != '}')
+			throw ::fmt::format_error("invalid format spec: expected '}' or '.<precision>'");
+
+		return it;
+	}
+};
+
+
+// Bulk formatting -------------------------------------------------------------
+
+/**
+ * A view over a contiguous range of `Vector`s, `Matrix`es or `Quat`s that
+ * formats every element straight into the output, separated by `separator`.
+ * Create one with `math::fmt::values`.
+ */
+template <typename T>
+struct Values {
+	const T* data = nullptr;
+	usize count = 0;
+	::fmt::string_view separator = "\n";
+};
+
+/**
+ * Format a range of math values with a single call and no intermediate
+ * strings, e.g.
+ *
+ * @code
+ * fmt::format_to(std::back_inserter(buffer), "{:.2}", math::fmt::values(points, count));
+ * @endcode
+ */
+template <typename T>
+constexpr auto values(const T* data, usize count, ::fmt::string_view separator = "\n") -> Values<T>
+{
+	return Values<T>{ data, count, separator };
 }
+
+/** Format every element of a contiguous container (e.g. `std::vector`). */
+template <typename Container>
+constexpr auto values(const Container& container, ::fmt::string_view separator = "\n")
+	-> Values<std::remove_cv_t<std::remove_reference_t<decltype(*std::data(container))>>>
+{
+	return { std::data(container), std::size(container), separator };
+}
+
+} // namespace math::fmt
+
+
+template <typename T>
+struct fmt::formatter<math::fmt::Values<T>> : fmt::formatter<T> {
+	template <typename FormatContext>
+	auto format(const math::fmt::Values<T>& values, FormatContext& ctx) const -> decltype(ctx.out())
+	{
+		auto out = ctx.out();
+		for (sized::usize i = 0; i < values.count; ++i) {
+			if (i > 0)
+				out = std::copy(values.separator.begin(), values.separator.end(), out);
+
+			ctx.advance_to(out);
+			out = fmt::formatter<T>::format(values.data[i], ctx);
+		}
+		return out;
+	}
+};
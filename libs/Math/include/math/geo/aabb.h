@@ -5,6 +5,7 @@
 
 #include <sized.h>
 
+#include "math/expr.h"
 #include "math/sfinae.h"
 #include "math/matrix.h"
 #include "math/vector.h"
@@ -89,7 +90,7 @@ struct AABBox {
 
 	/** Get the center point of the bounding box. */
 	constexpr auto center() const -> Vec3 {
-		return 0.5 * (min + max);
+		return 0.5 * (expr::lazy(min) + max);
 	}
 
 	/** Get the three-dimensional size of the bounding box. */
@@ -99,7 +100,7 @@ struct AABBox {
 
 	/** Get the distance from the center point to the sides along each axis. */
 	constexpr auto radius() const -> Vec3 {
-		return 0.5 * (max - min);
+		return 0.5 * (expr::lazy(max) - min);
 	}
 
 
@@ -2,6 +2,7 @@
 
 #include <sized.h>
 
+#include "math/expr.h"
 #include "math/sfinae.h"
 #include "math/vector.h"
 
@@ -78,7 +79,7 @@ struct Plane {
 		// Compute the distance as the average of the distance for each point
 		//   = avg(p | n)
 		//   = avg(p) | n
-		flt distance = ((1 / static_cast<flt>(count)) * sum) | normal;
+		flt distance = ((1 / static_cast<flt>(count)) * expr::lazy(sum)) | normal;
 
 		return Plane{ normal, distance };
 	}
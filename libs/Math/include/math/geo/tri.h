@@ -2,6 +2,7 @@
 
 #include <sized.h>
 
+#include "math/expr.h"
 #include "math/geo/circle.h"
 #include "math/matrix.h"
 #include "math/vector.h"
@@ -168,7 +169,8 @@ struct Tri {
 
 	/** Get the cartesian point for the given barycentric coordinates. */
 	constexpr auto bary2cart(flt x, flt y, flt z) const -> Vec3 {
-		return x * v1 + y * v2 + z * v3;
+		using expr::lazy;
+		return lazy(v1) * x + lazy(v2) * y + lazy(v3) * z;
 	}
 
 	/** Get the cartesian point for the given barycentric coordinates. */
@@ -7,6 +7,7 @@
 
 #include <sized.h>
 
+#include "math/fmt.h"
 #include "math/vector.h"
 
 
@@ -150,6 +151,17 @@ public:
 	auto end() -> detail::RawIterator<flt>;
 	auto end() const -> detail::RawConstIterator<flt>;
 
+	/**
+	 * Get a pointer to the matrix elements, which are stored contiguously in
+	 * row-major order. Indexing through it is never bounds-checked.
+	 */
+	constexpr auto data() -> flt*;
+	/**
+	 * Get a pointer to the matrix elements, which are stored contiguously in
+	 * row-major order. Indexing through it is never bounds-checked.
+	 */
+	constexpr auto data() const -> const flt*;
+
 	// Member access
 	/**
 	 * Get the matrix value at the 1-based 2D index indicated by the template
@@ -211,11 +223,22 @@ public:
 	 */
 	auto m(usize row, usize col) -> flt&;
 
-	/** Get the row at the 0-based index. */
+	/**
+	 * Get the row at the 0-based index. Bounds-checked according to
+	 * `MATH_INDEX_CHECKS`.
+	 */
 	auto operator[](usize idx) -> Row&;
-	/** Get the row at the 0-based index. */
+	/**
+	 * Get the row at the 0-based index. Bounds-checked according to
+	 * `MATH_INDEX_CHECKS`.
+	 */
 	auto operator[](usize idx) const -> const Row&;
 
+	/** Get the row at the 0-based index, throwing `std::out_of_range` if invalid. */
+	auto at(usize idx) -> Row&;
+	/** Get the row at the 0-based index, throwing `std::out_of_range` if invalid. */
+	auto at(usize idx) const -> const Row&;
+
 	/**
 	 * Get the row at the 1-based index indicated by the template argument.
 	 * @tparam Index The 1-based index of the desired row.
@@ -317,6 +340,13 @@ public:
 
 	// Misc / Utility
 	auto to_string(usize precision = 3) const -> std::string;
+
+	/**
+	 * Write the same output as `to_string` to an output iterator (e.g. a
+	 * `fmt::memory_buffer`'s back-inserter) without any heap allocations.
+	 */
+	template <typename OutputIt>
+	auto format_to(OutputIt out, usize precision = 3) const -> OutputIt;
 };
 
 }
@@ -6,6 +6,7 @@
 #include <sized.h>
 
 #include "math/assert.h"
+#include "math/check.h"
 #include "math/utility.h"
 
 
@@ -46,9 +47,11 @@ constexpr auto Matrix<R,C>::identity() -> Matrix<R,C>
 	static_assert(R == C, "Identity matrix must be square");
 
 	Matrix<R,C> result;
-	for (usize r = 0; r < R; ++r)
-		for (usize c = 0; c < C; ++c)
-			result[r][c] = r == c ? 1 : 0;
+	flt* dest = result.data();
+
+	MATH_UNROLL
+	for (usize i = 0; i < R * C; ++i)
+		dest[i] = i / C == i % C ? 1 : 0;
 
 	return result;
 }
@@ -80,6 +83,20 @@ inline auto Matrix<R,C>::end() const -> detail::RawConstIterator<flt>
 	return m_data[R-1].end();
 }
 
+template <usize R, usize C>
+constexpr auto Matrix<R,C>::data() -> flt*
+{
+	static_assert(sizeof(Row) == C * sizeof(flt), "Expected tightly-packed rows");
+	return m_data[0].data();
+}
+
+template <usize R, usize C>
+constexpr auto Matrix<R,C>::data() const -> const flt*
+{
+	static_assert(sizeof(Row) == C * sizeof(flt), "Expected tightly-packed rows");
+	return m_data[0].data();
+}
+
 
 // Member access ---------------------------------------------------------------
 
@@ -134,8 +151,11 @@ inline auto Matrix<R,C>::col() const -> Col
 	static_assert(Index > 0 && Index <= C);
 
 	Col result;
+	const flt* src = data();
+
+	MATH_UNROLL
 	for (usize r = 0; r < R; ++r)
-		result[r] = m_data[r][Index-1];
+		result.data()[r] = src[r * C + Index-1];
 
 	return result;
 }
@@ -156,8 +176,11 @@ template <usize R, usize C>
 inline auto Matrix<R,C>::col(usize idx) const -> Col
 {
 	Col result;
+	const flt* src = data();
+
+	MATH_UNROLL
 	for (usize r = 0; r < R; ++r)
-		result[r] = m_data[r][idx-1];
+		result.data()[r] = src[r * C + idx-1];
 
 	return result;
 }
@@ -165,12 +188,32 @@ inline auto Matrix<R,C>::col(usize idx) const -> Col
 template <usize R, usize C>
 inline auto Matrix<R,C>::operator[](usize idx) -> Row&
 {
+	if constexpr (detail::k_check_indices)
+		detail::check_index("Matrix", R, idx);
+
 	return m_data[idx];
 }
 
 template <usize R, usize C>
 inline auto Matrix<R,C>::operator[](usize idx) const -> const Row&
 {
+	if constexpr (detail::k_check_indices)
+		detail::check_index("Matrix", R, idx);
+
+	return m_data[idx];
+}
+
+template <usize R, usize C>
+inline auto Matrix<R,C>::at(usize idx) -> Row&
+{
+	detail::check_index("Matrix", R, idx);
+	return m_data[idx];
+}
+
+template <usize R, usize C>
+inline auto Matrix<R,C>::at(usize idx) const -> const Row&
+{
+	detail::check_index("Matrix", R, idx);
 	return m_data[idx];
 }
 
@@ -181,9 +224,13 @@ template <usize R, usize C>
 inline auto Matrix<R,C>::transpose() const -> Matrix<C,R>
 {
 	Matrix<C,R> result;
-	for (usize r = 0; r < C; ++r)
-		for (usize c = 0; c < R; ++c)
-			result[r][c] = m_data[c][r];
+	flt* dest = result.data();
+	const flt* src = data();
+
+	// `dest` is CxR, so its row `i / R` is the source's column
+	MATH_UNROLL
+	for (usize i = 0; i < R * C; ++i)
+		dest[i] = src[(i % R) * C + i / R];
 
 	return result;
 }
@@ -195,9 +242,11 @@ template <usize R, usize C>
 constexpr auto Matrix<R,C>::operator*(flt value) const -> Matrix
 {
 	auto result = *this;
-	for (usize r = 0; r < R; ++r)
-		for (usize c = 0; c < C; ++c)
-			result.m_data[r][c] *= value;
+	flt* dest = result.data();
+
+	MATH_UNROLL
+	for (usize i = 0; i < R * C; ++i)
+		dest[i] *= value;
 
 	return result;
 }
@@ -205,9 +254,11 @@ constexpr auto Matrix<R,C>::operator*(flt value) const -> Matrix
 template <usize R, usize C>
 inline auto Matrix<R,C>::operator*=(flt value) -> Matrix&
 {
-	for (usize r = 0; r < R; ++r)
-		for (usize c = 0; c < C; ++c)
-			m_data[r][c] *= value;
+	flt* dest = data();
+
+	MATH_UNROLL
+	for (usize i = 0; i < R * C; ++i)
+		dest[i] *= value;
 
 	return *this;
 }
@@ -225,12 +276,26 @@ constexpr auto operator*(sized::flt lhs, const math::Matrix<R,C>& rhs) -> math::
 template <sized::usize R, sized::usize N, sized::usize C>
 inline auto operator*(const math::Matrix<R,N>& lhs, const math::Matrix<N,C>& rhs) -> math::Matrix<R,C>
 {
+	// Accumulate each row of the result as a linear combination of the rows of
+	// `rhs`, which avoids transposing it and keeps the innermost loop running
+	// over contiguous memory. Each element still sums its products in the same
+	// order as `lhs[r] | rhs.col(c)`.
 	math::Matrix<R,C> result;
-	auto rhs_cols = rhs.transpose();
-
-	for (sized::usize r = 0; r < R; ++r)
-		for (sized::usize c = 0; c < C; ++c)
-			result[r][c] = lhs[r] | rhs_cols[c];
+	sized::flt* dest = result.data();
+	const sized::flt* l = lhs.data();
+	const sized::flt* r = rhs.data();
+
+	MATH_UNROLL
+	for (sized::usize row = 0; row < R; ++row) {
+		MATH_UNROLL
+		for (sized::usize n = 0; n < N; ++n) {
+			sized::flt factor = l[row * N + n];
+
+			MATH_UNROLL
+			for (sized::usize col = 0; col < C; ++col)
+				dest[row * C + col] += factor * r[n * C + col];
+		}
+	}
 
 	return result;
 }
@@ -251,11 +316,20 @@ inline auto operator*(const math::Matrix<R,N>& lhs, const math::Matrix<N,C>& rhs
 template <sized::usize R, sized::usize C>
 inline auto operator*(const math::Vector<R>& lhs, const math::Matrix<R,C>& rhs) -> math::Vector<C>
 {
-	math::Vector<C> result;
-	auto rhs_cols = rhs.transpose();
+	// Same linear-combination approach as matrix multiplication, which sums
+	// each element's products in the same order as `lhs | rhs.col(c)`
+	math::Vector<C> result {};
+	sized::flt* dest = result.data();
+	const sized::flt* m = rhs.data();
 
-	for (sized::usize c = 0; c < C; ++c)
-		result[c] = lhs | rhs_cols[c];
+	MATH_UNROLL
+	for (sized::usize r = 0; r < R; ++r) {
+		sized::flt factor = lhs.data()[r];
+
+		MATH_UNROLL
+		for (sized::usize c = 0; c < C; ++c)
+			dest[c] += factor * m[r * C + c];
+	}
 
 	return result;
 }
@@ -277,9 +351,18 @@ template <sized::usize R, sized::usize C>
 inline auto operator*(const math::Matrix<R,C>& lhs, const math::Vector<C>& rhs) -> math::Vector<R>
 {
 	math::Vector<R> result;
+	const sized::flt* m = lhs.data();
+
+	MATH_UNROLL
+	for (sized::usize r = 0; r < R; ++r) {
+		sized::flt sum = 0;
 
-	for (sized::usize r = 0; r < R; ++r)
-		result[r] = lhs[r] | rhs;
+		MATH_UNROLL
+		for (sized::usize c = 0; c < C; ++c)
+			sum += m[r * C + c] * rhs.data()[c];
+
+		result.data()[r] = sum;
+	}
 
 	return result;
 }
@@ -467,14 +550,13 @@ inline auto Matrix<R,C>::is_orthogonal(flt tolerance) const -> bool
 template <usize R, usize C>
 constexpr auto Matrix<R,C>::is_identity(flt tolerance) const -> bool
 {
-	for (usize r = 0; r < R; ++r) {
-		for (usize c = 0; c < C; ++c) {
-			if (r != c && !math::nearly_equal(m_data[r][c], 0, tolerance)
-				|| r == c && !math::nearly_equal(m_data[r][c], 1, tolerance))
-			{
-				return false;
-			}
-		}
+	const flt* src = data();
+
+	MATH_UNROLL
+	for (usize i = 0; i < R * C; ++i) {
+		flt expected = i / C == i % C ? 1 : 0;
+		if (!math::nearly_equal(src[i], expected, tolerance))
+			return false;
 	}
 	return true;
 }
@@ -484,27 +566,70 @@ constexpr auto Matrix<R,C>::is_identity(flt tolerance) const -> bool
 
 template <usize R, usize C>
 auto Matrix<R,C>::to_string(usize precision) const -> std::string
+{
+	::fmt::memory_buffer buffer;
+	format_to(std::back_inserter(buffer), precision);
+
+	return ::fmt::to_string(buffer);
+}
+
+template <usize R, usize C>
+template <typename OutputIt>
+auto Matrix<R,C>::format_to(OutputIt out, usize precision) const -> OutputIt
 {
 	auto formatter = fmt::AlignedValues(begin(), end(), precision);
+	const flt* src = data();
 
-	std::string result;
 	for (usize r = 0; r < R; ++r) {
-		result += "| ";
+		out = ::fmt::format_to(out, "| ");
 		for (usize c = 0; c < C; ++c) {
-			result += formatter.format(m_data[r][c]);
+			out = formatter.format_to(out, src[r * C + c]);
 
 			if (c < C - 1)
-				result += "  ";
+				out = ::fmt::format_to(out, "  ");
 		}
-		result += " |\n";
+		out = ::fmt::format_to(out, " |\n");
 	}
 
-	return result;
+	return out;
 }
 
+
+namespace detail {
+
+template <usize R, usize C>
+auto matrix_base(const ::math::Matrix<R,C>& matrix) -> const ::math::Matrix<R,C>&;
+
+/** Whether `T` is a `Matrix` or derived from one (e.g. `RotationMatrix`). */
+template <typename T, typename = void>
+constexpr bool is_matrix = false;
+
+template <typename T>
+constexpr bool is_matrix<T, std::void_t<decltype(matrix_base(std::declval<const T&>()))>> = true;
+
+} // namespace detail
+
 }
 
 
+// fmt support -----------------------------------------------------------------
+
+/**
+ * Format a matrix, or any type derived from one, like `to_string`. Accepts an
+ * optional precision: `{:.5}`
+ */
+template <typename T>
+struct fmt::formatter<T, char, std::enable_if_t<math::detail::is_matrix<T>>>
+	: math::fmt::PrecisionSpec
+{
+	template <typename FormatContext>
+	auto format(const T& value, FormatContext& ctx) const -> decltype(ctx.out())
+	{
+		return value.format_to(ctx.out(), precision);
+	}
+};
+
+
 #undef VALIDATE_INDEX_2D
 #undef EXPAND_INDEX_2D_SUBSCRIPT
 #undef EXPAND_INDEX_2D_COMMA
@@ -84,6 +84,19 @@ struct Quat {
 	auto to_string(usize precision = 3) const -> std::string;
 	auto to_string(const fmt::AlignedValues& formatter) const -> std::string;
 
+	/**
+	 * Write the same output as `to_string` to an output iterator (e.g. a
+	 * `fmt::memory_buffer`'s back-inserter) without any heap allocations.
+	 */
+	template <typename OutputIt>
+	auto format_to(OutputIt out, usize precision = 3) const -> OutputIt;
+	/**
+	 * Write the same output as `to_string` to an output iterator (e.g. a
+	 * `fmt::memory_buffer`'s back-inserter) without any heap allocations.
+	 */
+	template <typename OutputIt>
+	auto format_to(OutputIt out, const fmt::AlignedValues& formatter) const -> OutputIt;
+
 	// Iterator support
 	auto begin() -> detail::RawIterator<flt>;
 	auto begin() const -> detail::RawConstIterator<flt>;
@@ -92,9 +105,16 @@ struct Quat {
 	auto end() const -> detail::RawConstIterator<flt>;
 
 	// Subscript operator
+	/** Access `w`, `x`, `y`, `z` by index. Checked per `MATH_INDEX_CHECKS`. */
 	auto operator[](usize idx) -> flt&;
+	/** Access `w`, `x`, `y`, `z` by index. Checked per `MATH_INDEX_CHECKS`. */
 	auto operator[](usize idx) const -> flt;
 
+	/** Access `w`, `x`, `y`, `z` by index, throwing `std::out_of_range` if invalid. */
+	auto at(usize idx) -> flt&;
+	/** Access `w`, `x`, `y`, `z` by index, throwing `std::out_of_range` if invalid. */
+	auto at(usize idx) const -> flt;
+
 	// Structured binding support
 	template <usize Index> auto get() &       { return get_helper<Index>(*this); }
 	template <usize Index> auto get() const&  { return get_helper<Index>(*this); }
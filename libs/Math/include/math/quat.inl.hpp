@@ -6,6 +6,7 @@
 #include <utility>
 
 #include "math/assert.h"
+#include "math/check.h"
 #include "math/euler.h"
 #include "math/matrix/rotation.h"
 #include "math/utility.h"
@@ -295,11 +296,32 @@ inline auto Quat::to_string(usize precision) const -> std::string
 
 inline auto Quat::to_string(const fmt::AlignedValues& formatter) const -> std::string
 {
-	return ::fmt::format("[ {}  ( {}  {}  {} )]",
-		formatter.format(w),
-		formatter.format(x),
-		formatter.format(y),
-		formatter.format(z));
+	::fmt::memory_buffer buffer;
+	format_to(std::back_inserter(buffer), formatter);
+
+	return ::fmt::to_string(buffer);
+}
+
+template <typename OutputIt>
+auto Quat::format_to(OutputIt out, usize precision) const -> OutputIt
+{
+	auto formatter = fmt::AlignedValues(begin(), end(), precision);
+	return format_to(out, formatter);
+}
+
+template <typename OutputIt>
+auto Quat::format_to(OutputIt out, const fmt::AlignedValues& formatter) const -> OutputIt
+{
+	out = ::fmt::format_to(out, "[ ");
+	out = formatter.format_to(out, w);
+	out = ::fmt::format_to(out, "  ( ");
+	out = formatter.format_to(out, x);
+	out = ::fmt::format_to(out, "  ");
+	out = formatter.format_to(out, y);
+	out = ::fmt::format_to(out, "  ");
+	out = formatter.format_to(out, z);
+
+	return ::fmt::format_to(out, " )]");
 }
 
 
@@ -328,22 +350,36 @@ inline auto Quat::end() const -> detail::RawConstIterator<flt>
 
 // Subscript operator ----------------------------------------------------------
 
+// `w`, `x`, `y` and `z` are laid out contiguously, which lets the subscript
+// operators index straight into them instead of switching on `idx`
+static_assert(sizeof(Quat) == 4 * sizeof(flt));
+
 inline auto Quat::operator[](usize idx) -> flt&
 {
-	switch (idx) {
-		case 0: return w;
-		default: return vector[idx + 1];
-	}
+	if constexpr (detail::k_check_indices)
+		detail::check_index("Quat", 4, idx);
+
+	return (&w)[idx]; // NOLINT(*-pointer-arithmetic)
 }
 
 inline auto Quat::operator[](usize idx) const -> flt
 {
-	ASSERT(idx < 4, "Index out of range");
+	if constexpr (detail::k_check_indices)
+		detail::check_index("Quat", 4, idx);
 
-	switch (idx) {
-		case 0: return w;
-		default: return vector[idx + 1];
-	}
+	return (&w)[idx]; // NOLINT(*-pointer-arithmetic)
+}
+
+inline auto Quat::at(usize idx) -> flt&
+{
+	detail::check_index("Quat", 4, idx);
+	return (&w)[idx]; // NOLINT(*-pointer-arithmetic)
+}
+
+inline auto Quat::at(usize idx) const -> flt
+{
+	detail::check_index("Quat", 4, idx);
+	return (&w)[idx]; // NOLINT(*-pointer-arithmetic)
 }
 
 
@@ -375,3 +411,16 @@ struct tuple_element<Index, ::math::Quat> {
 
 }
 
+
+
+// fmt support -----------------------------------------------------------------
+
+/** Format a quaternion like `to_string`. Accepts an optional precision: `{:.5}` */
+template <>
+struct fmt::formatter<math::Quat> : math::fmt::PrecisionSpec {
+	template <typename FormatContext>
+	auto format(const math::Quat& value, FormatContext& ctx) const -> decltype(ctx.out())
+	{
+		return value.format_to(ctx.out(), precision);
+	}
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vector>
+
+#include <sized.h>
+
+#include "math/vector.h"
+
+namespace math {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/**
+ * A uniform grid over points, for finding the points near a position. Cells
+ * are hashed into a table about the size of the point set, so the grid can
+ * cover unbounded space without storing empty cells.
+ *
+ * `build` sorts the points by their cell's bucket with a counting sort: a
+ * count per bucket, a prefix sum over the counts, then a scatter of the points
+ * into a single array. It's done in two passes, first into ranges of buckets
+ * and then each range into its buckets, so that every stage runs in parallel.
+ * Nothing is allocated per cell, so the grid is cheap enough to rebuild every
+ * frame for moving points. The buffers are kept between builds, so they're
+ * only reallocated when the number of points grows. The result is the same for
+ * any number of threads.
+ *
+ * Queries visit the cells overlapping the search and check each point's
+ * distance, so they're fastest when the cell size is around the query radius.
+ */
+class SpatialHash {
+public:
+	/**
+	 * Create an empty grid of cubic cells `cell_size` across, which builds with
+	 * up to `threads` threads (0 uses every hardware thread).
+	 */
+	explicit SpatialHash(flt cell_size, usize threads = 0);
+
+	/**
+	 * Index a new set of points, replacing the previous one. The points are
+	 * copied, in bucket order, so the array needn't outlive the grid.
+	 */
+	void build(const Vec3* points, usize count);
+
+	auto cell_size() const -> flt { return m_cell_size; }
+	/** The number of points in the grid. */
+	auto size() const -> usize { return m_indices.size(); }
+
+	/**
+	 * Replace the contents of `out` with the indices of the points within
+	 * `radius` of `center`, in no particular order.
+	 */
+	void query_radius(const Vec3& center, flt radius, std::vector<u32>& out) const;
+
+	/**
+	 * Replace the contents of `out` with the indices of the `k` points nearest
+	 * to `center` (or all of them, if there are fewer), nearest first. Ties are
+	 * broken by index.
+	 */
+	void query_nearest(const Vec3& center, usize k, std::vector<u32>& out) const;
+
+private:
+	struct Cell {
+		i32 x;
+		i32 y;
+		i32 z;
+	};
+
+	auto cell_of(const Vec3& point) const -> Cell;
+	auto bucket_of(const Cell& cell) const -> u32;
+
+	/** Call `fn(index, sq_distance)` for each point in a cell. */
+	template <typename Fn>
+	void visit_cell(const Cell& cell, const Vec3& center, const Fn& fn) const;
+
+	flt m_cell_size;
+	flt m_inv_cell_size;
+	usize m_threads;
+
+	/** `m_bucket_mask + 1` is the size of the table, a power of two. */
+	u32 m_bucket_mask = 0;
+	/** Where each bucket's points start in `m_indices`, plus the end. */
+	std::vector<u32> m_starts;
+	/** The points' indices, grouped by bucket. */
+	std::vector<u32> m_indices;
+	/** The points' positions, in the order of `m_indices`. */
+	std::vector<Vec3> m_points;
+
+	/** The smallest and largest cells with any points. */
+	Cell m_min_cell { 0, 0, 0 };
+	Cell m_max_cell { -1, -1, -1 };
+
+	// Scratch for `build`
+	/** Each point's bucket. */
+	std::vector<u32> m_buckets;
+	/** The points' indices, grouped by ranges of buckets. */
+	std::vector<u32> m_order;
+	/** Where each thread's points of each range of buckets go in `m_order`. */
+	std::vector<u32> m_group_offsets;
+	/** Where each range of buckets' points start in `m_order`, plus the end. */
+	std::vector<u32> m_group_starts;
+};
+
+} // namespace math
@@ -10,6 +10,21 @@
 
 #include <sized.h>
 
+/**
+ * Ask the compiler to fully unroll the loop that follows. Used for the small,
+ * fixed-size loops in `Vector` and `Matrix`, so they compile to straight-line
+ * code even when the optimizer's own heuristics would keep the loop. MSVC has no
+ * equivalent pragma, but unrolls loops this small on its own.
+ */
+#if defined(__clang__)
+	#define MATH_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__)
+	#define MATH_UNROLL _Pragma("GCC unroll 16")
+#else
+	#define MATH_UNROLL
+#endif
+
+
 namespace math {
 
 using namespace sized; // NOLINT(*-using-namespace)
@@ -107,10 +107,28 @@ public:
 	auto end() -> detail::RawIterator<flt>;
 	auto end() const -> detail::RawConstIterator<flt>;
 
+	/**
+	 * Get a pointer to the contiguous components. Indexing through it is never
+	 * bounds-checked.
+	 */
+	constexpr auto data() -> flt*;
+	/**
+	 * Get a pointer to the contiguous components. Indexing through it is never
+	 * bounds-checked.
+	 */
+	constexpr auto data() const -> const flt*;
+
 	// Subscript operator
+	/** Access a component. Bounds-checked according to `MATH_INDEX_CHECKS`. */
 	auto operator[](usize idx) -> flt&;
+	/** Access a component. Bounds-checked according to `MATH_INDEX_CHECKS`. */
 	auto operator[](usize idx) const -> flt;
 
+	/** Access a component, throwing `std::out_of_range` if `idx` is invalid. */
+	auto at(usize idx) -> flt&;
+	/** Access a component, throwing `std::out_of_range` if `idx` is invalid. */
+	auto at(usize idx) const -> flt;
+
 	// Unary negation
 	auto operator-() const -> Vector;
 
@@ -179,8 +197,18 @@ public:
 	auto to_string(usize precision = 3) const -> std::string;
 	auto to_string(const fmt::AlignedValues& formatter) const -> std::string;
 
-private:
-	void validate_index(usize idx) const;
+	/**
+	 * Write the same output as `to_string` to an output iterator (e.g. a
+	 * `fmt::memory_buffer`'s back-inserter) without any heap allocations.
+	 */
+	template <typename OutputIt>
+	auto format_to(OutputIt out, usize precision = 3) const -> OutputIt;
+	/**
+	 * Write the same output as `to_string` to an output iterator (e.g. a
+	 * `fmt::memory_buffer`'s back-inserter) without any heap allocations.
+	 */
+	template <typename OutputIt>
+	auto format_to(OutputIt out, const fmt::AlignedValues& formatter) const -> OutputIt;
 };
 
 } // namespace math
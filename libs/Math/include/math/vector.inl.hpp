@@ -7,6 +7,7 @@
 #include <utility>
 
 #include "math/assert.h"
+#include "math/check.h"
 #include "math/polar.h"
 
 
@@ -24,6 +25,7 @@ template <usize D>
 constexpr auto Vector<D>::all(flt value) -> Vector
 {
 	Vector result;
+	MATH_UNROLL
 	for (usize i = 0; i < D; ++i)
 		result.components[i] = value;
 
@@ -139,28 +141,53 @@ inline auto Vector<D>::end() const -> detail::RawConstIterator<flt>
 }
 
 
+// Raw data access -------------------------------------------------------------
+
+template <usize D>
+constexpr auto Vector<D>::data() -> flt*
+{
+	return components;
+}
+
+template <usize D>
+constexpr auto Vector<D>::data() const -> const flt*
+{
+	return components;
+}
+
+
 // Subscript operator ----------------------------------------------------------
 
 template <usize D>
 inline auto Vector<D>::operator[](usize idx) -> flt&
 {
-	validate_index(idx);
+	if constexpr (detail::k_check_indices)
+		detail::check_index("Vector", D, idx);
+
 	return components[idx];
 }
 
 template <usize D>
 inline auto Vector<D>::operator[](usize idx) const -> flt
 {
-	validate_index(idx);
+	if constexpr (detail::k_check_indices)
+		detail::check_index("Vector", D, idx);
+
 	return components[idx];
 }
 
 template <usize D>
-inline void Vector<D>::validate_index(usize idx) const // NOLINT(*-unused-parameters)
+inline auto Vector<D>::at(usize idx) -> flt&
 {
-	ASSERT(idx < D,
-		"Index out of range for Vec<{}>: Expected < {}, received {}",
-		D, D, idx);
+	detail::check_index("Vector", D, idx);
+	return components[idx];
+}
+
+template <usize D>
+inline auto Vector<D>::at(usize idx) const -> flt
+{
+	detail::check_index("Vector", D, idx);
+	return components[idx];
 }
 
 
@@ -170,6 +197,7 @@ template <usize D>
 inline auto Vector<D>::operator-() const -> Vector
 {
 	auto result = *this;
+	MATH_UNROLL
 	for (usize i = 0; i < D; ++i)
 		result.components[i] *= -1;
 
@@ -183,6 +211,7 @@ template <usize D>
 inline auto Vector<D>::operator+(const Vector& other) const -> Vector
 {
 	auto result = *this;
+	MATH_UNROLL
 	for (usize i = 0; i < D; ++i)
 		result.components[i] += other.components[i];
 
@@ -192,6 +221,7 @@ inline auto Vector<D>::operator+(const Vector& other) const -> Vector
 template <usize D>
 inline auto Vector<D>::operator+=(const Vector& other) -> Vector&
 {
+	MATH_UNROLL
 	for (usize i = 0; i < D; ++i)
 		components[i] += other.components[i];
 
@@ -205,6 +235,7 @@ template <usize D>
 inline auto Vector<D>::operator-(const Vector& other) const -> Vector
 {
 	auto result = *this;
+	MATH_UNROLL
 	for (usize i = 0; i < D; ++i)
 		result.components[i] -= other.components[i];
 
@@ -214,6 +245,7 @@ inline auto Vector<D>::operator-(const Vector& other) const -> Vector
 template <usize D>
 inline auto Vector<D>::operator-=(const Vector& other) -> Vector&
 {
+	MATH_UNROLL
 	for (usize i = 0; i < D; ++i)
 		components[i] -= other.components[i];
 
@@ -227,6 +259,7 @@ template <usize D>
 inline auto Vector<D>::operator*(flt magnitude) const -> Vector
 {
 	auto result = *this;
+	MATH_UNROLL
 	for (usize i = 0; i < D; ++i)
 		result.components[i] *= magnitude;
 
@@ -236,6 +269,7 @@ inline auto Vector<D>::operator*(flt magnitude) const -> Vector
 template <usize D>
 inline auto Vector<D>::operator*=(flt magnitude) -> Vector&
 {
+	MATH_UNROLL
 	for (usize i = 0; i < D; ++i)
 		components[i] *= magnitude;
 
@@ -261,6 +295,7 @@ inline auto Vector<D>::operator/(flt magnitude) const -> Vector
 		return Zero;
 
 	auto result = *this;
+	MATH_UNROLL
 	for (usize i = 0; i < D; ++i)
 		result.components[i] /= magnitude;
 
@@ -271,12 +306,14 @@ template <usize D>
 inline auto Vector<D>::operator/=(flt magnitude) -> Vector&
 {
 	if (math::nearly_equal(magnitude, 0)) {
+		MATH_UNROLL
 		for (usize i = 0; i < D; ++i)
 			components[i] = 0;
 
 		return *this;
 	}
 
+	MATH_UNROLL
 	for (usize i = 0; i < D; ++i)
 		components[i] /= magnitude;
 
@@ -292,6 +329,7 @@ inline auto Vector<D>::operator==(const Vector& other) const -> bool
 	if (this == &other)
 		return true;
 
+	MATH_UNROLL
 	for (usize i = 0; i < D; ++i)
 		if (!math::nearly_equal(components[i], other.components[i]))
 			return false;
@@ -305,6 +343,7 @@ inline auto Vector<D>::operator!=(const Vector& other) const -> bool
 	if (this == &other)
 		return false;
 
+	MATH_UNROLL
 	for (usize i = 0; i < D; ++i)
 		if (!math::nearly_equal(components[i], other.components[i]))
 			return true;
@@ -331,6 +370,7 @@ template <usize D>
 inline auto Vector<D>::sq_length() const -> flt
 {
 	flt result = 0;
+	MATH_UNROLL
 	for (usize i = 0; i < D; ++i)
 		result += components[i] * components[i];
 
@@ -354,6 +394,7 @@ inline auto Vector<D>::normal() const -> Vector
 	flt scale = 1.0 / std::sqrt(sq_len);
 
 	Vector result;
+	MATH_UNROLL
 	for (usize i = 0; i < D; ++i)
 		result.components[i] = components[i] * scale;
 
@@ -386,6 +427,7 @@ inline void Vector<D>::normalize()
 		return;
 
 	flt scale = 1.0 / std::sqrt(sq_len);
+	MATH_UNROLL
 	for (usize i = 0; i < D; ++i)
 		components[i] *= scale;
 }
@@ -403,6 +445,7 @@ inline auto Vector<D>::length_and_direction() const -> std::tuple<flt, Vector>
 
 	flt scale = 1 / len;
 	Vector normal;
+	MATH_UNROLL
 	for (usize i = 0; i < D; ++i)
 		normal.components[i] = components[i] * scale;
 
@@ -416,6 +459,7 @@ template <usize D>
 inline auto Vector<D>::dist(const Vector& other) const -> flt
 {
 	flt result = 0;
+	MATH_UNROLL
 	for (usize i = 0; i < D; ++i) {
 		auto diff = other.components[i] - components[i];
 		result += diff * diff;
@@ -437,6 +481,7 @@ template <usize D>
 inline auto Vector<D>::dot(const Vector& other) const -> flt
 {
 	flt result = 0;
+	MATH_UNROLL
 	for (usize i = 0; i < D; ++i)
 		result += components[i] * other.components[i];
 
@@ -500,16 +545,46 @@ auto Vector<D>::to_string(usize precision) const -> std::string
 template <usize D>
 inline auto Vector<D>::to_string(const fmt::AlignedValues& formatter) const -> std::string
 {
-	std::string result = "[ ";
+	::fmt::memory_buffer buffer;
+	format_to(std::back_inserter(buffer), formatter);
+
+	return ::fmt::to_string(buffer);
+}
+
+template <usize D>
+template <typename OutputIt>
+auto Vector<D>::format_to(OutputIt out, usize precision) const -> OutputIt
+{
+	auto formatter = fmt::AlignedValues(begin(), end(), precision);
+	return format_to(out, formatter);
+}
+
+template <usize D>
+template <typename OutputIt>
+auto Vector<D>::format_to(OutputIt out, const fmt::AlignedValues& formatter) const -> OutputIt
+{
+	out = ::fmt::format_to(out, "[ ");
 	for (usize i = 0; i < D; ++i) {
-		result += formatter.format(components[i]);
+		out = formatter.format_to(out, components[i]);
 
 		if (i < D - 1)
-			result += "  ";
+			out = ::fmt::format_to(out, "  ");
 	}
-	result += " ]";
 
-	return result;
+	return ::fmt::format_to(out, " ]");
 }
 
 } // namespace math
+
+
+// fmt support -----------------------------------------------------------------
+
+/** Format a vector like `to_string`. Accepts an optional precision: `{:.5}` */
+template <sized::usize D>
+struct fmt::formatter<math::Vector<D>> : math::fmt::PrecisionSpec {
+	template <typename FormatContext>
+	auto format(const math::Vector<D>& value, FormatContext& ctx) const -> decltype(ctx.out())
+	{
+		return value.format_to(ctx.out(), precision);
+	}
+};
@@ -0,0 +1,186 @@
+#include "math/batch.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#include "math/batch/kernels.h"
+
+
+namespace math::batch {
+
+namespace {
+
+using detail::Kernels;
+
+constexpr flt k_epsilon = std::numeric_limits<flt>::epsilon();
+
+/** The kernel table for an instruction set, or `nullptr` if it wasn't compiled. */
+auto kernels_for(Isa isa) -> const Kernels*
+{
+	switch (isa) {
+		case Isa::Baseline: return &detail::baseline::kernels();
+#ifdef MATH_BATCH_X86
+		case Isa::AVX2: return &detail::avx2::kernels();
+		case Isa::AVX512: return &detail::avx512::kernels();
+#endif
+		default: return nullptr;
+	}
+}
+
+/** The most capable supported kernels, unless overridden by `MATH_ISA`. */
+auto default_kernels() -> const Kernels*
+{
+	const char* forced = std::getenv("MATH_ISA"); // NOLINT(concurrency-mt-unsafe)
+	if (forced) {
+		for (auto isa : { Isa::Baseline, Isa::AVX2, Isa::AVX512 })
+			if (std::strcmp(forced, isa_name(isa)) == 0 && supported(isa))
+				return kernels_for(isa);
+	}
+
+	for (auto isa : { Isa::AVX512, Isa::AVX2 })
+		if (supported(isa))
+			return kernels_for(isa);
+
+	return kernels_for(Isa::Baseline);
+}
+
+auto active() -> std::atomic<const Kernels*>&
+{
+	static std::atomic<const Kernels*> result { default_kernels() };
+	return result;
+}
+
+auto table() -> const Kernels&
+{
+	return *active().load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+
+// Dispatch --------------------------------------------------------------------
+
+auto isa() -> Isa
+{
+	return table().isa;
+}
+
+auto supported(Isa isa) -> bool
+{
+	return kernels_for(isa) != nullptr
+		&& static_cast<u8>(isa) <= static_cast<u8>(cpu_isa());
+}
+
+auto force_isa(Isa isa) -> bool
+{
+	if (!supported(isa))
+		return false;
+
+	active().store(kernels_for(isa), std::memory_order_relaxed);
+	return true;
+}
+
+void reset_isa()
+{
+	active().store(default_kernels(), std::memory_order_relaxed);
+}
+
+
+// Kernels ---------------------------------------------------------------------
+
+void transform_points(const Mat4x4& m, const Vec3* points, Vec3* out, usize count)
+{
+	table().transform_points(m, points, out, count);
+}
+
+// Bound by the square root and division, which take as long per element at
+// every vector width, so the wider instruction sets gain nothing, and the
+// baseline is all there is
+void normalize(Vec3* vectors, usize count)
+{
+	// Through a flat array, since GCC can't tell whether the stores through
+	// the union members alias the next vector's loads
+	static_assert(sizeof(Vec3) == 3 * sizeof(flt));
+	flt* data = &vectors->x;
+
+	for (usize i = 0; i < count; ++i) {
+		flt x = data[i * 3];
+		flt y = data[i * 3 + 1];
+		flt z = data[i * 3 + 2];
+
+		flt sq_len = x * x + y * y + z * z;
+
+		// Same special cases as `Vector::normalize`, but as selects instead of
+		// early returns so the loop stays branch-free
+		flt scale = 1 / std::sqrt(sq_len);
+		scale = std::abs(sq_len - 1) < k_epsilon ? 1 : scale;
+		scale = std::abs(sq_len) < k_epsilon ? 0 : scale;
+
+		data[i * 3] = x * scale;
+		data[i * 3 + 1] = y * scale;
+		data[i * 3 + 2] = z * scale;
+	}
+}
+
+void cull_spheres(
+	const geo::Plane* planes, usize plane_count,
+	const geo::Sphere* spheres, usize count,
+	u8* out_visible)
+{
+	table().cull_spheres(planes, plane_count, spheres, count, out_visible);
+}
+
+void cull_cones(
+	const Vec3& eye,
+	const geo::Sphere* spheres, const Vec3* axes, const flt* cutoffs, usize count,
+	u8* out_visible)
+{
+	table().cull_cones(eye, spheres, axes, cutoffs, count, out_visible);
+}
+
+void intersect_ray_tris(const geo::Ray& ray, const geo::Tri* tris, usize count, flt* out_t)
+{
+	table().intersect_ray_tris(ray, tris, count, out_t);
+}
+
+// Calls `sin` and `atan2` for every element, which don't vectorize, so the
+// wider instruction sets gain nothing, and the baseline is all there is
+void slerp(const Quat* src, const Quat* dest, flt t, Quat* out, usize count)
+{
+	for (usize i = 0; i < count; ++i) {
+		const auto& a = src[i];
+		const auto& b = dest[i];
+
+		flt cos_omega = a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+
+		// Take the shortest arc by flipping `b` if it's on the far hemisphere
+		flt sign = cos_omega < 0 ? -1 : 1;
+		cos_omega *= sign;
+
+		flt k0, k1;
+		if (cos_omega > 1 - 1e-4) {
+			// Very close -- fall back to lerp to avoid dividing by ~0
+			k0 = 1 - t;
+			k1 = t;
+		}
+		else {
+			flt sin_omega = std::sqrt(1 - cos_omega * cos_omega);
+			flt omega = std::atan2(sin_omega, cos_omega);
+			flt inv_sin_omega = 1 / sin_omega;
+
+			k0 = std::sin((1 - t) * omega) * inv_sin_omega;
+			k1 = std::sin(t * omega) * inv_sin_omega;
+		}
+		k1 *= sign;
+
+		out[i].w = a.w * k0 + b.w * k1;
+		out[i].x = a.x * k0 + b.x * k1;
+		out[i].y = a.y * k0 + b.y * k1;
+		out[i].z = a.z * k0 + b.z * k1;
+	}
+}
+
+} // namespace math::batch
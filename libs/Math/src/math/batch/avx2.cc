@@ -0,0 +1,4 @@
+#define MATH_BATCH_NAMESPACE avx2
+#define MATH_BATCH_ISA ::math::Isa::AVX2
+#define MATH_BATCH_TARGET "avx2,fma"
+#include "math/batch/kernels.inl.hpp"
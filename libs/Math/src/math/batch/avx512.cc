@@ -0,0 +1,4 @@
+#define MATH_BATCH_NAMESPACE avx512
+#define MATH_BATCH_ISA ::math::Isa::AVX512
+#define MATH_BATCH_TARGET "avx512f,avx512vl,avx2,fma"
+#include "math/batch/kernels.inl.hpp"
@@ -0,0 +1,3 @@
+#define MATH_BATCH_NAMESPACE baseline
+#define MATH_BATCH_ISA ::math::Isa::Baseline
+#include "math/batch/kernels.inl.hpp"
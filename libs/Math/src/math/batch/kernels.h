@@ -0,0 +1,29 @@
+#pragma once
+
+#include <sized.h>
+
+#include "math/batch.h"
+
+namespace math::batch::detail {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/** A table of kernels compiled for one instruction set. */
+struct Kernels {
+	Isa isa;
+
+	void (*transform_points)(const Mat4x4&, const Vec3*, Vec3*, usize);
+	void (*cull_spheres)(const geo::Plane*, usize, const geo::Sphere*, usize, u8*);
+	void (*cull_cones)(const Vec3&, const geo::Sphere*, const Vec3*, const flt*, usize, u8*);
+	void (*intersect_ray_tris)(const geo::Ray&, const geo::Tri*, usize, flt*);
+};
+
+// Each of these is defined by a translation unit compiled with the
+// corresponding target flags (see `kernels.inl.hpp`)
+namespace baseline { auto kernels() -> const Kernels&; }
+
+#ifdef MATH_BATCH_X86
+namespace avx2 { auto kernels() -> const Kernels&; }
+namespace avx512 { auto kernels() -> const Kernels&; }
+#endif
+
+} // namespace math::batch::detail
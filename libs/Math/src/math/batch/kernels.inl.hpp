@@ -0,0 +1,187 @@
+// The portable source for every batch kernel. Each `batch/<isa>.cc` translation
+// unit defines `MATH_BATCH_NAMESPACE`, and `MATH_BATCH_TARGET` for anything but
+// the baseline, and includes this file. The vectorization itself is left to the
+// compiler.
+//
+// With GCC and Clang, only the kernels are compiled for the target, through a
+// function attribute, and the unit itself is built with the baseline flags.
+// Any header-defined inline function it emits, e.g. `std::abs`, is then safe
+// for the linker to keep over another unit's copy. MSVC has no such attribute,
+// so there the build compiles the whole unit for the target instead, and the
+// kernels deliberately touch nothing but plain data members and <cmath>: no
+// `Vector` operators, no constructors. All kernels have internal linkage.
+
+#ifndef MATH_BATCH_NAMESPACE
+	#error "MATH_BATCH_NAMESPACE must be defined before including kernels.inl.hpp"
+#endif
+
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include <sized.h>
+
+#include "math/batch/kernels.h"
+
+#if defined(MATH_BATCH_TARGET) && !defined(_MSC_VER)
+	#define MATH_BATCH_KERNEL __attribute__((target(MATH_BATCH_TARGET)))
+#else
+	#define MATH_BATCH_KERNEL
+#endif
+
+namespace math::batch::detail::MATH_BATCH_NAMESPACE {
+
+namespace {
+
+constexpr flt k_epsilon = std::numeric_limits<flt>::epsilon();
+/** The spheres `cull_spheres` tests against every plane at a time. */
+constexpr usize k_chunk = 256;
+
+
+MATH_BATCH_KERNEL void transform_points(const Mat4x4& m, const Vec3* points, Vec3* out, usize count)
+{
+	// Copy the matrix into locals so the compiler knows that writes to `out`
+	// can't alias it
+	const flt m11 = m.m11, m12 = m.m12, m13 = m.m13;
+	const flt m21 = m.m21, m22 = m.m22, m23 = m.m23;
+	const flt m31 = m.m31, m32 = m.m32, m33 = m.m33;
+	const flt m41 = m.m41, m42 = m.m42, m43 = m.m43;
+
+	for (usize i = 0; i < count; ++i) {
+		flt x = points[i].x;
+		flt y = points[i].y;
+		flt z = points[i].z;
+
+		out[i].x = x * m11 + y * m21 + z * m31 + m41;
+		out[i].y = x * m12 + y * m22 + z * m32 + m42;
+		out[i].z = x * m13 + y * m23 + z * m33 + m43;
+	}
+}
+
+
+MATH_BATCH_KERNEL void cull_spheres(
+	const geo::Plane* planes, usize plane_count,
+	const geo::Sphere* spheres, usize count,
+	u8* out_visible)
+{
+	// The spheres go in chunks, split into one array per member once, so
+	// that the pass over a chunk for each plane is a straight, contiguous loop
+	// rather than one that shuffles the members apart again every time. Each
+	// sphere's result stays a `flt` until the end, so the loop is as wide as
+	// its inputs: with a `u8` one, GCC does 32 spheres at a time, and spills
+	for (usize first = 0; first < count; first += k_chunk) {
+		usize chunk = count - first < k_chunk ? count - first : k_chunk;
+
+		auto cx = std::array<flt, k_chunk>();
+		auto cy = std::array<flt, k_chunk>();
+		auto cz = std::array<flt, k_chunk>();
+		auto min_dist = std::array<flt, k_chunk>();
+		auto inside = std::array<flt, k_chunk>();
+		for (usize i = 0; i < chunk; ++i) {
+			const auto& s = spheres[first + i];
+			cx[i] = s.center.x;
+			cy[i] = s.center.y;
+			cz[i] = s.center.z;
+			min_dist[i] = -s.radius;
+			inside[i] = 1;
+		}
+
+		for (usize p = 0; p < plane_count; ++p) {
+			const flt nx = planes[p].normal.x;
+			const flt ny = planes[p].normal.y;
+			const flt nz = planes[p].normal.z;
+			const flt d = planes[p].distance;
+
+			for (usize i = 0; i < chunk; ++i) {
+				flt dist = cx[i] * nx + cy[i] * ny + cz[i] * nz - d;
+				inside[i] = dist >= min_dist[i] ? inside[i] : 0;
+			}
+		}
+
+		for (usize i = 0; i < chunk; ++i)
+			out_visible[first + i] = static_cast<u8>(inside[i] != 0);
+	}
+}
+
+
+MATH_BATCH_KERNEL void cull_cones(
+	const Vec3& eye,
+	const geo::Sphere* spheres, const Vec3* axes, const flt* cutoffs, usize count,
+	u8* out_visible)
+{
+	const flt ex = eye.x, ey = eye.y, ez = eye.z;
+
+	// Every normal faces away if the direction from the eye to any point of the
+	// sphere is within 90 degrees minus the cone's angle of its axis
+	for (usize i = 0; i < count; ++i) {
+		const auto& s = spheres[i];
+		flt dx = s.center.x - ex;
+		flt dy = s.center.y - ey;
+		flt dz = s.center.z - ez;
+
+		flt dist = std::sqrt(dx * dx + dy * dy + dz * dz);
+		flt along = dx * axes[i].x + dy * axes[i].y + dz * axes[i].z;
+
+		out_visible[i] = static_cast<u8>(along < cutoffs[i] * dist + s.radius);
+	}
+}
+
+
+MATH_BATCH_KERNEL void intersect_ray_tris(const geo::Ray& ray, const geo::Tri* tris, usize count, flt* out_t)
+{
+	const flt ox = ray.origin.x, oy = ray.origin.y, oz = ray.origin.z;
+	const flt dx = ray.delta.x,  dy = ray.delta.y,  dz = ray.delta.z;
+	constexpr flt miss = std::numeric_limits<flt>::infinity();
+
+	// Möller-Trumbore
+	for (usize i = 0; i < count; ++i) {
+		const auto& tri = tris[i];
+
+		flt e1x = tri.v2.x - tri.v1.x, e1y = tri.v2.y - tri.v1.y, e1z = tri.v2.z - tri.v1.z;
+		flt e2x = tri.v3.x - tri.v1.x, e2y = tri.v3.y - tri.v1.y, e2z = tri.v3.z - tri.v1.z;
+
+		// p = delta x e2
+		flt px = dy * e2z - dz * e2y;
+		flt py = dz * e2x - dx * e2z;
+		flt pz = dx * e2y - dy * e2x;
+
+		flt det = e1x * px + e1y * py + e1z * pz;
+		flt inv_det = 1 / det;
+
+		flt sx = ox - tri.v1.x, sy = oy - tri.v1.y, sz = oz - tri.v1.z;
+		flt u = (sx * px + sy * py + sz * pz) * inv_det;
+
+		// q = s x e1
+		flt qx = sy * e1z - sz * e1y;
+		flt qy = sz * e1x - sx * e1z;
+		flt qz = sx * e1y - sy * e1x;
+
+		flt v = (dx * qx + dy * qy + dz * qz) * inv_det;
+		flt t = (e2x * qx + e2y * qy + e2z * qz) * inv_det;
+
+		bool hit = std::abs(det) > k_epsilon
+			&& u >= 0 && v >= 0 && u + v <= 1
+			&& t >= 0 && t <= 1;
+
+		out_t[i] = hit ? t : miss;
+	}
+}
+
+} // namespace
+
+
+auto kernels() -> const Kernels&
+{
+	static constexpr Kernels result {
+		MATH_BATCH_ISA,
+		transform_points,
+		cull_spheres,
+		cull_cones,
+		intersect_ray_tris,
+	};
+	return result;
+}
+
+} // namespace math::batch::detail::MATH_BATCH_NAMESPACE
+
+#undef MATH_BATCH_KERNEL
@@ -0,0 +1,17 @@
+#include "math/check.h"
+
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+
+namespace math::detail {
+
+void index_out_of_range(const char* type, usize size, usize idx)
+{
+	throw std::out_of_range(fmt::format(
+		"Index out of range for {}: Expected < {}, received {}",
+		type, size, idx));
+}
+
+} // namespace math::detail
@@ -0,0 +1,114 @@
+#include "math/cpu.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#define MATH_CPU_X86 1
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+#endif
+
+
+namespace math {
+
+namespace {
+
+#ifdef MATH_CPU_X86
+
+struct CpuidRegs {
+	u32 eax = 0, ebx = 0, ecx = 0, edx = 0;
+};
+
+auto cpuid(u32 leaf, u32 subleaf = 0) -> CpuidRegs
+{
+	CpuidRegs result;
+#ifdef _MSC_VER
+	int regs[4];
+	__cpuidex(regs, static_cast<int>(leaf), static_cast<int>(subleaf));
+	result.eax = static_cast<u32>(regs[0]);
+	result.ebx = static_cast<u32>(regs[1]);
+	result.ecx = static_cast<u32>(regs[2]);
+	result.edx = static_cast<u32>(regs[3]);
+#else
+	__cpuid_count(leaf, subleaf, result.eax, result.ebx, result.ecx, result.edx);
+#endif
+	return result;
+}
+
+/** Read the XCR0 register, which reports the register state saved by the OS. */
+auto xgetbv0() -> u64
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	u32 lo, hi;
+	__asm__ volatile ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	return (static_cast<u64>(hi) << 32) | lo;
+#endif
+}
+
+constexpr auto bit(u32 reg, u32 index) -> bool
+{
+	return (reg >> index) & 1;
+}
+
+auto detect() -> Isa
+{
+	u32 max_leaf = cpuid(0).eax;
+	if (max_leaf < 7)
+		return Isa::Baseline;
+
+	auto leaf1 = cpuid(1);
+	auto leaf7 = cpuid(7);
+
+	// The CPU supporting AVX isn't enough -- the OS also has to save the wider
+	// registers on context switches, which it advertises through XCR0
+	if (!bit(leaf1.ecx, 27)) // OSXSAVE
+		return Isa::Baseline;
+
+	u64 xcr0 = xgetbv0();
+	constexpr u64 ymm_state = 0x06;  // SSE + AVX
+	constexpr u64 zmm_state = 0xe6;  // SSE + AVX + opmask + ZMM_Hi256 + Hi16_ZMM
+
+	bool fma = bit(leaf1.ecx, 12);
+	bool avx2 = bit(leaf7.ebx, 5) && fma && (xcr0 & ymm_state) == ymm_state;
+	bool avx512f = bit(leaf7.ebx, 16);
+	bool avx512vl = bit(leaf7.ebx, 31);
+	bool avx512 = avx512f && avx512vl && avx2 && (xcr0 & zmm_state) == zmm_state;
+
+	if (avx512) return Isa::AVX512;
+	if (avx2) return Isa::AVX2;
+
+	return Isa::Baseline;
+}
+
+#else
+
+auto detect() -> Isa
+{
+	return Isa::Baseline;
+}
+
+#endif
+
+} // namespace
+
+
+auto cpu_isa() -> Isa
+{
+	static const Isa result = detect();
+	return result;
+}
+
+auto isa_name(Isa isa) -> const char*
+{
+	switch (isa) {
+		case Isa::Baseline: return "baseline";
+		case Isa::AVX2: return "avx2";
+		case Isa::AVX512: return "avx512";
+	}
+	return "unknown";
+}
+
+} // namespace math
@@ -0,0 +1,321 @@
+#include "math/spatial_hash.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <utility>
+
+#include "math/detail/parallel.h"
+
+
+namespace math {
+
+namespace {
+
+/**
+ * The number of groups of buckets the points are first split into. Each group
+ * is then sorted into its buckets by one task.
+ */
+constexpr usize k_bucket_groups = 256;
+/** The fewest points worth handing to a thread. */
+constexpr usize k_min_points_per_thread = 1 << 14;
+
+/** The smallest power of two that's at least `value`. */
+auto ceil_pow2(usize value) -> usize
+{
+	usize result = 1;
+	while (result < value)
+		result <<= 1;
+
+	return result;
+}
+
+auto log2(usize pow2) -> u32
+{
+	u32 result = 0;
+	while ((usize(1) << result) < pow2)
+		++result;
+
+	return result;
+}
+
+constexpr i32 k_min_i32 = std::numeric_limits<i32>::min();
+constexpr i32 k_max_i32 = std::numeric_limits<i32>::max();
+
+/**
+ * The range of cells, as `flt`s. The largest `i32` would round up out of
+ * range as an `f32`, so it's the largest `f32` below it there.
+ */
+constexpr flt k_min_cell = -2147483648.0;
+constexpr flt k_max_cell = std::numeric_limits<flt>::digits < 31 ? 2147483520.0 : 2147483647.0;
+
+/**
+ * `std::floor(value)` as an `i32`, saturated to its range, as casting a value
+ * outside it is undefined. NaN goes to the smallest.
+ */
+auto floor_to_i32(flt value) -> i32
+{
+	return static_cast<i32>(std::min(k_max_cell, std::max(k_min_cell, std::floor(value))));
+}
+
+} // namespace
+
+
+SpatialHash::SpatialHash(flt cell_size, usize threads)
+	: m_cell_size(cell_size)
+	, m_inv_cell_size(1 / cell_size)
+	, m_threads(detail::thread_count(threads))
+{}
+
+auto SpatialHash::cell_of(const Vec3& point) const -> Cell
+{
+	// Far enough out, the cells at the ends of the range hold everything beyond
+	return {
+		floor_to_i32(point.x * m_inv_cell_size),
+		floor_to_i32(point.y * m_inv_cell_size),
+		floor_to_i32(point.z * m_inv_cell_size),
+	};
+}
+
+auto SpatialHash::bucket_of(const Cell& cell) const -> u32
+{
+	// Teschner et al.'s hash, with a final mix so the low bits depend on all
+	// three coordinates
+	u32 h = (static_cast<u32>(cell.x) * 73856093u)
+		^ (static_cast<u32>(cell.y) * 19349663u)
+		^ (static_cast<u32>(cell.z) * 83492791u);
+	h ^= h >> 16;
+	h *= 0x85ebca6bu;
+	h ^= h >> 13;
+
+	return h & m_bucket_mask;
+}
+
+
+// Building --------------------------------------------------------------------
+
+void SpatialHash::build(const Vec3* points, usize count)
+{
+	usize bucket_count = ceil_pow2(std::max<usize>(count, 1));
+	usize groups = std::min(bucket_count, k_bucket_groups);
+	u32 group_shift = log2(bucket_count / groups);
+	m_bucket_mask = static_cast<u32>(bucket_count - 1);
+
+	usize chunks = std::clamp<usize>(count / k_min_points_per_thread, 1, m_threads);
+
+	m_starts.resize(bucket_count + 1);
+	m_indices.resize(count);
+	m_points.resize(count);
+	m_buckets.resize(count);
+	m_order.resize(count);
+	m_group_offsets.assign(chunks * groups, 0);
+	m_group_starts.resize(groups + 1);
+
+	auto chunk_bounds = std::vector<std::pair<Cell, Cell>>(chunks);
+
+	// Find each point's bucket, and count the points per group in each chunk
+	detail::parallel_for(chunks, m_threads, [&](usize c) {
+		usize begin = count * c / chunks;
+		usize end = count * (c + 1) / chunks;
+		u32* counts = m_group_offsets.data() + c * groups;
+
+		auto min = Cell{ k_max_i32, k_max_i32, k_max_i32 };
+		auto max = Cell{ k_min_i32, k_min_i32, k_min_i32 };
+		for (usize i = begin; i < end; ++i) {
+			auto cell = cell_of(points[i]);
+			min = { std::min(min.x, cell.x), std::min(min.y, cell.y), std::min(min.z, cell.z) };
+			max = { std::max(max.x, cell.x), std::max(max.y, cell.y), std::max(max.z, cell.z) };
+
+			u32 bucket = bucket_of(cell);
+			m_buckets[i] = bucket;
+			++counts[bucket >> group_shift];
+		}
+		chunk_bounds[c] = { min, max };
+	});
+
+	m_min_cell = { k_max_i32, k_max_i32, k_max_i32 };
+	m_max_cell = { k_min_i32, k_min_i32, k_min_i32 };
+	for (const auto& [min, max] : chunk_bounds) {
+		m_min_cell = { std::min(m_min_cell.x, min.x), std::min(m_min_cell.y, min.y), std::min(m_min_cell.z, min.z) };
+		m_max_cell = { std::max(m_max_cell.x, max.x), std::max(m_max_cell.y, max.y), std::max(m_max_cell.z, max.z) };
+	}
+
+	// Turn the counts into where each chunk's points of each group go, with
+	// the chunks in order within each group, so the sort is stable
+	u32 offset = 0;
+	for (usize g = 0; g < groups; ++g) {
+		m_group_starts[g] = offset;
+		for (usize c = 0; c < chunks; ++c) {
+			u32 group_count = m_group_offsets[c * groups + g];
+			m_group_offsets[c * groups + g] = offset;
+			offset += group_count;
+		}
+	}
+	m_group_starts[groups] = offset;
+
+	detail::parallel_for(chunks, m_threads, [&](usize c) {
+		usize begin = count * c / chunks;
+		usize end = count * (c + 1) / chunks;
+		u32* cursors = m_group_offsets.data() + c * groups;
+
+		for (usize i = begin; i < end; ++i)
+			m_order[cursors[m_buckets[i] >> group_shift]++] = static_cast<u32>(i);
+	});
+
+	// Sort each group into its buckets. The groups' buckets don't overlap, so
+	// each task only writes the starts of its own: it counts into the slot
+	// after each bucket, and scattering moves it on to the bucket's end
+	m_starts[0] = 0;
+	usize group_buckets = bucket_count / groups;
+	detail::parallel_for(groups, m_threads, [&](usize g) {
+		u32* slots = m_starts.data() + g * group_buckets + 1;
+		u32 begin = m_group_starts[g];
+		u32 end = m_group_starts[g + 1];
+
+		std::fill_n(slots, group_buckets, 0);
+		for (u32 i = begin; i < end; ++i)
+			++m_starts[m_buckets[m_order[i]] + 1];
+
+		u32 running = begin;
+		for (usize b = 0; b < group_buckets; ++b)
+			running += std::exchange(slots[b], running);
+
+		for (u32 i = begin; i < end; ++i) {
+			u32 index = m_order[i];
+			u32 position = m_starts[m_buckets[index] + 1]++;
+			m_indices[position] = index;
+			m_points[position] = points[index];
+		}
+	});
+}
+
+
+// Queries ---------------------------------------------------------------------
+
+template <typename Fn>
+void SpatialHash::visit_cell(const Cell& cell, const Vec3& center, const Fn& fn) const
+{
+	u32 bucket = bucket_of(cell);
+	for (u32 i = m_starts[bucket]; i < m_starts[bucket + 1]; ++i) {
+		const auto& p = m_points[i];
+
+		// Other cells can share the bucket
+		auto c = cell_of(p);
+		if (c.x != cell.x || c.y != cell.y || c.z != cell.z)
+			continue;
+
+		flt dx = p.x - center.x;
+		flt dy = p.y - center.y;
+		flt dz = p.z - center.z;
+		fn(m_indices[i], dx * dx + dy * dy + dz * dz);
+	}
+}
+
+void SpatialHash::query_radius(const Vec3& center, flt radius, std::vector<u32>& out) const
+{
+	out.clear();
+	if (m_indices.empty() || radius < 0)
+		return;
+
+	auto lo = cell_of(center - Vec3::all(radius));
+	auto hi = cell_of(center + Vec3::all(radius));
+	lo = { std::max(lo.x, m_min_cell.x), std::max(lo.y, m_min_cell.y), std::max(lo.z, m_min_cell.z) };
+	hi = { std::min(hi.x, m_max_cell.x), std::min(hi.y, m_max_cell.y), std::min(hi.z, m_max_cell.z) };
+
+	flt sq_radius = radius * radius;
+	auto add = [&](u32 index, flt sq_distance) {
+		if (sq_distance <= sq_radius)
+			out.push_back(index);
+	};
+
+	// Counting past the largest cell would overflow an i32
+	for (i64 z = lo.z; z <= hi.z; ++z)
+		for (i64 y = lo.y; y <= hi.y; ++y)
+			for (i64 x = lo.x; x <= hi.x; ++x)
+				visit_cell({ i32(x), i32(y), i32(z) }, center, add);
+}
+
+void SpatialHash::query_nearest(const Vec3& center, usize k, std::vector<u32>& out) const
+{
+	out.clear();
+	if (m_indices.empty() || k == 0)
+		return;
+
+	// The best so far, as a max-heap with the worst on top
+	auto best = std::vector<std::pair<flt, u32>>();
+	best.reserve(std::min(k, m_indices.size()));
+	auto add = [&](u32 index, flt sq_distance) {
+		auto candidate = std::pair(sq_distance, index);
+		if (best.size() < k) {
+			best.push_back(candidate);
+			std::push_heap(best.begin(), best.end());
+		}
+		else if (candidate < best.front()) {
+			std::pop_heap(best.begin(), best.end());
+			best.back() = candidate;
+			std::push_heap(best.begin(), best.end());
+		}
+	};
+
+	// Visit shells of cells around the center's, each one cell further out. The
+	// shells can reach past the range of an i32, so they're worked out in i64s
+	auto c = cell_of(center);
+	i64 cx = c.x, cy = c.y, cz = c.z;
+	const i64 min_cells[3] { m_min_cell.x, m_min_cell.y, m_min_cell.z };
+	const i64 max_cells[3] { m_max_cell.x, m_max_cell.y, m_max_cell.z };
+	for (i64 ring = 0; ; ++ring) {
+		if (ring > 0 && best.size() == k) {
+			// Nothing in this ring is nearer than the faces of the last. Faces
+			// with no points behind them don't count, which also leaves out
+			// the far side of a center in a cell at the end of the range
+			flt nearest = std::numeric_limits<flt>::infinity();
+			for (usize a = 0; a < 3; ++a) {
+				i64 cell = a == 0 ? cx : a == 1 ? cy : cz;
+				if (cell - ring >= min_cells[a]) {
+					flt lower = static_cast<flt>(cell - (ring - 1)) * m_cell_size;
+					nearest = std::min(nearest, center[a] - lower);
+				}
+				if (cell + ring <= max_cells[a]) {
+					flt upper = static_cast<flt>(cell + ring) * m_cell_size;
+					nearest = std::min(nearest, upper - center[a]);
+				}
+			}
+			if (nearest * nearest > best.front().first)
+				break;
+		}
+
+		i64 x0 = std::max<i64>(cx - ring, m_min_cell.x), x1 = std::min<i64>(cx + ring, m_max_cell.x);
+		i64 y0 = std::max<i64>(cy - ring, m_min_cell.y), y1 = std::min<i64>(cy + ring, m_max_cell.y);
+		i64 z0 = std::max<i64>(cz - ring, m_min_cell.z), z1 = std::min<i64>(cz + ring, m_max_cell.z);
+		for (i64 z = z0; z <= z1; ++z) {
+			for (i64 y = y0; y <= y1; ++y) {
+				// Rows inside the shell only cross its two faces along x
+				if (std::abs(z - cz) == ring || std::abs(y - cy) == ring) {
+					for (i64 x = x0; x <= x1; ++x)
+						visit_cell({ i32(x), i32(y), i32(z) }, center, add);
+				}
+				else {
+					if (cx - ring >= x0)
+						visit_cell({ i32(cx - ring), i32(y), i32(z) }, center, add);
+					if (cx + ring <= x1)
+						visit_cell({ i32(cx + ring), i32(y), i32(z) }, center, add);
+				}
+			}
+		}
+
+		// Stop once the shells cover every point
+		bool covered = cx - ring <= m_min_cell.x && cx + ring >= m_max_cell.x
+			&& cy - ring <= m_min_cell.y && cy + ring >= m_max_cell.y
+			&& cz - ring <= m_min_cell.z && cz + ring >= m_max_cell.z;
+		if (covered)
+			break;
+	}
+
+	std::sort_heap(best.begin(), best.end());
+	out.reserve(best.size());
+	for (const auto& [sq_distance, index] : best)
+		out.push_back(index);
+}
+
+} // namespace math
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include <math/geo/aabb.h>
+#include <sized.h>
+
+#include "mesh/layout.h"
+#include "mesh/mapped_file.h"
+#include "mesh/mesh_data.h"
+
+/**
+ * The binary mesh format (`.mesh`).
+ *
+ * A file is laid out exactly as the GPU wants it, so loading one is just a
+ * matter of mapping it and handing pointers to `glBufferData`:
+ *
+ *     Header
+ *     AttributeDesc[attribute_count]    -- the vertex layout
+ *     SubmeshDesc[submesh_count]        -- index ranges + bounds
+ *     vertex blob                       -- vertex_count * vertex_stride bytes
+ *     index blob                        -- index_count u32s
+ *
+ * Every section starts at a multiple of `k_alignment` bytes, and all values
+ * are little-endian. Readers accept any file with the same major version;
+ * minor versions only ever append fields to the end of a descriptor.
+ */
+namespace mesh::binary {
+using namespace sized; // NOLINT(*-using-namespace)
+
+constexpr auto k_magic = std::array<char, 4>{ 'M', 'E', 'S', 'H' };
+/** Reads back as a different value if the file's byte order doesn't match ours. */
+constexpr u32 k_byte_order = 0x01020304;
+constexpr u16 k_version_major = 1;
+constexpr u16 k_version_minor = 0;
+constexpr usize k_alignment = 16;
+
+struct Header {
+	std::array<char, 4> magic = k_magic;
+	u32 byte_order = k_byte_order;
+	u16 version_major = k_version_major;
+	u16 version_minor = k_version_minor;
+	/** `sizeof(Header)` when the file was written. */
+	u32 header_size = sizeof(Header);
+	u32 attribute_size = 0;
+	u32 submesh_size = 0;
+	u32 vertex_stride = 0;
+	u32 attribute_count = 0;
+	u32 submesh_count = 0;
+	u32 reserved = 0;
+	u64 vertex_count = 0;
+	u64 index_count = 0;
+	u64 attributes_offset = 0;
+	u64 submeshes_offset = 0;
+	u64 vertices_offset = 0;
+	u64 indices_offset = 0;
+};
+
+struct AttributeDesc {
+	/** A `mesh::Scalar` value. */
+	u32 type = 0;
+	u16 offset = 0;
+	u8 count = 0;
+	u8 normalized = 0;
+};
+
+struct SubmeshDesc {
+	u32 first_index = 0;
+	u32 index_count = 0;
+	std::array<f32, 3> min {};
+	std::array<f32, 3> max {};
+};
+
+static_assert(sizeof(Header) == 88, "The file header layout must not change within a major version");
+static_assert(sizeof(AttributeDesc) == 8, "The attribute layout must not change within a major version");
+static_assert(sizeof(SubmeshDesc) == 32, "The submesh layout must not change within a major version");
+
+
+/**
+ * Write a mesh to `path` in the binary format. Throws `mesh::FileError` if the
+ * file can't be written, or the mesh can't be represented.
+ */
+void write(const std::string& path, const MeshData& mesh);
+
+/** Encode a mesh in the binary format. */
+auto encode(const MeshData& mesh) -> std::vector<u8>;
+
+
+/**
+ * A mesh file mapped into memory. The vertex and index data are used in place,
+ * without being parsed or copied, and stay valid for the lifetime of the
+ * `Mesh`.
+ */
+class Mesh {
+public:
+	/** Map and validate the file at `path`. Throws `mesh::FileError`. */
+	static auto load(const std::string& path) -> Mesh;
+
+	/** Validate a mapped file. Throws `mesh::FileError`. */
+	explicit Mesh(MappedFile file);
+
+	/**
+	 * Validate an encoded mesh which is owned by the caller. Throws
+	 * `mesh::FileError`.
+	 */
+	Mesh(const u8* data, usize size);
+
+	auto layout() const -> const std::vector<Attribute>& { return m_layout; }
+	auto submeshes() const -> const std::vector<Submesh>& { return m_submeshes; }
+
+	auto vertex_stride() const -> u32 { return m_vertex_stride; }
+	auto vertex_count() const -> usize { return m_vertex_count; }
+	auto vertex_data() const -> const void* { return m_vertices; }
+	auto vertex_data_size() const -> usize { return m_vertex_count * m_vertex_stride; }
+
+	auto index_count() const -> usize { return m_index_count; }
+	auto index_data() const -> const u32* { return m_indices; }
+
+	/** The bounds of every submesh combined. */
+	auto bounds() const -> math::geo::AABBox;
+
+private:
+	void parse(const u8* data, usize size);
+
+	MappedFile m_file;
+
+	std::vector<Attribute> m_layout;
+	std::vector<Submesh> m_submeshes;
+
+	u32 m_vertex_stride = 0;
+	usize m_vertex_count = 0;
+	const u8* m_vertices = nullptr;
+
+	usize m_index_count = 0;
+	const u32* m_indices = nullptr;
+};
+
+} // namespace mesh::binary
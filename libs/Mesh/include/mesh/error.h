@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdexcept>
+
+namespace mesh {
+
+/** Thrown when a mesh file can't be read or written, or its contents are malformed. */
+class FileError : public std::runtime_error {
+public:
+	using std::runtime_error::runtime_error;
+};
+
+} // namespace mesh
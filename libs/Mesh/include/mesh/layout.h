@@ -0,0 +1,82 @@
+#pragma once
+
+#include <sized.h>
+
+namespace mesh {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/**
+ * Component types for vertex attributes. The values match the corresponding
+ * OpenGL enums (e.g. `GL_FLOAT`), so they're stored in mesh files as-is and
+ * can be cast straight to `gl::Scalar`.
+ */
+enum class Scalar : u32 {
+	i8 = 0x1400,
+	u8 = 0x1401,
+	i16 = 0x1402,
+	u16 = 0x1403,
+	i32 = 0x1404,
+	u32 = 0x1405,
+	f32 = 0x1406,
+	f64 = 0x140a,
+	f16 = 0x140b,
+	/** Four signed components packed into 10, 10, 10 and 2 bits. */
+	i32_2_10_10_10_rev = 0x8d9f,
+	/** Four unsigned components packed into 10, 10, 10 and 2 bits. */
+	u32_2_10_10_10_rev = 0x8368,
+};
+
+/**
+ * Get the size in bytes of one component of `type`, or of the whole packed
+ * attribute for the `_rev` types. Returns 0 for unknown values.
+ */
+constexpr auto size_of(Scalar type) -> usize
+{
+	switch (type) {
+		case Scalar::i8: return 1;
+		case Scalar::u8: return 1;
+		case Scalar::i16: return 2;
+		case Scalar::u16: return 2;
+		case Scalar::i32: return 4;
+		case Scalar::u32: return 4;
+		case Scalar::f32: return 4;
+		case Scalar::f64: return 8;
+		case Scalar::f16: return 2;
+		case Scalar::i32_2_10_10_10_rev: return 4;
+		case Scalar::u32_2_10_10_10_rev: return 4;
+	}
+	return 0;
+}
+
+/** Whether `type` packs all of an attribute's components into one value. */
+constexpr auto is_packed(Scalar type) -> bool
+{
+	return type == Scalar::i32_2_10_10_10_rev
+		|| type == Scalar::u32_2_10_10_10_rev;
+}
+
+/**
+ * One interleaved vertex attribute. Mirrors the Renderer's
+ * `VertexBufferElement`, plus the attribute's byte offset within a vertex.
+ */
+struct Attribute {
+	/** The data type of each component. */
+	Scalar type = Scalar::f32;
+	/** The number of components: 1, 2, 3 or 4. */
+	u32 count = 4;
+	/**
+	 * Whether integer components are normalized to [0, 1] (unsigned) or
+	 * [-1, 1] (signed) when they're read by a shader.
+	 */
+	bool normalized = false;
+	/** Byte offset from the start of the vertex. */
+	u32 offset = 0;
+
+	/** The size of the whole attribute in bytes. */
+	constexpr auto size() const -> usize
+	{
+		return is_packed(type) ? size_of(type) : size_of(type) * count;
+	}
+};
+
+} // namespace mesh
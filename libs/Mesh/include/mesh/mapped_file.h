@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+
+#include <sized.h>
+
+namespace mesh {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/**
+ * A read-only memory mapping of a whole file. Pages are loaded by the OS on
+ * first access, so opening a file is cheap no matter its size, and the
+ * contents are never copied into the process's heap.
+ */
+class MappedFile {
+public:
+	MappedFile() = default;
+
+	/** Map the file at `path`. Throws `mesh::FileError` on failure. */
+	explicit MappedFile(const std::string& path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	auto operator=(const MappedFile&) -> MappedFile& = delete;
+
+	MappedFile(MappedFile&& other) noexcept;
+	auto operator=(MappedFile&& other) noexcept -> MappedFile&;
+
+	auto data() const -> const u8* { return m_data; }
+	auto size() const -> usize { return m_size; }
+	auto empty() const -> bool { return m_size == 0; }
+
+private:
+	void close();
+
+	const u8* m_data = nullptr;
+	usize m_size = 0;
+#ifdef _WIN32
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#endif
+};
+
+} // namespace mesh
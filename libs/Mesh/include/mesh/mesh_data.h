@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+
+#include <math/geo/aabb.h>
+#include <math/vector.h>
+#include <sized.h>
+
+#include "mesh/layout.h"
+
+namespace mesh {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/** A range of a mesh's index buffer that's drawn as a unit. */
+struct Submesh {
+	/** The position of the submesh's first index in the index buffer. */
+	u32 first_index = 0;
+	/** The number of indices (three per triangle). */
+	u32 index_count = 0;
+	/** The bounds of every vertex referenced by the submesh. */
+	math::geo::AABBox bounds = math::geo::AABBox::empty();
+};
+
+/**
+ * An indexed triangle mesh with interleaved vertices, held in memory. This is
+ * what's written to and read from mesh files.
+ *
+ * By convention the first attribute is the position, stored as two or three
+ * `f32`s.
+ */
+struct MeshData {
+	std::vector<Attribute> layout;
+	/** The size of one vertex in bytes. */
+	u32 stride = 0;
+	std::vector<u8> vertices;
+	std::vector<u32> indices;
+	std::vector<Submesh> submeshes;
+
+
+	/** Append an attribute to the layout, directly after the previous one. */
+	void push_attribute(Scalar type, u32 count, bool normalized = false);
+
+	auto vertex_count() const -> usize;
+
+	/** Read the position attribute of a vertex. */
+	auto position(usize vertex) const -> math::Vec3;
+
+	/** Recalculate every submesh's bounds from the positions it references. */
+	void compute_bounds();
+};
+
+/**
+ * An indexed triangle mesh with each vertex attribute in its own array, as
+ * produced by importers and consumed by mesh processing. Optional attributes
+ * are either empty or have one element per position.
+ */
+struct SoaMesh {
+	std::vector<math::Vec3> positions;
+	std::vector<math::Vec3> normals;
+	std::vector<math::Vec2> uvs;
+	/** The direction of increasing u, and the bitangent sign in `w`. */
+	std::vector<math::Vec4> tangents;
+	std::vector<u32> indices;
+	std::vector<Submesh> submeshes;
+
+
+	auto vertex_count() const -> usize { return positions.size(); }
+
+	/** Recalculate every submesh's bounds from the positions it references. */
+	void compute_bounds();
+
+	/**
+	 * Interleave the attributes into a `MeshData` for upload or writing, as
+	 * `f32`s: position (3), then normal (3), uv (2) and tangent (4) if present.
+	 */
+	auto interleave() const -> MeshData;
+};
+
+} // namespace mesh
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <vector>
+
+#include <math/geo/aabb.h>
+#include <math/geo/plane.h>
+#include <math/geo/sphere.h>
+#include <math/vector.h>
+#include <sized.h>
+
+/**
+ * Clustering of triangle lists into meshlets: small groups of triangles over
+ * at most `k_max_vertices` vertices, each with its own bounds, so that they
+ * can be culled individually.
+ *
+ * Each meshlet has a bounding sphere and box, and a normal cone: an axis, and
+ * the widest angle between it and the normal of any of the meshlet's
+ * triangles. When every direction from the eye to the meshlet is far enough
+ * from the axis, all of its triangles face away, and it can be skipped
+ * without looking at them.
+ */
+namespace mesh::meshlet {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/** The most vertices in a meshlet. */
+constexpr usize k_max_vertices = 64;
+/**
+ * The most triangles in a meshlet. Along with `k_max_vertices`, the limits
+ * that suit mesh shaders on most GPUs.
+ */
+constexpr usize k_max_triangles = 124;
+
+
+// Building --------------------------------------------------------------------
+
+struct Meshlet {
+	/** The position of the meshlet's first vertex in `Meshlets::vertices`. */
+	u32 first_vertex = 0;
+	/** The position of the meshlet's first triangle in `Meshlets::triangles`. */
+	u32 first_triangle = 0;
+	u32 vertex_count = 0;
+	u32 triangle_count = 0;
+};
+
+/**
+ * A mesh's meshlets, with each meshlet's bounds in an array of its own, so
+ * culling makes a straight pass over each.
+ */
+struct Meshlets {
+	std::vector<Meshlet> meshlets;
+	/** The mesh's vertex indices used by each meshlet, as ranges. */
+	std::vector<u32> vertices;
+	/** Three indices per triangle, into the meshlet's range of `vertices`. */
+	std::vector<u8> triangles;
+
+	std::vector<math::geo::Sphere> spheres;
+	std::vector<math::geo::AABBox> boxes;
+	/** The normal cones' axes. */
+	std::vector<math::Vec3> cone_axes;
+	/**
+	 * The sine of the normal cones' angles, or 1 for meshlets whose triangles
+	 * face more than a hemisphere apart, which are never backfacing.
+	 */
+	std::vector<flt> cone_cutoffs;
+
+	auto size() const -> usize { return meshlets.size(); }
+};
+
+/**
+ * Split a triangle list into meshlets, filling each in the order of the
+ * triangles until the next one would overflow it. The meshlets are only as
+ * tight as the triangles are local, so the list should be ordered for the
+ * vertex cache first (see `mesh::optimize`).
+ */
+auto build(
+	const u32* indices, usize index_count,
+	const math::Vec3* positions, usize vertex_count)
+	-> Meshlets;
+
+
+// Culling ---------------------------------------------------------------------
+
+/**
+ * Culls meshlets against a view frustum and by their normal cones, and gathers
+ * the triangles of those that survive into an index buffer. The culler only
+ * holds scratch memory, so one can be reused for every mesh, every frame.
+ */
+class Culler {
+public:
+	/**
+	 * Cull `meshlets` against `planes`, whose normals point into the frustum,
+	 * and an `eye` position, both in the meshlets' space, then replace the
+	 * contents of `out_indices` with the triangles of the meshlets left, as
+	 * indices into the mesh's vertices. Returns the number of meshlets left.
+	 */
+	auto cull(
+		const Meshlets& meshlets,
+		const math::geo::Plane* planes, usize plane_count,
+		const math::Vec3& eye,
+		std::vector<u32>& out_indices)
+		-> usize;
+
+private:
+	std::vector<u8> m_inside;
+	std::vector<u8> m_front;
+};
+
+} // namespace mesh::meshlet
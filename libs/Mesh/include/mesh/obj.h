@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+
+#include <sized.h>
+
+#include "mesh/mesh_data.h"
+
+/**
+ * Wavefront OBJ import.
+ *
+ * Supports `v`, `vt`, `vn` and `f` statements (with absolute or relative
+ * indices, and polygons of any size, which are fan-triangulated). `o`, `g`
+ * and `usemtl` statements start a new submesh. Everything else is ignored.
+ */
+namespace mesh::obj {
+using namespace sized; // NOLINT(*-using-namespace)
+
+struct ImportOptions {
+	/** The number of threads to parse with. 0 uses every hardware thread. */
+	usize threads = 0;
+	/**
+	 * The smallest number of bytes worth handing to a thread. Files smaller
+	 * than twice this are parsed on the calling thread.
+	 */
+	usize min_chunk_size = 1 << 20;
+};
+
+/**
+ * Import an OBJ file. The file is memory-mapped and split into line-aligned
+ * chunks which are parsed in parallel, then each unique combination of
+ * position, uv and normal indices becomes one vertex.
+ *
+ * Throws `mesh::FileError` if the file can't be read or is malformed.
+ */
+auto import(const std::string& path, const ImportOptions& options = {}) -> SoaMesh;
+
+/** Import OBJ source held in memory. Same behavior as `import`. */
+auto import(const char* data, usize size, const ImportOptions& options = {}) -> SoaMesh;
+
+} // namespace mesh::obj
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include <math/vector.h>
+#include <sized.h>
+
+#include "mesh/mesh_data.h"
+
+/**
+ * Reordering of triangle lists for GPU efficiency. None of these change what's
+ * drawn -- only the order of the triangles within each submesh, and the order
+ * of the vertices.
+ *
+ * The raw-array functions operate on a single triangle list; `optimize` runs
+ * the whole pipeline over every submesh of a `SoaMesh`.
+ */
+namespace mesh::optimize {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/** The default post-transform cache size to optimize for and simulate. */
+constexpr usize k_cache_size = 16;
+/** Marks vertices that aren't referenced by any index in a remap table. */
+constexpr u32 k_unused = ~u32(0);
+
+
+// Statistics ------------------------------------------------------------------
+
+/** Post-transform vertex cache efficiency, simulated with a FIFO cache. */
+struct CacheStats {
+	/** The number of vertex shader invocations. */
+	usize transformed = 0;
+	/** Average cache miss ratio: vertices transformed per triangle (0.5 - 3). */
+	f32 acmr = 0;
+	/** Average transform to vertex ratio: vertices transformed per vertex (1+). */
+	f32 atvr = 0;
+};
+
+auto analyze_vertex_cache(
+	const u32* indices, usize index_count,
+	usize vertex_count,
+	usize cache_size = k_cache_size)
+	-> CacheStats;
+
+
+// Vertex cache ----------------------------------------------------------------
+
+/**
+ * Reorder triangles for post-transform vertex cache locality, using Tipsify
+ * (Sander et al. 2007). Runs in linear time. `dest` may alias `indices`.
+ */
+void optimize_vertex_cache(
+	u32* dest,
+	const u32* indices, usize index_count,
+	usize vertex_count,
+	usize cache_size = k_cache_size);
+
+
+// Overdraw --------------------------------------------------------------------
+
+/**
+ * Reorder clusters of triangles so outward-facing ones tend to be drawn first,
+ * reducing overdraw from any viewpoint. `indices` should already be optimized
+ * for the vertex cache; clusters are split where that costs no more than
+ * `threshold` times the cache misses. `dest` may not alias `indices`.
+ */
+void optimize_overdraw(
+	u32* dest,
+	const u32* indices, usize index_count,
+	const math::Vec3* positions, usize vertex_count,
+	usize cache_size = k_cache_size,
+	f32 threshold = 1.05f);
+
+
+// Vertex fetch ----------------------------------------------------------------
+
+/**
+ * Renumber vertices in the order they're first referenced, so vertex fetches
+ * walk memory linearly. Rewrites `indices` in place and returns the remap
+ * table (`old -> new`, or `k_unused` for unreferenced vertices). Apply it to
+ * each attribute array with `remap_vertices`.
+ */
+auto optimize_vertex_fetch(u32* indices, usize index_count, usize vertex_count) -> std::vector<u32>;
+
+/** Reorder (and compact) an attribute array with a table from `optimize_vertex_fetch`. */
+template <typename T>
+void remap_vertices(std::vector<T>& attribute, const std::vector<u32>& remap)
+{
+	if (attribute.empty())
+		return;
+
+	usize count = 0;
+	for (u32 target : remap)
+		if (target != k_unused)
+			++count;
+
+	auto result = std::vector<T>(count);
+	for (usize i = 0; i < remap.size(); ++i)
+		if (remap[i] != k_unused)
+			result[remap[i]] = attribute[i];
+
+	attribute = std::move(result);
+}
+
+
+// Pipeline --------------------------------------------------------------------
+
+struct Options {
+	usize cache_size = k_cache_size;
+	/** Whether to reorder triangle clusters to reduce overdraw. */
+	bool overdraw = true;
+	f32 overdraw_threshold = 1.05f;
+};
+
+struct Report {
+	CacheStats before;
+	CacheStats after;
+};
+
+/**
+ * Optimize every submesh's triangles for the vertex cache (and optionally
+ * overdraw), then the vertices for fetch locality. Unreferenced vertices are
+ * dropped. Returns the vertex cache statistics from before and after.
+ */
+auto optimize(SoaMesh& mesh, const Options& options = {}) -> Report;
+
+} // namespace mesh::optimize
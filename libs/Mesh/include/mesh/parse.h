@@ -0,0 +1,31 @@
+#pragma once
+
+#include <sized.h>
+
+/**
+ * Locale-independent number parsing for text asset formats. Unlike `strtod`
+ * and `std::stringstream`, these never consult the C locale, so they're both
+ * faster and immune to a `,` decimal separator.
+ */
+namespace mesh::parse {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/**
+ * Parse a decimal floating-point number (e.g. `-1.5e-3`) starting at `it`.
+ * On success, stores the value in `out`, advances `it` past the number and
+ * returns `true`. On failure `it` is left untouched.
+ *
+ * Numbers with up to 15 significant digits and a decimal exponent within
+ * +-22 -- which covers practically everything written by exporters -- are
+ * converted exactly with a single multiply or divide. Anything else falls back
+ * to a slower, correctly-rounded path.
+ */
+auto parse_float(const char*& it, const char* end, f64& out) -> bool;
+
+/**
+ * Parse an optionally-signed decimal integer starting at `it`. Same contract
+ * as `parse_float`.
+ */
+auto parse_int(const char*& it, const char* end, i64& out) -> bool;
+
+} // namespace mesh::parse
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <array>
+#include <utility>
+
+#include <math/geo/aabb.h>
+#include <math/matrix.h>
+#include <math/quat.h>
+#include <math/vector.h>
+#include <sized.h>
+
+#include "mesh/layout.h"
+#include "mesh/mesh_data.h"
+
+/**
+ * Compact encodings for vertex attributes, and the layout attributes that
+ * describe them to the GPU. The `decode_*` functions mirror what a shader (or
+ * the fixed-function normalization) recovers, and exist for testing and for
+ * CPU-side consumers.
+ */
+namespace mesh::quantize {
+using namespace sized; // NOLINT(*-using-namespace)
+
+
+// Scalars ---------------------------------------------------------------------
+
+/** Encode a value in [0, 1] as an unsigned normalized integer of `Bits` bits. */
+template <usize Bits>
+constexpr auto unorm(flt value) -> u32
+{
+	constexpr flt scale = flt((1u << Bits) - 1);
+	value = value < 0 ? 0 : (value > 1 ? 1 : value);
+
+	return static_cast<u32>(value * scale + flt(0.5));
+}
+
+/** Encode a value in [-1, 1] as a signed normalized integer of `Bits` bits. */
+template <usize Bits>
+constexpr auto snorm(flt value) -> i32
+{
+	constexpr flt scale = flt((1u << (Bits - 1)) - 1);
+	value = value < -1 ? -1 : (value > 1 ? 1 : value);
+
+	return static_cast<i32>(value * scale + (value < 0 ? flt(-0.5) : flt(0.5)));
+}
+
+template <usize Bits>
+constexpr auto decode_unorm(u32 value) -> flt
+{
+	return flt(value) / flt((1u << Bits) - 1);
+}
+
+/** Decodes like GL: the most negative value maps to -1, as does its successor. */
+template <usize Bits>
+constexpr auto decode_snorm(i32 value) -> flt
+{
+	flt result = flt(value) / flt((1u << (Bits - 1)) - 1);
+	return result < -1 ? -1 : result;
+}
+
+/** Convert to an IEEE 754 half float, rounding to nearest even. */
+auto half(f32 value) -> u16;
+auto decode_half(u16 value) -> f32;
+
+
+// Positions -------------------------------------------------------------------
+
+/**
+ * Encode a position as 16-bit unsigned normalized coordinates relative to
+ * `bounds`. The fourth component is padding, to keep vertices 4-byte aligned.
+ */
+auto position(const math::Vec3& p, const math::geo::AABBox& bounds) -> std::array<u16, 4>;
+auto decode_position(const std::array<u16, 4>& value, const math::geo::AABBox& bounds) -> math::Vec3;
+
+/**
+ * The transform from quantized [0, 1] positions back to `bounds`. Prepend it to
+ * the model matrix so the vertex shader needs no changes.
+ */
+auto dequantize_matrix(const math::geo::AABBox& bounds) -> math::Mat4x4;
+
+constexpr auto position_attribute() -> Attribute { return { Scalar::u16, 4, true }; }
+
+
+// Normals ---------------------------------------------------------------------
+
+/**
+ * Encode a unit vector with the octahedral mapping (Cigolle et al. 2014) as two
+ * signed normalized components. Each candidate rounding is tried and the most
+ * accurate one kept, which matters most at 8 bits.
+ */
+auto octahedral16(const math::Vec3& n) -> std::array<i16, 2>;
+auto octahedral8(const math::Vec3& n) -> std::array<i8, 2>;
+
+auto decode_octahedral16(const std::array<i16, 2>& value) -> math::Vec3;
+auto decode_octahedral8(const std::array<i8, 2>& value) -> math::Vec3;
+
+constexpr auto octahedral16_attribute() -> Attribute { return { Scalar::i16, 2, true }; }
+/** Padded to four components to keep vertices 4-byte aligned. */
+constexpr auto octahedral8_attribute() -> Attribute { return { Scalar::i8, 4, true }; }
+
+
+// Texture coordinates ---------------------------------------------------------
+
+auto uv(const math::Vec2& value) -> std::array<u16, 2>;
+auto decode_uv(const std::array<u16, 2>& value) -> math::Vec2;
+
+constexpr auto uv_attribute() -> Attribute { return { Scalar::f16, 2, false }; }
+
+
+// Tangent frames --------------------------------------------------------------
+
+/**
+ * Build the rotation taking the x, y and z axes to a vertex's tangent,
+ * bitangent and normal. The tangent is orthogonalized against the normal.
+ */
+auto tangent_frame(const math::Vec3& normal, const math::Vec3& tangent) -> math::Quat;
+
+/**
+ * Pack a tangent frame and its bitangent sign (+-1) into four signed 8-bit
+ * components (a "QTangent"). Since `q` and `-q` are the same rotation, `w`
+ * is made non-negative and its sign then stores the handedness.
+ */
+auto tangent_frame8(const math::Quat& frame, flt handedness) -> std::array<i8, 4>;
+
+/** Returns the frame, and the bitangent sign. */
+auto decode_tangent_frame8(const std::array<i8, 4>& value) -> std::pair<math::Quat, flt>;
+
+constexpr auto tangent_frame8_attribute() -> Attribute { return { Scalar::i8, 4, true }; }
+
+
+// Meshes ----------------------------------------------------------------------
+
+struct Options {
+	/** Use 8-bit instead of 16-bit octahedral normals. */
+	bool normals8 = false;
+};
+
+/**
+ * Interleave a mesh using the compact encodings: 16-bit positions relative to
+ * the mesh bounds, octahedral normals, half-float uvs and, for meshes with
+ * normals and tangents, 8-bit tangent frames. Transform positions with
+ * `dequantize_matrix(mesh_bounds(mesh))` to restore them.
+ */
+auto interleave(const SoaMesh& mesh, const Options& options = {}) -> MeshData;
+
+/** The bounds of every position, which `interleave` quantizes against. */
+auto mesh_bounds(const SoaMesh& mesh) -> math::geo::AABBox;
+
+} // namespace mesh::quantize
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+
+#include <math/vector.h>
+#include <sized.h>
+
+#include "mesh/mesh_data.h"
+
+/**
+ * Mesh simplification for levels of detail, by edge collapse with quadric
+ * error metrics (Garland and Heckbert 1997).
+ *
+ * Each vertex starts with the sum of the quadrics of the planes of the
+ * triangles around it, whose error at a point is the sum of its squared
+ * distances to those planes. The edges are collapsed cheapest first, from a
+ * priority queue, each moving one vertex onto the other, which takes on the
+ * sum of their quadrics. Collapses that would flip a triangle or make the
+ * surface non-manifold are skipped.
+ *
+ * Vertices only ever move onto existing vertices, so every level of detail
+ * shares the original vertex buffer, and only needs its own index buffer.
+ */
+namespace mesh::simplify {
+using namespace sized; // NOLINT(*-using-namespace)
+
+struct Options {
+	/** Stop once there are at most this many triangles left. */
+	usize target_triangles = 0;
+	/**
+	 * Stop before a collapse that would move the surface further than this,
+	 * relative to the size of the mesh (the diagonal of its bounds).
+	 */
+	flt target_error = std::numeric_limits<flt>::infinity();
+	/**
+	 * The cost of collapsing between vertices whose normals differ, per unit
+	 * of squared difference, relative to the squared size of the mesh.
+	 */
+	flt normal_weight = 1e-4;
+	/** The same, for uvs. */
+	flt uv_weight = 1e-3;
+	/**
+	 * Whether vertices on open boundaries stay where they are. Otherwise they
+	 * only move along the boundary, kept in place by heavily weighted planes
+	 * through the boundary edges.
+	 */
+	bool lock_boundary = false;
+};
+
+struct Result {
+	/** The triangles left, in their original order. */
+	std::vector<u32> indices;
+	/** The largest error of a collapse, relative to the size of the mesh. */
+	flt error = 0;
+};
+
+/**
+ * Simplify a triangle list. `normals` and `uvs` are optional, and make
+ * collapses between vertices with different attributes cost more. Vertices
+ * sharing their position with another (e.g. on uv seams) are never moved,
+ * so seams stay closed.
+ */
+auto simplify(
+	const u32* indices, usize index_count,
+	const math::Vec3* positions, usize vertex_count,
+	const Options& options,
+	const math::Vec3* normals = nullptr, const math::Vec2* uvs = nullptr)
+	-> Result;
+
+
+// Levels of detail ------------------------------------------------------------
+
+struct Lod {
+	/** A triangle list into the mesh's vertices. */
+	std::vector<u32> indices;
+	/** The mesh's submeshes, as ranges of `indices`. */
+	std::vector<Submesh> submeshes;
+	/** The largest error of a collapse, relative to the size of the mesh. */
+	flt error = 0;
+};
+
+/**
+ * Build `count` levels of detail, each with about `ratio` times the triangles
+ * of the one before, starting from the mesh itself. Each level is simplified
+ * from the previous one, one submesh at a time, and `options.target_triangles`
+ * is ignored. Stops early if a level can't be simplified further within
+ * `options.target_error`.
+ */
+auto build_lods(const SoaMesh& mesh, usize count, flt ratio = 0.5, const Options& options = {}) -> std::vector<Lod>;
+
+} // namespace mesh::simplify
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <math/vector.h>
+#include <sized.h>
+
+#include "mesh/mesh_data.h"
+
+/**
+ * Generation of per-vertex normals and tangents for indexed triangle lists.
+ *
+ * Both are sums over the triangles around each vertex. Rather than scattering
+ * every triangle's contribution into a shared array, which would need atomics
+ * or locks, the triangles are split into one contiguous run per thread, and
+ * each thread sums into its own array covering only the vertices its run
+ * references. The arrays are then added up per vertex, in parallel over
+ * blocks of vertices. In meshes ordered by `optimize`, each run references a
+ * narrow range of vertices, so the per-thread arrays stay small.
+ *
+ * The sums are added in the same order whatever the number of threads, except
+ * where runs share vertices, so results can differ between thread counts in
+ * the last bits.
+ */
+namespace mesh::tangent_space {
+using namespace sized; // NOLINT(*-using-namespace)
+
+enum class Weighting : u8 {
+	/** Weight each triangle by its area, which favors large triangles. */
+	Area,
+	/**
+	 * Weight each triangle by its angle at the vertex, which doesn't depend
+	 * on how the surface around it is triangulated.
+	 */
+	Angle,
+};
+
+struct Options {
+	/** How `compute_normals` weights triangles. Tangents are always angle-weighted. */
+	Weighting weighting = Weighting::Angle;
+	/** The number of threads to use. 0 uses every hardware thread. */
+	usize threads = 0;
+	/** The fewest triangles worth handing to a thread. */
+	usize min_triangles_per_thread = 1 << 14;
+};
+
+
+// Normals ---------------------------------------------------------------------
+
+/**
+ * Compute the unit normal of each vertex from the counter-clockwise triangles
+ * that use it. Vertices used by no triangle with a nonzero area get a zero
+ * normal.
+ */
+void compute_normals(
+	math::Vec3* out,
+	const u32* indices, usize index_count,
+	const math::Vec3* positions, usize vertex_count,
+	const Options& options = {});
+
+
+// Tangents --------------------------------------------------------------------
+
+/**
+ * Compute the tangent of each vertex, in the form MikkTSpace produces and
+ * normal mapping shaders expect: `xyz` is the unit tangent (the direction of
+ * increasing u), orthogonal to the normal, and `w` is the sign that gives the
+ * bitangent as `w * cross(normal, tangent)`.
+ *
+ * As in MikkTSpace, each triangle's tangent and bitangent are projected onto
+ * the plane of the vertex normal and weighted by the triangle's angle at the
+ * vertex, and triangles with degenerate uvs are skipped. Unlike MikkTSpace,
+ * vertices are never split: a vertex where mirrored uvs meet gets the
+ * majority's sign. Vertices without a usable triangle get an arbitrary
+ * tangent orthogonal to their normal.
+ */
+void compute_tangents(
+	math::Vec4* out,
+	const u32* indices, usize index_count,
+	const math::Vec3* positions, const math::Vec3* normals, const math::Vec2* uvs,
+	usize vertex_count,
+	const Options& options = {});
+
+
+// Meshes ----------------------------------------------------------------------
+
+/**
+ * Fill in a mesh's normals, if it has none, and its tangents, if it has uvs.
+ * Normals are computed over the whole index buffer, so they're smooth across
+ * submeshes that share vertices.
+ */
+void generate(SoaMesh& mesh, const Options& options = {});
+
+} // namespace mesh::tangent_space
@@ -0,0 +1,246 @@
+#include "mesh/binary.h"
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <utility>
+
+#include <fmt/format.h>
+
+#include "mesh/error.h"
+
+
+namespace mesh::binary {
+
+namespace {
+
+constexpr auto align_up(u64 value) -> u64
+{
+	return (value + k_alignment - 1) / k_alignment * k_alignment;
+}
+
+template <typename T>
+auto read(const u8* src) -> T
+{
+	T result;
+	std::memcpy(&result, src, sizeof(T));
+
+	return result;
+}
+
+template <typename T>
+void write(std::vector<u8>& dest, u64 offset, const T& value)
+{
+	std::memcpy(dest.data() + offset, &value, sizeof(T));
+}
+
+/**
+ * Check that `count` elements of `element_size` bytes starting at `offset` lie
+ * within a file of `file_size` bytes, without overflowing.
+ */
+void check_section(const char* name, u64 offset, u64 count, u64 element_size, usize file_size)
+{
+	if (offset % k_alignment != 0)
+		throw FileError(fmt::format("Mesh {} section is misaligned (offset {})", name, offset));
+
+	bool fits = offset <= file_size
+		&& (element_size == 0 || count <= (file_size - offset) / element_size);
+
+	if (!fits)
+		throw FileError(fmt::format(
+			"Mesh {} section is out of bounds ({} x {} bytes at offset {}, file is {} bytes)",
+			name, count, element_size, offset, file_size));
+}
+
+} // namespace
+
+
+// Writing ---------------------------------------------------------------------
+
+auto encode(const MeshData& mesh) -> std::vector<u8>
+{
+	if (mesh.stride == 0 || mesh.vertices.size() % mesh.stride != 0)
+		throw FileError(fmt::format(
+			"Mesh vertex data ({} bytes) isn't a whole number of {}-byte vertices",
+			mesh.vertices.size(), mesh.stride));
+
+	auto header = Header{};
+	header.attribute_size = sizeof(AttributeDesc);
+	header.submesh_size = sizeof(SubmeshDesc);
+	header.vertex_stride = mesh.stride;
+	header.attribute_count = static_cast<u32>(mesh.layout.size());
+	header.submesh_count = static_cast<u32>(mesh.submeshes.size());
+	header.vertex_count = mesh.vertex_count();
+	header.index_count = mesh.indices.size();
+
+	header.attributes_offset = align_up(sizeof(Header));
+	header.submeshes_offset = align_up(header.attributes_offset + mesh.layout.size() * sizeof(AttributeDesc));
+	header.vertices_offset = align_up(header.submeshes_offset + mesh.submeshes.size() * sizeof(SubmeshDesc));
+	header.indices_offset = align_up(header.vertices_offset + mesh.vertices.size());
+
+	auto result = std::vector<u8>(header.indices_offset + mesh.indices.size() * sizeof(u32));
+	write(result, 0, header);
+
+	for (usize i = 0; i < mesh.layout.size(); ++i) {
+		const auto& attribute = mesh.layout[i];
+
+		if (attribute.count > std::numeric_limits<u8>::max()
+			|| attribute.offset > std::numeric_limits<u16>::max())
+		{
+			throw FileError(fmt::format("Mesh attribute {} can't be represented", i));
+		}
+
+		auto desc = AttributeDesc{
+			static_cast<u32>(attribute.type),
+			static_cast<u16>(attribute.offset),
+			static_cast<u8>(attribute.count),
+			static_cast<u8>(attribute.normalized),
+		};
+		write(result, header.attributes_offset + i * sizeof(AttributeDesc), desc);
+	}
+
+	for (usize i = 0; i < mesh.submeshes.size(); ++i) {
+		const auto& submesh = mesh.submeshes[i];
+		const auto& bounds = submesh.bounds;
+
+		auto desc = SubmeshDesc{
+			submesh.first_index,
+			submesh.index_count,
+			{ f32(bounds.min.x), f32(bounds.min.y), f32(bounds.min.z) },
+			{ f32(bounds.max.x), f32(bounds.max.y), f32(bounds.max.z) },
+		};
+		write(result, header.submeshes_offset + i * sizeof(SubmeshDesc), desc);
+	}
+
+	if (!mesh.vertices.empty())
+		std::memcpy(result.data() + header.vertices_offset, mesh.vertices.data(), mesh.vertices.size());
+
+	if (!mesh.indices.empty())
+		std::memcpy(result.data() + header.indices_offset, mesh.indices.data(), mesh.indices.size() * sizeof(u32));
+
+	return result;
+}
+
+void write(const std::string& path, const MeshData& mesh)
+{
+	auto bytes = encode(mesh);
+
+	auto file = std::ofstream(path, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+	if (!file)
+		throw FileError(fmt::format("Failed to write mesh file '{}'", path));
+}
+
+
+// Reading ---------------------------------------------------------------------
+
+auto Mesh::load(const std::string& path) -> Mesh
+{
+	return Mesh(MappedFile(path));
+}
+
+Mesh::Mesh(MappedFile file)
+	: m_file(std::move(file))
+{
+	parse(m_file.data(), m_file.size());
+}
+
+Mesh::Mesh(const u8* data, usize size)
+{
+	parse(data, size);
+}
+
+void Mesh::parse(const u8* data, usize size)
+{
+	if (size < sizeof(Header))
+		throw FileError(fmt::format("Mesh file is too small ({} bytes)", size));
+
+	auto header = read<Header>(data);
+
+	if (header.magic != k_magic)
+		throw FileError("Not a mesh file");
+
+	if (header.byte_order != k_byte_order)
+		throw FileError("Mesh file has the wrong byte order");
+
+	if (header.version_major != k_version_major)
+		throw FileError(fmt::format(
+			"Unsupported mesh file version {}.{} (expected {}.x)",
+			header.version_major, header.version_minor, k_version_major));
+
+	// Newer minor versions may have grown any of these, but never shrunk them
+	if (header.header_size < sizeof(Header)
+		|| header.attribute_size < sizeof(AttributeDesc)
+		|| header.submesh_size < sizeof(SubmeshDesc))
+	{
+		throw FileError("Mesh file has truncated descriptors");
+	}
+
+	if (header.vertex_stride == 0 && header.vertex_count > 0)
+		throw FileError("Mesh file has a zero vertex stride");
+
+	check_section("attribute", header.attributes_offset, header.attribute_count, header.attribute_size, size);
+	check_section("submesh", header.submeshes_offset, header.submesh_count, header.submesh_size, size);
+	check_section("vertex", header.vertices_offset, header.vertex_count, header.vertex_stride, size);
+	check_section("index", header.indices_offset, header.index_count, sizeof(u32), size);
+
+	m_layout.clear();
+	m_layout.reserve(header.attribute_count);
+	for (u32 i = 0; i < header.attribute_count; ++i) {
+		auto desc = read<AttributeDesc>(data + header.attributes_offset + u64(i) * header.attribute_size);
+		auto attribute = Attribute{
+			static_cast<Scalar>(desc.type),
+			desc.count,
+			desc.normalized != 0,
+			desc.offset,
+		};
+
+		if (size_of(attribute.type) == 0 || attribute.count < 1 || attribute.count > 4)
+			throw FileError(fmt::format("Mesh attribute {} has an invalid format", i));
+
+		if (attribute.offset + attribute.size() > header.vertex_stride)
+			throw FileError(fmt::format("Mesh attribute {} overruns the vertex stride", i));
+
+		m_layout.push_back(attribute);
+	}
+
+	m_submeshes.clear();
+	m_submeshes.reserve(header.submesh_count);
+	for (u32 i = 0; i < header.submesh_count; ++i) {
+		auto desc = read<SubmeshDesc>(data + header.submeshes_offset + u64(i) * header.submesh_size);
+
+		if (u64(desc.first_index) + desc.index_count > header.index_count)
+			throw FileError(fmt::format("Mesh submesh {} overruns the index buffer", i));
+
+		m_submeshes.push_back(Submesh{
+			desc.first_index,
+			desc.index_count,
+			math::geo::AABBox{
+				math::Vec3{ desc.min[0], desc.min[1], desc.min[2] },
+				math::Vec3{ desc.max[0], desc.max[1], desc.max[2] },
+			},
+		});
+	}
+
+	// NOTE: The index values themselves aren't validated against the vertex
+	// count -- that would mean reading the whole index buffer.
+	m_vertex_stride = header.vertex_stride;
+	m_vertex_count = header.vertex_count;
+	m_vertices = data + header.vertices_offset;
+	m_index_count = header.index_count;
+	m_indices = reinterpret_cast<const u32*>(data + header.indices_offset); // NOLINT(*-reinterpret-cast)
+}
+
+auto Mesh::bounds() const -> math::geo::AABBox
+{
+	auto result = math::geo::AABBox::empty();
+	for (const auto& submesh : m_submeshes) {
+		if (submesh.index_count > 0)
+			result.add({ submesh.bounds.min, submesh.bounds.max });
+	}
+
+	return result;
+}
+
+} // namespace mesh::binary
@@ -0,0 +1,158 @@
+#include "mesh/mapped_file.h"
+
+#include <utility>
+
+#include <fmt/format.h>
+
+#include "mesh/error.h"
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <cerrno>
+	#include <cstring>
+
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+
+namespace mesh {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path)
+{
+	m_file = CreateFileA(
+		path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	if (m_file == INVALID_HANDLE_VALUE) {
+		m_file = nullptr;
+		throw FileError(fmt::format("Failed to open '{}': error {}", path, GetLastError()));
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size)) {
+		auto error = GetLastError();
+		close();
+		throw FileError(fmt::format("Failed to stat '{}': error {}", path, error));
+	}
+
+	m_size = static_cast<usize>(size.QuadPart);
+	if (m_size == 0)
+		return;
+
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mapping)
+		m_data = static_cast<const u8*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+
+	if (!m_data) {
+		auto error = GetLastError();
+		close();
+		throw FileError(fmt::format("Failed to map '{}': error {}", path, error));
+	}
+}
+
+void MappedFile::close()
+{
+	if (m_data) UnmapViewOfFile(m_data);
+	if (m_mapping) CloseHandle(m_mapping);
+	if (m_file) CloseHandle(m_file);
+
+	m_data = nullptr;
+	m_size = 0;
+	m_mapping = nullptr;
+	m_file = nullptr;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	: m_data(std::exchange(other.m_data, nullptr))
+	, m_size(std::exchange(other.m_size, 0))
+	, m_file(std::exchange(other.m_file, nullptr))
+	, m_mapping(std::exchange(other.m_mapping, nullptr))
+{}
+
+auto MappedFile::operator=(MappedFile&& other) noexcept -> MappedFile&
+{
+	if (this != &other) {
+		close();
+		m_data = std::exchange(other.m_data, nullptr);
+		m_size = std::exchange(other.m_size, 0);
+		m_file = std::exchange(other.m_file, nullptr);
+		m_mapping = std::exchange(other.m_mapping, nullptr);
+	}
+	return *this;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path)
+{
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC); // NOLINT(*-vararg)
+	if (fd < 0)
+		throw FileError(fmt::format("Failed to open '{}': {}", path, std::strerror(errno)));
+
+	struct stat info {};
+	if (::fstat(fd, &info) != 0) {
+		int error = errno;
+		::close(fd);
+		throw FileError(fmt::format("Failed to stat '{}': {}", path, std::strerror(error)));
+	}
+
+	m_size = static_cast<usize>(info.st_size);
+	if (m_size == 0) {
+		::close(fd);
+		return;
+	}
+
+	void* mapping = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	int error = errno;
+
+	// The mapping keeps its own reference to the file
+	::close(fd);
+
+	if (mapping == MAP_FAILED) { // NOLINT(*-cstyle-cast,performance-no-int-to-ptr)
+		m_size = 0;
+		throw FileError(fmt::format("Failed to map '{}': {}", path, std::strerror(error)));
+	}
+
+	m_data = static_cast<const u8*>(mapping);
+}
+
+void MappedFile::close()
+{
+	if (m_data)
+		::munmap(const_cast<u8*>(m_data), m_size); // NOLINT(*-const-cast)
+
+	m_data = nullptr;
+	m_size = 0;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	: m_data(std::exchange(other.m_data, nullptr))
+	, m_size(std::exchange(other.m_size, 0))
+{}
+
+auto MappedFile::operator=(MappedFile&& other) noexcept -> MappedFile&
+{
+	if (this != &other) {
+		close();
+		m_data = std::exchange(other.m_data, nullptr);
+		m_size = std::exchange(other.m_size, 0);
+	}
+	return *this;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+} // namespace mesh
@@ -0,0 +1,98 @@
+#include "mesh/mesh_data.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <math/assert.h>
+
+
+namespace mesh {
+
+void MeshData::push_attribute(Scalar type, u32 count, bool normalized)
+{
+	auto attribute = Attribute{ type, count, normalized, stride };
+	stride += static_cast<u32>(attribute.size());
+
+	layout.push_back(attribute);
+}
+
+auto MeshData::vertex_count() const -> usize
+{
+	return stride == 0 ? 0 : vertices.size() / stride;
+}
+
+auto MeshData::position(usize vertex) const -> math::Vec3
+{
+	ASSERT(!layout.empty() && layout[0].type == Scalar::f32 && layout[0].count >= 2,
+		"Expected the first attribute to be an f32 position, found {} components of type {:#x}",
+		layout.empty() ? 0 : layout[0].count,
+		layout.empty() ? 0 : static_cast<u32>(layout[0].type));
+
+	f32 xyz[3] { 0, 0, 0 };
+	const u8* src = vertices.data() + vertex * stride + layout[0].offset;
+	std::memcpy(xyz, src, std::min<usize>(layout[0].count, 3) * sizeof(f32));
+
+	return math::Vec3{ xyz[0], xyz[1], xyz[2] };
+}
+
+void MeshData::compute_bounds()
+{
+	for (auto& submesh : submeshes) {
+		submesh.bounds.clear();
+
+		for (usize i = submesh.first_index; i < submesh.first_index + submesh.index_count; ++i)
+			submesh.bounds.add(position(indices[i]));
+	}
+}
+
+
+
+void SoaMesh::compute_bounds()
+{
+	for (auto& submesh : submeshes) {
+		submesh.bounds.clear();
+
+		for (usize i = submesh.first_index; i < submesh.first_index + submesh.index_count; ++i)
+			submesh.bounds.add(positions[indices[i]]);
+	}
+}
+
+auto SoaMesh::interleave() const -> MeshData
+{
+	auto result = MeshData();
+	result.push_attribute(Scalar::f32, 3);
+
+	bool has_normals = !normals.empty();
+	bool has_uvs = !uvs.empty();
+	bool has_tangents = !tangents.empty();
+
+	if (has_normals) result.push_attribute(Scalar::f32, 3);
+	if (has_uvs) result.push_attribute(Scalar::f32, 2);
+	if (has_tangents) result.push_attribute(Scalar::f32, 4);
+
+	result.vertices.resize(positions.size() * result.stride);
+	u8* dest = result.vertices.data();
+
+	for (usize i = 0; i < positions.size(); ++i) {
+		f32 vertex[12];
+		usize count = 0;
+
+		for (usize c = 0; c < 3; ++c) vertex[count++] = static_cast<f32>(positions[i][c]);
+		if (has_normals)
+			for (usize c = 0; c < 3; ++c) vertex[count++] = static_cast<f32>(normals[i][c]);
+		if (has_uvs)
+			for (usize c = 0; c < 2; ++c) vertex[count++] = static_cast<f32>(uvs[i][c]);
+		if (has_tangents)
+			for (usize c = 0; c < 4; ++c) vertex[count++] = static_cast<f32>(tangents[i][c]);
+
+		std::memcpy(dest, vertex, count * sizeof(f32));
+		dest += result.stride;
+	}
+
+	result.indices = indices;
+	result.submeshes = submeshes;
+
+	return result;
+}
+
+} // namespace mesh
@@ -0,0 +1,186 @@
+#include "mesh/meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <math/batch.h>
+
+
+namespace mesh::meshlet {
+
+namespace {
+
+using math::Vec3;
+using math::geo::AABBox;
+using math::geo::Sphere;
+
+/** Marks vertices that aren't in the meshlet being filled. */
+constexpr u8 k_no_slot = 0xff;
+
+static_assert(k_max_vertices < k_no_slot, "Local vertex indices must fit in a u8");
+
+
+// Bounds ----------------------------------------------------------------------
+
+void add_bounds(Meshlets& result, const Meshlet& meshlet, const Vec3* positions)
+{
+	const u32* vertices = result.vertices.data() + meshlet.first_vertex;
+	const u8* triangles = result.triangles.data() + static_cast<usize>(meshlet.first_triangle) * 3;
+
+	auto box = AABBox::empty();
+	for (u32 i = 0; i < meshlet.vertex_count; ++i)
+		box.add(positions[vertices[i]]);
+
+	// Not the smallest sphere, but close for the compact clusters built here
+	auto center = box.center();
+	flt sq_radius = 0;
+	for (u32 i = 0; i < meshlet.vertex_count; ++i)
+		sq_radius = std::max(sq_radius, (positions[vertices[i]] - center).sq_length());
+
+	auto normals = std::vector<Vec3>();
+	normals.reserve(meshlet.triangle_count);
+	auto axis = Vec3{ 0, 0, 0 };
+	for (u32 t = 0; t < meshlet.triangle_count; ++t) {
+		const auto& p0 = positions[vertices[triangles[t * 3]]];
+		const auto& p1 = positions[vertices[triangles[t * 3 + 1]]];
+		const auto& p2 = positions[vertices[triangles[t * 3 + 2]]];
+
+		auto normal = (p1 - p0) ^ (p2 - p0);
+		flt length = normal.length();
+		if (length <= 0)
+			continue;
+
+		normal *= 1 / length;
+		normals.push_back(normal);
+		axis += normal;
+	}
+
+	// The cone's angle is the widest between the axis and a normal, and the
+	// culling test wants its sine
+	flt cutoff = 1;
+	flt axis_length = axis.length();
+	if (axis_length > 0) {
+		axis *= 1 / axis_length;
+
+		flt min_cos = 1;
+		for (const auto& normal : normals)
+			min_cos = std::min(min_cos, normal | axis);
+
+		if (min_cos > 0)
+			cutoff = std::sqrt(1 - min_cos * min_cos);
+	}
+	else {
+		axis = Vec3{ 0, 0, 1 };
+	}
+
+	result.spheres.push_back(Sphere{ center, std::sqrt(sq_radius) });
+	result.boxes.push_back(box);
+	result.cone_axes.push_back(axis);
+	result.cone_cutoffs.push_back(cutoff);
+}
+
+} // namespace
+
+
+// Building --------------------------------------------------------------------
+
+auto build(
+	const u32* indices, usize index_count,
+	const Vec3* positions, usize vertex_count)
+	-> Meshlets
+{
+	auto result = Meshlets();
+	usize triangle_count = index_count / 3;
+
+	result.meshlets.reserve(triangle_count / k_max_triangles + 1);
+	// Vertices on the borders between meshlets are repeated in each
+	result.vertices.reserve(std::min(vertex_count * 2, index_count));
+	result.triangles.reserve(triangle_count * 3);
+
+	// Each vertex's index within the meshlet being filled
+	auto slots = std::vector<u8>(vertex_count, k_no_slot);
+	auto current = Meshlet();
+
+	auto flush = [&] {
+		if (current.triangle_count == 0)
+			return;
+
+		for (u32 i = 0; i < current.vertex_count; ++i)
+			slots[result.vertices[current.first_vertex + i]] = k_no_slot;
+
+		result.meshlets.push_back(current);
+		add_bounds(result, current, positions);
+
+		current = Meshlet();
+		current.first_vertex = static_cast<u32>(result.vertices.size());
+		current.first_triangle = static_cast<u32>(result.triangles.size() / 3);
+	};
+
+	for (usize t = 0; t < triangle_count; ++t) {
+		const u32* triangle = indices + t * 3;
+
+		u32 added = (slots[triangle[0]] == k_no_slot)
+			+ (slots[triangle[1]] == k_no_slot && triangle[1] != triangle[0])
+			+ (slots[triangle[2]] == k_no_slot && triangle[2] != triangle[0] && triangle[2] != triangle[1]);
+
+		if (current.vertex_count + added > k_max_vertices || current.triangle_count == k_max_triangles)
+			flush();
+
+		for (usize i = 0; i < 3; ++i) {
+			u32 v = triangle[i];
+			if (slots[v] == k_no_slot) {
+				slots[v] = static_cast<u8>(current.vertex_count++);
+				result.vertices.push_back(v);
+			}
+			result.triangles.push_back(slots[v]);
+		}
+		++current.triangle_count;
+	}
+	flush();
+
+	return result;
+}
+
+
+// Culling ---------------------------------------------------------------------
+
+auto Culler::cull(
+	const Meshlets& meshlets,
+	const math::geo::Plane* planes, usize plane_count,
+	const Vec3& eye,
+	std::vector<u32>& out_indices)
+	-> usize
+{
+	usize count = meshlets.size();
+	m_inside.resize(count);
+	m_front.resize(count);
+
+	math::batch::cull_spheres(planes, plane_count, meshlets.spheres.data(), count, m_inside.data());
+	math::batch::cull_cones(
+		eye,
+		meshlets.spheres.data(), meshlets.cone_axes.data(), meshlets.cone_cutoffs.data(), count,
+		m_front.data());
+
+	out_indices.clear();
+	usize result = 0;
+	for (usize i = 0; i < count; ++i) {
+		if (!(m_inside[i] & m_front[i]))
+			continue;
+
+		const auto& meshlet = meshlets.meshlets[i];
+		const u32* vertices = meshlets.vertices.data() + meshlet.first_vertex;
+		const u8* local = meshlets.triangles.data() + static_cast<usize>(meshlet.first_triangle) * 3;
+
+		usize offset = out_indices.size();
+		out_indices.resize(offset + static_cast<usize>(meshlet.triangle_count) * 3);
+		u32* out = out_indices.data() + offset;
+		for (usize k = 0; k < static_cast<usize>(meshlet.triangle_count) * 3; ++k)
+			out[k] = vertices[local[k]];
+
+		++result;
+	}
+
+	return result;
+}
+
+} // namespace mesh::meshlet
@@ -0,0 +1,500 @@
+#include "mesh/obj.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <fmt/format.h>
+#include <math/detail/parallel.h>
+
+#include "mesh/error.h"
+#include "mesh/mapped_file.h"
+#include "mesh/parse.h"
+
+
+namespace mesh::obj {
+
+namespace {
+
+using math::Vec2;
+using math::Vec3;
+
+constexpr i64 k_missing = std::numeric_limits<i64>::min();
+constexpr u32 k_none = std::numeric_limits<u32>::max();
+
+enum Relative : u8 {
+	RelativePosition = 1 << 0,
+	RelativeUv = 1 << 1,
+	RelativeNormal = 1 << 2,
+};
+
+/**
+ * One face corner's indices as written. Absolute indices are stored 0-based;
+ * relative (negative) indices are stored relative to the start of the chunk
+ * and flagged, since the chunk doesn't know how many elements precede it.
+ */
+struct Corner {
+	i64 position = k_missing;
+	i64 uv = k_missing;
+	i64 normal = k_missing;
+	u8 relative = 0;
+};
+
+/** The resolved, 0-based indices of a face corner, which identify a vertex. */
+struct Key {
+	u32 position = k_none;
+	u32 uv = k_none;
+	u32 normal = k_none;
+
+	auto operator==(const Key& other) const -> bool
+	{
+		return position == other.position && uv == other.uv && normal == other.normal;
+	}
+};
+
+/** A line-aligned slice of the file, and everything parsed from it. */
+struct Chunk {
+	const char* begin = nullptr;
+	const char* end = nullptr;
+
+	std::vector<Vec3> positions;
+	std::vector<Vec2> uvs;
+	std::vector<Vec3> normals;
+	/** Three corners per triangle. */
+	std::vector<Corner> corners;
+	/** Offsets into `corners` at which an `o`, `g` or `usemtl` was seen. */
+	std::vector<usize> submesh_starts;
+
+	usize line_count = 0;
+	/** The 1-based line within the chunk of the first error, or 0. */
+	usize error_line = 0;
+	std::string error;
+};
+
+/** Split `[data, data + size)` into up to `count` chunks, each ending after a newline. */
+auto split(const char* data, usize size, usize count) -> std::vector<Chunk>
+{
+	auto result = std::vector<Chunk>();
+	const char* end = data + size;
+	const char* begin = data;
+
+	for (usize i = 1; i <= count && begin != end; ++i) {
+		const char* split = (i == count) ? end : data + size * i / count;
+		if (split < begin)
+			continue;
+
+		if (split != end) {
+			const auto* newline = static_cast<const char*>(
+				std::memchr(split, '\n', static_cast<usize>(end - split)));
+			split = newline ? newline + 1 : end;
+		}
+
+		auto& chunk = result.emplace_back();
+		chunk.begin = begin;
+		chunk.end = split;
+		begin = split;
+	}
+
+	return result;
+}
+
+
+// Parsing ---------------------------------------------------------------------
+
+constexpr auto is_space(char c) -> bool
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+void skip_spaces(const char*& it, const char* end)
+{
+	while (it != end && is_space(*it))
+		++it;
+}
+
+auto read_float(const char*& it, const char* end, flt& out) -> bool
+{
+	skip_spaces(it, end);
+
+	f64 value;
+	if (!parse::parse_float(it, end, value))
+		return false;
+
+	out = static_cast<flt>(value);
+	return true;
+}
+
+/**
+ * Convert an index as written to a chunk-local one. Positive indices are
+ * 1-based and absolute, negative ones count back from the latest element.
+ */
+auto resolve_local(i64 index, usize local_count, u8 flag, u8& relative) -> i64
+{
+	if (index > 0)
+		return index - 1;
+
+	relative |= flag;
+	return static_cast<i64>(local_count) + index;
+}
+
+/** Parse one `v/vt/vn` face corner. */
+auto read_corner(const char*& it, const char* end, const Chunk& chunk, Corner& out) -> bool
+{
+	i64 index = 0;
+	if (!parse::parse_int(it, end, index) || index == 0)
+		return false;
+
+	out = Corner{};
+	out.position = resolve_local(index, chunk.positions.size(), RelativePosition, out.relative);
+
+	if (it == end || *it != '/')
+		return true;
+	++it;
+
+	// The uv index may be omitted (`v//vn`)
+	if (it != end && *it != '/') {
+		if (!parse::parse_int(it, end, index) || index == 0)
+			return false;
+
+		out.uv = resolve_local(index, chunk.uvs.size(), RelativeUv, out.relative);
+	}
+
+	if (it == end || *it != '/')
+		return true;
+	++it;
+
+	if (!parse::parse_int(it, end, index) || index == 0)
+		return false;
+
+	out.normal = resolve_local(index, chunk.normals.size(), RelativeNormal, out.relative);
+	return true;
+}
+
+/** Parse a single statement, with `it` just past its keyword. */
+auto parse_statement(std::string_view keyword, const char*& it, const char* end, Chunk& chunk)
+	-> const char* // error message, or nullptr
+{
+	if (keyword == "v") {
+		Vec3 p;
+		if (!read_float(it, end, p.x) || !read_float(it, end, p.y) || !read_float(it, end, p.z))
+			return "expected three coordinates";
+
+		chunk.positions.push_back(p);
+	}
+	else if (keyword == "vt") {
+		Vec2 uv { 0, 0 };
+		if (!read_float(it, end, uv.x))
+			return "expected a texture coordinate";
+
+		read_float(it, end, uv.y);
+		chunk.uvs.push_back(uv);
+	}
+	else if (keyword == "vn") {
+		Vec3 n;
+		if (!read_float(it, end, n.x) || !read_float(it, end, n.y) || !read_float(it, end, n.z))
+			return "expected three normal components";
+
+		chunk.normals.push_back(n);
+	}
+	else if (keyword == "f") {
+		Corner first, previous, current;
+		usize count = 0;
+
+		for (skip_spaces(it, end); it != end && *it != '\n' && *it != '#'; skip_spaces(it, end)) {
+			if (!read_corner(it, end, chunk, current))
+				return "invalid face index";
+
+			// Fan-triangulate polygons as we go
+			if (count >= 2) {
+				chunk.corners.push_back(first);
+				chunk.corners.push_back(previous);
+				chunk.corners.push_back(current);
+			}
+
+			if (count == 0) first = current;
+			previous = current;
+			++count;
+		}
+
+		if (count < 3)
+			return "expected at least three face indices";
+	}
+	else if (keyword == "o" || keyword == "g" || keyword == "usemtl") {
+		chunk.submesh_starts.push_back(chunk.corners.size());
+	}
+
+	return nullptr;
+}
+
+void parse_chunk(Chunk& chunk)
+{
+	const char* it = chunk.begin;
+	const char* end = chunk.end;
+
+	while (it != end) {
+		++chunk.line_count;
+		skip_spaces(it, end);
+
+		const char* keyword_begin = it;
+		while (it != end && !is_space(*it) && *it != '\n')
+			++it;
+
+		auto keyword = std::string_view(keyword_begin, static_cast<usize>(it - keyword_begin));
+		if (!keyword.empty() && keyword[0] != '#') {
+			if (const char* error = parse_statement(keyword, it, end, chunk)) {
+				chunk.error_line = chunk.line_count;
+				chunk.error = fmt::format("'{}' statement: {}", keyword, error);
+				return;
+			}
+		}
+
+		const auto* newline = static_cast<const char*>(
+			std::memchr(it, '\n', static_cast<usize>(end - it)));
+		it = newline ? newline + 1 : end;
+	}
+}
+
+
+// Vertex deduplication --------------------------------------------------------
+
+/** An open-addressing hash map from `Key` to output vertex index. */
+class VertexMap {
+public:
+	explicit VertexMap(usize expected)
+	{
+		usize capacity = 16;
+		while (capacity < expected * 2)
+			capacity *= 2;
+
+		m_slots.resize(capacity);
+	}
+
+	/** Get the vertex for `key`, or insert it as `vertex` if it's new. */
+	auto insert(const Key& key, u32 vertex) -> u32
+	{
+		if ((m_size + 1) * 2 > m_slots.size())
+			grow();
+
+		usize mask = m_slots.size() - 1;
+		for (usize i = hash(key) & mask;; i = (i + 1) & mask) {
+			auto& slot = m_slots[i];
+
+			if (slot.vertex == k_none) {
+				slot = { key, vertex };
+				++m_size;
+				return vertex;
+			}
+			if (slot.key == key)
+				return slot.vertex;
+		}
+	}
+
+private:
+	struct Slot {
+		Key key;
+		u32 vertex = k_none;
+	};
+
+	static auto hash(const Key& key) -> usize
+	{
+		u64 h = key.position * 0x9e3779b97f4a7c15ull;
+		h ^= key.uv * 0xc2b2ae3d27d4eb4full;
+		h ^= key.normal * 0x165667b19e3779f9ull;
+
+		return static_cast<usize>(h ^ (h >> 29));
+	}
+
+	void grow()
+	{
+		auto old = std::move(m_slots);
+		m_slots = std::vector<Slot>(old.size() * 2);
+		m_size = 0;
+
+		for (const auto& slot : old)
+			if (slot.vertex != k_none)
+				insert(slot.key, slot.vertex);
+	}
+
+	std::vector<Slot> m_slots;
+	usize m_size = 0;
+};
+
+
+// Assembly --------------------------------------------------------------------
+
+/** Resolve a corner index to an absolute one, checking it against `count`. */
+auto resolve(i64 index, bool relative, usize base, usize count, const char* what) -> u32
+{
+	if (index == k_missing)
+		return k_none;
+
+	i64 absolute = relative ? static_cast<i64>(base) + index : index;
+	if (absolute < 0 || static_cast<u64>(absolute) >= count)
+		throw FileError(fmt::format(
+			"OBJ face references {} {}, but only {} are defined",
+			what, absolute + 1, count));
+
+	return static_cast<u32>(absolute);
+}
+
+auto assemble(std::vector<Chunk>& chunks, usize threads) -> SoaMesh
+{
+	// Offsets of each chunk's elements in the file-wide arrays
+	struct Base {
+		usize positions = 0, uvs = 0, normals = 0, corners = 0;
+	};
+
+	auto bases = std::vector<Base>(chunks.size() + 1);
+	for (usize i = 0; i < chunks.size(); ++i) {
+		bases[i + 1].positions = bases[i].positions + chunks[i].positions.size();
+		bases[i + 1].uvs = bases[i].uvs + chunks[i].uvs.size();
+		bases[i + 1].normals = bases[i].normals + chunks[i].normals.size();
+		bases[i + 1].corners = bases[i].corners + chunks[i].corners.size();
+	}
+	const auto& total = bases.back();
+
+	if (total.corners > std::numeric_limits<u32>::max()
+		|| total.positions >= std::numeric_limits<u32>::max())
+	{
+		throw FileError("OBJ file is too large for 32-bit indices");
+	}
+
+	// Resolve every corner to absolute indices in parallel
+	auto keys = std::vector<Key>(total.corners);
+	auto has_uvs = std::atomic<bool>(false);
+	auto has_normals = std::atomic<bool>(false);
+
+	math::detail::parallel_for(chunks.size(), threads, [&](usize c) {
+		const auto& chunk = chunks[c];
+		const auto& base = bases[c];
+		bool uvs = false;
+		bool normals = false;
+
+		for (usize i = 0; i < chunk.corners.size(); ++i) {
+			const auto& corner = chunk.corners[i];
+			auto& key = keys[base.corners + i];
+
+			key.position = resolve(corner.position, corner.relative & RelativePosition,
+				base.positions, total.positions, "position");
+			key.uv = resolve(corner.uv, corner.relative & RelativeUv,
+				base.uvs, total.uvs, "texture coordinate");
+			key.normal = resolve(corner.normal, corner.relative & RelativeNormal,
+				base.normals, total.normals, "normal");
+
+			uvs |= key.uv != k_none;
+			normals |= key.normal != k_none;
+		}
+
+		if (uvs) has_uvs = true;
+		if (normals) has_normals = true;
+	});
+
+	// Flatten the attribute arrays so vertices can be gathered by index
+	auto flatten = [&](auto member, usize count) {
+		using T = typename std::decay_t<decltype(chunks[0].*member)>::value_type;
+		auto result = std::vector<T>();
+		result.reserve(count);
+		for (auto& chunk : chunks) {
+			auto& source = chunk.*member;
+			result.insert(result.end(), source.begin(), source.end());
+			source = {};
+		}
+		return result;
+	};
+
+	auto all_positions = flatten(&Chunk::positions, total.positions);
+	auto all_uvs = flatten(&Chunk::uvs, total.uvs);
+	auto all_normals = flatten(&Chunk::normals, total.normals);
+
+	auto result = SoaMesh();
+	result.indices.resize(keys.size());
+
+	auto emit = [&](const Key& key) {
+		result.positions.push_back(all_positions[key.position]);
+
+		if (has_uvs)
+			result.uvs.push_back(key.uv == k_none ? Vec2{ 0, 0 } : all_uvs[key.uv]);
+		if (has_normals)
+			result.normals.push_back(key.normal == k_none ? Vec3{ 0, 0, 0 } : all_normals[key.normal]);
+	};
+
+	if (!has_uvs && !has_normals) {
+		// Vertices are just positions, so a flat remap table beats hashing
+		auto remap = std::vector<u32>(total.positions, k_none);
+
+		for (usize i = 0; i < keys.size(); ++i) {
+			u32& vertex = remap[keys[i].position];
+			if (vertex == k_none) {
+				vertex = static_cast<u32>(result.positions.size());
+				emit(keys[i]);
+			}
+			result.indices[i] = vertex;
+		}
+	}
+	else {
+		auto map = VertexMap(std::max({ total.positions, total.uvs, total.normals }));
+
+		for (usize i = 0; i < keys.size(); ++i) {
+			auto next = static_cast<u32>(result.positions.size());
+			u32 vertex = map.insert(keys[i], next);
+
+			if (vertex == next)
+				emit(keys[i]);
+
+			result.indices[i] = vertex;
+		}
+	}
+
+	// Submeshes start at the beginning and at every `o`/`g`/`usemtl`
+	auto starts = std::vector<usize>{ 0 };
+	for (usize c = 0; c < chunks.size(); ++c)
+		for (usize start : chunks[c].submesh_starts)
+			starts.push_back(bases[c].corners + start);
+	starts.push_back(total.corners);
+
+	for (usize i = 0; i + 1 < starts.size(); ++i) {
+		if (starts[i + 1] > starts[i])
+			result.submeshes.push_back({
+				static_cast<u32>(starts[i]),
+				static_cast<u32>(starts[i + 1] - starts[i]),
+			});
+	}
+
+	result.compute_bounds();
+
+	return result;
+}
+
+} // namespace
+
+
+auto import(const char* data, usize size, const ImportOptions& options) -> SoaMesh
+{
+	usize threads = math::detail::thread_count(options.threads);
+	usize chunk_count = std::clamp<usize>(size / std::max<usize>(options.min_chunk_size, 1), 1, threads);
+
+	auto chunks = split(data, size, chunk_count);
+	math::detail::parallel_for(chunks.size(), threads, [&](usize i) { parse_chunk(chunks[i]); });
+
+	usize line = 0;
+	for (const auto& chunk : chunks) {
+		if (!chunk.error.empty())
+			throw FileError(fmt::format("OBJ line {}: {}", line + chunk.error_line, chunk.error));
+
+		line += chunk.line_count;
+	}
+
+	return assemble(chunks, threads);
+}
+
+auto import(const std::string& path, const ImportOptions& options) -> SoaMesh
+{
+	auto file = MappedFile(path);
+	return import(reinterpret_cast<const char*>(file.data()), file.size(), options); // NOLINT(*-reinterpret-cast)
+}
+
+} // namespace mesh::obj
@@ -0,0 +1,390 @@
+#include "mesh/optimize.h"
+
+#include <algorithm>
+#include <numeric>
+
+
+namespace mesh::optimize {
+
+namespace {
+
+using math::Vec3;
+
+/**
+ * A FIFO post-transform cache, modelled with per-vertex timestamps: a vertex
+ * is cached if fewer than `cache_size` vertices have been transformed since
+ * it was.
+ */
+class CacheSim {
+public:
+	CacheSim(usize vertex_count, usize cache_size)
+		: m_timestamps(vertex_count, 0)
+		, m_cache_size(static_cast<u32>(cache_size))
+		, m_time(m_cache_size + 1)
+	{}
+
+	/** Reference a vertex, returning whether it had to be transformed. */
+	auto access(u32 vertex) -> bool
+	{
+		if (m_time - m_timestamps[vertex] > m_cache_size) {
+			m_timestamps[vertex] = m_time++;
+			return true;
+		}
+		return false;
+	}
+
+	/** Reference a triangle's vertices, returning the number of misses. */
+	auto access(const u32* triangle) -> u32
+	{
+		return u32(access(triangle[0])) + u32(access(triangle[1])) + u32(access(triangle[2]));
+	}
+
+	/** Empty the cache. */
+	void flush()
+	{
+		m_time += m_cache_size + 1;
+	}
+
+	/** The time since a vertex was last transformed. */
+	auto age(u32 vertex) const -> u32
+	{
+		return m_time - m_timestamps[vertex];
+	}
+
+private:
+	std::vector<u32> m_timestamps;
+	u32 m_cache_size;
+	u32 m_time;
+};
+
+/** The triangles using each vertex, in compressed sparse row form. */
+struct Adjacency {
+	std::vector<u32> counts;
+	std::vector<u32> offsets;
+	std::vector<u32> triangles;
+
+	Adjacency(const u32* indices, usize index_count, usize vertex_count)
+		: counts(vertex_count, 0)
+		, offsets(vertex_count + 1, 0)
+		, triangles(index_count)
+	{
+		for (usize i = 0; i < index_count; ++i)
+			++counts[indices[i]];
+
+		std::partial_sum(counts.begin(), counts.end(), offsets.begin() + 1);
+
+		auto cursor = std::vector<u32>(offsets.begin(), offsets.end() - 1);
+		for (usize i = 0; i < index_count; ++i)
+			triangles[cursor[indices[i]]++] = static_cast<u32>(i / 3);
+	}
+};
+
+} // namespace
+
+
+// Statistics ------------------------------------------------------------------
+
+auto analyze_vertex_cache(
+	const u32* indices, usize index_count,
+	usize vertex_count,
+	usize cache_size)
+	-> CacheStats
+{
+	auto result = CacheStats{};
+	if (index_count == 0)
+		return result;
+
+	auto cache = CacheSim(vertex_count, cache_size);
+	for (usize i = 0; i < index_count; ++i)
+		result.transformed += cache.access(indices[i]);
+
+	// Only count the vertices that are actually referenced
+	auto used = std::vector<bool>(vertex_count, false);
+	usize used_count = 0;
+	for (usize i = 0; i < index_count; ++i) {
+		if (!used[indices[i]]) {
+			used[indices[i]] = true;
+			++used_count;
+		}
+	}
+
+	result.acmr = f32(result.transformed) / f32(index_count / 3);
+	result.atvr = f32(result.transformed) / f32(used_count);
+
+	return result;
+}
+
+
+// Vertex cache ----------------------------------------------------------------
+
+void optimize_vertex_cache(
+	u32* dest,
+	const u32* indices, usize index_count,
+	usize vertex_count,
+	usize cache_size)
+{
+	usize triangle_count = index_count / 3;
+	auto adjacency = Adjacency(indices, index_count, vertex_count);
+
+	auto& live = adjacency.counts;
+	auto emitted = std::vector<bool>(triangle_count, false);
+	auto cache = CacheSim(vertex_count, cache_size);
+
+	auto result = std::vector<u32>();
+	result.reserve(index_count);
+
+	auto dead_end = std::vector<u32>();
+	dead_end.reserve(index_count);
+
+	auto candidates = std::vector<u32>();
+	usize cursor = 0;
+
+	// When the fanning vertex has no cached neighbours left, fall back to the
+	// most recently used vertex that still has triangles, then to input order
+	auto skip_dead_end = [&]() -> i64 {
+		while (!dead_end.empty()) {
+			u32 vertex = dead_end.back();
+			dead_end.pop_back();
+
+			if (live[vertex] > 0)
+				return vertex;
+		}
+		for (; cursor < vertex_count; ++cursor)
+			if (live[cursor] > 0)
+				return static_cast<i64>(cursor);
+
+		return -1;
+	};
+
+	auto next_vertex = [&]() -> i64 {
+		i64 best = -1;
+		i64 best_priority = -1;
+
+		for (u32 vertex : candidates) {
+			if (live[vertex] == 0)
+				continue;
+
+			// Prefer the oldest vertex that will still be in the cache after
+			// emitting all its remaining triangles
+			i64 priority = 0;
+			if (cache.age(vertex) + 2 * live[vertex] <= cache_size)
+				priority = cache.age(vertex);
+
+			if (priority > best_priority) {
+				best = vertex;
+				best_priority = priority;
+			}
+		}
+
+		return best >= 0 ? best : skip_dead_end();
+	};
+
+	for (i64 fanning = skip_dead_end(); fanning >= 0; fanning = next_vertex()) {
+		candidates.clear();
+
+		auto begin = adjacency.offsets[fanning];
+		auto end = adjacency.offsets[fanning + 1];
+
+		for (u32 t = begin; t < end; ++t) {
+			u32 triangle = adjacency.triangles[t];
+			if (emitted[triangle])
+				continue;
+
+			for (usize k = 0; k < 3; ++k) {
+				u32 vertex = indices[triangle * 3 + k];
+
+				result.push_back(vertex);
+				dead_end.push_back(vertex);
+				candidates.push_back(vertex);
+
+				--live[vertex];
+				cache.access(vertex);
+			}
+			emitted[triangle] = true;
+		}
+	}
+
+	std::copy(result.begin(), result.end(), dest);
+}
+
+
+// Overdraw --------------------------------------------------------------------
+
+void optimize_overdraw(
+	u32* dest,
+	const u32* indices, usize index_count,
+	const math::Vec3* positions, usize vertex_count,
+	usize cache_size,
+	f32 threshold)
+{
+	usize triangle_count = index_count / 3;
+	if (triangle_count == 0)
+		return;
+
+	// Hard boundaries are where the cache-optimized order already restarts,
+	// i.e. a triangle none of whose vertices are cached
+	auto hard = std::vector<usize>();
+	{
+		auto cache = CacheSim(vertex_count, cache_size);
+		for (usize t = 0; t < triangle_count; ++t)
+			if (cache.access(&indices[t * 3]) == 3 || t == 0)
+				hard.push_back(t);
+	}
+	hard.push_back(triangle_count);
+
+	// Split each hard cluster further wherever the running miss ratio of the
+	// current piece drops to within `threshold` of the whole cluster's
+	auto clusters = std::vector<usize>();
+	{
+		auto cache = CacheSim(vertex_count, cache_size);
+
+		for (usize h = 0; h + 1 < hard.size(); ++h) {
+			usize start = hard[h];
+			usize end = hard[h + 1];
+
+			cache.flush();
+			u32 cluster_misses = 0;
+			for (usize t = start; t < end; ++t)
+				cluster_misses += cache.access(&indices[t * 3]);
+
+			f32 target = threshold * f32(cluster_misses) / f32(end - start);
+
+			clusters.push_back(start);
+			cache.flush();
+
+			u32 misses = 0;
+			u32 count = 0;
+			for (usize t = start; t < end; ++t) {
+				misses += cache.access(&indices[t * 3]);
+				++count;
+
+				if (t + 1 < end && f32(misses) / f32(count) <= target) {
+					clusters.push_back(t + 1);
+					cache.flush();
+					misses = 0;
+					count = 0;
+				}
+			}
+		}
+	}
+	clusters.push_back(triangle_count);
+
+	// Sort clusters so those facing away from the mesh's centroid come first:
+	// they're the most likely to occlude the rest
+	usize cluster_count = clusters.size() - 1;
+
+	auto centroid = Vec3{ 0, 0, 0 };
+	flt total_area = 0;
+
+	auto cluster_centroids = std::vector<Vec3>(cluster_count, Vec3{ 0, 0, 0 });
+	auto cluster_normals = std::vector<Vec3>(cluster_count, Vec3{ 0, 0, 0 });
+
+	for (usize c = 0; c < cluster_count; ++c) {
+		flt cluster_area = 0;
+
+		for (usize t = clusters[c]; t < clusters[c + 1]; ++t) {
+			const auto& a = positions[indices[t * 3 + 0]];
+			const auto& b = positions[indices[t * 3 + 1]];
+			const auto& p = positions[indices[t * 3 + 2]];
+
+			auto normal = (b - a) ^ (p - a);
+			flt area = normal.length();
+			auto center = (a + b + p) / 3;
+
+			cluster_centroids[c] += center * area;
+			cluster_normals[c] += normal;
+			cluster_area += area;
+		}
+
+		centroid += cluster_centroids[c];
+		total_area += cluster_area;
+
+		if (cluster_area > 0)
+			cluster_centroids[c] /= cluster_area;
+	}
+
+	if (total_area > 0)
+		centroid /= total_area;
+
+	auto sort_keys = std::vector<flt>(cluster_count);
+	for (usize c = 0; c < cluster_count; ++c)
+		sort_keys[c] = (cluster_centroids[c] - centroid) | cluster_normals[c].normal();
+
+	auto order = std::vector<usize>(cluster_count);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](usize lhs, usize rhs) {
+		return sort_keys[lhs] > sort_keys[rhs];
+	});
+
+	u32* out = dest;
+	for (usize c : order) {
+		const u32* begin = indices + clusters[c] * 3;
+		const u32* end = indices + clusters[c + 1] * 3;
+		out = std::copy(begin, end, out);
+	}
+}
+
+
+// Vertex fetch ----------------------------------------------------------------
+
+auto optimize_vertex_fetch(u32* indices, usize index_count, usize vertex_count) -> std::vector<u32>
+{
+	auto remap = std::vector<u32>(vertex_count, k_unused);
+	u32 next = 0;
+
+	for (usize i = 0; i < index_count; ++i) {
+		u32& target = remap[indices[i]];
+		if (target == k_unused)
+			target = next++;
+
+		indices[i] = target;
+	}
+
+	return remap;
+}
+
+
+// Pipeline --------------------------------------------------------------------
+
+auto optimize(SoaMesh& mesh, const Options& options) -> Report
+{
+	auto result = Report{};
+	usize vertex_count = mesh.vertex_count();
+
+	result.before = analyze_vertex_cache(
+		mesh.indices.data(), mesh.indices.size(), vertex_count, options.cache_size);
+
+	// Triangles never move between submeshes
+	auto ranges = mesh.submeshes;
+	if (ranges.empty())
+		ranges.push_back({ 0, static_cast<u32>(mesh.indices.size()) });
+
+	auto scratch = std::vector<u32>();
+	for (const auto& submesh : ranges) {
+		u32* indices = mesh.indices.data() + submesh.first_index;
+		usize count = submesh.index_count;
+
+		optimize_vertex_cache(indices, indices, count, vertex_count, options.cache_size);
+
+		if (options.overdraw) {
+			scratch.assign(indices, indices + count);
+			optimize_overdraw(
+				indices, scratch.data(), count,
+				mesh.positions.data(), vertex_count,
+				options.cache_size, options.overdraw_threshold);
+		}
+	}
+
+	auto remap = optimize_vertex_fetch(mesh.indices.data(), mesh.indices.size(), vertex_count);
+	remap_vertices(mesh.positions, remap);
+	remap_vertices(mesh.normals, remap);
+	remap_vertices(mesh.tangents, remap);
+	remap_vertices(mesh.uvs, remap);
+
+	result.after = analyze_vertex_cache(
+		mesh.indices.data(), mesh.indices.size(), mesh.vertex_count(), options.cache_size);
+
+	return result;
+}
+
+} // namespace mesh::optimize
@@ -0,0 +1,171 @@
+#include "mesh/parse.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <limits>
+
+
+namespace mesh::parse {
+
+namespace {
+
+constexpr auto is_digit(char c) -> bool
+{
+	return c >= '0' && c <= '9';
+}
+
+/** Powers of ten which are exactly representable as an `f64`. */
+constexpr auto k_exact_powers = std::array<f64, 23>{
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/** Mantissas up to 2^53 convert to `f64` exactly. */
+constexpr u64 k_max_exact_mantissa = u64(1) << 53;
+
+auto parse_float_slow(const char* begin, const char* end, f64& out) -> bool
+{
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+	auto [ptr, error] = std::from_chars(begin, end, out);
+	return error == std::errc() && ptr == end;
+#else
+	// Without a locale-free strtod, redo the parse in long double. This isn't
+	// always correctly rounded, but is within an ulp.
+	long double mantissa = 0;
+	i64 exponent = 0;
+	const char* it = begin;
+	bool negative = *it == '-';
+	if (*it == '-' || *it == '+') ++it;
+
+	for (; it != end && is_digit(*it); ++it)
+		mantissa = mantissa * 10 + (*it - '0');
+	if (it != end && *it == '.')
+		for (++it; it != end && is_digit(*it); ++it, --exponent)
+			mantissa = mantissa * 10 + (*it - '0');
+	if (it != end && (*it == 'e' || *it == 'E')) {
+		++it;
+		i64 e = 0;
+		if (!parse_int(it, end, e))
+			return false;
+		exponent += e;
+	}
+
+	long double result = mantissa * std::pow(10.0L, static_cast<long double>(exponent));
+	out = static_cast<f64>(negative ? -result : result);
+	return true;
+#endif
+}
+
+} // namespace
+
+
+auto parse_float(const char*& it, const char* end, f64& out) -> bool
+{
+	const char* p = it;
+	bool negative = false;
+
+	if (p != end && (*p == '-' || *p == '+')) {
+		negative = *p == '-';
+		++p;
+	}
+
+	u64 mantissa = 0;
+	i64 exponent = 0;
+	usize digits = 0;
+	usize significant = 0;
+
+	// Leading zeros don't count towards the significant digits
+	for (; p != end && *p == '0'; ++p)
+		++digits;
+
+	for (; p != end && is_digit(*p); ++p, ++digits) {
+		if (significant < 19) {
+			mantissa = mantissa * 10 + static_cast<u64>(*p - '0');
+			++significant;
+		} else {
+			++exponent;
+			++significant;
+		}
+	}
+
+	if (p != end && *p == '.') {
+		++p;
+		if (mantissa == 0)
+			for (; p != end && *p == '0'; ++p, ++digits)
+				--exponent;
+
+		for (; p != end && is_digit(*p); ++p, ++digits) {
+			if (significant < 19) {
+				mantissa = mantissa * 10 + static_cast<u64>(*p - '0');
+				--exponent;
+			}
+			++significant;
+		}
+	}
+
+	if (digits == 0)
+		return false;
+
+	if (p != end && (*p == 'e' || *p == 'E')) {
+		const char* exponent_start = p + 1;
+		i64 e = 0;
+
+		if (parse_int(exponent_start, end, e)) {
+			// Far beyond the range of an f64 either way, but keeps the sum in range
+			exponent += std::clamp<i64>(e, -100'000, 100'000);
+			p = exponent_start;
+		}
+	}
+
+	if (significant <= 19 && mantissa <= k_max_exact_mantissa
+		&& exponent >= -22 && exponent <= 22)
+	{
+		auto value = static_cast<f64>(mantissa);
+		value = exponent < 0
+			? value / k_exact_powers[static_cast<usize>(-exponent)]
+			: value * k_exact_powers[static_cast<usize>(exponent)];
+
+		out = negative ? -value : value;
+	}
+	else if (mantissa == 0) {
+		out = negative ? -0.0 : 0.0;
+	}
+	else {
+		// `from_chars` doesn't accept a leading '+'
+		const char* start = (*it == '+') ? it + 1 : it;
+		if (!parse_float_slow(start, p, out))
+			return false;
+	}
+
+	it = p;
+	return true;
+}
+
+auto parse_int(const char*& it, const char* end, i64& out) -> bool
+{
+	const char* p = it;
+	bool negative = false;
+
+	if (p != end && (*p == '-' || *p == '+')) {
+		negative = *p == '-';
+		++p;
+	}
+
+	if (p == end || !is_digit(*p))
+		return false;
+
+	u64 value = 0;
+	for (; p != end && is_digit(*p); ++p) {
+		value = value * 10 + static_cast<u64>(*p - '0');
+		if (value > static_cast<u64>(std::numeric_limits<i64>::max()))
+			return false;
+	}
+
+	out = negative ? -static_cast<i64>(value) : static_cast<i64>(value);
+	it = p;
+	return true;
+}
+
+} // namespace mesh::parse
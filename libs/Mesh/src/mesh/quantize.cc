@@ -0,0 +1,379 @@
+#include "mesh/quantize.h"
+
+#include <cmath>
+#include <cstring>
+
+
+namespace mesh::quantize {
+
+using math::Quat;
+using math::Vec2;
+using math::Vec3;
+using math::geo::AABBox;
+
+namespace {
+
+auto bits(f32 value) -> u32
+{
+	u32 result;
+	std::memcpy(&result, &value, sizeof(result));
+	return result;
+}
+
+auto from_bits(u32 value) -> f32
+{
+	f32 result;
+	std::memcpy(&result, &value, sizeof(result));
+	return result;
+}
+
+/** Like `std::copysign(1, value)`, but folds -0 into +1 too. */
+auto sign(flt value) -> flt
+{
+	return value < 0 ? -1 : 1;
+}
+
+auto decode_octahedral(flt x, flt y) -> Vec3
+{
+	auto result = Vec3{ x, y, 1 - std::abs(x) - std::abs(y) };
+
+	flt fold = std::max<flt>(-result.z, 0);
+	result.x += result.x >= 0 ? -fold : fold;
+	result.y += result.y >= 0 ? -fold : fold;
+
+	return result.normal();
+}
+
+/**
+ * Encode a unit vector in `Bits`-bit octahedral coordinates, picking whichever
+ * of the four neighbouring grid points decodes closest to `n`.
+ */
+template <usize Bits>
+auto octahedral(const Vec3& n) -> std::array<i32, 2>
+{
+	constexpr flt scale = flt((1u << (Bits - 1)) - 1);
+
+	flt l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+	if (l1 == 0)
+		return { 0, 0 };
+
+	flt x = n.x / l1;
+	flt y = n.y / l1;
+
+	if (n.z < 0) {
+		flt folded_x = (1 - std::abs(y)) * sign(x);
+		flt folded_y = (1 - std::abs(x)) * sign(y);
+		x = folded_x;
+		y = folded_y;
+	}
+
+	auto best = std::array<i32, 2>{ snorm<Bits>(x), snorm<Bits>(y) };
+	flt best_dot = -2;
+
+	for (flt cx : { std::floor(x * scale), std::ceil(x * scale) })
+		for (flt cy : { std::floor(y * scale), std::ceil(y * scale) }) {
+			auto candidate = std::array<i32, 2>{ static_cast<i32>(cx), static_cast<i32>(cy) };
+			auto decoded = decode_octahedral(
+				decode_snorm<Bits>(candidate[0]),
+				decode_snorm<Bits>(candidate[1]));
+
+			flt dot = decoded | n;
+			if (dot > best_dot) {
+				best_dot = dot;
+				best = candidate;
+			}
+		}
+
+	return best;
+}
+
+} // namespace
+
+
+// Scalars ---------------------------------------------------------------------
+
+// Based on Fabian Giesen's float_to_half_fast3_rtne and half_to_float_fast5
+// (https://gist.github.com/rygorous/2156668)
+
+auto half(f32 value) -> u16
+{
+	constexpr u32 f32_infinity = 255u << 23;
+	constexpr u32 f16_max = (127u + 16) << 23;
+	constexpr u32 denorm_magic = ((127u - 15) + (23 - 10) + 1) << 23;
+
+	u32 f = bits(value);
+	u32 sign = f & 0x8000'0000u;
+	f ^= sign;
+
+	u32 result;
+	if (f >= f16_max) {
+		// Overflow to infinity, or NaN (quieted)
+		result = f > f32_infinity ? 0x7e00 : 0x7c00;
+	}
+	else if (f < (113u << 23)) {
+		// Denormal or zero: let the FPU do the rounding by aligning the mantissa
+		result = bits(from_bits(f) + from_bits(denorm_magic)) - denorm_magic;
+	}
+	else {
+		u32 mantissa_odd = (f >> 13) & 1;
+		f += ((15u - 127) << 23) + 0xfff;
+		f += mantissa_odd;
+		result = f >> 13;
+	}
+
+	return static_cast<u16>(result | (sign >> 16));
+}
+
+auto decode_half(u16 value) -> f32
+{
+	constexpr u32 magic = 113u << 23;
+	constexpr u32 shifted_exponent = 0x7c00u << 13;
+
+	u32 result = (value & 0x7fffu) << 13;
+	u32 exponent = result & shifted_exponent;
+	result += (127u - 15) << 23;
+
+	if (exponent == shifted_exponent) {
+		// Infinity or NaN
+		result += (128u - 16) << 23;
+	}
+	else if (exponent == 0) {
+		// Denormal or zero: renormalize
+		result += 1u << 23;
+		result = bits(from_bits(result) - from_bits(magic));
+	}
+
+	return from_bits(result | (value & 0x8000u) << 16);
+}
+
+
+// Positions -------------------------------------------------------------------
+
+auto position(const Vec3& p, const AABBox& bounds) -> std::array<u16, 4>
+{
+	auto result = std::array<u16, 4>{ 0, 0, 0, 0 };
+
+	for (usize i = 0; i < 3; ++i) {
+		flt extent = bounds.max[i] - bounds.min[i];
+		if (extent > 0)
+			result[i] = static_cast<u16>(unorm<16>((p[i] - bounds.min[i]) / extent));
+	}
+
+	return result;
+}
+
+auto decode_position(const std::array<u16, 4>& value, const AABBox& bounds) -> Vec3
+{
+	auto result = Vec3();
+	for (usize i = 0; i < 3; ++i)
+		result[i] = bounds.min[i] + decode_unorm<16>(value[i]) * (bounds.max[i] - bounds.min[i]);
+
+	return result;
+}
+
+auto dequantize_matrix(const AABBox& bounds) -> math::Mat4x4
+{
+	auto extent = bounds.max - bounds.min;
+
+	return math::Mat4x4{
+		{ extent.x, 0, 0, 0 },
+		{ 0, extent.y, 0, 0 },
+		{ 0, 0, extent.z, 0 },
+		{ bounds.min.x, bounds.min.y, bounds.min.z, 1 },
+	};
+}
+
+
+// Normals ---------------------------------------------------------------------
+
+auto octahedral16(const Vec3& n) -> std::array<i16, 2>
+{
+	auto [x, y] = octahedral<16>(n);
+	return { static_cast<i16>(x), static_cast<i16>(y) };
+}
+
+auto octahedral8(const Vec3& n) -> std::array<i8, 2>
+{
+	auto [x, y] = octahedral<8>(n);
+	return { static_cast<i8>(x), static_cast<i8>(y) };
+}
+
+auto decode_octahedral16(const std::array<i16, 2>& value) -> Vec3
+{
+	return decode_octahedral(decode_snorm<16>(value[0]), decode_snorm<16>(value[1]));
+}
+
+auto decode_octahedral8(const std::array<i8, 2>& value) -> Vec3
+{
+	return decode_octahedral(decode_snorm<8>(value[0]), decode_snorm<8>(value[1]));
+}
+
+
+// Texture coordinates ---------------------------------------------------------
+
+auto uv(const Vec2& value) -> std::array<u16, 2>
+{
+	return { half(static_cast<f32>(value.x)), half(static_cast<f32>(value.y)) };
+}
+
+auto decode_uv(const std::array<u16, 2>& value) -> Vec2
+{
+	return Vec2{ decode_half(value[0]), decode_half(value[1]) };
+}
+
+
+// Tangent frames --------------------------------------------------------------
+
+auto tangent_frame(const Vec3& normal, const Vec3& tangent) -> Quat
+{
+	auto n = normal.normal();
+	auto t = (tangent - n * (n | tangent)).normal();
+	auto b = n ^ t;
+
+	// The rotation matrix's columns are t, b and n; `r<row><column>` below
+	flt r00 = t.x, r01 = b.x, r02 = n.x;
+	flt r10 = t.y, r11 = b.y, r12 = n.y;
+	flt r20 = t.z, r21 = b.z, r22 = n.z;
+
+	auto result = Quat();
+	flt trace = r00 + r11 + r22;
+
+	if (trace > 0) {
+		flt s = std::sqrt(trace + 1) * 2;
+		result = Quat{ s / 4, (r21 - r12) / s, (r02 - r20) / s, (r10 - r01) / s };
+	}
+	else if (r00 > r11 && r00 > r22) {
+		flt s = std::sqrt(1 + r00 - r11 - r22) * 2;
+		result = Quat{ (r21 - r12) / s, s / 4, (r01 + r10) / s, (r02 + r20) / s };
+	}
+	else if (r11 > r22) {
+		flt s = std::sqrt(1 + r11 - r00 - r22) * 2;
+		result = Quat{ (r02 - r20) / s, (r01 + r10) / s, s / 4, (r12 + r21) / s };
+	}
+	else {
+		flt s = std::sqrt(1 + r22 - r00 - r11) * 2;
+		result = Quat{ (r10 - r01) / s, (r02 + r20) / s, (r12 + r21) / s, s / 4 };
+	}
+
+	result.normalize();
+	return result;
+}
+
+auto tangent_frame8(const Quat& frame, flt handedness) -> std::array<i8, 4>
+{
+	auto q = frame;
+	q.normalize();
+
+	if (q.w < 0)
+		q = -q;
+
+	// `w` must survive quantization as non-zero, or its sign would be lost
+	constexpr flt min_w = flt(1) / 127;
+	if (q.w < min_w) {
+		flt xyz = q.vector.length();
+		flt scale = xyz > 0 ? std::sqrt(1 - min_w * min_w) / xyz : 0;
+
+		q = Quat{ min_w, q.vector * scale };
+	}
+
+	if (handedness < 0)
+		q = -q;
+
+	return {
+		static_cast<i8>(snorm<8>(q.w)),
+		static_cast<i8>(snorm<8>(q.x)),
+		static_cast<i8>(snorm<8>(q.y)),
+		static_cast<i8>(snorm<8>(q.z)),
+	};
+}
+
+auto decode_tangent_frame8(const std::array<i8, 4>& value) -> std::pair<Quat, flt>
+{
+	auto q = Quat{
+		decode_snorm<8>(value[0]),
+		decode_snorm<8>(value[1]),
+		decode_snorm<8>(value[2]),
+		decode_snorm<8>(value[3]),
+	};
+
+	flt handedness = sign(q.w);
+	if (q.w < 0)
+		q = -q;
+
+	q.normalize();
+	return { q, handedness };
+}
+
+
+// Meshes ----------------------------------------------------------------------
+
+auto mesh_bounds(const SoaMesh& mesh) -> AABBox
+{
+	auto result = AABBox::empty();
+	for (const auto& p : mesh.positions)
+		result.add(p);
+
+	return result;
+}
+
+auto interleave(const SoaMesh& mesh, const Options& options) -> MeshData
+{
+	auto result = MeshData();
+	result.submeshes = mesh.submeshes;
+	result.indices = mesh.indices;
+
+	auto add = [&](const Attribute& attribute) {
+		result.push_attribute(attribute.type, attribute.count, attribute.normalized);
+	};
+
+	bool has_normals = !mesh.normals.empty();
+	bool has_uvs = !mesh.uvs.empty();
+	bool has_tangents = has_normals && !mesh.tangents.empty();
+
+	add(position_attribute());
+	if (has_normals) add(options.normals8 ? octahedral8_attribute() : octahedral16_attribute());
+	if (has_uvs) add(uv_attribute());
+	if (has_tangents) add(tangent_frame8_attribute());
+
+	auto bounds = mesh_bounds(mesh);
+
+	result.vertices.resize(mesh.vertex_count() * result.stride);
+	u8* dest = result.vertices.data();
+
+	for (usize i = 0; i < mesh.vertex_count(); ++i) {
+		auto p = position(mesh.positions[i], bounds);
+		std::memcpy(dest, p.data(), sizeof(p));
+		dest += sizeof(p);
+
+		if (has_normals) {
+			if (options.normals8) {
+				auto n = octahedral8(mesh.normals[i]);
+				i8 padded[4] { n[0], n[1], 0, 0 };
+				std::memcpy(dest, padded, sizeof(padded));
+				dest += sizeof(padded);
+			}
+			else {
+				auto n = octahedral16(mesh.normals[i]);
+				std::memcpy(dest, n.data(), sizeof(n));
+				dest += sizeof(n);
+			}
+		}
+
+		if (has_uvs) {
+			auto t = uv(mesh.uvs[i]);
+			std::memcpy(dest, t.data(), sizeof(t));
+			dest += sizeof(t);
+		}
+
+		if (has_tangents) {
+			const auto& t = mesh.tangents[i];
+			auto frame = tangent_frame8(tangent_frame(mesh.normals[i], Vec3{ t.x, t.y, t.z }), t.w);
+			std::memcpy(dest, frame.data(), sizeof(frame));
+			dest += sizeof(frame);
+		}
+	}
+
+	return result;
+}
+
+} // namespace mesh::quantize
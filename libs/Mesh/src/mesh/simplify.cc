@@ -0,0 +1,590 @@
+#include "mesh/simplify.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <queue>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+#include <math/geo/plane.h>
+#include <math/matrix.h>
+
+
+namespace mesh::simplify {
+
+namespace {
+
+using math::Mat4x4;
+using math::Vec2;
+using math::Vec3;
+using math::geo::Plane;
+
+/** How much more the planes through boundary edges weigh than the triangles' own. */
+constexpr flt k_boundary_weight = 100;
+/**
+ * The cosine of the furthest a collapse may turn a triangle. Limiting it
+ * more than to a flip stops a series of collapses from flipping it bit by bit.
+ */
+constexpr flt k_min_turn_cosine = 0.25;
+
+
+// Quadrics --------------------------------------------------------------------
+
+/**
+ * The squared distance to a set of planes, as the symmetric matrix `Q` for
+ * which `[x y z 1] Q [x y z 1]^T` is the sum of the squared distances.
+ */
+struct Quadric {
+	Mat4x4 q;
+
+	static auto from_plane(const Plane& plane, flt weight) -> Quadric
+	{
+		flt p[4] { plane.normal.x, plane.normal.y, plane.normal.z, -plane.distance };
+
+		auto result = Quadric();
+		flt* m = result.q.data();
+		for (usize r = 0; r < 4; ++r)
+			for (usize c = 0; c < 4; ++c)
+				m[r * 4 + c] = p[r] * p[c] * weight;
+
+		return result;
+	}
+
+	auto operator+=(const Quadric& other) -> Quadric&
+	{
+		flt* m = q.data();
+		const flt* o = other.q.data();
+		for (usize i = 0; i < 16; ++i)
+			m[i] += o[i];
+
+		return *this;
+	}
+
+	auto operator+(const Quadric& other) const -> Quadric
+	{
+		auto result = *this;
+		return result += other;
+	}
+
+	auto error(const Vec3& v) const -> flt
+	{
+		const flt* m = q.data();
+		flt p[4] { v.x, v.y, v.z, 1 };
+
+		flt result = 0;
+		for (usize r = 0; r < 4; ++r)
+			for (usize c = 0; c < 4; ++c)
+				result += p[r] * m[r * 4 + c] * p[c];
+
+		// Rounding can take it just below zero
+		return std::max(result, flt(0));
+	}
+};
+
+/** The plane through three points, or `nullopt` if they're (nearly) in a line. */
+auto plane_through(const Vec3& a, const Vec3& b, const Vec3& c) -> std::optional<Plane>
+{
+	auto normal = (b - a) ^ (c - a);
+	flt length = normal.length();
+	if (length <= 0)
+		return std::nullopt;
+
+	normal *= 1 / length;
+	return Plane{ normal, a | normal };
+}
+
+auto edge_key(u32 a, u32 b) -> u64
+{
+	return (u64(std::min(a, b)) << 32) | std::max(a, b);
+}
+
+/** What takes positions to units of the size of their bounds' diagonal. */
+auto scale_of(const Vec3* positions, usize count) -> flt
+{
+	auto min = Vec3::all(std::numeric_limits<flt>::infinity());
+	auto max = Vec3::all(-std::numeric_limits<flt>::infinity());
+	for (usize i = 0; i < count; ++i) {
+		for (usize c = 0; c < 3; ++c) {
+			min[c] = std::min(min[c], positions[i][c]);
+			max[c] = std::max(max[c], positions[i][c]);
+		}
+	}
+	flt size = count > 0 ? (max - min).length() : 0;
+	return size > 0 ? 1 / size : 1;
+}
+
+/** Which vertices share their position with another, e.g. on uv seams. */
+auto shared_positions(const Vec3* positions, usize count) -> std::vector<u8>
+{
+	auto order = std::vector<u32>(count);
+	std::iota(order.begin(), order.end(), 0);
+
+	auto key = [&](u32 v) {
+		const auto& p = positions[v];
+		return std::tie(p.x, p.y, p.z);
+	};
+	std::sort(order.begin(), order.end(), [&](u32 a, u32 b) { return key(a) < key(b); });
+
+	auto result = std::vector<u8>(count, 0);
+	for (usize i = 1; i < order.size(); ++i) {
+		if (key(order[i - 1]) == key(order[i])) {
+			result[order[i - 1]] = 1;
+			result[order[i]] = 1;
+		}
+	}
+
+	return result;
+}
+
+
+// Collapses -------------------------------------------------------------------
+
+struct Collapse {
+	flt cost;
+	u32 from;
+	u32 to;
+	/** The vertices' versions when the cost was computed. */
+	u32 from_version;
+	u32 to_version;
+
+	auto operator>(const Collapse& other) const -> bool
+	{
+		return std::tie(cost, from, to) > std::tie(other.cost, other.from, other.to);
+	}
+};
+
+class Simplifier {
+public:
+	/**
+	 * `scale` takes positions to the units errors are measured in, and
+	 * `locked` marks the vertices that never move.
+	 */
+	Simplifier(
+		const u32* indices, usize index_count,
+		const Vec3* positions, usize vertex_count,
+		const Options& options, const Vec3* normals, const Vec2* uvs,
+		flt scale, std::vector<u8> locked)
+		: m_indices(indices, indices + index_count)
+		, m_alive(index_count / 3, 1)
+		, m_live_triangles(index_count / 3)
+		, m_positions(vertex_count)
+		, m_normals(normals)
+		, m_uvs(uvs)
+		, m_options(options)
+		, m_triangles(vertex_count)
+		, m_quadrics(vertex_count)
+		, m_versions(vertex_count, 0)
+		, m_removed(vertex_count, 0)
+		, m_locked(std::move(locked))
+		, m_boundary(vertex_count, 0)
+	{
+		for (usize i = 0; i < vertex_count; ++i)
+			m_positions[i] = positions[i] * scale;
+
+		build_adjacency();
+		build_quadrics();
+	}
+
+	auto run() -> Result
+	{
+		for (u32 t = 0; t < m_alive.size(); ++t) {
+			const u32* triangle = &m_indices[t * 3];
+			// The triangle on the other side pushes the reverse of an inner edge
+			for (usize i = 0; i < 3; ++i) {
+				u32 from = triangle[i];
+				u32 to = triangle[(i + 1) % 3];
+				push(from, to);
+				if (m_edges[edge_key(from, to)] == 1)
+					push(to, from);
+			}
+		}
+
+		flt max_cost = m_options.target_error * m_options.target_error;
+		flt error = 0;
+
+		while (!m_queue.empty() && m_live_triangles > m_options.target_triangles) {
+			auto collapse = m_queue.top();
+			m_queue.pop();
+
+			bool stale = m_removed[collapse.from] || m_removed[collapse.to]
+				|| m_versions[collapse.from] != collapse.from_version
+				|| m_versions[collapse.to] != collapse.to_version;
+			if (stale)
+				continue;
+			if (collapse.cost > max_cost)
+				break;
+			if (!valid(collapse.from, collapse.to))
+				continue;
+
+			apply(collapse.from, collapse.to);
+			error = std::max(error, collapse.cost);
+		}
+
+		auto result = Result();
+		result.error = std::sqrt(error);
+		result.indices.reserve(m_live_triangles * 3);
+		for (usize t = 0; t < m_alive.size(); ++t)
+			if (m_alive[t])
+				result.indices.insert(result.indices.end(), &m_indices[t * 3], &m_indices[t * 3 + 3]);
+
+		return result;
+	}
+
+private:
+	void build_adjacency()
+	{
+		for (u32 t = 0; t < m_alive.size(); ++t)
+			for (usize i = 0; i < 3; ++i)
+				m_triangles[m_indices[t * 3 + i]].push_back(t);
+
+		for (usize i = 0; i < m_indices.size(); i += 3) {
+			for (usize e = 0; e < 3; ++e) {
+				u32 a = m_indices[i + e];
+				u32 b = m_indices[i + (e + 1) % 3];
+				++m_edges[edge_key(a, b)];
+			}
+		}
+	}
+
+	void build_quadrics()
+	{
+		for (usize i = 0; i < m_indices.size(); i += 3) {
+			const u32* triangle = &m_indices[i];
+			const auto& a = m_positions[triangle[0]];
+			const auto& b = m_positions[triangle[1]];
+			const auto& c = m_positions[triangle[2]];
+
+			auto plane = plane_through(a, b, c);
+			if (!plane)
+				continue;
+
+			auto quadric = Quadric::from_plane(*plane, 1);
+			for (usize k = 0; k < 3; ++k)
+				m_quadrics[triangle[k]] += quadric;
+
+			// Hold boundary edges in place with a plane through the edge,
+			// perpendicular to the triangle
+			for (usize e = 0; e < 3; ++e) {
+				u32 from = triangle[e];
+				u32 to = triangle[(e + 1) % 3];
+				if (m_edges[edge_key(from, to)] != 1)
+					continue;
+
+				m_boundary[from] = 1;
+				m_boundary[to] = 1;
+
+				const auto& p = m_positions[from];
+				auto edge = m_positions[to] - p;
+				auto normal = edge ^ plane->normal;
+				flt length = normal.length();
+				if (length <= 0)
+					continue;
+
+				normal *= 1 / length;
+				auto boundary = Quadric::from_plane(Plane{ normal, p | normal }, k_boundary_weight);
+				m_quadrics[from] += boundary;
+				m_quadrics[to] += boundary;
+			}
+		}
+	}
+
+	/** Whether `from` may move onto `to` at all. */
+	auto allowed(u32 from, u32 to) const -> bool
+	{
+		if (from == to || m_locked[from])
+			return false;
+		if (!m_boundary[from])
+			return true;
+
+		// Boundary vertices only slide along the boundary
+		return !m_options.lock_boundary && m_boundary[to] && shared_triangles(from, to) == 1;
+	}
+
+	auto cost(u32 from, u32 to) const -> flt
+	{
+		flt result = (m_quadrics[from] + m_quadrics[to]).error(m_positions[to]);
+		if (m_normals)
+			result += m_options.normal_weight * (m_normals[from] - m_normals[to]).sq_length();
+		if (m_uvs)
+			result += m_options.uv_weight * (m_uvs[from] - m_uvs[to]).sq_length();
+
+		return result;
+	}
+
+	void push(u32 from, u32 to)
+	{
+		if (!allowed(from, to))
+			return;
+
+		m_queue.push({ cost(from, to), from, to, m_versions[from], m_versions[to] });
+	}
+
+	auto contains(u32 triangle, u32 vertex) const -> bool
+	{
+		const u32* t = &m_indices[triangle * 3];
+		return t[0] == vertex || t[1] == vertex || t[2] == vertex;
+	}
+
+	auto shared_triangles(u32 a, u32 b) const -> usize
+	{
+		usize result = 0;
+		for (u32 t : m_triangles[a])
+			result += m_alive[t] && contains(t, b);
+
+		return result;
+	}
+
+	/** The other vertices of the live triangles around `v`. */
+	auto neighbors(u32 v) const -> std::vector<u32>
+	{
+		auto result = std::vector<u32>();
+		for (u32 t : m_triangles[v]) {
+			if (!m_alive[t])
+				continue;
+			for (usize i = 0; i < 3; ++i)
+				if (m_indices[t * 3 + i] != v)
+					result.push_back(m_indices[t * 3 + i]);
+		}
+
+		std::sort(result.begin(), result.end());
+		result.erase(std::unique(result.begin(), result.end()), result.end());
+		return result;
+	}
+
+	/** Whether moving `from` onto `to` keeps the surface manifold and unflipped. */
+	auto valid(u32 from, u32 to) const -> bool
+	{
+		usize shared = shared_triangles(from, to);
+		if (shared == 0)
+			return false;
+
+		// The link condition: the edge's ends may only share the neighbors
+		// opposite the edge, or the collapse pinches the surface
+		auto a = neighbors(from);
+		auto b = neighbors(to);
+		auto common = std::vector<u32>();
+		std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(common));
+		if (common.size() != shared)
+			return false;
+
+		const auto& target = m_positions[to];
+		for (u32 t : m_triangles[from]) {
+			if (!m_alive[t] || contains(t, to))
+				continue;
+
+			const u32* triangle = &m_indices[t * 3];
+			auto corner = [&](usize i) -> const Vec3& {
+				return triangle[i] == from ? target : m_positions[triangle[i]];
+			};
+
+			auto before = (m_positions[triangle[1]] - m_positions[triangle[0]])
+				^ (m_positions[triangle[2]] - m_positions[triangle[0]]);
+			auto after = (corner(1) - corner(0)) ^ (corner(2) - corner(0));
+			if ((before | after) <= k_min_turn_cosine * before.length() * after.length())
+				return false;
+		}
+
+		return true;
+	}
+
+	void apply(u32 from, u32 to)
+	{
+		for (u32 t : m_triangles[from]) {
+			if (!m_alive[t])
+				continue;
+
+			if (contains(t, to)) {
+				m_alive[t] = 0;
+				--m_live_triangles;
+				continue;
+			}
+
+			for (usize i = 0; i < 3; ++i)
+				if (m_indices[t * 3 + i] == from)
+					m_indices[t * 3 + i] = to;
+			m_triangles[to].push_back(t);
+		}
+
+		m_quadrics[to] += m_quadrics[from];
+		m_triangles[from] = {};
+		m_removed[from] = 1;
+		++m_versions[to];
+
+		auto& around = m_triangles[to];
+		around.erase(std::remove_if(around.begin(), around.end(), [&](u32 t) { return !m_alive[t]; }), around.end());
+
+		for (u32 neighbor : neighbors(to)) {
+			push(to, neighbor);
+			push(neighbor, to);
+		}
+	}
+
+	std::vector<u32> m_indices;
+	std::vector<u8> m_alive;
+	usize m_live_triangles;
+
+	std::vector<Vec3> m_positions;
+	const Vec3* m_normals;
+	const Vec2* m_uvs;
+	const Options& m_options;
+
+	/** The triangles around each vertex, including dead ones until they're cleaned up. */
+	std::vector<std::vector<u32>> m_triangles;
+	/** The number of triangles using each edge of the original mesh. */
+	std::unordered_map<u64, u32> m_edges;
+	std::vector<Quadric> m_quadrics;
+	std::vector<u32> m_versions;
+	std::vector<u8> m_removed;
+	std::vector<u8> m_locked;
+	std::vector<u8> m_boundary;
+
+	std::priority_queue<Collapse, std::vector<Collapse>, std::greater<>> m_queue;
+};
+
+
+// Submeshes -------------------------------------------------------------------
+
+/**
+ * Simplifies a mesh's submeshes one at a time, each over only the vertices it
+ * uses, so that a submesh costs as much as its own vertices rather than the
+ * whole mesh's. Errors are still relative to the size of the whole mesh, and
+ * vertices sharing their position with any other of the mesh stay locked, so
+ * seams between submeshes stay closed too.
+ */
+class SubmeshSimplifier {
+public:
+	explicit SubmeshSimplifier(const SoaMesh& mesh)
+		: m_mesh(mesh)
+		, m_scale(scale_of(mesh.positions.data(), mesh.vertex_count()))
+		, m_shared(shared_positions(mesh.positions.data(), mesh.vertex_count()))
+		, m_local(mesh.vertex_count(), k_unused)
+	{}
+
+	/** Simplify a submesh's triangles, given as indices into the mesh's vertices. */
+	auto run(const u32* indices, usize index_count, const Options& options) -> Result
+	{
+		m_vertices.clear();
+		m_indices.clear();
+		for (usize i = 0; i < index_count; ++i) {
+			u32& local = m_local[indices[i]];
+			if (local == k_unused) {
+				local = static_cast<u32>(m_vertices.size());
+				m_vertices.push_back(indices[i]);
+			}
+			m_indices.push_back(local);
+		}
+
+		bool normals = !m_mesh.normals.empty();
+		bool uvs = !m_mesh.uvs.empty();
+		m_positions.clear();
+		m_normals.clear();
+		m_uvs.clear();
+		auto locked = std::vector<u8>();
+		locked.reserve(m_vertices.size());
+		for (u32 v : m_vertices) {
+			m_positions.push_back(m_mesh.positions[v]);
+			if (normals)
+				m_normals.push_back(m_mesh.normals[v]);
+			if (uvs)
+				m_uvs.push_back(m_mesh.uvs[v]);
+			locked.push_back(m_shared[v]);
+		}
+
+		auto result = Simplifier(
+			m_indices.data(), m_indices.size(),
+			m_positions.data(), m_positions.size(),
+			options, normals ? m_normals.data() : nullptr, uvs ? m_uvs.data() : nullptr,
+			m_scale, std::move(locked)).run();
+
+		for (u32& index : result.indices)
+			index = m_vertices[index];
+		for (u32 v : m_vertices)
+			m_local[v] = k_unused;
+
+		return result;
+	}
+
+private:
+	static constexpr u32 k_unused = std::numeric_limits<u32>::max();
+
+	const SoaMesh& m_mesh;
+	flt m_scale;
+	std::vector<u8> m_shared;
+	/** The submesh's index of each of the mesh's vertices it uses, or `k_unused`. */
+	std::vector<u32> m_local;
+
+	/** The mesh's index of each of the submesh's vertices. */
+	std::vector<u32> m_vertices;
+	std::vector<u32> m_indices;
+	std::vector<Vec3> m_positions;
+	std::vector<Vec3> m_normals;
+	std::vector<Vec2> m_uvs;
+};
+
+} // namespace
+
+
+auto simplify(
+	const u32* indices, usize index_count,
+	const Vec3* positions, usize vertex_count,
+	const Options& options,
+	const Vec3* normals, const Vec2* uvs)
+	-> Result
+{
+	return Simplifier(
+		indices, index_count, positions, vertex_count, options, normals, uvs,
+		scale_of(positions, vertex_count), shared_positions(positions, vertex_count)).run();
+}
+
+
+// Levels of detail ------------------------------------------------------------
+
+auto build_lods(const SoaMesh& mesh, usize count, flt ratio, const Options& options) -> std::vector<Lod>
+{
+	auto result = std::vector<Lod>();
+	if (count == 0)
+		return result;
+
+	auto& base = result.emplace_back();
+	base.indices = mesh.indices;
+	base.submeshes = mesh.submeshes;
+
+	auto simplifier = SubmeshSimplifier(mesh);
+
+	while (result.size() < count) {
+		const auto& previous = result.back();
+		auto lod = Lod();
+		lod.error = previous.error;
+
+		for (const auto& submesh : previous.submeshes) {
+			auto level_options = options;
+			level_options.target_triangles = static_cast<usize>(static_cast<flt>(submesh.index_count / 3) * ratio);
+
+			auto simplified = simplifier.run(
+				previous.indices.data() + submesh.first_index, submesh.index_count, level_options);
+
+			auto range = submesh;
+			range.first_index = static_cast<u32>(lod.indices.size());
+			range.index_count = static_cast<u32>(simplified.indices.size());
+			lod.submeshes.push_back(range);
+			lod.indices.insert(lod.indices.end(), simplified.indices.begin(), simplified.indices.end());
+			lod.error = std::max(lod.error, simplified.error);
+		}
+
+		// Nothing more can go within the error bound
+		if (lod.indices.size() == previous.indices.size())
+			break;
+
+		result.push_back(std::move(lod));
+	}
+
+	return result;
+}
+
+} // namespace mesh::simplify
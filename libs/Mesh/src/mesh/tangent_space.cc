@@ -0,0 +1,266 @@
+#include "mesh/tangent_space.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <math/detail/parallel.h>
+
+
+namespace mesh::tangent_space {
+
+namespace {
+
+using math::Vec2;
+using math::Vec3;
+using math::Vec4;
+
+/** The vertices finished by one task of the reduction. */
+constexpr usize k_vertex_block = 1 << 14;
+
+
+// Accumulation ----------------------------------------------------------------
+
+/** One thread's triangles, and its sums over the vertices they reference. */
+template <typename Sum>
+struct Run {
+	usize first_triangle = 0;
+	usize end_triangle = 0;
+	u32 first_vertex = 0;
+	u32 end_vertex = 0;
+	std::vector<Sum> sums;
+
+	auto operator[](u32 vertex) -> Sum& { return sums[vertex - first_vertex]; }
+};
+
+/**
+ * Sum `add(triangle, run)`'s contributions to every vertex, then call
+ * `finish(vertex, sum)` with each vertex's total.
+ */
+template <typename Sum, typename Add, typename Finish>
+void accumulate(
+	const u32* indices, usize index_count, usize vertex_count,
+	const Options& options, const Add& add, const Finish& finish)
+{
+	usize triangle_count = index_count / 3;
+	usize threads = math::detail::thread_count(options.threads);
+	usize run_count = std::clamp<usize>(
+		triangle_count / std::max<usize>(options.min_triangles_per_thread, 1), 1, threads);
+
+	auto runs = std::vector<Run<Sum>>(run_count);
+	math::detail::parallel_for(run_count, threads, [&](usize r) {
+		auto& run = runs[r];
+		run.first_triangle = triangle_count * r / run_count;
+		run.end_triangle = triangle_count * (r + 1) / run_count;
+
+		const u32* begin = indices + run.first_triangle * 3;
+		const u32* end = indices + run.end_triangle * 3;
+		if (begin == end)
+			return;
+
+		auto [min, max] = std::minmax_element(begin, end);
+		run.first_vertex = *min;
+		run.end_vertex = *max + 1;
+		run.sums.assign(run.end_vertex - run.first_vertex, Sum());
+
+		for (const u32* triangle = begin; triangle != end; triangle += 3)
+			add(triangle, run);
+	});
+
+	usize blocks = (vertex_count + k_vertex_block - 1) / k_vertex_block;
+	math::detail::parallel_for(blocks, threads, [&](usize b) {
+		auto first = static_cast<u32>(b * k_vertex_block);
+		auto end = static_cast<u32>(std::min(vertex_count, (b + 1) * k_vertex_block));
+
+		auto overlapping = std::vector<Run<Sum>*>();
+		for (auto& run : runs)
+			if (run.first_vertex < end && run.end_vertex > first)
+				overlapping.push_back(&run);
+
+		for (u32 v = first; v < end; ++v) {
+			auto total = Sum();
+			for (auto* run : overlapping)
+				if (v >= run->first_vertex && v < run->end_vertex)
+					total += (*run)[v];
+
+			finish(v, total);
+		}
+	});
+}
+
+/** The angle between two directions from a point, or 0 if either is zero. */
+auto angle_between(const Vec3& a, const Vec3& b) -> flt
+{
+	flt lengths = a.length() * b.length();
+	if (lengths <= 0)
+		return 0;
+
+	return std::acos(std::clamp((a | b) / lengths, flt(-1), flt(1)));
+}
+
+/** `v` without its component along the unit vector `n`. */
+auto project(const Vec3& v, const Vec3& n) -> Vec3
+{
+	return v - n * (n | v);
+}
+
+/** Any unit vector orthogonal to the unit vector `n`. */
+auto orthogonal(const Vec3& n) -> Vec3
+{
+	auto axis = std::abs(n.x) < 0.9 ? Vec3{ 1, 0, 0 } : Vec3{ 0, 1, 0 };
+	auto result = project(axis, n);
+	flt length = result.length();
+
+	return length > 0 ? result * (1 / length) : Vec3{ 1, 0, 0 };
+}
+
+struct TangentSum {
+	Vec3 tangent = Vec3{ 0, 0, 0 };
+	Vec3 bitangent = Vec3{ 0, 0, 0 };
+
+	auto operator+=(const TangentSum& other) -> TangentSum&
+	{
+		tangent += other.tangent;
+		bitangent += other.bitangent;
+		return *this;
+	}
+};
+
+} // namespace
+
+
+// Normals ---------------------------------------------------------------------
+
+void compute_normals(
+	Vec3* out,
+	const u32* indices, usize index_count,
+	const Vec3* positions, usize vertex_count,
+	const Options& options)
+{
+	bool by_angle = options.weighting == Weighting::Angle;
+
+	auto add = [&](const u32* triangle, Run<Vec3>& run) {
+		const auto& p0 = positions[triangle[0]];
+		const auto& p1 = positions[triangle[1]];
+		const auto& p2 = positions[triangle[2]];
+
+		// The cross product's length is twice the area
+		auto normal = (p1 - p0) ^ (p2 - p0);
+		if (!by_angle) {
+			for (usize i = 0; i < 3; ++i)
+				run[triangle[i]] += normal;
+			return;
+		}
+
+		flt length = normal.length();
+		if (length <= 0)
+			return;
+
+		normal *= 1 / length;
+		run[triangle[0]] += normal * angle_between(p1 - p0, p2 - p0);
+		run[triangle[1]] += normal * angle_between(p2 - p1, p0 - p1);
+		run[triangle[2]] += normal * angle_between(p0 - p2, p1 - p2);
+	};
+
+	accumulate<Vec3>(indices, index_count, vertex_count, options, add, [&](u32 v, const Vec3& sum) {
+		flt length = sum.length();
+		out[v] = length > 0 ? sum * (1 / length) : Vec3{ 0, 0, 0 };
+	});
+}
+
+
+// Tangents --------------------------------------------------------------------
+
+void compute_tangents(
+	Vec4* out,
+	const u32* indices, usize index_count,
+	const Vec3* positions, const Vec3* normals, const Vec2* uvs,
+	usize vertex_count,
+	const Options& options)
+{
+	auto add = [&](const u32* triangle, Run<TangentSum>& run) {
+		const auto& p0 = positions[triangle[0]];
+		auto e1 = positions[triangle[1]] - p0;
+		auto e2 = positions[triangle[2]] - p0;
+
+		const auto& t0 = uvs[triangle[0]];
+		flt du1 = uvs[triangle[1]].x - t0.x;
+		flt dv1 = uvs[triangle[1]].y - t0.y;
+		flt du2 = uvs[triangle[2]].x - t0.x;
+		flt dv2 = uvs[triangle[2]].y - t0.y;
+
+		// The directions of increasing u and v, scaled by the signed uv area
+		flt area = du1 * dv2 - du2 * dv1;
+		if (std::abs(area) <= std::numeric_limits<flt>::min())
+			return;
+
+		Vec3 tangent = e1 * dv2 - e2 * dv1;
+		Vec3 bitangent = e2 * du1 - e1 * du2;
+		flt tangent_length = tangent.length();
+		flt bitangent_length = bitangent.length();
+		if (tangent_length <= 0 || bitangent_length <= 0)
+			return;
+
+		flt sign = area > 0 ? 1 : -1;
+		tangent *= sign / tangent_length;
+		bitangent *= sign / bitangent_length;
+
+		for (usize i = 0; i < 3; ++i) {
+			u32 v = triangle[i];
+			const auto& n = normals[v];
+			const auto& p = positions[v];
+
+			// Weight by the angle between the edges, as seen along the normal
+			auto angle = angle_between(
+				project(positions[triangle[(i + 1) % 3]] - p, n),
+				project(positions[triangle[(i + 2) % 3]] - p, n));
+
+			auto t = project(tangent, n);
+			auto b = project(bitangent, n);
+			flt t_length = t.length();
+			flt b_length = b.length();
+
+			auto& sum = run[v];
+			if (t_length > 0)
+				sum.tangent += t * (angle / t_length);
+			if (b_length > 0)
+				sum.bitangent += b * (angle / b_length);
+		}
+	};
+
+	accumulate<TangentSum>(indices, index_count, vertex_count, options, add, [&](u32 v, const TangentSum& sum) {
+		const auto& n = normals[v];
+		auto tangent = project(sum.tangent, n);
+		flt length = tangent.length();
+		tangent = length > 0 ? tangent * (1 / length) : orthogonal(n);
+
+		flt sign = ((n ^ tangent) | sum.bitangent) < 0 ? -1 : 1;
+		out[v] = Vec4{ tangent.x, tangent.y, tangent.z, sign };
+	});
+}
+
+
+// Meshes ----------------------------------------------------------------------
+
+void generate(SoaMesh& mesh, const Options& options)
+{
+	if (mesh.normals.empty()) {
+		mesh.normals.resize(mesh.vertex_count());
+		compute_normals(mesh.normals.data(),
+			mesh.indices.data(), mesh.indices.size(),
+			mesh.positions.data(), mesh.vertex_count(),
+			options);
+	}
+
+	if (!mesh.uvs.empty()) {
+		mesh.tangents.resize(mesh.vertex_count());
+		compute_tangents(mesh.tangents.data(),
+			mesh.indices.data(), mesh.indices.size(),
+			mesh.positions.data(), mesh.normals.data(), mesh.uvs.data(),
+			mesh.vertex_count(),
+			options);
+	}
+}
+
+} // namespace mesh::tangent_space
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+#include <gfx/draw_queue.h>
+#include <sized.h>
+
+#include "raster/framebuffer.h"
+#include "raster/rasterizer.h"
+
+namespace raster {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/** The most uniform buffer binding points a `Backend` tracks. */
+constexpr u32 k_max_block_bindings = 8;
+
+/**
+ * What the shaders of a draw through a `Backend` get as their `uniforms`: the
+ * state an OpenGL program would read besides its per-vertex attributes.
+ */
+struct Bindings {
+	/** The uniform blocks bound to each binding point, as std140 bytes, or null. */
+	std::array<const u8*, k_max_block_bindings> blocks {};
+	/** The draw's per-instance data, from its base instance. */
+	const u8* instances = nullptr;
+	usize instance_stride = 0;
+	/** The data given with the program, e.g. how to read its attributes. */
+	const void* program_data = nullptr;
+	/** The values last set on the program, by uniform location. */
+	const std::vector<std::vector<f32>>* uniforms = nullptr;
+
+	/** The values of the uniform at `location`, or null if it was never set. */
+	auto uniform(i32 location) const -> const f32*;
+	/** The instance data of the instance the vertex shader is called for. */
+	auto instance(u32 index) const -> const u8* { return instances + index * instance_stride; }
+};
+
+/**
+ * A `gfx::DrawBackend` that draws with a `Rasterizer`, so that a frame
+ * recorded into a `gfx::DrawQueue` for OpenGL can be drawn without a GPU.
+ *
+ * The names in a `gfx::DrawItem` refer to objects registered with the
+ * backend instead of GL objects: programs written in C++, vertex arrays with
+ * their per-instance data, and buffers of indices or uniform blocks. None of
+ * their data is copied, so it must outlive the draws.
+ *
+ * Only `k_triangles` drawn with `k_unsigned_int` indices are supported, like
+ * in the rest of `raster`. As with GL's default state, nothing is culled.
+ */
+class Backend final : public gfx::DrawBackend {
+public:
+	Backend(Rasterizer& rasterizer, Framebuffer& target);
+
+	/** Register a program, whose shaders are passed a `Bindings`. */
+	void set_program(u32 name, const Program& program, const void* data = nullptr);
+	/**
+	 * Register a vertex array: the vertices, and the per-instance data read by
+	 * the vertex shader through `Bindings::instance`, if any.
+	 */
+	void set_vertex_array(u32 name, const VertexArray& vertices, const VertexArray& instances = {});
+	/** Register a buffer, of indices or uniform blocks. */
+	void set_buffer(u32 name, const void* data, usize size);
+	/**
+	 * Bind a buffer, from `offset`, to a uniform block binding point. As in
+	 * GL, draws that bind a block of their own leave it bound.
+	 */
+	void bind_block(u32 binding, u32 buffer, usize offset = 0);
+
+	/**
+	 * Throws `std::invalid_argument` if the draw refers to an unknown object,
+	 * or isn't a triangle list with 32-bit indices.
+	 */
+	void draw(const gfx::DrawItem& item, const gfx::UniformValue* uniforms) override;
+
+	auto cull() const -> Cull { return m_cull; }
+	void set_cull(Cull cull) { m_cull = cull; }
+
+private:
+	struct ProgramEntry {
+		Program program;
+		const void* data = nullptr;
+		std::vector<std::vector<f32>> uniforms;
+	};
+
+	struct VertexArrayEntry {
+		VertexArray vertices;
+		VertexArray instances;
+	};
+
+	struct Buffer {
+		const u8* data = nullptr;
+		usize size = 0;
+	};
+
+	struct BlockBinding {
+		u32 buffer = 0;
+		usize offset = 0;
+	};
+
+	auto buffer(u32 name) const -> const Buffer&;
+
+	Rasterizer* m_rasterizer;
+	Framebuffer* m_target;
+	Cull m_cull = Cull::None;
+
+	std::unordered_map<u32, ProgramEntry> m_programs;
+	std::unordered_map<u32, VertexArrayEntry> m_vertex_arrays;
+	std::unordered_map<u32, Buffer> m_buffers;
+	std::array<BlockBinding, k_max_block_bindings> m_blocks {};
+};
+
+} // namespace raster
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include <sized.h>
+
+namespace raster {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/** A linear RGBA color, with components nominally in [0, 1]. */
+struct Color {
+	f32 r = 0;
+	f32 g = 0;
+	f32 b = 0;
+	f32 a = 1;
+};
+
+/** A color as 8-bit RGBA, red in the lowest byte, clamped and rounded. */
+auto pack(const Color& color) -> u32;
+auto unpack(u32 color) -> Color;
+
+/**
+ * A color and depth target for the software rasterizer: one packed RGBA8 color
+ * (see `pack`) and one 32-bit float depth per pixel, row by row from the top.
+ *
+ * Rows are padded to a multiple of `k_row_alignment` pixels, so that the
+ * rasterizer can always process whole groups of pixels.
+ */
+class Framebuffer {
+public:
+	static constexpr u32 k_row_alignment = 8;
+
+	Framebuffer(u32 width, u32 height);
+
+	void clear(const Color& color, f32 depth = 1);
+
+	auto width() const -> u32 { return m_width; }
+	auto height() const -> u32 { return m_height; }
+	/** The pixels from the start of one row to the next. */
+	auto stride() const -> u32 { return m_stride; }
+
+	auto color(u32 x, u32 y) const -> u32 { return m_colors[y * m_stride + x]; }
+	auto depth(u32 x, u32 y) const -> f32 { return m_depths[y * m_stride + x]; }
+
+	auto colors() -> u32* { return m_colors.data(); }
+	auto colors() const -> const u32* { return m_colors.data(); }
+	auto depths() -> f32* { return m_depths.data(); }
+	auto depths() const -> const f32* { return m_depths.data(); }
+
+	/** Write the color buffer as an uncompressed 32-bit TGA image. Returns whether it could. */
+	auto write_tga(const std::filesystem::path& path) const -> bool;
+
+private:
+	u32 m_width;
+	u32 m_height;
+	u32 m_stride;
+	std::vector<u32> m_colors;
+	std::vector<f32> m_depths;
+};
+
+} // namespace raster
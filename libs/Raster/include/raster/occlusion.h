@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vector>
+
+#include <math/geo/aabb.h>
+#include <math/geo/tri.h>
+#include <math/matrix.h>
+#include <sized.h>
+
+#include "raster/framebuffer.h"
+#include "raster/rasterizer.h"
+
+namespace raster {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/**
+ * Occlusion culling against a low-resolution depth buffer, drawn on the CPU.
+ *
+ * Each frame, `begin` sets the view-projection, `add_occluders` draws the
+ * triangles of large, solid meshes (walls, terrain, buildings) into the depth
+ * buffer with a depth-only `Rasterizer`, and `finish` builds a hierarchical
+ * depth buffer from it, where each level halves the last, keeping the
+ * farthest depth of each 2x2 texels. `test` then checks the bounding boxes of
+ * the objects to draw: a box is hidden if its nearest point is behind the
+ * farthest occluder over the screen rectangle it covers, which takes reading
+ * the 2x2 texels of the level where the rectangle spans at most two each way.
+ * The corners' projection and bounds, and the levels' 2x2 reductions, are
+ * branch-free loops, which the compiler vectorizes.
+ *
+ * Matrices transform row vectors, as `TransformMatrix::transform_point`
+ * does, and the view-projection maps the visible volume to OpenGL's clip
+ * space.
+ */
+class OcclusionBuffer {
+public:
+	struct Stats {
+		/** Occluder triangles drawn. */
+		u64 triangles = 0;
+		/** Boxes tested. */
+		u64 tested = 0;
+		/** Boxes found to be hidden, including off-screen ones. */
+		u64 occluded = 0;
+	};
+
+	/** A depth buffer of `width` by `height`, drawn and tested with `threads` threads. */
+	OcclusionBuffer(u32 width, u32 height, usize threads = 0);
+
+	/** Clear the depth buffer, and set the view-projection for the frame. */
+	void begin(const math::Mat4x4& view_projection);
+	/** Draw counter-clockwise occluder triangles, transformed by `model` into world space. */
+	void add_occluders(const math::geo::Tri* tris, usize count, const math::Mat4x4& model);
+	/** Build the hierarchical depth buffer, once every occluder is drawn. */
+	void finish();
+
+	/**
+	 * Write whether each world-space box may be visible to `out_visible`, as
+	 * `1` or `0`. Boxes that cross the near plane are always visible.
+	 */
+	void test(const math::geo::AABBox* boxes, usize count, u8* out_visible);
+
+	auto width() const -> u32 { return m_depth.width(); }
+	auto height() const -> u32 { return m_depth.height(); }
+	/** The number of levels of the hierarchical depth buffer. */
+	auto levels() const -> usize { return m_levels.size(); }
+	/** The farthest occluder depth of a texel of a level, in [0, 1]. */
+	auto depth(usize level, u32 x, u32 y) const -> f32;
+
+	auto stats() const -> const Stats& { return m_stats; }
+	void reset_stats() { m_stats = {}; }
+
+private:
+	struct Level {
+		u32 width = 0;
+		u32 height = 0;
+		std::vector<f32> depths;
+	};
+
+	auto visible(const math::geo::AABBox& box) const -> bool;
+
+	Rasterizer m_rasterizer;
+	Framebuffer m_depth;
+	std::vector<Level> m_levels;
+	math::Mat4x4 m_view_projection;
+	/** `0, 1, 2, ...`, to draw triangles from consecutive vertices. */
+	std::vector<u32> m_indices;
+	Stats m_stats;
+};
+
+} // namespace raster
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include <sized.h>
+
+#include "raster/framebuffer.h"
+
+namespace raster {
+using namespace sized; // NOLINT(*-using-namespace)
+
+class Workers;
+
+/** A clip-space position, as output by a vertex shader. */
+struct Position {
+	f32 x = 0;
+	f32 y = 0;
+	f32 z = 0;
+	f32 w = 1;
+};
+
+/** The most values a vertex shader can pass on to the fragment shader. */
+constexpr u32 k_max_varyings = 16;
+
+/**
+ * The programmable stages, written in C++. Both are called from several
+ * threads at once, so they mustn't write to shared state.
+ */
+struct Program {
+	/**
+	 * Transform the vertex at `vertex` in instance `instance`, returning its
+	 * clip-space position and writing its `varying_count` varyings.
+	 */
+	using VertexShader = auto (*)(const void* uniforms, const u8* vertex, u32 instance, f32* varyings) -> Position;
+	/** Shade a fragment, given its perspective-correct varyings. */
+	using FragmentShader = auto (*)(const void* uniforms, const f32* varyings) -> Color;
+
+	VertexShader vertex = nullptr;
+	/** Null to only write depth. */
+	FragmentShader fragment = nullptr;
+	u32 varying_count = 0;
+};
+
+/** Interleaved vertices, each passed to the vertex shader whole. */
+struct VertexArray {
+	const void* data = nullptr;
+	usize stride = 0;
+	usize count = 0;
+};
+
+/** Triangle list indices into a `VertexArray`. */
+struct IndexBuffer {
+	const u32* data = nullptr;
+	usize count = 0;
+};
+
+/** Which triangles to skip. Counter-clockwise ones face the front, as in OpenGL. */
+enum class Cull : u8 {
+	None,
+	Back,
+	Front,
+};
+
+/** One draw call, like `gfx::DrawItem`. */
+struct DrawItem {
+	const Program* program = nullptr;
+	/** Passed to the shaders as-is. */
+	const void* uniforms = nullptr;
+	VertexArray vertices;
+	IndexBuffer indices;
+	/** The indices of the draw, a multiple of three. */
+	usize first = 0;
+	usize count = 0;
+	/** Each instance draws the same indices, with its own vertex shader outputs. */
+	u32 instance_count = 1;
+	Cull cull = Cull::Back;
+};
+
+/**
+ * A tile-based, multi-threaded software rasterizer, for rendering without a
+ * GPU, e.g. in tests or on build machines.
+ *
+ * Each `draw` runs in three parallel passes: the vertex shader over every
+ * vertex of every instance; then clipping against the near plane, culling and
+ * setup of the triangles, split into one contiguous run per thread, each
+ * binned into the screen's `k_tile_size` square tiles it touches; and finally
+ * every tile, rasterizing its triangles in submission order.
+ *
+ * Coverage comes from edge functions evaluated at pixel centers, with the
+ * top-left fill rule, for a row of eight pixels at a time. The edge functions,
+ * coverage masks and depth test and write for the row are one branch-free loop
+ * over fixed-size arrays, which the compiler vectorizes (at `-O3`, or `-O2`
+ * with GCC 12 and later); shading is then one call per covered pixel. The edge
+ * functions are evaluated directly rather than stepped, so that the two
+ * triangles sharing an edge compute exactly opposite values, and every pixel
+ * is covered by exactly one of them. The depth test (`less`) and write happen
+ * before shading, and colors are written without blending.
+ *
+ * Since each tile is only ever touched by one thread, and takes its triangles
+ * in order, the output doesn't depend on the number of threads.
+ */
+class Rasterizer {
+public:
+	static constexpr u32 k_tile_size = 64;
+
+	struct Stats {
+		/** Triangles submitted. */
+		u64 triangles = 0;
+		/** Triangles that were back-facing, degenerate, off screen or between pixels. */
+		u64 culled = 0;
+		/** Triangles that crossed the near plane. */
+		u64 clipped = 0;
+		/** Fragments that passed the depth test. */
+		u64 fragments = 0;
+	};
+
+	/** Rasterize with `threads` threads, including the caller's. 0 uses every hardware thread. */
+	explicit Rasterizer(usize threads = 0);
+	~Rasterizer();
+
+	Rasterizer(const Rasterizer&) = delete;
+	Rasterizer& operator=(const Rasterizer&) = delete;
+
+	Rasterizer(Rasterizer&&) noexcept;
+	Rasterizer& operator=(Rasterizer&&) noexcept;
+
+	/**
+	 * Draw triangles into `target`, returning once they're all drawn. Throws
+	 * `std::invalid_argument` if the draw is malformed, or `std::out_of_range`
+	 * if an index is past the end of the vertices.
+	 */
+	void draw(Framebuffer& target, const DrawItem& item);
+
+	auto threads() const -> usize;
+	auto stats() const -> const Stats& { return m_stats; }
+	void reset_stats() { m_stats = {}; }
+
+private:
+	/** Which runs its own parallel passes on the rasterizer's threads. */
+	friend class OcclusionBuffer;
+
+	struct Triangle;
+	struct Slice;
+
+	/** Cull a triangle, or clip it to the near plane, and `bin` what's left. */
+	void setup(Slice& slice, const std::array<const Position*, 3>& positions,
+		const std::array<const f32*, 3>& varyings, const Framebuffer& target, Cull cull);
+	/** Project a triangle in front of the near plane, and add it to the tiles it covers. */
+	void bin(Slice& slice, const std::array<const Position*, 3>& positions,
+		const std::array<const f32*, 3>& varyings, const Framebuffer& target, Cull cull);
+	void rasterize(Framebuffer& target, const DrawItem& item, u32 tile, u64& fragments) const;
+
+	std::unique_ptr<Workers> m_workers;
+	u32 m_varying_count = 0;
+	/** The vertex shader outputs of the current draw. */
+	std::vector<Position> m_positions;
+	std::vector<f32> m_varyings;
+	/** The triangles of the current draw, by thread. */
+	std::vector<Slice> m_slices;
+	u32 m_tiles_x = 0;
+	Stats m_stats;
+};
+
+} // namespace raster
@@ -0,0 +1,120 @@
+#include "raster/backend.h"
+
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+
+namespace raster {
+
+auto Bindings::uniform(i32 location) const -> const f32*
+{
+	if (!uniforms || location < 0 || static_cast<usize>(location) >= uniforms->size())
+		return nullptr;
+
+	const auto& values = (*uniforms)[static_cast<usize>(location)];
+	return values.empty() ? nullptr : values.data();
+}
+
+
+Backend::Backend(Rasterizer& rasterizer, Framebuffer& target)
+	: m_rasterizer(&rasterizer)
+	, m_target(&target)
+{}
+
+void Backend::set_program(u32 name, const Program& program, const void* data)
+{
+	m_programs.insert_or_assign(name, ProgramEntry{ program, data, {} });
+}
+
+void Backend::set_vertex_array(u32 name, const VertexArray& vertices, const VertexArray& instances)
+{
+	m_vertex_arrays.insert_or_assign(name, VertexArrayEntry{ vertices, instances });
+}
+
+void Backend::set_buffer(u32 name, const void* data, usize size)
+{
+	m_buffers.insert_or_assign(name, Buffer{ static_cast<const u8*>(data), size });
+}
+
+void Backend::bind_block(u32 binding, u32 buffer, usize offset)
+{
+	if (binding >= k_max_block_bindings)
+		throw std::invalid_argument(fmt::format("Invalid block binding {} (at most {})",
+			binding, k_max_block_bindings - 1));
+
+	m_blocks[binding] = { buffer, offset };
+}
+
+auto Backend::buffer(u32 name) const -> const Buffer&
+{
+	auto it = m_buffers.find(name);
+	if (it == m_buffers.end())
+		throw std::invalid_argument(fmt::format("Unknown buffer {}", name));
+
+	return it->second;
+}
+
+void Backend::draw(const gfx::DrawItem& item, const gfx::UniformValue* uniforms)
+{
+	if (item.mode != gfx::k_triangles || item.index_type != gfx::k_unsigned_int)
+		throw std::invalid_argument("Only triangle lists with 32-bit indices can be rasterized");
+	if (item.offset % sizeof(u32) != 0 || item.count < 0 || item.instance_count < 0)
+		throw std::invalid_argument("Invalid index range");
+
+	auto program = m_programs.find(item.program);
+	if (program == m_programs.end())
+		throw std::invalid_argument(fmt::format("Unknown program {}", item.program));
+
+	auto vertex_array = m_vertex_arrays.find(item.vertex_array);
+	if (vertex_array == m_vertex_arrays.end())
+		throw std::invalid_argument(fmt::format("Unknown vertex array {}", item.vertex_array));
+
+	const auto& indices = buffer(item.index_buffer);
+	const auto& instances = vertex_array->second.instances;
+	if (instances.data && item.base_instance + static_cast<usize>(item.instance_count) > instances.count)
+		throw std::invalid_argument(fmt::format("Invalid instance range [{}, {}) of {}",
+			item.base_instance, item.base_instance + static_cast<usize>(item.instance_count), instances.count));
+
+	// Uniforms and block bindings stay set, as in GL
+	auto& values = program->second.uniforms;
+	for (const auto* u = uniforms; u; u = u->next) {
+		if (u->location < 0)
+			continue;
+
+		auto location = static_cast<usize>(u->location);
+		if (values.size() <= location)
+			values.resize(location + 1);
+
+		usize count = gfx::component_count(u->type) * static_cast<usize>(u->count);
+		values[location].assign(u->values, u->values + count);
+	}
+
+	if (item.block_buffer != 0)
+		bind_block(item.block_binding, item.block_buffer, item.block_offset);
+
+	auto bindings = Bindings();
+	for (u32 b = 0; b < k_max_block_bindings; ++b) {
+		if (m_blocks[b].buffer != 0)
+			bindings.blocks[b] = buffer(m_blocks[b].buffer).data + m_blocks[b].offset;
+	}
+	if (instances.data) {
+		bindings.instances = static_cast<const u8*>(instances.data) + item.base_instance * instances.stride;
+		bindings.instance_stride = instances.stride;
+	}
+	bindings.program_data = program->second.data;
+	bindings.uniforms = &values;
+
+	auto draw = DrawItem();
+	draw.program = &program->second.program;
+	draw.uniforms = &bindings;
+	draw.vertices = vertex_array->second.vertices;
+	draw.indices = { reinterpret_cast<const u32*>(indices.data), indices.size / sizeof(u32) }; // NOLINT
+	draw.first = item.offset / sizeof(u32);
+	draw.count = static_cast<usize>(item.count);
+	draw.instance_count = static_cast<u32>(item.instance_count);
+	draw.cull = m_cull;
+	m_rasterizer->draw(*m_target, draw);
+}
+
+} // namespace raster
@@ -0,0 +1,87 @@
+#include "raster/framebuffer.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+
+
+namespace raster {
+namespace fs = std::filesystem;
+
+namespace {
+
+auto to_unorm8(f32 value) -> u32
+{
+	return static_cast<u32>(std::clamp(value, 0.f, 1.f) * 255.f + 0.5f);
+}
+
+} // namespace
+
+
+auto pack(const Color& color) -> u32
+{
+	return to_unorm8(color.r)
+		| to_unorm8(color.g) << 8
+		| to_unorm8(color.b) << 16
+		| to_unorm8(color.a) << 24;
+}
+
+auto unpack(u32 color) -> Color
+{
+	return {
+		static_cast<f32>(color & 0xff) / 255.f,
+		static_cast<f32>(color >> 8 & 0xff) / 255.f,
+		static_cast<f32>(color >> 16 & 0xff) / 255.f,
+		static_cast<f32>(color >> 24) / 255.f,
+	};
+}
+
+
+Framebuffer::Framebuffer(u32 width, u32 height)
+	: m_width(width)
+	, m_height(height)
+	, m_stride((width + k_row_alignment - 1) / k_row_alignment * k_row_alignment)
+	, m_colors(static_cast<usize>(m_stride) * height)
+	, m_depths(static_cast<usize>(m_stride) * height, 1.f)
+{}
+
+void Framebuffer::clear(const Color& color, f32 depth)
+{
+	std::fill(m_colors.begin(), m_colors.end(), pack(color));
+	std::fill(m_depths.begin(), m_depths.end(), depth);
+}
+
+auto Framebuffer::write_tga(const fs::path& path) const -> bool
+{
+	auto file = std::ofstream(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+		return false;
+
+	// Uncompressed true-color, 8 bits of alpha, rows from the top
+	auto header = std::array<u8,18>{};
+	header[2] = 2;
+	header[12] = static_cast<u8>(m_width);
+	header[13] = static_cast<u8>(m_width >> 8);
+	header[14] = static_cast<u8>(m_height);
+	header[15] = static_cast<u8>(m_height >> 8);
+	header[16] = 32;
+	header[17] = 0x28;
+	file.write(reinterpret_cast<const char*>(header.data()), header.size()); // NOLINT
+
+	// TGA stores BGRA
+	auto row = std::vector<u8>(static_cast<usize>(m_width) * 4);
+	for (u32 y = 0; y < m_height; ++y) {
+		for (u32 x = 0; x < m_width; ++x) {
+			u32 pixel = color(x, y);
+			row[x * 4 + 0] = static_cast<u8>(pixel >> 16);
+			row[x * 4 + 1] = static_cast<u8>(pixel >> 8);
+			row[x * 4 + 2] = static_cast<u8>(pixel);
+			row[x * 4 + 3] = static_cast<u8>(pixel >> 24);
+		}
+		file.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size())); // NOLINT
+	}
+
+	return static_cast<bool>(file);
+}
+
+} // namespace raster
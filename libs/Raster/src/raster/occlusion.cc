@@ -0,0 +1,251 @@
+#include "raster/occlusion.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#include "raster/workers.h"
+
+
+namespace raster {
+
+namespace {
+
+/** The boxes tested by one task. */
+constexpr usize k_box_chunk = 256;
+/** The smallest `w` of a box corner that's treated as in front of the eye. */
+constexpr f32 k_min_w = 1e-5f;
+
+struct OccluderUniforms {
+	const flt* model;
+	const flt* view_projection;
+};
+
+auto occluder_vertex(const void* uniforms, const u8* vertex, u32 /*instance*/, f32* /*varyings*/) -> Position
+{
+	const auto& u = *static_cast<const OccluderUniforms*>(uniforms);
+	flt p[3];
+	std::memcpy(p, vertex, sizeof(p));
+
+	const flt* m = u.model;
+	const flt* vp = u.view_projection;
+
+	flt world[3];
+	for (usize c = 0; c < 3; ++c)
+		world[c] = p[0] * m[c] + p[1] * m[4 + c] + p[2] * m[8 + c] + m[12 + c];
+
+	flt clip[4];
+	for (usize c = 0; c < 4; ++c)
+		clip[c] = world[0] * vp[c] + world[1] * vp[4 + c] + world[2] * vp[8 + c] + vp[12 + c];
+
+	return {
+		static_cast<f32>(clip[0]),
+		static_cast<f32>(clip[1]),
+		static_cast<f32>(clip[2]),
+		static_cast<f32>(clip[3]),
+	};
+}
+
+const auto k_occluder_program = Program{ occluder_vertex, nullptr, 0 };
+
+/**
+ * The smallest and largest of eight lanes: the two halves element-wise, which
+ * the compiler vectorizes, then the four left. A serial `std::min` reduction
+ * doesn't vectorize, since it isn't associative for NaNs and signed zeros.
+ */
+auto min_of(const std::array<f32, 8>& lanes) -> f32
+{
+	auto half = std::array<f32, 4>();
+	for (usize i = 0; i < 4; ++i)
+		half[i] = std::min(lanes[i], lanes[i + 4]);
+
+	return std::min(std::min(half[0], half[1]), std::min(half[2], half[3]));
+}
+
+auto max_of(const std::array<f32, 8>& lanes) -> f32
+{
+	auto half = std::array<f32, 4>();
+	for (usize i = 0; i < 4; ++i)
+		half[i] = std::max(lanes[i], lanes[i + 4]);
+
+	return std::max(std::max(half[0], half[1]), std::max(half[2], half[3]));
+}
+
+} // namespace
+
+
+OcclusionBuffer::OcclusionBuffer(u32 width, u32 height, usize threads)
+	: m_rasterizer(threads)
+	, m_depth(width, height)
+	, m_view_projection(math::Mat4x4::identity())
+{
+	// Each level halves the last, down to a single texel
+	for (u32 w = width, h = height; ; w = (w + 1) / 2, h = (h + 1) / 2) {
+		m_levels.push_back({ w, h, std::vector<f32>(static_cast<usize>(w) * h, 1) });
+		if (w <= 1 && h <= 1)
+			break;
+	}
+}
+
+void OcclusionBuffer::begin(const math::Mat4x4& view_projection)
+{
+	m_view_projection = view_projection;
+	m_depth.clear({ 0, 0, 0, 0 });
+}
+
+void OcclusionBuffer::add_occluders(const math::geo::Tri* tris, usize count, const math::Mat4x4& model)
+{
+	static_assert(sizeof(math::geo::Tri) == 3 * sizeof(math::Vec3));
+	static_assert(sizeof(math::Vec3) == 3 * sizeof(flt));
+
+	usize vertex_count = count * 3;
+	if (m_indices.size() < vertex_count) {
+		m_indices.resize(vertex_count);
+		std::iota(m_indices.begin(), m_indices.end(), 0);
+	}
+
+	auto uniforms = OccluderUniforms{ model.data(), m_view_projection.data() };
+	auto item = DrawItem();
+	item.program = &k_occluder_program;
+	item.uniforms = &uniforms;
+	item.vertices = { tris, sizeof(math::Vec3), vertex_count };
+	item.indices = { m_indices.data(), vertex_count };
+	item.count = vertex_count;
+	m_rasterizer.draw(m_depth, item);
+
+	m_stats.triangles += count;
+}
+
+void OcclusionBuffer::finish()
+{
+	auto& workers = *m_rasterizer.m_workers;
+
+	auto& base = m_levels.front();
+	workers.run(base.height, [&](usize y) {
+		const f32* row = m_depth.depths() + y * m_depth.stride();
+		std::copy_n(row, base.width, base.depths.begin() + static_cast<std::ptrdiff_t>(y * base.width));
+	});
+
+	for (usize level = 1; level < m_levels.size(); ++level) {
+		const auto& source = m_levels[level - 1];
+		auto& target = m_levels[level];
+
+		workers.run(target.height, [&](usize y) {
+			usize y0 = std::min<usize>(y * 2, source.height - 1);
+			usize y1 = std::min<usize>(y * 2 + 1, source.height - 1);
+			const f32* row0 = source.depths.data() + y0 * source.width;
+			const f32* row1 = source.depths.data() + y1 * source.width;
+			f32* out = target.depths.data() + y * target.width;
+
+			// Whole 2x2 texels, then the last column alone if the width is odd
+			usize pairs = source.width / 2;
+			for (usize x = 0; x < pairs; ++x)
+				out[x] = std::max(std::max(row0[x * 2], row0[x * 2 + 1]), std::max(row1[x * 2], row1[x * 2 + 1]));
+			if (pairs < target.width)
+				out[pairs] = std::max(row0[source.width - 1], row1[source.width - 1]);
+		});
+	}
+}
+
+void OcclusionBuffer::test(const math::geo::AABBox* boxes, usize count, u8* out_visible)
+{
+	usize chunks = (count + k_box_chunk - 1) / k_box_chunk;
+	auto occluded = std::vector<u64>(chunks);
+
+	m_rasterizer.m_workers->run(chunks, [&](usize chunk) {
+		usize end = std::min(count, (chunk + 1) * k_box_chunk);
+		for (usize i = chunk * k_box_chunk; i < end; ++i) {
+			out_visible[i] = visible(boxes[i]) ? 1 : 0;
+			occluded[chunk] += out_visible[i] == 0;
+		}
+	});
+
+	m_stats.tested += count;
+	for (u64 hidden : occluded)
+		m_stats.occluded += hidden;
+}
+
+auto OcclusionBuffer::depth(usize level, u32 x, u32 y) const -> f32
+{
+	const auto& l = m_levels[level];
+	return l.depths[static_cast<usize>(y) * l.width + x];
+}
+
+auto OcclusionBuffer::visible(const math::geo::AABBox& box) const -> bool
+{
+	// Project the eight corners at once
+	auto px = std::array<f32, 8>();
+	auto py = std::array<f32, 8>();
+	auto pz = std::array<f32, 8>();
+	for (usize i = 0; i < 8; ++i) {
+		px[i] = static_cast<f32>((i & 1) ? box.max.x : box.min.x);
+		py[i] = static_cast<f32>((i & 2) ? box.max.y : box.min.y);
+		pz[i] = static_cast<f32>((i & 4) ? box.max.z : box.min.z);
+	}
+
+	auto m = std::array<f32, 16>();
+	std::copy_n(m_view_projection.data(), 16, m.begin());
+
+	auto x = std::array<f32, 8>();
+	auto y = std::array<f32, 8>();
+	auto z = std::array<f32, 8>();
+	// `|` rather than `||`, so that the loop has no control flow and vectorizes
+	u32 behind = 0;
+	for (usize i = 0; i < 8; ++i) {
+		f32 w = px[i] * m[3] + py[i] * m[7] + pz[i] * m[11] + m[15];
+		f32 cz = px[i] * m[2] + py[i] * m[6] + pz[i] * m[10] + m[14];
+		behind |= (w < k_min_w) | (cz < -w);
+
+		// Corners near or behind the eye give garbage, but then the box is
+		// reported visible without looking at them
+		f32 inv_w = 1 / w;
+		x[i] = (px[i] * m[0] + py[i] * m[4] + pz[i] * m[8] + m[12]) * inv_w;
+		y[i] = (px[i] * m[1] + py[i] * m[5] + pz[i] * m[9] + m[13]) * inv_w;
+		z[i] = cz * inv_w;
+	}
+
+	// Occluders can't be in front of a box that reaches behind the eye
+	if (behind)
+		return true;
+
+	f32 min_x = min_of(x);
+	f32 max_x = max_of(x);
+	f32 min_y = min_of(y);
+	f32 max_y = max_of(y);
+	f32 min_z = min_of(z);
+
+	if (max_x < -1 || min_x > 1 || max_y < -1 || min_y > 1 || min_z > 1)
+		return false;
+
+	// The pixels the box's screen rectangle touches, with y down
+	auto width = static_cast<f32>(m_depth.width());
+	auto height = static_cast<f32>(m_depth.height());
+	auto to_pixel = [](f32 value, f32 size) {
+		return static_cast<u32>(std::clamp(std::floor(value * size), 0.f, size - 1));
+	};
+
+	u32 x0 = to_pixel(min_x * 0.5f + 0.5f, width);
+	u32 x1 = to_pixel(max_x * 0.5f + 0.5f, width);
+	u32 y0 = to_pixel(0.5f - max_y * 0.5f, height);
+	u32 y1 = to_pixel(0.5f - min_y * 0.5f, height);
+
+	// Use the level where the rectangle spans at most two texels each way
+	usize level = 0;
+	while (level + 1 < m_levels.size() && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1))
+		++level;
+
+	// The rectangle's two texels each way, the same one twice where it spans
+	// just one, read without a loop
+	const auto& l = m_levels[level];
+	const f32* row0 = l.depths.data() + static_cast<usize>(y0 >> level) * l.width;
+	const f32* row1 = l.depths.data() + static_cast<usize>(y1 >> level) * l.width;
+	u32 tx0 = x0 >> level;
+	u32 tx1 = x1 >> level;
+	f32 farthest = std::max(std::max(row0[tx0], row0[tx1]), std::max(row1[tx0], row1[tx1]));
+
+	return min_z * 0.5f + 0.5f <= farthest;
+}
+
+} // namespace raster
@@ -0,0 +1,419 @@
+#include "raster/rasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+#include <fmt/format.h>
+
+#include "raster/workers.h"
+
+
+namespace raster {
+
+namespace {
+
+/** The pixels processed together, one per lane. */
+constexpr u32 k_lanes = Framebuffer::k_row_alignment;
+/** The vertices shaded by one task of the vertex pass. */
+constexpr usize k_vertex_chunk = 1024;
+
+/** A vertex made by clipping, with its own copy of the varyings. */
+struct ClipVertex {
+	Position position;
+	std::array<f32, k_max_varyings> varyings;
+};
+
+/** The signed distance from the near plane, `z = -w`, positive in front of it. */
+auto near_distance(const Position& p) -> f32
+{
+	return p.z + p.w;
+}
+
+auto lerp(const ClipVertex& a, const ClipVertex& b, f32 t, u32 varying_count) -> ClipVertex
+{
+	auto result = ClipVertex();
+	result.position = {
+		a.position.x + (b.position.x - a.position.x) * t,
+		a.position.y + (b.position.y - a.position.y) * t,
+		a.position.z + (b.position.z - a.position.z) * t,
+		a.position.w + (b.position.w - a.position.w) * t,
+	};
+	for (u32 i = 0; i < varying_count; ++i)
+		result.varyings[i] = a.varyings[i] + (b.varyings[i] - a.varyings[i]) * t;
+
+	return result;
+}
+
+/** Whether all three vertices are outside the same side of the view volume. */
+auto outside_frustum(const std::array<const Position*, 3>& p) -> bool
+{
+	auto all = [&](auto&& outside) {
+		return outside(*p[0]) && outside(*p[1]) && outside(*p[2]);
+	};
+
+	return all([](const Position& v) { return v.x > v.w; })
+		|| all([](const Position& v) { return v.x < -v.w; })
+		|| all([](const Position& v) { return v.y > v.w; })
+		|| all([](const Position& v) { return v.y < -v.w; })
+		|| all([](const Position& v) { return v.z > v.w; })
+		|| all([](const Position& v) { return near_distance(v) < 0; });
+}
+
+} // namespace
+
+
+// Triangles -------------------------------------------------------------------
+
+/**
+ * A triangle ready to rasterize. Edge `i` is the one opposite vertex `i`, and
+ * its function `a * x + b * y + c` is positive inside the triangle, and
+ * proportional to vertex `i`'s barycentric weight.
+ */
+struct Rasterizer::Triangle {
+	std::array<f32,3> a;
+	std::array<f32,3> b;
+	std::array<f32,3> c;
+	/** Whether pixels exactly on the edge are covered. */
+	std::array<bool,3> top_left;
+	/** The depth of each vertex, divided by twice the area. */
+	std::array<f32,3> z;
+	/** 1 / w of each vertex, to weight the varyings. */
+	std::array<f32,3> inv_w;
+	/** The pixels covered, inclusive, within the target. */
+	i32 min_x;
+	i32 min_y;
+	i32 max_x;
+	i32 max_y;
+	/** Where the vertices' varyings start in the slice's `varyings`. */
+	usize varyings;
+};
+
+/** The triangles set up by one thread, in submission order. */
+struct Rasterizer::Slice {
+	std::vector<Triangle> triangles;
+	std::vector<f32> varyings;
+	/** Each tile's triangles, as indices into `triangles`. */
+	std::vector<std::vector<u32>> bins;
+	u64 culled = 0;
+	u64 clipped = 0;
+};
+
+
+// Rasterizer ------------------------------------------------------------------
+
+Rasterizer::Rasterizer(usize threads)
+	: m_workers(std::make_unique<Workers>(threads))
+{}
+
+Rasterizer::~Rasterizer() = default;
+
+Rasterizer::Rasterizer(Rasterizer&&) noexcept = default;
+auto Rasterizer::operator=(Rasterizer&&) noexcept -> Rasterizer& = default;
+
+auto Rasterizer::threads() const -> usize
+{
+	return m_workers->size();
+}
+
+void Rasterizer::draw(Framebuffer& target, const DrawItem& item)
+{
+	if (!item.program || !item.program->vertex)
+		throw std::invalid_argument("Draw without a vertex shader");
+	if (item.program->varying_count > k_max_varyings)
+		throw std::invalid_argument(fmt::format("Too many varyings: {} (at most {})",
+			item.program->varying_count, k_max_varyings));
+	if (item.count % 3 != 0 || item.first + item.count > item.indices.count)
+		throw std::invalid_argument(fmt::format("Invalid index range [{}, {}) of {}",
+			item.first, item.first + item.count, item.indices.count));
+
+	const auto& program = *item.program;
+	usize vertex_count = item.vertices.count;
+	usize total = vertex_count * item.instance_count;
+	m_varying_count = program.varying_count;
+
+	// Shade every vertex of every instance
+	m_positions.resize(total);
+	m_varyings.resize(total * m_varying_count);
+	m_workers->run((total + k_vertex_chunk - 1) / k_vertex_chunk, [&](usize chunk) {
+		const auto* vertices = static_cast<const u8*>(item.vertices.data);
+		usize end = std::min(total, (chunk + 1) * k_vertex_chunk);
+		for (usize i = chunk * k_vertex_chunk; i < end; ++i) {
+			auto instance = static_cast<u32>(i / vertex_count);
+			usize vertex = i % vertex_count;
+			m_positions[i] = program.vertex(item.uniforms, vertices + vertex * item.vertices.stride,
+				instance, &m_varyings[i * m_varying_count]);
+		}
+	});
+
+	// Set up and bin the triangles, in a contiguous run per thread
+	m_tiles_x = (target.width() + k_tile_size - 1) / k_tile_size;
+	u32 tiles_y = (target.height() + k_tile_size - 1) / k_tile_size;
+	usize tile_count = static_cast<usize>(m_tiles_x) * tiles_y;
+	usize triangles_per_instance = item.count / 3;
+	usize triangle_count = triangles_per_instance * item.instance_count;
+
+	m_slices.resize(m_workers->size());
+	m_workers->run(m_slices.size(), [&](usize index) {
+		auto& slice = m_slices[index];
+		slice.triangles.clear();
+		slice.varyings.clear();
+		slice.bins.resize(tile_count);
+		for (auto& bin : slice.bins)
+			bin.clear();
+		slice.culled = 0;
+		slice.clipped = 0;
+
+		usize begin = triangle_count * index / m_slices.size();
+		usize end = triangle_count * (index + 1) / m_slices.size();
+		for (usize t = begin; t < end; ++t) {
+			usize instance = t / triangles_per_instance;
+			const u32* indices = item.indices.data + item.first + (t % triangles_per_instance) * 3;
+
+			auto positions = std::array<const Position*, 3>();
+			auto varyings = std::array<const f32*, 3>();
+			for (usize i = 0; i < 3; ++i) {
+				if (indices[i] >= vertex_count)
+					throw std::out_of_range(fmt::format("Index {} is out of range", indices[i]));
+
+				usize vertex = instance * vertex_count + indices[i];
+				positions[i] = &m_positions[vertex];
+				varyings[i] = &m_varyings[vertex * m_varying_count];
+			}
+
+			setup(slice, positions, varyings, target, item.cull);
+		}
+	});
+
+	// Rasterize each tile's triangles
+	auto fragments = std::vector<u64>(tile_count);
+	m_workers->run(tile_count, [&](usize tile) {
+		rasterize(target, item, static_cast<u32>(tile), fragments[tile]);
+	});
+
+	m_stats.triangles += triangle_count;
+	for (const auto& slice : m_slices) {
+		m_stats.culled += slice.culled;
+		m_stats.clipped += slice.clipped;
+	}
+	for (u64 count : fragments)
+		m_stats.fragments += count;
+}
+
+void Rasterizer::setup(Slice& slice, const std::array<const Position*, 3>& positions,
+	const std::array<const f32*, 3>& varyings, const Framebuffer& target, Cull cull)
+{
+	if (outside_frustum(positions)) {
+		++slice.culled;
+		return;
+	}
+
+	bool crosses_near = near_distance(*positions[0]) < 0
+		|| near_distance(*positions[1]) < 0
+		|| near_distance(*positions[2]) < 0;
+
+	if (crosses_near) {
+		// Clip to the near plane, leaving three or four vertices, and set up
+		// the fan of triangles they make
+		++slice.clipped;
+
+		auto input = std::array<ClipVertex, 3>();
+		for (usize i = 0; i < 3; ++i) {
+			input[i].position = *positions[i];
+			std::copy_n(varyings[i], m_varying_count, input[i].varyings.begin());
+		}
+
+		auto clipped = std::array<ClipVertex, 4>();
+		usize count = 0;
+		for (usize i = 0; i < 3; ++i) {
+			const auto& current = input[i];
+			const auto& next = input[(i + 1) % 3];
+			f32 d0 = near_distance(current.position);
+			f32 d1 = near_distance(next.position);
+
+			if (d0 >= 0)
+				clipped[count++] = current;
+			if ((d0 >= 0) != (d1 >= 0))
+				clipped[count++] = lerp(current, next, d0 / (d0 - d1), m_varying_count);
+		}
+
+		for (usize i = 1; i + 1 < count; ++i) {
+			bin(slice,
+				{ &clipped[0].position, &clipped[i].position, &clipped[i + 1].position },
+				{ clipped[0].varyings.data(), clipped[i].varyings.data(), clipped[i + 1].varyings.data() },
+				target, cull);
+		}
+		return;
+	}
+
+	bin(slice, positions, varyings, target, cull);
+}
+
+void Rasterizer::bin(Slice& slice, const std::array<const Position*, 3>& positions,
+	const std::array<const f32*, 3>& varyings, const Framebuffer& target, Cull cull)
+{
+	// Project onto the target, with y down and depth in [0, 1]
+	auto width = static_cast<f32>(target.width());
+	auto height = static_cast<f32>(target.height());
+	std::array<f32,3> x, y, z, inv_w;
+	for (usize i = 0; i < 3; ++i) {
+		const auto& p = *positions[i];
+		inv_w[i] = 1 / p.w;
+		x[i] = (p.x * inv_w[i] * 0.5f + 0.5f) * width;
+		y[i] = (0.5f - p.y * inv_w[i] * 0.5f) * height;
+		z[i] = p.z * inv_w[i] * 0.5f + 0.5f;
+	}
+
+	// Twice the signed area. With y down, it's negative for triangles that
+	// are counter-clockwise in normalized device coordinates.
+	f32 area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	bool front = area < 0;
+	if (area == 0 || (cull == Cull::Back && !front) || (cull == Cull::Front && front)) {
+		++slice.culled;
+		return;
+	}
+
+	// Only the pixels whose centers are within the bounds can be covered
+	auto bound = [](f32 value, f32 limit) { return std::clamp(value, -1.f, limit + 1); };
+	auto min_x = static_cast<i32>(std::ceil(bound(std::min({ x[0], x[1], x[2] }), width) - 0.5f));
+	auto max_x = static_cast<i32>(std::floor(bound(std::max({ x[0], x[1], x[2] }), width) - 0.5f));
+	auto min_y = static_cast<i32>(std::ceil(bound(std::min({ y[0], y[1], y[2] }), height) - 0.5f));
+	auto max_y = static_cast<i32>(std::floor(bound(std::max({ y[0], y[1], y[2] }), height) - 0.5f));
+	min_x = std::max(min_x, 0);
+	min_y = std::max(min_y, 0);
+	max_x = std::min(max_x, static_cast<i32>(target.width()) - 1);
+	max_y = std::min(max_y, static_cast<i32>(target.height()) - 1);
+	if (min_x > max_x || min_y > max_y) {
+		++slice.culled;
+		return;
+	}
+
+	// Make the area positive, so that the edge functions are positive inside
+	auto order = std::array<usize,3>{ 0, 1, 2 };
+	if (area < 0) {
+		std::swap(order[1], order[2]);
+		area = -area;
+	}
+
+	auto triangle = Triangle();
+	for (usize i = 0; i < 3; ++i) {
+		usize v = order[i];
+		usize from = order[(i + 1) % 3];
+		usize to = order[(i + 2) % 3];
+
+		// Swapping the ends negates every coefficient exactly, so neighbors
+		// agree on which side of their shared edge each pixel is
+		triangle.a[i] = y[from] - y[to];
+		triangle.b[i] = x[to] - x[from];
+		triangle.c[i] = x[from] * y[to] - y[from] * x[to];
+		triangle.top_left[i] = triangle.a[i] > 0 || (triangle.a[i] == 0 && triangle.b[i] > 0);
+		triangle.z[i] = z[v] / area;
+		triangle.inv_w[i] = inv_w[v];
+	}
+	triangle.min_x = min_x;
+	triangle.min_y = min_y;
+	triangle.max_x = max_x;
+	triangle.max_y = max_y;
+	triangle.varyings = slice.varyings.size();
+	for (usize i = 0; i < 3; ++i)
+		slice.varyings.insert(slice.varyings.end(), varyings[order[i]], varyings[order[i]] + m_varying_count);
+
+	auto index = static_cast<u32>(slice.triangles.size());
+	slice.triangles.push_back(triangle);
+
+	for (auto ty = static_cast<u32>(min_y) / k_tile_size; ty <= static_cast<u32>(max_y) / k_tile_size; ++ty)
+		for (auto tx = static_cast<u32>(min_x) / k_tile_size; tx <= static_cast<u32>(max_x) / k_tile_size; ++tx)
+			slice.bins[ty * m_tiles_x + tx].push_back(index);
+}
+
+void Rasterizer::rasterize(Framebuffer& target, const DrawItem& item, u32 tile, u64& fragments) const
+{
+	const auto& program = *item.program;
+	auto tile_x = static_cast<i32>(tile % m_tiles_x * k_tile_size);
+	auto tile_y = static_cast<i32>(tile / m_tiles_x * k_tile_size);
+	auto varyings = std::array<f32, k_max_varyings>();
+
+	for (const auto& slice : m_slices) {
+		for (u32 index : slice.bins[tile]) {
+			const auto& tri = slice.triangles[index];
+			const f32* vertex_varyings = slice.varyings.data() + tri.varyings;
+
+			i32 min_x = std::max(tri.min_x, tile_x);
+			i32 max_x = std::min(tri.max_x, tile_x + static_cast<i32>(k_tile_size) - 1);
+			i32 min_y = std::max(tri.min_y, tile_y);
+			i32 max_y = std::min(tri.max_y, tile_y + static_cast<i32>(k_tile_size) - 1);
+
+			// Local copies, which the depth writes can't alias
+			auto a = tri.a;
+			auto z = tri.z;
+			auto top_left = std::array<u32,3>{ tri.top_left[0], tri.top_left[1], tri.top_left[2] };
+
+			for (i32 y = min_y; y <= max_y; ++y) {
+				f32 py = static_cast<f32>(y) + 0.5f;
+				std::array<f32,3> row;
+				for (usize i = 0; i < 3; ++i)
+					row[i] = tri.b[i] * py + tri.c[i];
+
+				auto first = min_x / static_cast<i32>(k_lanes) * static_cast<i32>(k_lanes);
+				for (i32 x = first; x <= max_x; x += k_lanes) {
+					usize offset = static_cast<usize>(y) * target.stride() + static_cast<usize>(x);
+					f32* depths = target.depths() + offset;
+
+					// Masks combined with `&` and `|` rather than `&&` and `||`, and
+					// a select rather than a conditional store, so that the lanes
+					// have no control flow and the loop vectorizes
+					std::array<f32, k_lanes> e0, e1, e2;
+					std::array<u32, k_lanes> pass;
+					u32 passed = 0;
+					for (u32 lane = 0; lane < k_lanes; ++lane) {
+						i32 px = x + static_cast<i32>(lane);
+						f32 center = static_cast<f32>(px) + 0.5f;
+						e0[lane] = a[0] * center + row[0];
+						e1[lane] = a[1] * center + row[1];
+						e2[lane] = a[2] * center + row[2];
+
+						u32 inside = ((e0[lane] > 0) | ((e0[lane] == 0) & top_left[0]))
+							& ((e1[lane] > 0) | ((e1[lane] == 0) & top_left[1]))
+							& ((e2[lane] > 0) | ((e2[lane] == 0) & top_left[2]))
+							& (px >= min_x) & (px <= max_x);
+
+						f32 depth = e0[lane] * z[0] + e1[lane] * z[1] + e2[lane] * z[2];
+						pass[lane] = inside & (depth < depths[lane]);
+						depths[lane] = pass[lane] ? depth : depths[lane];
+						passed += pass[lane];
+					}
+
+					fragments += passed;
+					if (passed == 0 || !program.fragment)
+						continue;
+
+					u32* colors = target.colors() + offset;
+					for (u32 lane = 0; lane < k_lanes; ++lane) {
+						if (!pass[lane])
+							continue;
+
+						// Perspective-correct weights
+						f32 l0 = e0[lane] * tri.inv_w[0];
+						f32 l1 = e1[lane] * tri.inv_w[1];
+						f32 l2 = e2[lane] * tri.inv_w[2];
+						f32 scale = 1 / (l0 + l1 + l2);
+						l0 *= scale;
+						l1 *= scale;
+						l2 *= scale;
+
+						const f32* v0 = vertex_varyings;
+						const f32* v1 = v0 + m_varying_count;
+						const f32* v2 = v1 + m_varying_count;
+						for (u32 i = 0; i < m_varying_count; ++i)
+							varyings[i] = l0 * v0[i] + l1 * v1[i] + l2 * v2[i];
+
+						colors[lane] = pack(program.fragment(item.uniforms, varyings.data()));
+					}
+				}
+			}
+		}
+	}
+}
+
+} // namespace raster
@@ -0,0 +1,99 @@
+#include "raster/workers.h"
+
+#include <algorithm>
+#include <utility>
+
+
+namespace raster {
+
+Workers::Workers(usize count)
+{
+	if (count == 0)
+		count = std::max(1u, std::thread::hardware_concurrency());
+
+	m_threads.reserve(count - 1);
+	for (usize i = 1; i < count; ++i)
+		m_threads.emplace_back([this] { work(); });
+}
+
+Workers::~Workers()
+{
+	{
+		auto lock = std::lock_guard(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+
+	for (auto& thread : m_threads)
+		thread.join();
+}
+
+void Workers::run(usize count, const std::function<void(usize)>& fn)
+{
+	if (m_threads.empty() || count <= 1) {
+		for (usize i = 0; i < count; ++i)
+			fn(i);
+		return;
+	}
+
+	{
+		auto lock = std::lock_guard(m_mutex);
+		m_job = &fn;
+		m_count = count;
+		m_next = 0;
+		m_busy = m_threads.size();
+		m_error = nullptr;
+		++m_generation;
+	}
+	m_wake.notify_all();
+
+	drain();
+
+	auto error = std::exception_ptr();
+	{
+		auto lock = std::unique_lock(m_mutex);
+		m_done.wait(lock, [this] { return m_busy == 0; });
+		m_job = nullptr;
+		error = std::exchange(m_error, nullptr);
+	}
+
+	if (error)
+		std::rethrow_exception(error);
+}
+
+void Workers::work()
+{
+	u64 seen = 0;
+	for (;;) {
+		{
+			auto lock = std::unique_lock(m_mutex);
+			m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+			if (m_stop)
+				return;
+
+			seen = m_generation;
+		}
+
+		drain();
+
+		auto lock = std::lock_guard(m_mutex);
+		if (--m_busy == 0)
+			m_done.notify_one();
+	}
+}
+
+void Workers::drain()
+{
+	for (usize i = m_next++; i < m_count; i = m_next++) {
+		try {
+			(*m_job)(i);
+		}
+		catch (...) {
+			auto lock = std::lock_guard(m_mutex);
+			if (!m_error)
+				m_error = std::current_exception();
+		}
+	}
+}
+
+} // namespace raster
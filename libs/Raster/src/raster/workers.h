@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <sized.h>
+
+namespace raster {
+using namespace sized; // NOLINT(*-using-namespace)
+
+/**
+ * A fixed set of threads for running parallel loops, kept alive between
+ * them, since a rasterizer runs several short loops for every draw.
+ */
+class Workers {
+public:
+	/** `count` includes the calling thread. 0 uses every hardware thread. */
+	explicit Workers(usize count);
+	~Workers();
+
+	Workers(const Workers&) = delete;
+	Workers& operator=(const Workers&) = delete;
+
+	/**
+	 * Call `fn(i)` for every `i` in `[0, count)`, on the workers and the
+	 * calling thread, and wait for them all. Rethrows the first exception
+	 * thrown by `fn`.
+	 */
+	void run(usize count, const std::function<void(usize)>& fn);
+
+	/** The number of threads, including the calling thread. */
+	auto size() const -> usize { return m_threads.size() + 1; }
+
+private:
+	void work();
+	void drain();
+
+	std::vector<std::thread> m_threads;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+
+	// The current loop, set under the mutex
+	const std::function<void(usize)>* m_job = nullptr;
+	usize m_count = 0;
+	std::atomic<usize> m_next = 0;
+	u64 m_generation = 0;
+	usize m_busy = 0;
+	bool m_stop = false;
+	std::exception_ptr m_error;
+};
+
+} // namespace raster